@@ -0,0 +1,193 @@
+/*
+ * host.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Runs the drivers on a Linux x86-64 host against models of the peripherals
+ * they use, for tests and benchmarks. See host_bus.c for how the registers are
+ * modeled and host_core.c for the virtual time base.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef HOST_HG
+#define HOST_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_gpio.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_HFCLK_HZ       26000000    // HFRCO band main.c picks, one virtual cycle is one HFCLK cycle
+#define HOST_NEVER          UINT64_MAX  // no event, for a model's next
+#define HOST_MS(ms)         ((uint64_t)(ms) * (HOST_HFCLK_HZ / 1000))
+#define HOST_US(us)         ((uint64_t)(us) * (HOST_HFCLK_HZ / 1000000))
+
+// Awake cost of what the model can see. Code between two register accesses
+// is not counted, so awake cycles are a floor that moves with the number of
+// accesses, interrupts and wake ups, not a cycle count.
+#define HOST_BUS_CYCLES     6           // a peripheral register access and the instructions around it
+#define HOST_IRQ_CYCLES     24          // exception entry and exit
+#define HOST_WAKE_CYCLES    280         // wake up from EM2 or EM3, about 10 us
+#define HOST_SPIN_READS     3           // same read at the same instruction before it counts as polling
+
+#define HOST_EM_COUNT       5
+
+#define HOST_I2C_DEVICES    4           // per bus
+#define HOST_I2C_LOG_SIZE   64          // transactions kept by a register slave
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+// Where the core's time went since host_init or host_stats_reset
+typedef struct{
+  uint64_t  em_cycles[HOST_EM_COUNT]; // in each energy mode, EM0 is awake
+  uint64_t  bus_cycles;               // EM0 spent on register accesses
+  uint64_t  irq_cycles;               // EM0 spent entering interrupts
+  uint64_t  spin_cycles;              // EM0 spent polling a register that did not change
+  uint64_t  wake_cycles;              // EM0 spent waking up from EM2 and EM3
+  uint32_t  accesses;                 // register accesses by the core
+  uint32_t  sleeps[HOST_EM_COUNT];    // times the core went into each energy mode
+}HOST_ENERGY;
+
+// A byte on the LEUART0 line from the board, with the rate it was sent at
+typedef void (*HOST_LEUART_PEER)(uint8_t byte, uint32_t baudrate);
+
+typedef struct{
+  uint32_t  tx_bytes;                 // sent by the board
+  uint32_t  rx_bytes;                 // put on the line by the peer
+  uint32_t  rx_lost;                  // receiver off or its clock stopped
+  uint32_t  rx_garbled;               // peer on another rate
+  uint32_t  rx_blocked;               // dropped by RX block, no interrupt
+  uint32_t  rx_overflow;
+}HOST_LEUART_STATS;
+
+typedef struct{
+  uint32_t  baudrate;                 // rate of the UART side
+  bool      connected;
+  bool      noti;                     // connect and lost notices
+  uint32_t  commands;                 // AT commands answered
+  uint32_t  resets;
+  uint32_t  central_bytes;            // delivered to the phone
+}HOST_HM18_STATE;
+
+// Faults the bus model puts in the next transactions, see host_i2c_fault
+typedef enum{
+  HOST_I2C_NACK_ADDR,                 // the slave does not answer its address
+  HOST_I2C_NACK_DATA,                 // the slave nacks a byte written to it
+  HOST_I2C_ARBLOST,                   // another master wins the next byte
+  HOST_I2C_BUSERR,                    // misplaced START or STOP on the next byte
+  HOST_I2C_SDA_STUCK,                 // a slave holds SDA low, count is the clocks it needs to let go
+  HOST_I2C_SCL_STUCK,                 // a slave stretches SCL forever on the next byte, until ABORT
+  HOST_I2C_LOST_ACK,                  // the ACK of the next byte is lost, the master holds the bus
+  HOST_I2C_FAULTS
+}HOST_I2C_FAULT;
+
+// A slave on a bus. start is called once the address is acked, write and
+// read per byte, and stop at the STOP, repeated START or ABORT.
+typedef struct{
+  uint8_t   address;
+  void      *context;
+  bool      (*start)(void *context, bool read);   // false nacks the address
+  bool      (*write)(void *context, uint8_t byte);  // false nacks the byte
+  uint8_t   (*read)(void *context);
+  void      (*read_ack)(void *context, bool ack);   // the master's answer to the byte just read
+  void      (*stop)(void *context);
+}HOST_I2C_DEVICE;
+
+typedef struct{
+  uint32_t  starts;
+  uint32_t  stops;
+  uint32_t  bytes_out;                // address and data bytes sent by the master
+  uint32_t  bytes_in;
+  uint32_t  master_nacks;             // bytes read and nacked by the master
+  uint32_t  aborts;
+}HOST_I2C_STATS;
+
+// One transaction seen by a register slave, between START and STOP
+typedef struct{
+  bool      read;
+  uint8_t   reg;                      // register pointer when it began
+  uint32_t  length;                   // data bytes, not counting the register address
+  uint32_t  nack_at;                  // read byte the master nacked, 0 if none
+}HOST_I2C_XFER;
+
+// A slave with 256 byte wide registers. The first byte written sets the
+// register pointer, the rest go to the registers, and reads carry on from
+// the pointer. Both auto increment.
+typedef struct HOST_I2C_REGS{
+  HOST_I2C_DEVICE   device;
+  uint8_t           regs[256];
+  uint8_t           pointer;
+  bool              pointer_set;      // first byte of this write went to the pointer
+  bool              reading;
+  void              (*on_write)(struct HOST_I2C_REGS *slave, uint8_t reg, uint8_t value);
+  void              (*on_read)(struct HOST_I2C_REGS *slave, uint8_t reg);    // before reg goes out
+  void              *context;
+  HOST_I2C_XFER     log[HOST_I2C_LOG_SIZE];
+  uint32_t          log_count;        // all transactions, the log keeps the first HOST_I2C_LOG_SIZE
+}HOST_I2C_REGS;
+
+typedef struct{
+  bool      running;                  // autonomous mode
+  uint32_t  commands;
+  uint32_t  measurements;
+  uint32_t  irq_status;
+}HOST_SI1133_STATE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+// Time, interrupts and energy, host_core.c
+void host_init(void);
+uint64_t host_now(void);
+void host_advance(uint64_t cycles);
+bool host_run(void (*entry)(void), uint64_t cycles);
+void host_energy(HOST_ENERGY *energy);
+void host_stats_reset(void);
+uint32_t host_irq_count(IRQn_Type irq);
+void host_irq_delay(IRQn_Type irq, uint64_t cycles);
+void host_fail(const char *format, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+// Pins, host_gpio.c
+void host_gpio_drive(GPIO_Port_TypeDef port, unsigned int pin, bool low);
+bool host_gpio_get(GPIO_Port_TypeDef port, unsigned int pin);
+
+// LDMA, host_ldma.c
+uint32_t host_ldma_units(void);
+
+// LEUART0 line, host_leuart.c
+void host_leuart_peer(HOST_LEUART_PEER peer);
+void host_leuart_send(uint8_t byte, uint32_t baudrate);
+void host_leuart_stats(HOST_LEUART_STATS *stats);
+
+// HM-18 on LEUART0, host_hm18.c
+void host_hm18_init(void);
+void host_hm18_connect(bool connected);
+void host_hm18_central_send(const char *string);
+uint32_t host_hm18_central_read(char *buf, uint32_t max_len);
+void host_hm18_state(HOST_HM18_STATE *state);
+
+// I2C buses, host_i2c.c and host_i2c_regs.c
+void host_i2c_attach(I2C_TypeDef *i2c, HOST_I2C_DEVICE *device);
+void host_i2c_pins(I2C_TypeDef *i2c, GPIO_Port_TypeDef scl_port, unsigned int scl_pin, GPIO_Port_TypeDef sda_port, unsigned int sda_pin);
+void host_i2c_fault(I2C_TypeDef *i2c, HOST_I2C_FAULT fault, uint32_t count);
+void host_i2c_stats(I2C_TypeDef *i2c, HOST_I2C_STATS *stats);
+void host_i2c_regs_init(HOST_I2C_REGS *slave, uint8_t address);
+
+// Si1133 on an I2C bus, host_si1133.c
+void host_si1133_init(I2C_TypeDef *i2c);
+void host_si1133_light(int32_t white, int32_t uv, int32_t ir);
+void host_si1133_state(HOST_SI1133_STATE *state);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * host_model.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * What the peripheral and device models share with host_core.c and
+ * host_bus.c. Tests and benchmarks only need host.h.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef HOST_MODEL_HG
+#define HOST_MODEL_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+
+/* The developer's include statements */
+#include "host.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_BUS_BASE       0x40000000UL    // peripheral region the drivers see
+#define HOST_BUS_SIZE       0x00100000UL
+#define HOST_BLOCK_SIZE     0x400UL         // one peripheral's registers
+
+// Model side write to a register, including the ones the core can only read
+#define HOST_SET(reg, value)  (*(volatile uint32_t *)&(reg) = (uint32_t)(value))
+#define HOST_OFFSET(type, reg)  ((uint32_t)offsetof(type, reg))
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+// A register block. read runs before the core or the LDMA reads the register
+// at offset, for registers like RXDATA that change when read. write runs
+// after a write, with the value already in the register.
+typedef struct HOST_BLOCK{
+  const char          *name;
+  uintptr_t           base;
+  void                (*read)(uint32_t offset);
+  void                (*write)(uint32_t offset, uint32_t value);
+  struct HOST_BLOCK   *link;
+}HOST_BLOCK;
+
+// Anything with a clock. next is the number of cycles to the model's next
+// event, at least 1, or HOST_NEVER. advance runs the clock that far and does
+// what comes due. A model is frozen while the core sleeps deeper than em.
+typedef struct HOST_MODEL{
+  const char          *name;
+  uint32_t            (*em)(void);
+  uint64_t            (*next)(void);
+  void                (*advance)(uint64_t cycles);
+  struct HOST_MODEL   *link;
+}HOST_MODEL;
+
+// How a charge to host_charge is accounted
+typedef enum{
+  HOST_CHARGE_BUS,
+  HOST_CHARGE_IRQ,
+  HOST_CHARGE_SPIN,
+  HOST_CHARGE_WAKE
+}HOST_CHARGE;
+
+typedef void (*HOST_GPIO_WATCH)(bool level, void *context);
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+// host_core.c
+void host_model_add(HOST_MODEL *model);
+void host_charge(HOST_CHARGE charge, uint64_t cycles);
+void host_spin(void);
+void host_sleep(uint32_t em);
+uint32_t host_em(void);
+void host_irq_level(IRQn_Type irq, bool level);
+void host_irq_poll(void);
+
+// host_bus.c
+void host_bus_open(void);
+void host_bus_add(HOST_BLOCK *block);
+void *host_alias(volatile const void *reg);
+bool host_bus_owns(uint32_t address);
+uint32_t host_reg_read(uint32_t address);
+void host_reg_write(uint32_t address, uint32_t value);
+uint32_t host_cpu_read(volatile const uint32_t *reg);
+void host_cpu_write(volatile uint32_t *reg, uint32_t value);
+void host_bus_spin_reset(void);
+uint32_t host_bus_accesses(void);
+
+// Peripheral models, opened by host_init
+void host_cmu_open(void);
+void host_gpio_open(void);
+void host_ldma_open(void);
+void host_leuart_open(void);
+void host_letimer_open(void);
+void host_timer_open(void);
+void host_i2c_open(void);
+
+// Between the models
+uint32_t host_cmu_hz(CMU_Clock_TypeDef clock);
+uint32_t host_cmu_em(CMU_Clock_TypeDef clock);
+void host_gpio_watch(GPIO_Port_TypeDef port, unsigned int pin, HOST_GPIO_WATCH watch, void *context);
+void host_ldma_service(void);
+bool host_leuart_dma_request(uint32_t signal, bool *wakeup);
+bool host_i2c_dma_request(uint32_t signal);
+
+#endif
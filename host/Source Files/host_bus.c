@@ -0,0 +1,351 @@
+/**
+ * @file
+ * host_bus.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Peripheral register region of the host build, at the addresses the drivers
+ * were written for
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_PAGE           4096UL
+#define HOST_TRAP_FLAG      0x100UL     // EFLAGS.TF, single steps the access
+#define HOST_FAULT_WRITE    0x2UL       // page fault error code, the access was a write
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Register bus
+ * @details
+ *  The region is one shared memory file mapped twice. The drivers get it at
+ *  HOST_BUS_BASE with no access, the models get a read write alias. Every
+ *  access by the drivers faults, the fault handler finds the block, charges
+ *  the access and runs its read hook, then opens the page and single steps
+ *  the instruction. The trap after the step closes the page again, runs the
+ *  write hook and lets pending interrupts in, like the core would between
+ *  two instructions. Registers that change on their own are kept current in
+ *  the alias by their model, so only side effects need hooks.
+ *
+ ******************************************************************************/
+static struct{
+  uint8_t       *alias;
+  HOST_BLOCK    *blocks;
+  uint32_t      accesses;
+  // access between the fault and the trap
+  bool          active;
+  HOST_BLOCK    *block;
+  uint32_t      offset;
+  bool          write;
+  uintptr_t     address;
+  uintptr_t     page;
+  uintptr_t     rip;
+  // polling detector, the last read
+  uintptr_t     spin_rip;
+  uintptr_t     spin_address;
+  uint32_t      spin_value;
+  uint32_t      spin_reads;
+}host_bus;
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Finds the block at address, NULL if none is modeled there.
+ *
+ ******************************************************************************/
+static HOST_BLOCK *host_bus_block(uintptr_t address){
+  for(HOST_BLOCK *block = host_bus.blocks; block; block = block->link){
+      if((address >= block->base) && (address < block->base + HOST_BLOCK_SIZE)){
+          return block;
+      }
+  }
+  return NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Hands a fault that is not a register access back to the system, so the
+ * instruction faults again and the process dies the normal way.
+ *
+ ******************************************************************************/
+static void host_bus_default(int sig){
+  signal(sig, SIG_DFL);
+}
+
+/***************************************************************************//**
+ * @brief
+ * SIGSEGV handler, the start of a register access.
+ *
+ * @details
+ * The access is charged before it is made, so the models are up to date
+ * when the register is read. Then the page is opened and the instruction
+ * single stepped.
+ *
+ ******************************************************************************/
+static void host_bus_fault(int sig, siginfo_t *info, void *context){
+  ucontext_t *uc = context;
+  uintptr_t address = (uintptr_t)info->si_addr;
+
+  if(host_bus.active || (address < HOST_BUS_BASE) || (address >= HOST_BUS_BASE + HOST_BUS_SIZE)){
+      host_bus_default(sig);
+      return;
+  }
+  host_bus.block = host_bus_block(address);
+  if(!host_bus.block){
+      host_fail("access to 0x%08lx, no peripheral is modeled there", (unsigned long)address);
+  }
+  host_bus.active = true;
+  host_bus.address = address & ~3UL;
+  host_bus.offset = (uint32_t)(host_bus.address - host_bus.block->base);
+  host_bus.write = (uc->uc_mcontext.gregs[REG_ERR] & HOST_FAULT_WRITE) != 0;
+  host_bus.page = address & ~(HOST_PAGE - 1);
+  host_bus.rip = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+  host_bus.accesses++;
+
+  host_charge(HOST_CHARGE_BUS, HOST_BUS_CYCLES);
+  if(!host_bus.write && host_bus.block->read){
+      host_bus.block->read(host_bus.offset);
+  }
+  mprotect((void *)host_bus.page, HOST_PAGE, PROT_READ | PROT_WRITE);
+  uc->uc_mcontext.gregs[REG_EFL] |= HOST_TRAP_FLAG;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Polling detector, counts a read that repeats the last one.
+ *
+ * @details
+ * A read that repeats at the same instruction with the same value, with no
+ * other access in between, is a polling loop. Nothing it reads can change
+ * before the next model event, so after HOST_SPIN_READS of them the time to
+ * that event is charged at once instead of being polled through.
+ *
+ ******************************************************************************/
+static void host_bus_spin_check(uintptr_t rip, uintptr_t address, uint32_t value){
+  if((rip == host_bus.spin_rip) && (address == host_bus.spin_address) && (value == host_bus.spin_value)){
+      if(++host_bus.spin_reads >= HOST_SPIN_READS){
+          host_bus.spin_reads = 0;
+          host_spin();
+      }
+      return;
+  }
+  host_bus.spin_rip = rip;
+  host_bus.spin_address = address;
+  host_bus.spin_value = value;
+  host_bus.spin_reads = 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * SIGTRAP handler, the end of a register access.
+ *
+ * @details
+ * Reads go through the polling detector, see host_bus_spin_check.
+ *
+ ******************************************************************************/
+static void host_bus_trap(int sig, siginfo_t *info, void *context){
+  ucontext_t *uc = context;
+  uint32_t value;
+  (void)info;
+
+  if(!host_bus.active){
+      host_bus_default(sig);
+      return;
+  }
+  mprotect((void *)host_bus.page, HOST_PAGE, PROT_NONE);
+  uc->uc_mcontext.gregs[REG_EFL] &= ~HOST_TRAP_FLAG;
+  host_bus.active = false;
+
+  value = *(volatile uint32_t *)host_alias((volatile void *)host_bus.address);
+  if(host_bus.write){
+      host_bus.spin_reads = 0;
+      if(host_bus.block->write){
+          host_bus.block->write(host_bus.offset, value);
+      }
+  }
+  else{
+      host_bus_spin_check(host_bus.rip, host_bus.address, value);
+  }
+  host_irq_poll();
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Maps the register region and installs the access handlers.
+ *
+ * @note
+ * Called once by host_init, before any model adds its block.
+ *
+ ******************************************************************************/
+void host_bus_open(void){
+  struct sigaction action;
+  void *bus;
+  int fd;
+
+  fd = memfd_create("host_bus", 0);
+  if((fd < 0) || ftruncate(fd, HOST_BUS_SIZE)){
+      host_fail("no memory file for the register region");
+  }
+  bus = mmap((void *)HOST_BUS_BASE, HOST_BUS_SIZE, PROT_NONE, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+  if(bus != (void *)HOST_BUS_BASE){
+      host_fail("0x%08lx is taken, the register region cannot be mapped", HOST_BUS_BASE);
+  }
+  host_bus.alias = mmap(NULL, HOST_BUS_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(host_bus.alias == MAP_FAILED){
+      host_fail("no alias of the register region");
+  }
+  close(fd);
+
+  memset(&action, 0, sizeof(action));
+  action.sa_flags = SA_SIGINFO | SA_NODEFER;     //interrupt handlers run inside the trap and make accesses of their own
+  action.sa_sigaction = host_bus_fault;
+  sigaction(SIGSEGV, &action, NULL);
+  action.sa_sigaction = host_bus_trap;
+  sigaction(SIGTRAP, &action, NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a model's register block to the region.
+ *
+ * @param[in] block
+ * Static block, its registers start out zero.
+ *
+ ******************************************************************************/
+void host_bus_add(HOST_BLOCK *block){
+  EFM_ASSERT(!host_bus_block(block->base));
+  block->link = host_bus.blocks;
+  host_bus.blocks = block;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The model side address of a register, read and write without a trap.
+ *
+ ******************************************************************************/
+void *host_alias(volatile const void *reg){
+  uintptr_t address = (uintptr_t)reg;
+
+  EFM_ASSERT((address >= HOST_BUS_BASE) && (address < HOST_BUS_BASE + HOST_BUS_SIZE));
+  return host_bus.alias + (address - HOST_BUS_BASE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * True if address is a register, for the LDMA to tell them from RAM.
+ *
+ ******************************************************************************/
+bool host_bus_owns(uint32_t address){
+  return (address >= HOST_BUS_BASE) && (address < HOST_BUS_BASE + HOST_BUS_SIZE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads a register with its side effects but no charge, for the LDMA.
+ *
+ ******************************************************************************/
+uint32_t host_reg_read(uint32_t address){
+  HOST_BLOCK *block = host_bus_block(address);
+
+  if(!block){
+      host_fail("read of 0x%08x, no peripheral is modeled there", (unsigned)address);
+  }
+  address &= ~3u;
+  if(block->read){
+      block->read(address - (uint32_t)block->base);
+  }
+  return *(volatile uint32_t *)host_alias((volatile void *)(uintptr_t)address);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes a register with its side effects but no charge, for the LDMA.
+ *
+ ******************************************************************************/
+void host_reg_write(uint32_t address, uint32_t value){
+  HOST_BLOCK *block = host_bus_block(address);
+
+  if(!block){
+      host_fail("write of 0x%08x, no peripheral is modeled there", (unsigned)address);
+  }
+  address &= ~3u;
+  *(volatile uint32_t *)host_alias((volatile void *)(uintptr_t)address) = value;
+  if(block->write){
+      block->write(address - (uint32_t)block->base, value);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * A register read by the stand-in emlib functions, charged like a trapped
+ * one, with pending interrupts let in after it.
+ *
+ ******************************************************************************/
+uint32_t host_cpu_read(volatile const uint32_t *reg){
+  uint32_t value;
+
+  host_bus.accesses++;
+  host_charge(HOST_CHARGE_BUS, HOST_BUS_CYCLES);
+  value = host_reg_read((uint32_t)(uintptr_t)reg);
+  host_bus_spin_check((uintptr_t)__builtin_return_address(0), (uintptr_t)reg, value);
+  host_irq_poll();
+  return value;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A register write by the stand-in emlib functions, charged like a trapped
+ * one, with pending interrupts let in after it.
+ *
+ ******************************************************************************/
+void host_cpu_write(volatile uint32_t *reg, uint32_t value){
+  host_bus.accesses++;
+  host_bus.spin_reads = 0;
+  host_charge(HOST_CHARGE_BUS, HOST_BUS_CYCLES);
+  host_reg_write((uint32_t)(uintptr_t)reg, value);
+  host_irq_poll();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Forgets the last read, called when an interrupt runs in between.
+ *
+ ******************************************************************************/
+void host_bus_spin_reset(void){
+  host_bus.spin_reads = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Register accesses by the core so far.
+ *
+ ******************************************************************************/
+uint32_t host_bus_accesses(void){
+  return host_bus.accesses;
+}
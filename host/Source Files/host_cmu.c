@@ -0,0 +1,288 @@
+/**
+ * @file
+ * host_cmu.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Clock tree and energy management unit of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_cmu.h"
+#include "em_emu.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_LFXO_HZ        32768
+#define HOST_LFRCO_HZ       32768
+#define HOST_ULFRCO_HZ      1000
+#define HOST_HFCLKLE_HZ     (HOST_HFCLK_HZ / 2)
+
+#define HOST_CMU_BIT(clock) (1UL << (uint32_t)(clock))
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Clock tree
+ * @details
+ *  The CMU and EMU blocks only hold what the stand-in functions set: the
+ *  oscillators that are on in STATUS, the LFA and LFB selects, and one enable
+ *  bit per CMU_Clock_TypeDef in the enable register of its branch. Models
+ *  ask host_cmu_hz how fast they run, 0 while their clock is off, and
+ *  host_cmu_em for the deepest energy mode it runs in.
+ *
+ ******************************************************************************/
+static HOST_BLOCK host_cmu_block = { "CMU", CMU_BASE, NULL, NULL, NULL };
+static HOST_BLOCK host_emu_block = { "EMU", EMU_BASE, NULL, NULL, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the CMU registers.
+ *
+ ******************************************************************************/
+static CMU_TypeDef *host_cmu(void){
+  return host_alias(CMU);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Enable register of a clock's branch.
+ *
+ ******************************************************************************/
+static volatile uint32_t *host_cmu_enable_reg(CMU_Clock_TypeDef clock){
+  switch(clock){
+    case cmuClock_GPIO:
+    case cmuClock_LDMA:
+      return &CMU->HFBUSCLKEN0;
+    case cmuClock_I2C0:
+    case cmuClock_I2C1:
+    case cmuClock_TIMER0:
+    case cmuClock_TIMER1:
+      return &CMU->HFPERCLKEN0;
+    case cmuClock_LETIMER0:
+      return &CMU->LFACLKEN0;
+    case cmuClock_LEUART0:
+      return &CMU->LFBCLKEN0;
+    default:
+      return &CMU->CTRL;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * True if a clock's enable bit is set, reads the alias.
+ *
+ ******************************************************************************/
+static bool host_cmu_enabled(CMU_Clock_TypeDef clock){
+  return (*(volatile uint32_t *)host_alias(host_cmu_enable_reg(clock)) & HOST_CMU_BIT(clock)) != 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Rate of an oscillator, 0 while it is off.
+ *
+ ******************************************************************************/
+static uint32_t host_cmu_select_hz(CMU_Select_TypeDef select){
+  uint32_t status = host_cmu()->STATUS;
+
+  switch(select){
+    case cmuSelect_LFXO:
+      return (status & HOST_CMU_BIT(cmuOsc_LFXO)) ? HOST_LFXO_HZ : 0;
+    case cmuSelect_LFRCO:
+      return (status & HOST_CMU_BIT(cmuOsc_LFRCO)) ? HOST_LFRCO_HZ : 0;
+    case cmuSelect_ULFRCO:
+      return HOST_ULFRCO_HZ;
+    case cmuSelect_HFCLKLE:
+      return (host_cmu()->CTRL & HOST_CMU_BIT(cmuClock_CORELE)) ? HOST_HFCLKLE_HZ : 0;
+    default:
+      return 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Deepest energy mode an oscillator runs in.
+ *
+ ******************************************************************************/
+static uint32_t host_cmu_select_em(CMU_Select_TypeDef select){
+  switch(select){
+    case cmuSelect_ULFRCO:
+      return 3;
+    case cmuSelect_LFXO:
+    case cmuSelect_LFRCO:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds the CMU and EMU blocks, with the ULFRCO on and nothing selected.
+ *
+ ******************************************************************************/
+void host_cmu_open(void){
+  host_bus_add(&host_cmu_block);
+  host_bus_add(&host_emu_block);
+  HOST_SET(host_cmu()->STATUS, HOST_CMU_BIT(cmuOsc_ULFRCO) | HOST_CMU_BIT(cmuOsc_HFRCO));
+  host_cmu()->HFRCOCTRL = HOST_HFCLK_HZ;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Rate of a clock as the model of its peripheral sees it, 0 while the clock
+ * or its oscillator is off.
+ *
+ ******************************************************************************/
+uint32_t host_cmu_hz(CMU_Clock_TypeDef clock){
+  CMU_TypeDef *cmu = host_cmu();
+
+  switch(clock){
+    case cmuClock_HF:
+    case cmuClock_HFPER:
+      return HOST_HFCLK_HZ;
+    case cmuClock_LFA:
+      return host_cmu_select_hz((CMU_Select_TypeDef)cmu->LFACLKSEL);
+    case cmuClock_LFB:
+      return host_cmu_select_hz((CMU_Select_TypeDef)cmu->LFBCLKSEL);
+    case cmuClock_LETIMER0:
+      if(!host_cmu_enabled(cmuClock_CORELE) || !host_cmu_enabled(clock)){
+          return 0;
+      }
+      return host_cmu_hz(cmuClock_LFA);
+    case cmuClock_LEUART0:
+      if(!host_cmu_enabled(cmuClock_CORELE) || !host_cmu_enabled(clock)){
+          return 0;
+      }
+      return host_cmu_hz(cmuClock_LFB);
+    default:
+      if(!host_cmu_enabled(clock)){
+          return 0;
+      }
+      return HOST_HFCLK_HZ;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Deepest energy mode a clock runs in, where the model of its peripheral
+ * stops.
+ *
+ ******************************************************************************/
+uint32_t host_cmu_em(CMU_Clock_TypeDef clock){
+  CMU_TypeDef *cmu = host_cmu();
+
+  switch(clock){
+    case cmuClock_LFA:
+    case cmuClock_LETIMER0:
+      return host_cmu_select_em((CMU_Select_TypeDef)cmu->LFACLKSEL);
+    case cmuClock_LFB:
+    case cmuClock_LEUART0:
+      return host_cmu_select_em((CMU_Select_TypeDef)cmu->LFBCLKSEL);
+    default:
+      return 1;
+  }
+}
+
+//***********************************************************************************
+// Stand-in emlib CMU and EMU functions
+//***********************************************************************************
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable){
+  volatile uint32_t *reg = host_cmu_enable_reg(clock);
+  uint32_t value = host_cpu_read(reg);
+
+  if(enable){
+      value |= HOST_CMU_BIT(clock);
+  }
+  else{
+      value &= ~HOST_CMU_BIT(clock);
+  }
+  host_cpu_write(reg, value);
+}
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock){
+  host_charge(HOST_CHARGE_BUS, HOST_BUS_CYCLES);
+  return host_cmu_hz(clock);
+}
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref){
+  switch(clock){
+    case cmuClock_LFA:
+      host_cpu_write(&CMU->LFACLKSEL, ref);
+      break;
+    case cmuClock_LFB:
+      host_cpu_write(&CMU->LFBCLKSEL, ref);
+      break;
+    case cmuClock_HF:
+      EFM_ASSERT((ref == cmuSelect_HFRCO) || (ref == cmuSelect_HFXO));
+      break;
+    default:
+      EFM_ASSERT(false);
+      break;
+  }
+}
+
+CMU_Select_TypeDef CMU_ClockSelectGet(CMU_Clock_TypeDef clock){
+  switch(clock){
+    case cmuClock_LFA:
+      return (CMU_Select_TypeDef)host_cpu_read(&CMU->LFACLKSEL);
+    case cmuClock_LFB:
+      return (CMU_Select_TypeDef)host_cpu_read(&CMU->LFBCLKSEL);
+    case cmuClock_HF:
+      return cmuSelect_HFRCO;
+    default:
+      return cmuSelect_Error;
+  }
+}
+
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait){
+  uint32_t status = host_cpu_read(&CMU->STATUS);
+  (void)wait;
+
+  if(enable){
+      status |= HOST_CMU_BIT(osc);
+  }
+  else{
+      status &= ~HOST_CMU_BIT(osc);
+  }
+  host_cpu_write(&CMU->OSCENCMD, HOST_CMU_BIT(osc));
+  HOST_SET(host_cmu()->STATUS, status);
+}
+
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef setFreq){
+  EFM_ASSERT(setFreq == HOST_HFCLK_HZ);      //one virtual cycle is one HFCLK cycle
+  host_cpu_write(&CMU->HFRCOCTRL, setFreq);
+}
+
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit){
+  (void)hfxoInit;
+}
+
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit){
+  host_cpu_write(&EMU->DCDCCTRL, dcdcInit->dcdcMode);
+  return true;
+}
+
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init){
+  host_cpu_write(&EMU->EM23CTRL, em23Init->vScaleEM23Voltage);
+}
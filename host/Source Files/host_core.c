@@ -0,0 +1,626 @@
+/**
+ * @file
+ * host_core.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Virtual time, energy modes and the NVIC of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "em_core.h"
+#include "em_emu.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_IRQ_BIT(irq)   (1ULL << (uint32_t)(irq))
+#define HOST_STACK_SIZE     (1024*1024)     // stack of host_run's entry
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Virtual core
+ * @details
+ *  Time is counted in HFCLK cycles and only moves when something the models
+ *  can see costs time: a register access, an interrupt entry, a wake up, or
+ *  sleep. Each model runs while the core is in an energy mode its clock runs
+ *  in, so the LEUART stops in EM3 and the HF peripherals in EM2.
+ *
+ *  Interrupts have an enable, a pending latch set on the rising edge of the
+ *  peripheral's line, and the line level itself, which pends the interrupt
+ *  again when its handler returns. They do not nest, and run at the next
+ *  access, critical section exit or wake up that finds PRIMASK clear.
+ *
+ ******************************************************************************/
+static struct{
+  bool          open;
+  uint64_t      now;
+  uint32_t      em;               // energy mode the core is in
+  bool          advancing;
+  HOST_MODEL    *models;
+  HOST_ENERGY   energy;
+  uint32_t      accesses;         // host_bus_accesses at the last reset
+  // NVIC
+  bool          primask;
+  bool          in_isr;
+  uint64_t      enabled;
+  uint64_t      pending;
+  uint64_t      level;
+  uint64_t      ready_at[EXT_IRQ_COUNT];
+  uint64_t      delay[EXT_IRQ_COUNT];
+  uint32_t      count[EXT_IRQ_COUNT];
+  void          (*vector[EXT_IRQ_COUNT])(void);
+  // host_run
+  bool          running;
+  bool          suspended;        // entry is stopped in a sleep, the next host_run goes on from there
+  bool          returned;
+  bool          entry_primask;    // PRIMASK of the suspended entry
+  uint64_t      stop;
+  void          (*entry)(void);
+  ucontext_t    caller;
+  ucontext_t    context;
+}host_core;
+
+// In the static image, so like the board's RAM it is below 4 GB and the
+// LDMA can be given the address of a local
+static uint8_t host_stack[HOST_STACK_SIZE] __attribute__((aligned(16)));
+
+// Handlers of the drivers linked in, NULL for the others
+void LDMA_IRQHandler(void) __attribute__((weak));
+void GPIO_EVEN_IRQHandler(void) __attribute__((weak));
+void GPIO_ODD_IRQHandler(void) __attribute__((weak));
+void TIMER0_IRQHandler(void) __attribute__((weak));
+void I2C0_IRQHandler(void) __attribute__((weak));
+void I2C1_IRQHandler(void) __attribute__((weak));
+void LEUART0_IRQHandler(void) __attribute__((weak));
+void LETIMER0_IRQHandler(void) __attribute__((weak));
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * True if model's clock runs in the energy mode the core is in.
+ *
+ ******************************************************************************/
+static bool host_model_running(HOST_MODEL *model){
+  return model->em() >= host_core.em;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the next thing that can happen, a model event or a delayed
+ * interrupt becoming ready.
+ *
+ ******************************************************************************/
+static uint64_t host_next(void){
+  uint64_t next = HOST_NEVER;
+  uint64_t waiting = host_core.pending & host_core.enabled;
+
+  for(HOST_MODEL *model = host_core.models; model; model = model->link){
+      if(host_model_running(model)){
+          uint64_t cycles = model->next();
+          if(cycles < next){
+              next = cycles;
+          }
+      }
+  }
+  while(waiting){
+      uint32_t irq = (uint32_t)__builtin_ctzll(waiting);
+      waiting &= waiting - 1;
+      if((host_core.ready_at[irq] > host_core.now) && (host_core.ready_at[irq] - host_core.now < next)){
+          next = host_core.ready_at[irq] - host_core.now;
+      }
+  }
+  return next;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The lowest numbered interrupt that is enabled, pending and past its
+ * delay, or -1.
+ *
+ ******************************************************************************/
+static int32_t host_irq_ready(void){
+  uint64_t waiting = host_core.pending & host_core.enabled;
+
+  while(waiting){
+      uint32_t irq = (uint32_t)__builtin_ctzll(waiting);
+      waiting &= waiting - 1;
+      if(host_core.ready_at[irq] <= host_core.now){
+          return (int32_t)irq;
+      }
+  }
+  return -1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Latches irq pending, ready after its delay.
+ *
+ ******************************************************************************/
+static void host_irq_pend(uint32_t irq){
+  if(!(host_core.pending & HOST_IRQ_BIT(irq))){
+      host_core.pending |= HOST_IRQ_BIT(irq);
+      host_core.ready_at[irq] = host_core.now + host_core.delay[irq];
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends a host_run at its stop time.
+ *
+ ******************************************************************************/
+static void host_stop(void){
+  uint32_t em = host_core.em;
+
+  host_core.suspended = true;
+  host_core.entry_primask = host_core.primask;
+  swapcontext(&host_core.context, &host_core.caller);
+  host_core.em = em;
+  host_core.primask = host_core.entry_primask;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs host_run's entry on its own stack.
+ *
+ ******************************************************************************/
+static void host_entry(void){
+  host_core.entry();
+  host_core.returned = true;
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Maps the registers and opens every peripheral model, at time 0 with the
+ * core in EM0.
+ *
+ * @note
+ * Once per process. To compare configurations, fork one process per run.
+ *
+ ******************************************************************************/
+void host_init(void){
+  EFM_ASSERT(!host_core.open);
+  host_core.open = true;
+  host_core.vector[LDMA_IRQn] = LDMA_IRQHandler;
+  host_core.vector[GPIO_EVEN_IRQn] = GPIO_EVEN_IRQHandler;
+  host_core.vector[GPIO_ODD_IRQn] = GPIO_ODD_IRQHandler;
+  host_core.vector[TIMER0_IRQn] = TIMER0_IRQHandler;
+  host_core.vector[I2C0_IRQn] = I2C0_IRQHandler;
+  host_core.vector[I2C1_IRQn] = I2C1_IRQHandler;
+  host_core.vector[LEUART0_IRQn] = LEUART0_IRQHandler;
+  host_core.vector[LETIMER0_IRQn] = LETIMER0_IRQHandler;
+
+  host_bus_open();
+  host_cmu_open();
+  host_gpio_open();
+  host_ldma_open();
+  host_leuart_open();
+  host_letimer_open();
+  host_timer_open();
+  host_i2c_open();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a model to the clock, called by the models' open functions.
+ *
+ ******************************************************************************/
+void host_model_add(HOST_MODEL *model){
+  model->link = host_core.models;
+  host_core.models = model;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Virtual time since host_init, in HFCLK cycles.
+ *
+ ******************************************************************************/
+uint64_t host_now(void){
+  return host_core.now;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Energy mode the core is in, 0 while it runs.
+ *
+ ******************************************************************************/
+uint32_t host_em(void){
+  return host_core.em;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Moves time forward, running every model whose clock runs in the current
+ * energy mode, and charges it to that energy mode.
+ *
+ * @details
+ * Steps from one model event to the next so each model sees the others'
+ * events in order. Interrupts raised on the way are left pending.
+ *
+ ******************************************************************************/
+void host_advance(uint64_t cycles){
+  EFM_ASSERT(!host_core.advancing);
+  host_core.advancing = true;
+  while(cycles){
+      uint64_t step = cycles;
+      for(HOST_MODEL *model = host_core.models; model; model = model->link){
+          if(host_model_running(model)){
+              uint64_t next = model->next();
+              if(next < step){
+                  step = next;
+              }
+          }
+      }
+      EFM_ASSERT(step);
+      host_core.now += step;
+      host_core.energy.em_cycles[host_core.em] += step;
+      for(HOST_MODEL *model = host_core.models; model; model = model->link){
+          if(host_model_running(model)){
+              model->advance(step);
+          }
+      }
+      cycles -= step;
+  }
+  host_core.advancing = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Time the awake core spends on something the models can see.
+ *
+ ******************************************************************************/
+void host_charge(HOST_CHARGE charge, uint64_t cycles){
+  switch(charge){
+    case HOST_CHARGE_BUS:
+      host_core.energy.bus_cycles += cycles;
+      break;
+    case HOST_CHARGE_IRQ:
+      host_core.energy.irq_cycles += cycles;
+      break;
+    case HOST_CHARGE_SPIN:
+      host_core.energy.spin_cycles += cycles;
+      break;
+    case HOST_CHARGE_WAKE:
+      host_core.energy.wake_cycles += cycles;
+      break;
+  }
+  if(!host_core.advancing){
+      host_advance(cycles);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The core is polling a register, jumps to the next event charging the
+ * time as awake.
+ *
+ ******************************************************************************/
+void host_spin(void){
+  uint64_t next;
+
+  if(host_core.advancing || (!host_core.primask && !host_core.in_isr && (host_irq_ready() >= 0))){
+      return;
+  }
+  next = host_next();
+  if(next == HOST_NEVER){
+      host_fail("polling a register nothing will change");
+  }
+  host_charge(HOST_CHARGE_SPIN, next);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sleeps the core in em until an enabled interrupt is pending, then runs it
+ * if PRIMASK allows, like WFI.
+ *
+ * @details
+ * Leaving EM2 or EM3 is charged HOST_WAKE_CYCLES awake. The LDMA gets any
+ * request it could not serve while it slept. A sleep that would go past the
+ * stop time of host_run ends the run instead. The next host_run wakes it
+ * like an event would, since what the caller did in between may have changed
+ * the energy mode the entry can sleep in.
+ *
+ * @param[in] em
+ * 1 to 3.
+ *
+ ******************************************************************************/
+void host_sleep(uint32_t em){
+  EFM_ASSERT((em > 0) && (em < HOST_EM_COUNT));
+  EFM_ASSERT(!host_core.in_isr);
+
+  host_core.energy.sleeps[em]++;
+  host_core.em = em;
+  while(host_irq_ready() < 0){
+      uint64_t next;
+      if(host_core.running && (host_core.now >= host_core.stop)){
+          host_stop();
+          host_core.em = 0;
+          host_bus_spin_reset();
+          return;
+      }
+      next = host_next();
+      if(host_core.running && (next > host_core.stop - host_core.now)){
+          next = host_core.stop - host_core.now;
+      }
+      if(next == HOST_NEVER){
+          host_fail("sleeping in EM%u with nothing to wake the core", (unsigned)em);
+      }
+      host_advance(next);
+  }
+  host_core.em = 0;
+  host_bus_spin_reset();      //the same read after a sleep is not polling
+  if(em >= 2){
+      host_charge(HOST_CHARGE_WAKE, HOST_WAKE_CYCLES);
+  }
+  host_ldma_service();
+  host_irq_poll();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs entry for at most cycles of virtual time.
+ *
+ * @details
+ * entry runs on a stack of its own and is normally a main loop that never
+ * returns. It is suspended in the first sleep that reaches the stop time,
+ * and the caller goes on awake with its own PRIMASK. The next host_run with
+ * the same entry resumes it in that sleep, another entry starts over.
+ *
+ * @return
+ * True if entry returned by itself.
+ *
+ ******************************************************************************/
+bool host_run(void (*entry)(void), uint64_t cycles){
+  bool primask = host_core.primask;
+
+  EFM_ASSERT(!host_core.running && !host_core.in_isr);
+  host_core.stop = host_core.now + cycles;
+  host_core.running = true;
+  if(!host_core.suspended || (entry != host_core.entry)){
+      host_core.entry = entry;
+      host_core.returned = false;
+      getcontext(&host_core.context);
+      host_core.context.uc_stack.ss_sp = host_stack;
+      host_core.context.uc_stack.ss_size = sizeof(host_stack);
+      host_core.context.uc_link = &host_core.caller;
+      makecontext(&host_core.context, host_entry, 0);
+  }
+  host_core.suspended = false;
+  swapcontext(&host_core.caller, &host_core.context);
+  host_core.running = false;
+  host_core.em = 0;
+  host_core.primask = primask;
+  return host_core.returned;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Energy accounting since host_init or host_stats_reset.
+ *
+ ******************************************************************************/
+void host_energy(HOST_ENERGY *energy){
+  *energy = host_core.energy;
+  energy->accesses = host_bus_accesses() - host_core.accesses;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the energy accounting and interrupt counts over.
+ *
+ ******************************************************************************/
+void host_stats_reset(void){
+  memset(&host_core.energy, 0, sizeof(host_core.energy));
+  memset(host_core.count, 0, sizeof(host_core.count));
+  host_core.accesses = host_bus_accesses();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Handler entries of irq since host_init or host_stats_reset.
+ *
+ ******************************************************************************/
+uint32_t host_irq_count(IRQn_Type irq){
+  return host_core.count[irq];
+}
+
+/***************************************************************************//**
+ * @brief
+ * Holds irq back for cycles after it is raised, to test a handler that
+ * runs late.
+ *
+ ******************************************************************************/
+void host_irq_delay(IRQn_Type irq, uint64_t cycles){
+  host_core.delay[irq] = cycles;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A model sets the level of a peripheral's interrupt line.
+ *
+ ******************************************************************************/
+void host_irq_level(IRQn_Type irq, bool level){
+  if(level && !(host_core.level & HOST_IRQ_BIT(irq))){
+      host_irq_pend(irq);
+  }
+  if(level){
+      host_core.level |= HOST_IRQ_BIT(irq);
+  }
+  else{
+      host_core.level &= ~HOST_IRQ_BIT(irq);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the ready interrupts, lowest number first, if PRIMASK is clear and
+ * no handler is running.
+ *
+ ******************************************************************************/
+void host_irq_poll(void){
+  int32_t irq;
+
+  if(host_core.primask || host_core.in_isr || host_core.advancing){
+      return;
+  }
+  while((irq = host_irq_ready()) >= 0){
+      host_core.pending &= ~HOST_IRQ_BIT(irq);
+      if(!host_core.vector[irq]){
+          host_fail("IRQ %d raised, its driver is not linked in", (int)irq);
+      }
+      host_core.count[irq]++;
+      host_core.in_isr = true;
+      host_charge(HOST_CHARGE_IRQ, HOST_IRQ_CYCLES);
+      host_bus_spin_reset();
+      host_core.vector[irq]();
+      host_bus_spin_reset();
+      host_core.in_isr = false;
+      if(host_core.level & HOST_IRQ_BIT(irq)){
+          host_irq_pend((uint32_t)irq);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends the process with a message, for what the board would hang or fault
+ * on.
+ *
+ ******************************************************************************/
+void host_fail(const char *format, ...){
+  va_list args;
+
+  fflush(stdout);
+  fprintf(stderr, "host: at %llu cycles: ", (unsigned long long)host_core.now);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+  exit(EXIT_FAILURE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * EFM_ASSERT of the host build.
+ *
+ ******************************************************************************/
+void host_assert_failed(const char *file, int line){
+  host_fail("EFM_ASSERT failed at %s:%d", file, line);
+}
+
+/***************************************************************************//**
+ * @brief
+ * SCHEDULER_CYCLES and PROFILE_CYCLES of the host build, a monotonic clock
+ * in ns, see host_config.h.
+ *
+ ******************************************************************************/
+uint32_t host_cycles(void){
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+//***********************************************************************************
+// Stand-in emlib core and CMSIS functions
+//***********************************************************************************
+
+CORE_irqState_t CORE_EnterCritical(void){
+  CORE_irqState_t state = host_core.primask;
+
+  host_core.primask = true;
+  return state;
+}
+
+void CORE_ExitCritical(CORE_irqState_t irqState){
+  host_core.primask = irqState;
+  host_irq_poll();
+}
+
+CORE_irqState_t CORE_EnterAtomic(void){
+  return CORE_EnterCritical();
+}
+
+void CORE_ExitAtomic(CORE_irqState_t irqState){
+  CORE_ExitCritical(irqState);
+}
+
+bool CORE_InIrqContext(void){
+  return host_core.in_isr;
+}
+
+void __enable_irq(void){
+  host_core.primask = false;
+  host_irq_poll();
+}
+
+void __disable_irq(void){
+  host_core.primask = true;
+}
+
+uint32_t __get_PRIMASK(void){
+  return host_core.primask;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn){
+  host_core.enabled |= HOST_IRQ_BIT(IRQn);
+  host_irq_poll();
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn){
+  host_core.enabled &= ~HOST_IRQ_BIT(IRQn);
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn){
+  host_irq_pend((uint32_t)IRQn);
+  host_irq_poll();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn){
+  host_core.pending &= ~HOST_IRQ_BIT(IRQn);
+  if(host_core.level & HOST_IRQ_BIT(IRQn)){
+      host_irq_pend((uint32_t)IRQn);
+  }
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn){
+  return (host_core.pending & HOST_IRQ_BIT(IRQn)) != 0;
+}
+
+void EMU_EnterEM1(void){
+  host_sleep(1);
+}
+
+void EMU_EnterEM2(bool restore){
+  (void)restore;
+  host_sleep(2);
+}
+
+void EMU_EnterEM3(bool restore){
+  (void)restore;
+  host_sleep(3);
+}
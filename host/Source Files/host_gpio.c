@@ -0,0 +1,387 @@
+/**
+ * @file
+ * host_gpio.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Pins and external interrupts of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_gpio.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_GPIO_PINS      16
+#define HOST_GPIO_LINES     16
+#define HOST_GPIO_WATCHES   8
+#define HOST_GPIO_EVEN      0x5555UL
+#define HOST_GPIO_ODD       0xAAAAUL
+
+// The GPIO of the host build only has the registers the stand-in functions
+// use, packed into one block instead of the EFR32 layout
+typedef struct{
+  struct{
+    __IOM uint32_t MODEL;           // 4 bits a pin, pins 0 to 7
+    __IOM uint32_t MODEH;           // pins 8 to 15
+    __IOM uint32_t DOUT;
+    __OM  uint32_t DOUTSET;
+    __OM  uint32_t DOUTCLR;
+    __OM  uint32_t DOUTTGL;
+    __IM  uint32_t DIN;
+    __IOM uint32_t CTRL;            // drive strength
+  }P[GPIO_PORT_COUNT];
+  __IOM uint32_t EXTIPSELL;         // port of each interrupt line, 4 bits a line
+  __IOM uint32_t EXTIPSELH;
+  __IOM uint32_t EXTIPINSELL;       // pin of each interrupt line
+  __IOM uint32_t EXTIPINSELH;
+  __IOM uint32_t EXTIRISE;
+  __IOM uint32_t EXTIFALL;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+}HOST_GPIO_TypeDef;
+
+#define HOST_GPIO           ((HOST_GPIO_TypeDef *) GPIO_BASE)
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Pins
+ * @details
+ *  A pin's level comes from its mode, its DOUT and whether a device on the
+ *  board pulls it low. Push pull outputs drive DOUT, wired and outputs and
+ *  inputs with a pull up read high unless something pulls them low, and
+ *  inputs with a pull down read low. DIN is kept current in the block.
+ *  Devices see level changes through watchers, the core through the
+ *  external interrupt lines, which are edge triggered like on the EFR32 and
+ *  work in every energy mode.
+ *
+ ******************************************************************************/
+static struct{
+  uint32_t      ext_low[GPIO_PORT_COUNT];     // pins a device pulls low
+  struct{
+    GPIO_Port_TypeDef   port;
+    unsigned int        pin;
+    HOST_GPIO_WATCH     watch;
+    void                *context;
+  }watches[HOST_GPIO_WATCHES];
+  uint32_t      watch_count;
+}host_gpio;
+
+static void host_gpio_write(uint32_t offset, uint32_t value);
+
+static HOST_BLOCK host_gpio_block = { "GPIO", GPIO_BASE, NULL, host_gpio_write, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the GPIO registers.
+ *
+ ******************************************************************************/
+static HOST_GPIO_TypeDef *host_gpio_regs(void){
+  return host_alias(HOST_GPIO);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Mode of a pin, from MODEL or MODEH.
+ *
+ ******************************************************************************/
+static GPIO_Mode_TypeDef host_gpio_mode(uint32_t port, uint32_t pin){
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+  uint32_t model = (pin < 8) ? gpio->P[port].MODEL : gpio->P[port].MODEH;
+
+  return (GPIO_Mode_TypeDef)((model >> (4 * (pin & 7))) & 0xF);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Level of a pin.
+ *
+ ******************************************************************************/
+static bool host_gpio_level(uint32_t port, uint32_t pin){
+  bool dout = (host_gpio_regs()->P[port].DOUT >> pin) & 1;
+  bool ext_low = (host_gpio.ext_low[port] >> pin) & 1;
+
+  switch(host_gpio_mode(port, pin)){
+    case gpioModePushPull:
+    case gpioModePushPullAlternate:
+      return dout;
+    case gpioModeInputPull:
+    case gpioModeInputPullFilter:
+      return dout && !ext_low;        // DOUT picks the pull
+    case gpioModeWiredOrPullDown:
+      return dout;
+    case gpioModeWiredAnd:
+    case gpioModeWiredAndFilter:
+    case gpioModeWiredAndPullUp:
+    case gpioModeWiredAndPullUpFilter:
+      return dout && !ext_low;
+    default:
+      return !ext_low;                // floating, held high by whatever is on the line
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Interrupt line a pin is selected for, or -1.
+ *
+ ******************************************************************************/
+static int32_t host_gpio_line(uint32_t port, uint32_t pin){
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+
+  for(uint32_t line = 0; line < HOST_GPIO_LINES; line++){
+      uint32_t shift = 4 * (line & 7);
+      uint32_t sel = (line < 8) ? gpio->EXTIPSELL : gpio->EXTIPSELH;
+      uint32_t pinsel = (line < 8) ? gpio->EXTIPINSELL : gpio->EXTIPINSELH;
+      if((((sel >> shift) & 0xF) == port) && (((pinsel >> shift) & 0xF) == pin) &&
+         (((gpio->EXTIRISE | gpio->EXTIFALL) >> line) & 1)){
+          return (int32_t)line;
+      }
+  }
+  return -1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the two GPIO interrupt lines from IF and IEN.
+ *
+ ******************************************************************************/
+static void host_gpio_irq(void){
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+  uint32_t pending = gpio->IF & gpio->IEN;
+
+  host_irq_level(GPIO_EVEN_IRQn, (pending & HOST_GPIO_EVEN) != 0);
+  host_irq_level(GPIO_ODD_IRQn, (pending & HOST_GPIO_ODD) != 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Works out the levels of a port again, raising the interrupts and calling
+ * the watchers of the pins that changed.
+ *
+ ******************************************************************************/
+static void host_gpio_update(uint32_t port){
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+  uint32_t old = gpio->P[port].DIN;
+  uint32_t din = 0;
+  uint32_t changed;
+
+  for(uint32_t pin = 0; pin < HOST_GPIO_PINS; pin++){
+      din |= (uint32_t)host_gpio_level(port, pin) << pin;
+  }
+  HOST_SET(gpio->P[port].DIN, din);
+  changed = old ^ din;
+  for(uint32_t pin = 0; changed >> pin; pin++){
+      if(!((changed >> pin) & 1)){
+          continue;
+      }
+      bool level = (din >> pin) & 1;
+      int32_t line = host_gpio_line(port, pin);
+      if((line >= 0) && (((level ? gpio->EXTIRISE : gpio->EXTIFALL) >> line) & 1)){
+          HOST_SET(gpio->IF, gpio->IF | (1UL << line));
+      }
+      for(uint32_t i = 0; i < host_gpio.watch_count; i++){
+          if((host_gpio.watches[i].port == port) && (host_gpio.watches[i].pin == pin)){
+              host_gpio.watches[i].watch(level, host_gpio.watches[i].context);
+          }
+      }
+  }
+  host_gpio_irq();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of the GPIO block.
+ *
+ ******************************************************************************/
+static void host_gpio_write(uint32_t offset, uint32_t value){
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+  uint32_t port = offset / sizeof(gpio->P[0]);
+
+  if(port < GPIO_PORT_COUNT){
+      switch(offset % sizeof(gpio->P[0])){
+        case HOST_OFFSET(HOST_GPIO_TypeDef, P[0].DOUTSET):
+          gpio->P[port].DOUT |= value;
+          break;
+        case HOST_OFFSET(HOST_GPIO_TypeDef, P[0].DOUTCLR):
+          gpio->P[port].DOUT &= ~value;
+          break;
+        case HOST_OFFSET(HOST_GPIO_TypeDef, P[0].DOUTTGL):
+          gpio->P[port].DOUT ^= value;
+          break;
+        default:
+          break;
+      }
+      HOST_SET(gpio->P[port].DOUTSET, 0);
+      HOST_SET(gpio->P[port].DOUTCLR, 0);
+      HOST_SET(gpio->P[port].DOUTTGL, 0);
+      host_gpio_update(port);
+      return;
+  }
+  if(offset == HOST_OFFSET(HOST_GPIO_TypeDef, IFS)){
+      HOST_SET(gpio->IF, gpio->IF | value);
+      HOST_SET(gpio->IFS, 0);
+  }
+  else if(offset == HOST_OFFSET(HOST_GPIO_TypeDef, IFC)){
+      HOST_SET(gpio->IF, gpio->IF & ~value);
+      HOST_SET(gpio->IFC, 0);
+  }
+  host_gpio_irq();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes the 4 bit field of a pin or line in a pair of L and H registers.
+ *
+ ******************************************************************************/
+static void host_gpio_field(volatile uint32_t *low, volatile uint32_t *high, unsigned int index, uint32_t value){
+  volatile uint32_t *reg = (index < 8) ? low : high;
+  uint32_t shift = 4 * (index & 7);
+  uint32_t field = *(volatile uint32_t *)host_alias(reg);
+
+  host_cpu_write(reg, (field & ~(0xFUL << shift)) | ((value & 0xF) << shift));
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds the GPIO block, every pin disabled and released.
+ *
+ ******************************************************************************/
+void host_gpio_open(void){
+  host_bus_add(&host_gpio_block);
+  for(uint32_t port = 0; port < GPIO_PORT_COUNT; port++){
+      host_gpio_update(port);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Calls watch with the new level each time a pin changes.
+ *
+ ******************************************************************************/
+void host_gpio_watch(GPIO_Port_TypeDef port, unsigned int pin, HOST_GPIO_WATCH watch, void *context){
+  EFM_ASSERT(host_gpio.watch_count < HOST_GPIO_WATCHES);
+  host_gpio.watches[host_gpio.watch_count].port = port;
+  host_gpio.watches[host_gpio.watch_count].pin = pin;
+  host_gpio.watches[host_gpio.watch_count].watch = watch;
+  host_gpio.watches[host_gpio.watch_count].context = context;
+  host_gpio.watch_count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A device on the board pulls a pin low, or lets it go.
+ *
+ ******************************************************************************/
+void host_gpio_drive(GPIO_Port_TypeDef port, unsigned int pin, bool low){
+  if(low){
+      host_gpio.ext_low[port] |= 1UL << pin;
+  }
+  else{
+      host_gpio.ext_low[port] &= ~(1UL << pin);
+  }
+  host_gpio_update(port);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Level of a pin, for the devices and tests.
+ *
+ ******************************************************************************/
+bool host_gpio_get(GPIO_Port_TypeDef port, unsigned int pin){
+  return (host_gpio_regs()->P[port].DIN >> pin) & 1;
+}
+
+//***********************************************************************************
+// Stand-in emlib GPIO functions
+//***********************************************************************************
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out){
+  if(out){
+      host_cpu_write(&HOST_GPIO->P[port].DOUTSET, 1UL << pin);
+  }
+  else{
+      host_cpu_write(&HOST_GPIO->P[port].DOUTCLR, 1UL << pin);
+  }
+  host_gpio_field(&HOST_GPIO->P[port].MODEL, &HOST_GPIO->P[port].MODEH, pin, mode);
+}
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength){
+  host_cpu_write(&HOST_GPIO->P[port].CTRL, strength);
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin){
+  host_cpu_write(&HOST_GPIO->P[port].DOUTSET, 1UL << pin);
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin){
+  host_cpu_write(&HOST_GPIO->P[port].DOUTCLR, 1UL << pin);
+}
+
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin){
+  host_cpu_write(&HOST_GPIO->P[port].DOUTTGL, 1UL << pin);
+}
+
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin){
+  return (host_cpu_read(&HOST_GPIO->P[port].DOUT) >> pin) & 1;
+}
+
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin){
+  return (host_cpu_read(&HOST_GPIO->P[port].DIN) >> pin) & 1;
+}
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo, bool risingEdge, bool fallingEdge, bool enable){
+  uint32_t bit = 1UL << intNo;
+  HOST_GPIO_TypeDef *gpio = host_gpio_regs();
+
+  EFM_ASSERT(intNo < HOST_GPIO_LINES);
+  host_gpio_field(&HOST_GPIO->EXTIPSELL, &HOST_GPIO->EXTIPSELH, intNo, port);
+  host_gpio_field(&HOST_GPIO->EXTIPINSELL, &HOST_GPIO->EXTIPINSELH, intNo, pin);
+  host_cpu_write(&HOST_GPIO->EXTIRISE, risingEdge ? (gpio->EXTIRISE | bit) : (gpio->EXTIRISE & ~bit));
+  host_cpu_write(&HOST_GPIO->EXTIFALL, fallingEdge ? (gpio->EXTIFALL | bit) : (gpio->EXTIFALL & ~bit));
+  host_cpu_write(&HOST_GPIO->IFC, bit);
+  host_cpu_write(&HOST_GPIO->IEN, enable ? (gpio->IEN | bit) : (gpio->IEN & ~bit));
+}
+
+uint32_t GPIO_IntGet(void){
+  return host_cpu_read(&HOST_GPIO->IF);
+}
+
+uint32_t GPIO_IntGetEnabled(void){
+  uint32_t flags = host_cpu_read(&HOST_GPIO->IF);
+
+  return flags & host_cpu_read(&HOST_GPIO->IEN);
+}
+
+void GPIO_IntClear(uint32_t flags){
+  host_cpu_write(&HOST_GPIO->IFC, flags);
+}
+
+void GPIO_IntEnable(uint32_t flags){
+  host_cpu_write(&HOST_GPIO->IEN, host_gpio_regs()->IEN | flags);
+}
+
+void GPIO_IntDisable(uint32_t flags){
+  host_cpu_write(&HOST_GPIO->IEN, host_gpio_regs()->IEN & ~flags);
+}
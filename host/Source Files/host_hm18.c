@@ -0,0 +1,297 @@
+/**
+ * @file
+ * host_hm18.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * HM-18 BLE module on LEUART0 of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_HM18_BAUDRATE      9600                // rate out of the box
+#define HOST_HM18_GAP           HOST_MS(10)         // quiet line that ends a command
+#define HOST_HM18_RESET         HOST_MS(500)        // deaf after OK+RESET
+#define HOST_HM18_CMD_SIZE      64
+#define HOST_HM18_CENTRAL_SIZE  4096
+#define HOST_HM18_TOLERANCE     3                   // percent off its rate it still reads a byte
+#define HOST_HM18_GARBLED       0xFF                // what a byte at the wrong rate reads as
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief HM-18
+ * @details
+ *  What the firmware sees of an HM-18. AT commands have no line ending, a
+ *  quiet line of HOST_HM18_GAP ends one. AT+BAUD is stored and takes effect
+ *  at the next AT+RESET, after which the module does not listen for
+ *  HOST_HM18_RESET. With NOTI on, OK+CONN and OK+LOST are sent when a
+ *  central connects and goes. While connected, what the board sends goes to
+ *  the central, apart from a lone AT, which breaks the connection. Bytes
+ *  the board sends at another rate are read as garbage.
+ *
+ ******************************************************************************/
+static struct{
+  uint32_t          baud_index;
+  uint32_t          next_index;         // AT+BAUD, taken at the next reset
+  uint64_t          deaf_until;
+  uint64_t          last_byte;
+  char              cmd[HOST_HM18_CMD_SIZE];
+  uint32_t          cmd_len;
+  char              central[HOST_HM18_CENTRAL_SIZE];
+  uint32_t          central_head;
+  uint32_t          central_tail;
+  HOST_HM18_STATE   state;
+}host_hm18;
+
+static const uint32_t host_hm18_rates[] = {
+    9600, 19200, 38400, 57600, 115200, 4800, 2400, 1200, 230400
+};
+
+static uint32_t host_hm18_em(void);
+static uint64_t host_hm18_next(void);
+static void host_hm18_advance(uint64_t cycles);
+
+static HOST_MODEL host_hm18_model = { "HM-18", host_hm18_em, host_hm18_next, host_hm18_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Sends a reply to the board.
+ *
+ ******************************************************************************/
+static void host_hm18_reply(const char *reply){
+  while(*reply){
+      host_leuart_send((uint8_t)*reply++, host_hm18.state.baudrate);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Passes bytes from the board on to the central.
+ *
+ ******************************************************************************/
+static void host_hm18_to_central(const char *data, uint32_t len){
+  for(uint32_t i = 0; i < len; i++){
+      if(host_hm18.central_head - host_hm18.central_tail < HOST_HM18_CENTRAL_SIZE){
+          host_hm18.central[host_hm18.central_head++ % HOST_HM18_CENTRAL_SIZE] = data[i];
+          host_hm18.state.central_bytes++;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Answers an AT command, nothing for anything else.
+ *
+ ******************************************************************************/
+static void host_hm18_command(const char *cmd){
+  char reply[HOST_HM18_CMD_SIZE + 8];
+
+  if(!strcmp(cmd, "AT")){
+      host_hm18_reply("OK");
+  }
+  else if(!strcmp(cmd, "AT+NOTI1") || !strcmp(cmd, "AT+NOTI0")){
+      host_hm18.state.noti = (cmd[7] == '1');
+      snprintf(reply, sizeof(reply), "OK+Set:%c", cmd[7]);
+      host_hm18_reply(reply);
+  }
+  else if(!strncmp(cmd, "AT+BAUD", 7) && (strlen(cmd) == 8) && (cmd[7] >= '0') && (cmd[7] <= '8')){
+      host_hm18.next_index = cmd[7] - '0';
+      snprintf(reply, sizeof(reply), "OK+Set:%c", cmd[7]);
+      host_hm18_reply(reply);
+  }
+  else if(!strcmp(cmd, "AT+RESET")){
+      host_hm18_reply("OK+RESET");
+      host_hm18.state.resets++;
+      host_hm18.deaf_until = host_now() + HOST_HM18_RESET;
+  }
+  else if(!strncmp(cmd, "AT+NAME", 7) && cmd[7]){
+      snprintf(reply, sizeof(reply), "OK+Set:%s", &cmd[7]);
+      host_hm18_reply(reply);
+  }
+  else{
+      return;
+  }
+  host_hm18.state.commands++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The line went quiet, takes what came in as a command or as data.
+ *
+ ******************************************************************************/
+static void host_hm18_gap(void){
+  host_hm18.cmd[host_hm18.cmd_len] = 0;
+  if(host_hm18.state.connected){
+      if(!strcmp(host_hm18.cmd, "AT")){
+          host_hm18.state.connected = false;
+          host_hm18.state.commands++;
+          host_hm18_reply("OK+LOST");
+      }
+      else{
+          host_hm18_to_central(host_hm18.cmd, host_hm18.cmd_len);
+      }
+  }
+  else{
+      host_hm18_command(host_hm18.cmd);
+  }
+  host_hm18.cmd_len = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A byte from the board, LEUART0 peer.
+ *
+ ******************************************************************************/
+static void host_hm18_receive(uint8_t byte, uint32_t baudrate){
+  uint32_t rate = host_hm18.state.baudrate;
+  uint32_t diff = (baudrate > rate) ? baudrate - rate : rate - baudrate;
+
+  if(host_now() < host_hm18.deaf_until){
+      return;
+  }
+  if((uint64_t)diff * 100 > (uint64_t)rate * HOST_HM18_TOLERANCE){
+      byte = HOST_HM18_GARBLED;
+  }
+  host_hm18.last_byte = host_now();
+  if(host_hm18.cmd_len == HOST_HM18_CMD_SIZE - 1){
+      if(host_hm18.state.connected){
+          host_hm18_to_central(host_hm18.cmd, host_hm18.cmd_len);
+      }
+      host_hm18.cmd_len = 0;
+  }
+  host_hm18.cmd[host_hm18.cmd_len++] = (char)byte;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The module is powered on its own, whatever the core does.
+ *
+ ******************************************************************************/
+static uint32_t host_hm18_em(void){
+  return HOST_EM_COUNT - 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the end of a command or of a reset.
+ *
+ ******************************************************************************/
+static uint64_t host_hm18_next(void){
+  uint64_t when = HOST_NEVER;
+
+  if(host_hm18.cmd_len){
+      when = host_hm18.last_byte + HOST_HM18_GAP;
+  }
+  if(host_hm18.deaf_until && (host_hm18.deaf_until < when)){
+      when = host_hm18.deaf_until;
+  }
+  if(when == HOST_NEVER){
+      return HOST_NEVER;
+  }
+  return (when > host_now()) ? when - host_now() : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends a command or a reset that came due.
+ *
+ ******************************************************************************/
+static void host_hm18_advance(uint64_t cycles){
+  (void)cycles;
+  if(host_hm18.deaf_until && (host_hm18.deaf_until <= host_now())){
+      host_hm18.deaf_until = 0;
+      host_hm18.baud_index = host_hm18.next_index;
+      host_hm18.state.baudrate = host_hm18_rates[host_hm18.baud_index];
+      host_hm18.state.connected = false;
+  }
+  if(host_hm18.cmd_len && (host_hm18.last_byte + HOST_HM18_GAP <= host_now())){
+      host_hm18_gap();
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Puts an HM-18 on LEUART0, at 9600 with NOTI off and no central.
+ *
+ ******************************************************************************/
+void host_hm18_init(void){
+  memset(&host_hm18, 0, sizeof(host_hm18));
+  host_hm18.state.baudrate = HOST_HM18_BAUDRATE;
+  host_leuart_peer(host_hm18_receive);
+  host_model_add(&host_hm18_model);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A central connects or goes away.
+ *
+ ******************************************************************************/
+void host_hm18_connect(bool connected){
+  if(connected == host_hm18.state.connected){
+      return;
+  }
+  host_hm18.state.connected = connected;
+  if(host_hm18.state.noti){
+      host_hm18_reply(connected ? "OK+CONN" : "OK+LOST");
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The central sends a string to the board.
+ *
+ ******************************************************************************/
+void host_hm18_central_send(const char *string){
+  EFM_ASSERT(host_hm18.state.connected);
+  host_hm18_reply(string);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Takes what the central got so far.
+ *
+ * @return
+ * Bytes put in buf, which is not terminated.
+ *
+ ******************************************************************************/
+uint32_t host_hm18_central_read(char *buf, uint32_t max_len){
+  uint32_t len = 0;
+
+  while((len < max_len) && (host_hm18.central_tail != host_hm18.central_head)){
+      buf[len++] = host_hm18.central[host_hm18.central_tail++ % HOST_HM18_CENTRAL_SIZE];
+  }
+  return len;
+}
+
+/***************************************************************************//**
+ * @brief
+ * What the module is doing.
+ *
+ ******************************************************************************/
+void host_hm18_state(HOST_HM18_STATE *state){
+  *state = host_hm18.state;
+}
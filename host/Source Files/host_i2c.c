@@ -0,0 +1,879 @@
+/**
+ * @file
+ * host_i2c.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * I2C0 and I2C1 masters and their buses of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_i2c.h"
+#include "em_ldma.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_I2C_BUSES          2
+#define HOST_I2C_CTRL_CLHR_SHIFT  8     // CTRL.CLHR, low and high periods of SCL
+#define HOST_I2C_CTRL_CLHR_MASK   (0x3UL << HOST_I2C_CTRL_CLHR_SHIFT)
+
+// Bit times of each part of a transaction
+#define HOST_I2C_START_BITS     1
+#define HOST_I2C_STOP_BITS      1
+#define HOST_I2C_BYTE_BITS      9       // 8 data bits and the slave's ACK
+#define HOST_I2C_RX_BITS        8       // the master's ACK goes out separately
+#define HOST_I2C_ACK_BITS       1
+
+#define HOST_I2C_LEVEL_FLAGS    (I2C_IF_TXBL | I2C_IF_RXDATAV)
+
+// What the master is doing
+typedef enum{
+  host_i2c_idle,
+  host_i2c_start_wait,        // START waits for SDA to come up
+  host_i2c_starting,
+  host_i2c_addr_wait,         // START is out, holds the bus for the address
+  host_i2c_addr,              // address byte and its ACK
+  host_i2c_tx,                // data byte and its ACK
+  host_i2c_tx_wait,           // ACKed, holds the bus for TXDATA, START or STOP
+  host_i2c_rx,                // data byte in from the slave
+  host_i2c_rx_full,           // byte in, RXDATA not read yet, holds SCL
+  host_i2c_ack_wait,          // byte in RXDATA, holds the bus for ACK or NACK
+  host_i2c_acking,            // the master's ACK or NACK
+  host_i2c_nacked,            // NACKed, holds the bus for START or STOP
+  host_i2c_stopping,
+  host_i2c_stuck              // a slave stretches SCL until ABORT
+}HOST_I2C_STATE;
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief I2C buses
+ * @details
+ *  Each master runs its part of the bus protocol against the slaves attached
+ *  to its bus, one bit time at a time from CLKDIV and CLHR, and holds the
+ *  bus where the EFR32 would: after an ACK with nothing to send, after a
+ *  received byte without AUTOACK, and after a NACK, each until the command
+ *  it needs. START and STOP are latched and done at the next point they
+ *  can be. TXDATA and RXDATA are one byte deep. AUTOACK acks a byte as it
+ *  lands in RXDATA, before the LDMA gets to see it.
+ *
+ *  host_i2c_fault puts faults in the next transactions so the driver's
+ *  recovery can be run on the host. SDA stuck low is done with the pins, so
+ *  only the driver's bus recovery, clocking SCL by GPIO, lets it go.
+ *
+ ******************************************************************************/
+typedef struct{
+  I2C_TypeDef       *i2c;
+  IRQn_Type         irq;
+  CMU_Clock_TypeDef clock;
+  uint32_t          rx_signal;
+  uint32_t          tx_signal;
+  HOST_I2C_DEVICE   *devices[HOST_I2C_DEVICES];
+  uint32_t          device_count;
+  HOST_I2C_DEVICE   *selected;            // slave that acked the last address
+  bool              reading;
+  HOST_I2C_STATE    state;
+  uint64_t          state_end;            // end of a timed state
+  bool              start_pending;
+  bool              stop_pending;
+  bool              repeated;             // the START being sent follows another
+  bool              tx_full;
+  uint8_t           shift;                // byte going out or coming in
+  bool              ack;                  // master's answer in host_i2c_acking
+  bool              place_pending;        // rx_full byte goes in once RXDATA is read
+  uint32_t          faults[HOST_I2C_FAULTS];
+  bool              pins;
+  GPIO_Port_TypeDef scl_port;
+  unsigned int      scl_pin;
+  GPIO_Port_TypeDef sda_port;
+  unsigned int      sda_pin;
+  uint32_t          sda_clocks;           // SCL rising edges until a stuck SDA is let go
+  HOST_I2C_STATS    stats;
+}HOST_I2C_BUS;
+
+static HOST_I2C_BUS host_i2c_bus[HOST_I2C_BUSES];
+
+static void host_i2c0_read(uint32_t offset);
+static void host_i2c1_read(uint32_t offset);
+static void host_i2c0_write(uint32_t offset, uint32_t value);
+static void host_i2c1_write(uint32_t offset, uint32_t value);
+static uint32_t host_i2c_em(void);
+static uint64_t host_i2c_next(void);
+static void host_i2c_advance(uint64_t cycles);
+
+static HOST_BLOCK host_i2c0_block = { "I2C0", I2C0_BASE, host_i2c0_read, host_i2c0_write, NULL };
+static HOST_BLOCK host_i2c1_block = { "I2C1", I2C1_BASE, host_i2c1_read, host_i2c1_write, NULL };
+static HOST_MODEL host_i2c_model = { "I2C", host_i2c_em, host_i2c_next, host_i2c_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The bus of an I2C peripheral.
+ *
+ ******************************************************************************/
+static HOST_I2C_BUS *host_i2c_find(I2C_TypeDef *i2c){
+  for(uint32_t i = 0; i < HOST_I2C_BUSES; i++){
+      if(host_i2c_bus[i].i2c == i2c){
+          return &host_i2c_bus[i];
+      }
+  }
+  host_fail("no I2C model at %p", (void *)i2c);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of a bus's registers.
+ *
+ ******************************************************************************/
+static I2C_TypeDef *host_i2c_regs(HOST_I2C_BUS *bus){
+  return host_alias(bus->i2c);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles of one bit time.
+ *
+ ******************************************************************************/
+static uint64_t host_i2c_bit(HOST_I2C_BUS *bus){
+  static const uint32_t periods[] = { 8, 9, 17 };     // CLHR standard, asymmetric, fast
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+  uint32_t clhr = (i2c->CTRL & HOST_I2C_CTRL_CLHR_MASK) >> HOST_I2C_CTRL_CLHR_SHIFT;
+  uint32_t hz = host_cmu_hz(bus->clock);
+
+  if(!hz || (clhr > 2)){
+      host_fail("%s runs with its clock off or a bad CLHR", (bus->i2c == I2C0) ? "I2C0" : "I2C1");
+  }
+  return ((uint64_t)(i2c->CLKDIV + 1) * periods[clhr] * HOST_HFCLK_HZ) / hz;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Goes into a state that lasts bits bit times.
+ *
+ ******************************************************************************/
+static void host_i2c_timed(HOST_I2C_BUS *bus, HOST_I2C_STATE state, uint32_t bits){
+  bus->state = state;
+  bus->state_end = host_now() + bits * host_i2c_bit(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Takes one from a fault's count, true if it was armed.
+ *
+ ******************************************************************************/
+static bool host_i2c_take(HOST_I2C_BUS *bus, HOST_I2C_FAULT fault){
+  if(!bus->faults[fault]){
+      return false;
+  }
+  bus->faults[fault]--;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets flags in IF.
+ *
+ ******************************************************************************/
+static void host_i2c_flag(HOST_I2C_BUS *bus, uint32_t flags){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  HOST_SET(i2c->IF, i2c->IF | flags);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The selected slave is done, at a STOP, repeated START or ABORT.
+ *
+ ******************************************************************************/
+static void host_i2c_release(HOST_I2C_BUS *bus){
+  if(bus->selected && bus->selected->stop){
+      bus->selected->stop(bus->selected->context);
+  }
+  bus->selected = NULL;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Back to idle, nothing latched.
+ *
+ ******************************************************************************/
+static void host_i2c_idle_state(HOST_I2C_BUS *bus){
+  bus->state = host_i2c_idle;
+  bus->start_pending = false;
+  bus->stop_pending = false;
+  bus->place_pending = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends a START if SDA lets it, otherwise waits for it.
+ *
+ ******************************************************************************/
+static void host_i2c_start(HOST_I2C_BUS *bus){
+  bus->start_pending = false;
+  if(bus->pins && host_i2c_take(bus, HOST_I2C_SDA_STUCK)){
+      bus->sda_clocks = bus->faults[HOST_I2C_SDA_STUCK] + 1;
+      bus->faults[HOST_I2C_SDA_STUCK] = 0;
+      host_gpio_drive(bus->sda_port, bus->sda_pin, true);
+  }
+  if(bus->pins && !host_gpio_get(bus->sda_port, bus->sda_pin)){
+      bus->state = host_i2c_start_wait;
+      return;
+  }
+  host_i2c_timed(bus, host_i2c_starting, HOST_I2C_START_BITS);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the byte in TXDATA, the address if it follows a START.
+ *
+ ******************************************************************************/
+static void host_i2c_send(HOST_I2C_BUS *bus, HOST_I2C_STATE state){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  bus->tx_full = false;
+  bus->shift = (uint8_t)i2c->TXDATA;
+  if(host_i2c_take(bus, HOST_I2C_SCL_STUCK)){
+      bus->state = host_i2c_stuck;
+      return;
+  }
+  host_i2c_timed(bus, state, HOST_I2C_BYTE_BITS);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Carries on after the bus is held, with a START, STOP or the byte in TXDATA
+ * if there is one, or holds it in hold.
+ *
+ ******************************************************************************/
+static void host_i2c_carry_on(HOST_I2C_BUS *bus, HOST_I2C_STATE hold){
+  if(bus->start_pending){
+      bus->repeated = true;
+      host_i2c_start(bus);
+  }
+  else if((hold == host_i2c_tx_wait) && bus->tx_full){
+      host_i2c_send(bus, host_i2c_tx);
+  }
+  else if(bus->stop_pending){
+      host_i2c_timed(bus, host_i2c_stopping, HOST_I2C_STOP_BITS);
+  }
+  else{
+      bus->state = hold;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The slave's answer to a byte the master sent.
+ *
+ ******************************************************************************/
+static void host_i2c_answer(HOST_I2C_BUS *bus, bool ack){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+  uint32_t status = i2c->STATUS & ~(I2C_STATUS_PACK | I2C_STATUS_PNACK);
+
+  bus->stats.bytes_out++;
+  if(!ack){
+      HOST_SET(i2c->STATUS, status | I2C_STATUS_PNACK);
+      host_i2c_flag(bus, I2C_IF_NACK);
+      host_i2c_release(bus);
+      host_i2c_carry_on(bus, host_i2c_nacked);
+      return;
+  }
+  HOST_SET(i2c->STATUS, status | I2C_STATUS_PACK);
+  if(!host_i2c_take(bus, HOST_I2C_LOST_ACK)){
+      host_i2c_flag(bus, I2C_IF_ACK);
+  }
+  if(bus->reading){
+      host_i2c_timed(bus, host_i2c_rx, HOST_I2C_RX_BITS);
+      return;
+  }
+  host_i2c_carry_on(bus, host_i2c_tx_wait);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A byte the master sent is out, unless it lost the bus on the way.
+ *
+ * @return
+ * True if the byte went out.
+ *
+ ******************************************************************************/
+static bool host_i2c_sent(HOST_I2C_BUS *bus){
+  if(host_i2c_take(bus, HOST_I2C_ARBLOST)){
+      host_i2c_flag(bus, I2C_IF_ARBLOST);
+  }
+  else if(host_i2c_take(bus, HOST_I2C_BUSERR)){
+      host_i2c_flag(bus, I2C_IF_BUSERR);
+  }
+  else{
+      return true;
+  }
+  host_i2c_release(bus);
+  host_i2c_idle_state(bus);
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The address byte is out.
+ *
+ ******************************************************************************/
+static void host_i2c_addr_done(HOST_I2C_BUS *bus){
+  uint8_t address = bus->shift >> 1;
+  HOST_I2C_DEVICE *device = NULL;
+
+  if(!host_i2c_sent(bus)){
+      return;
+  }
+  bus->reading = bus->shift & 1;
+  for(uint32_t i = 0; i < bus->device_count; i++){
+      if(bus->devices[i]->address == address){
+          device = bus->devices[i];
+      }
+  }
+  if(host_i2c_take(bus, HOST_I2C_NACK_ADDR) || !device || !device->start(device->context, bus->reading)){
+      host_i2c_answer(bus, false);
+      return;
+  }
+  bus->selected = device;
+  host_i2c_answer(bus, true);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A data byte is out.
+ *
+ ******************************************************************************/
+static void host_i2c_tx_done(HOST_I2C_BUS *bus){
+  bool ack;
+
+  if(!host_i2c_sent(bus)){
+      return;
+  }
+  ack = bus->selected->write(bus->selected->context, bus->shift);
+  host_i2c_answer(bus, ack && !host_i2c_take(bus, HOST_I2C_NACK_DATA));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts the byte just in into RXDATA and acks it if AUTOACK is on.
+ *
+ ******************************************************************************/
+static void host_i2c_place(HOST_I2C_BUS *bus){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+  bool autoack = (i2c->CTRL & I2C_CTRL_AUTOACK) != 0;     //before the LDMA can turn it off
+
+  bus->place_pending = false;
+  HOST_SET(i2c->RXDATA, bus->shift);
+  HOST_SET(i2c->STATUS, i2c->STATUS | I2C_STATUS_RXDATAV);
+  if(autoack){
+      bus->ack = true;
+      host_i2c_timed(bus, host_i2c_acking, HOST_I2C_ACK_BITS);
+  }
+  else{
+      bus->state = host_i2c_ack_wait;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * A byte from the slave is in.
+ *
+ ******************************************************************************/
+static void host_i2c_rx_done(HOST_I2C_BUS *bus){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  bus->shift = bus->selected->read(bus->selected->context);
+  bus->stats.bytes_in++;
+  if(i2c->STATUS & I2C_STATUS_RXDATAV){
+      bus->state = host_i2c_rx_full;
+      return;
+  }
+  host_i2c_place(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The master's ACK or NACK is out.
+ *
+ ******************************************************************************/
+static void host_i2c_ack_done(HOST_I2C_BUS *bus){
+  if(bus->selected->read_ack){
+      bus->selected->read_ack(bus->selected->context, bus->ack);
+  }
+  if(bus->ack){
+      host_i2c_timed(bus, host_i2c_rx, HOST_I2C_RX_BITS);
+      return;
+  }
+  bus->stats.master_nacks++;
+  host_i2c_carry_on(bus, host_i2c_nacked);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends the timed state that came due.
+ *
+ ******************************************************************************/
+static void host_i2c_step(HOST_I2C_BUS *bus){
+  switch(bus->state){
+    case host_i2c_starting:
+      bus->stats.starts++;
+      host_i2c_flag(bus, bus->repeated ? (I2C_IF_START | I2C_IF_RSTART) : I2C_IF_START);
+      host_i2c_release(bus);
+      if(bus->tx_full){
+          host_i2c_send(bus, host_i2c_addr);
+      }
+      else if(bus->stop_pending){
+          host_i2c_timed(bus, host_i2c_stopping, HOST_I2C_STOP_BITS);
+      }
+      else{
+          bus->state = host_i2c_addr_wait;
+      }
+      break;
+    case host_i2c_addr:
+      host_i2c_addr_done(bus);
+      break;
+    case host_i2c_tx:
+      host_i2c_tx_done(bus);
+      break;
+    case host_i2c_rx:
+      host_i2c_rx_done(bus);
+      break;
+    case host_i2c_rx_full:
+      host_i2c_place(bus);
+      break;
+    case host_i2c_acking:
+      host_i2c_ack_done(bus);
+      break;
+    case host_i2c_stopping:
+      bus->stats.stops++;
+      host_i2c_release(bus);
+      host_i2c_idle_state(bus);
+      host_i2c_flag(bus, I2C_IF_MSTOP);
+      break;
+    default:
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * True if a state ends on its own after state_end.
+ *
+ ******************************************************************************/
+static bool host_i2c_is_timed(HOST_I2C_BUS *bus){
+  switch(bus->state){
+    case host_i2c_starting:
+    case host_i2c_addr:
+    case host_i2c_tx:
+    case host_i2c_rx:
+    case host_i2c_acking:
+    case host_i2c_stopping:
+      return true;
+    case host_i2c_rx_full:
+      return bus->place_pending;
+    default:
+      return false;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets STATE, the level flags and the interrupt line, and gives the LDMA a
+ * look at the new requests.
+ *
+ ******************************************************************************/
+static void host_i2c_update(HOST_I2C_BUS *bus){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+  uint32_t state = 0;
+  uint32_t status = i2c->STATUS & ~(I2C_STATUS_TXBL | I2C_STATUS_PSTART | I2C_STATUS_PSTOP);
+  uint32_t flags = i2c->IF & ~HOST_I2C_LEVEL_FLAGS;
+
+  switch(bus->state){
+    case host_i2c_idle:
+      state = I2C_STATE_STATE_IDLE;
+      break;
+    case host_i2c_start_wait:
+      state = I2C_STATE_BUSY | I2C_STATE_STATE_WAIT;
+      break;
+    case host_i2c_starting:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_STATE_START;
+      break;
+    case host_i2c_addr_wait:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_BUSHOLD | I2C_STATE_STATE_START;
+      break;
+    case host_i2c_addr:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_TRANSMITTER | I2C_STATE_STATE_ADDR;
+      break;
+    case host_i2c_tx:
+    case host_i2c_stuck:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_TRANSMITTER | I2C_STATE_STATE_DATA;
+      break;
+    case host_i2c_tx_wait:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_TRANSMITTER | I2C_STATE_BUSHOLD | I2C_STATE_STATE_DATAACK;
+      break;
+    case host_i2c_rx:
+    case host_i2c_acking:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_STATE_DATA;
+      break;
+    case host_i2c_rx_full:
+    case host_i2c_ack_wait:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_BUSHOLD | I2C_STATE_STATE_DATA;
+      break;
+    case host_i2c_nacked:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_NACKED | I2C_STATE_BUSHOLD | I2C_STATE_STATE_DATAACK;
+      break;
+    case host_i2c_stopping:
+      state = I2C_STATE_BUSY | I2C_STATE_MASTER | I2C_STATE_STATE_DATAACK;
+      break;
+  }
+  if(!bus->tx_full){
+      status |= I2C_STATUS_TXBL;
+      flags |= I2C_IF_TXBL;
+  }
+  if(status & I2C_STATUS_RXDATAV){
+      flags |= I2C_IF_RXDATAV;
+  }
+  status |= bus->start_pending ? I2C_STATUS_PSTART : 0;
+  status |= bus->stop_pending ? I2C_STATUS_PSTOP : 0;
+  HOST_SET(i2c->STATE, state);
+  HOST_SET(i2c->STATUS, status);
+  HOST_SET(i2c->IF, flags);
+  host_irq_level(bus->irq, (flags & i2c->IEN) != 0);
+  host_ldma_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs a CMD write.
+ *
+ ******************************************************************************/
+static void host_i2c_cmd(HOST_I2C_BUS *bus, uint32_t cmd){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  HOST_SET(i2c->CMD, 0);
+  if(cmd & I2C_CMD_ABORT){
+      if(bus->state != host_i2c_idle){
+          bus->stats.aborts++;
+      }
+      host_i2c_release(bus);
+      host_i2c_idle_state(bus);
+      bus->repeated = false;
+  }
+  if(cmd & I2C_CMD_CLEARTX){
+      bus->tx_full = false;
+  }
+  if(cmd & I2C_CMD_START){
+      bus->start_pending = true;
+  }
+  if(cmd & I2C_CMD_STOP){
+      bus->stop_pending = (bus->state != host_i2c_idle) || bus->start_pending;
+  }
+  if(cmd & (I2C_CMD_ACK | I2C_CMD_NACK)){
+      if(bus->state == host_i2c_ack_wait){
+          bus->ack = (cmd & I2C_CMD_ACK) != 0;
+          host_i2c_timed(bus, host_i2c_acking, HOST_I2C_ACK_BITS);
+      }
+  }
+  switch(bus->state){
+    case host_i2c_idle:
+      if(bus->start_pending){
+          bus->repeated = false;
+          host_i2c_start(bus);
+      }
+      break;
+    case host_i2c_addr_wait:
+    case host_i2c_tx_wait:
+    case host_i2c_nacked:
+      host_i2c_carry_on(bus, bus->state);
+      break;
+    default:
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Read hook of both buses, reading RXDATA empties it.
+ *
+ ******************************************************************************/
+static void host_i2c_read(HOST_I2C_BUS *bus, uint32_t offset){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  if(offset != HOST_OFFSET(I2C_TypeDef, RXDATA)){
+      return;
+  }
+  if(i2c->STATUS & I2C_STATUS_RXDATAV){
+      HOST_SET(i2c->STATUS, i2c->STATUS & ~I2C_STATUS_RXDATAV);
+  }
+  else{
+      host_i2c_flag(bus, I2C_IF_RXUF);
+  }
+  if(bus->state == host_i2c_rx_full){
+      bus->place_pending = true;        //after this read has its byte
+      bus->state_end = host_now() + 1;
+  }
+  host_i2c_update(bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of both buses.
+ *
+ ******************************************************************************/
+static void host_i2c_write(HOST_I2C_BUS *bus, uint32_t offset, uint32_t value){
+  I2C_TypeDef *i2c = host_i2c_regs(bus);
+
+  switch(offset){
+    case HOST_OFFSET(I2C_TypeDef, CMD):
+      host_i2c_cmd(bus, value);
+      break;
+    case HOST_OFFSET(I2C_TypeDef, TXDATA):
+      if(bus->tx_full){
+          host_i2c_flag(bus, I2C_IF_TXOF);
+          break;
+      }
+      bus->tx_full = true;
+      if(bus->state == host_i2c_addr_wait){
+          host_i2c_send(bus, host_i2c_addr);
+      }
+      else if(bus->state == host_i2c_tx_wait){
+          host_i2c_send(bus, host_i2c_tx);
+      }
+      break;
+    case HOST_OFFSET(I2C_TypeDef, IFS):
+      host_i2c_flag(bus, value & ~HOST_I2C_LEVEL_FLAGS);
+      HOST_SET(i2c->IFS, 0);
+      break;
+    case HOST_OFFSET(I2C_TypeDef, IFC):
+      HOST_SET(i2c->IF, i2c->IF & ~value);
+      HOST_SET(i2c->IFC, 0);
+      break;
+    case HOST_OFFSET(I2C_TypeDef, ROUTEPEN):
+      if((bus->state == host_i2c_start_wait) && value && (!bus->pins || host_gpio_get(bus->sda_port, bus->sda_pin))){
+          host_i2c_timed(bus, host_i2c_starting, HOST_I2C_START_BITS);
+      }
+      break;
+    default:
+      break;
+  }
+  host_i2c_update(bus);
+}
+
+static void host_i2c0_read(uint32_t offset){
+  host_i2c_read(&host_i2c_bus[0], offset);
+}
+
+static void host_i2c1_read(uint32_t offset){
+  host_i2c_read(&host_i2c_bus[1], offset);
+}
+
+static void host_i2c0_write(uint32_t offset, uint32_t value){
+  host_i2c_write(&host_i2c_bus[0], offset, value);
+}
+
+static void host_i2c1_write(uint32_t offset, uint32_t value){
+  host_i2c_write(&host_i2c_bus[1], offset, value);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A slave holding SDA low counts SCL clocks from the driver's bus recovery.
+ *
+ ******************************************************************************/
+static void host_i2c_scl_watch(bool level, void *context){
+  HOST_I2C_BUS *bus = context;
+
+  if(!level || !bus->sda_clocks){
+      return;
+  }
+  if(--bus->sda_clocks == 0){
+      host_gpio_drive(bus->sda_port, bus->sda_pin, false);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The I2C peripherals run on HFPERCLK, which stops in EM2.
+ *
+ ******************************************************************************/
+static uint32_t host_i2c_em(void){
+  return 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the end of the soonest timed state.
+ *
+ ******************************************************************************/
+static uint64_t host_i2c_next(void){
+  uint64_t next = HOST_NEVER;
+
+  for(uint32_t i = 0; i < HOST_I2C_BUSES; i++){
+      HOST_I2C_BUS *bus = &host_i2c_bus[i];
+      if(host_i2c_is_timed(bus)){
+          uint64_t cycles = (bus->state_end > host_now()) ? bus->state_end - host_now() : 1;
+          if(cycles < next){
+              next = cycles;
+          }
+      }
+  }
+  return next;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends the timed states that came due.
+ *
+ ******************************************************************************/
+static void host_i2c_advance(uint64_t cycles){
+  (void)cycles;
+  for(uint32_t i = 0; i < HOST_I2C_BUSES; i++){
+      HOST_I2C_BUS *bus = &host_i2c_bus[i];
+      if(host_i2c_is_timed(bus) && (bus->state_end <= host_now())){
+          host_i2c_step(bus);
+          host_i2c_update(bus);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets up one bus.
+ *
+ ******************************************************************************/
+static void host_i2c_bus_open(HOST_I2C_BUS *bus, I2C_TypeDef *i2c, IRQn_Type irq, CMU_Clock_TypeDef clock, uint32_t rx_signal, uint32_t tx_signal){
+  bus->i2c = i2c;
+  bus->irq = irq;
+  bus->clock = clock;
+  bus->rx_signal = rx_signal;
+  bus->tx_signal = tx_signal;
+  host_i2c_update(bus);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds I2C0 and I2C1, each with an empty bus.
+ *
+ ******************************************************************************/
+void host_i2c_open(void){
+  host_bus_add(&host_i2c0_block);
+  host_bus_add(&host_i2c1_block);
+  host_model_add(&host_i2c_model);
+  host_i2c_bus_open(&host_i2c_bus[0], I2C0, I2C0_IRQn, cmuClock_I2C0,
+                    ldmaPeripheralSignal_I2C0_RXDATAV, ldmaPeripheralSignal_I2C0_TXBL);
+  host_i2c_bus_open(&host_i2c_bus[1], I2C1, I2C1_IRQn, cmuClock_I2C1,
+                    ldmaPeripheralSignal_I2C1_RXDATAV, ldmaPeripheralSignal_I2C1_TXBL);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts a slave on the bus of i2c.
+ *
+ ******************************************************************************/
+void host_i2c_attach(I2C_TypeDef *i2c, HOST_I2C_DEVICE *device){
+  HOST_I2C_BUS *bus = host_i2c_find(i2c);
+
+  EFM_ASSERT(bus->device_count < HOST_I2C_DEVICES);
+  bus->devices[bus->device_count++] = device;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Pins of a bus, for HOST_I2C_SDA_STUCK.
+ *
+ ******************************************************************************/
+void host_i2c_pins(I2C_TypeDef *i2c, GPIO_Port_TypeDef scl_port, unsigned int scl_pin, GPIO_Port_TypeDef sda_port, unsigned int sda_pin){
+  HOST_I2C_BUS *bus = host_i2c_find(i2c);
+
+  bus->pins = true;
+  bus->scl_port = scl_port;
+  bus->scl_pin = scl_pin;
+  bus->sda_port = sda_port;
+  bus->sda_pin = sda_pin;
+  host_gpio_watch(scl_port, scl_pin, host_i2c_scl_watch, bus);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Arms a fault for the next bytes on a bus.
+ *
+ * @param[in] count
+ * Bytes it hits, or for HOST_I2C_SDA_STUCK the SCL clocks the slave needs
+ * to let SDA go, from the next START on.
+ *
+ ******************************************************************************/
+void host_i2c_fault(I2C_TypeDef *i2c, HOST_I2C_FAULT fault, uint32_t count){
+  HOST_I2C_BUS *bus = host_i2c_find(i2c);
+
+  EFM_ASSERT((fault != HOST_I2C_SDA_STUCK) || bus->pins);
+  bus->faults[fault] = count;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Bus counters since host_init.
+ *
+ ******************************************************************************/
+void host_i2c_stats(I2C_TypeDef *i2c, HOST_I2C_STATS *stats){
+  *stats = host_i2c_find(i2c)->stats;
+}
+
+/***************************************************************************//**
+ * @brief
+ * LDMA request of a bus.
+ *
+ ******************************************************************************/
+bool host_i2c_dma_request(uint32_t signal){
+  for(uint32_t i = 0; i < HOST_I2C_BUSES; i++){
+      HOST_I2C_BUS *bus = &host_i2c_bus[i];
+      I2C_TypeDef *i2c = host_i2c_regs(bus);
+      if(signal == bus->rx_signal){
+          return (i2c->STATUS & I2C_STATUS_RXDATAV) != 0;
+      }
+      if(signal == bus->tx_signal){
+          return !bus->tx_full;
+      }
+  }
+  return false;
+}
+
+//***********************************************************************************
+// Stand-in emlib I2C functions
+//***********************************************************************************
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init){
+  static const uint32_t periods[] = { 8, 9, 17 };
+  uint32_t ref = init->refFreq ? init->refFreq : CMU_ClockFreqGet(i2c == I2C0 ? cmuClock_I2C0 : cmuClock_I2C1);
+  uint32_t per_bit = periods[init->clhr] * init->freq;
+  uint32_t clkdiv = (ref + per_bit - 1) / per_bit;
+
+  EFM_ASSERT(init->master && init->freq && clkdiv);
+  host_cpu_write(&i2c->CTRL, (uint32_t)init->clhr << HOST_I2C_CTRL_CLHR_SHIFT);
+  host_cpu_write(&i2c->CLKDIV, clkdiv - 1);
+  I2C_Enable(i2c, init->enable);
+}
+
+void I2C_Enable(I2C_TypeDef *i2c, bool enable){
+  uint32_t ctrl = host_cpu_read(&i2c->CTRL);
+
+  host_cpu_write(&i2c->CTRL, enable ? (ctrl | I2C_CTRL_EN) : (ctrl & ~I2C_CTRL_EN));
+}
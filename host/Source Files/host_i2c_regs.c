@@ -0,0 +1,147 @@
+/**
+ * @file
+ * host_i2c_regs.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Register slave for the I2C buses of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <string.h>
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Transaction being logged, NULL once the log is full.
+ *
+ ******************************************************************************/
+static HOST_I2C_XFER *host_i2c_regs_xfer(HOST_I2C_REGS *slave){
+  if(!slave->log_count || (slave->log_count > HOST_I2C_LOG_SIZE)){
+      return NULL;
+  }
+  return &slave->log[slave->log_count - 1];
+}
+
+/***************************************************************************//**
+ * @brief
+ * The address was acked, a transaction begins.
+ *
+ ******************************************************************************/
+static bool host_i2c_regs_start(void *context, bool read){
+  HOST_I2C_REGS *slave = context;
+  HOST_I2C_XFER *xfer;
+
+  slave->reading = read;
+  slave->pointer_set = false;
+  slave->log_count++;
+  xfer = host_i2c_regs_xfer(slave);
+  if(xfer){
+      xfer->read = read;
+      xfer->reg = slave->pointer;
+      xfer->length = 0;
+      xfer->nack_at = 0;
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A byte from the master, the register pointer first.
+ *
+ ******************************************************************************/
+static bool host_i2c_regs_write(void *context, uint8_t byte){
+  HOST_I2C_REGS *slave = context;
+  HOST_I2C_XFER *xfer = host_i2c_regs_xfer(slave);
+
+  if(!slave->pointer_set){
+      slave->pointer_set = true;
+      slave->pointer = byte;
+      if(xfer){
+          xfer->reg = byte;
+      }
+      return true;
+  }
+  if(xfer){
+      xfer->length++;
+  }
+  slave->regs[slave->pointer] = byte;
+  if(slave->on_write){
+      slave->on_write(slave, slave->pointer, byte);
+  }
+  slave->pointer++;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A byte to the master from the register pointer.
+ *
+ ******************************************************************************/
+static uint8_t host_i2c_regs_read(void *context){
+  HOST_I2C_REGS *slave = context;
+  HOST_I2C_XFER *xfer = host_i2c_regs_xfer(slave);
+
+  if(xfer){
+      xfer->length++;
+  }
+  if(slave->on_read){
+      slave->on_read(slave, slave->pointer);
+  }
+  return slave->regs[slave->pointer++];
+}
+
+/***************************************************************************//**
+ * @brief
+ * The master's answer to the byte just read.
+ *
+ ******************************************************************************/
+static void host_i2c_regs_read_ack(void *context, bool ack){
+  HOST_I2C_REGS *slave = context;
+  HOST_I2C_XFER *xfer = host_i2c_regs_xfer(slave);
+
+  if(!ack && xfer && !xfer->nack_at){
+      xfer->nack_at = xfer->length;
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Clears a register slave and sets it up at address. Attach slave->device
+ * to a bus with host_i2c_attach, on_write, on_read and context can be set
+ * in between.
+ *
+ ******************************************************************************/
+void host_i2c_regs_init(HOST_I2C_REGS *slave, uint8_t address){
+  memset(slave, 0, sizeof(*slave));
+  slave->device.address = address;
+  slave->device.context = slave;
+  slave->device.start = host_i2c_regs_start;
+  slave->device.write = host_i2c_regs_write;
+  slave->device.read = host_i2c_regs_read;
+  slave->device.read_ack = host_i2c_regs_read_ack;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file
+ * host_ldma.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * LDMA channels of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_ldma.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_LDMA_CH_BIT(ch)  (1UL << (uint32_t)(ch))
+
+// The LDMA of the host build only has the registers the stand-in functions
+// use, packed into one block instead of the EFR32 layout
+typedef struct{
+  __IOM uint32_t CTRL;
+  __OM  uint32_t CHEN;              // 1 starts a channel on the descriptor at its LINK
+  __OM  uint32_t CHDIS;             // 1 stops a channel
+  __IM  uint32_t CHBUSY;            // channels with a transfer
+  __IM  uint32_t CHDONE;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+  struct{
+    __IOM uint32_t REQSEL;
+    __IOM uint32_t LINK;
+    __IM  uint32_t REMAIN;          // units left in the descriptor, less one
+  }CH[DMA_CHAN_COUNT];
+}HOST_LDMA_TypeDef;
+
+#define HOST_LDMA           ((HOST_LDMA_TypeDef *) LDMA_BASE)
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief LDMA channels
+ * @details
+ *  A channel moves one unit each time its peripheral's request is up, at the
+ *  moment the request comes up, so it always keeps up with the peripherals.
+ *  Its descriptors are the drivers' own, read from their memory. A write
+ *  descriptor with structReq runs as soon as it is loaded, like on the EFR32.
+ *  The LDMA runs in EM0 and EM1, and in EM2 only for a request with DMA wake
+ *  up on. The requests it could not serve while the core slept are served
+ *  when it wakes, see host_sleep.
+ *
+ ******************************************************************************/
+static struct{
+  const LDMA_Descriptor_t   *desc[DMA_CHAN_COUNT];
+  uint32_t                  src[DMA_CHAN_COUNT];
+  uint32_t                  dst[DMA_CHAN_COUNT];
+  bool                      servicing;
+  bool                      again;
+  uint32_t                  units;          // moved since host_init
+}host_ldma;
+
+static void host_ldma_write(uint32_t offset, uint32_t value);
+
+static HOST_BLOCK host_ldma_block = { "LDMA", LDMA_BASE, NULL, host_ldma_write, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the LDMA registers.
+ *
+ ******************************************************************************/
+static HOST_LDMA_TypeDef *host_ldma_regs(void){
+  return host_alias(HOST_LDMA);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the LDMA interrupt line from IF and IEN.
+ *
+ ******************************************************************************/
+static void host_ldma_irq(void){
+  HOST_LDMA_TypeDef *ldma = host_ldma_regs();
+
+  host_irq_level(LDMA_IRQn, (ldma->IF & ldma->IEN) != 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Loads a descriptor into a channel.
+ *
+ ******************************************************************************/
+static void host_ldma_load(uint32_t ch, uint32_t address){
+  HOST_LDMA_TypeDef *ldma = host_ldma_regs();
+  const LDMA_Descriptor_t *desc = (const LDMA_Descriptor_t *)(uintptr_t)address;
+
+  host_ldma.desc[ch] = desc;
+  host_ldma.src[ch] = desc->xfer.srcAddr;
+  host_ldma.dst[ch] = desc->xfer.dstAddr;
+  HOST_SET(ldma->CH[ch].LINK, address);
+  HOST_SET(ldma->CH[ch].REMAIN, desc->xfer.xferCnt);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends a channel's transfer.
+ *
+ ******************************************************************************/
+static void host_ldma_stop(uint32_t ch, bool done){
+  HOST_LDMA_TypeDef *ldma = host_ldma_regs();
+
+  host_ldma.desc[ch] = NULL;
+  HOST_SET(ldma->CHBUSY, ldma->CHBUSY & ~HOST_LDMA_CH_BIT(ch));
+  if(done){
+      HOST_SET(ldma->CHDONE, ldma->CHDONE | HOST_LDMA_CH_BIT(ch));
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads one unit, from a register or the drivers' memory.
+ *
+ ******************************************************************************/
+static uint32_t host_ldma_read_unit(uint32_t address, uint32_t size){
+  if(host_bus_owns(address)){
+      return host_reg_read(address);
+  }
+  switch(size){
+    case ldmaCtrlSizeByte:
+      return *(volatile uint8_t *)(uintptr_t)address;
+    case ldmaCtrlSizeHalf:
+      return *(volatile uint16_t *)(uintptr_t)address;
+    default:
+      return *(volatile uint32_t *)(uintptr_t)address;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes one unit, to a register or the drivers' memory.
+ *
+ ******************************************************************************/
+static void host_ldma_write_unit(uint32_t address, uint32_t size, uint32_t value){
+  if(host_bus_owns(address)){
+      host_reg_write(address, value);
+      return;
+  }
+  switch(size){
+    case ldmaCtrlSizeByte:
+      *(volatile uint8_t *)(uintptr_t)address = (uint8_t)value;
+      break;
+    case ldmaCtrlSizeHalf:
+      *(volatile uint16_t *)(uintptr_t)address = (uint16_t)value;
+      break;
+    default:
+      *(volatile uint32_t *)(uintptr_t)address = value;
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Address step for an increment field.
+ *
+ ******************************************************************************/
+static uint32_t host_ldma_step(uint32_t inc, uint32_t size){
+  return (inc == ldmaCtrlSrcIncNone) ? 0 : ((1UL << inc) << size);
+}
+
+/***************************************************************************//**
+ * @brief
+ * True if a channel's peripheral wants a unit moved now.
+ *
+ ******************************************************************************/
+static bool host_ldma_request(uint32_t ch){
+  uint32_t signal = host_ldma_regs()->CH[ch].REQSEL;
+  bool wakeup = false;
+  bool request;
+
+  switch(signal){
+    case ldmaPeripheralSignal_LEUART0_RXDATAV:
+    case ldmaPeripheralSignal_LEUART0_TXBL:
+    case ldmaPeripheralSignal_LEUART0_TXEMPTY:
+      request = host_leuart_dma_request(signal, &wakeup);
+      break;
+    case ldmaPeripheralSignal_I2C0_RXDATAV:
+    case ldmaPeripheralSignal_I2C0_TXBL:
+    case ldmaPeripheralSignal_I2C1_RXDATAV:
+    case ldmaPeripheralSignal_I2C1_TXBL:
+      request = host_i2c_dma_request(signal);
+      break;
+    default:
+      request = true;
+      break;
+  }
+  return request && ((host_em() < 2) || wakeup);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs a channel as far as its requests let it.
+ *
+ * @return
+ * True if anything moved.
+ *
+ ******************************************************************************/
+static bool host_ldma_run(uint32_t ch){
+  HOST_LDMA_TypeDef *ldma = host_ldma_regs();
+  bool moved = false;
+
+  while(host_ldma.desc[ch]){
+      const LDMA_Descriptor_t *desc = host_ldma.desc[ch];
+
+      if(desc->xfer.structType == ldmaCtrlStructTypeWrite){
+          host_ldma_write_unit(desc->wri.dstAddr, ldmaCtrlSizeWord, desc->wri.immVal);
+      }
+      else{
+          if(!desc->xfer.structReq && !host_ldma_request(ch)){
+              break;
+          }
+          uint32_t size = desc->xfer.size;
+          host_ldma_write_unit(host_ldma.dst[ch], size, host_ldma_read_unit(host_ldma.src[ch], size));
+          host_ldma.src[ch] += host_ldma_step(desc->xfer.srcInc, size);
+          host_ldma.dst[ch] += host_ldma_step(desc->xfer.dstInc, size);
+          host_ldma.units++;
+          moved = true;
+          if(ldma->CH[ch].REMAIN){
+              HOST_SET(ldma->CH[ch].REMAIN, ldma->CH[ch].REMAIN - 1);
+              continue;
+          }
+      }
+      moved = true;
+      if(desc->xfer.doneIfs){
+          HOST_SET(ldma->IF, ldma->IF | HOST_LDMA_CH_BIT(ch));
+      }
+      if(desc->xfer.link){
+          uint32_t next = (uint32_t)desc->xfer.linkAddr << 2;
+          if(desc->xfer.linkMode == ldmaLinkModeRel){
+              next = (uint32_t)(uintptr_t)desc + (uint32_t)(desc->xfer.linkAddr * 4);
+          }
+          host_ldma_load(ch, next);
+      }
+      else{
+          host_ldma_stop(ch, true);
+      }
+  }
+  return moved;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of the LDMA block.
+ *
+ ******************************************************************************/
+static void host_ldma_write(uint32_t offset, uint32_t value){
+  HOST_LDMA_TypeDef *ldma = host_ldma_regs();
+
+  switch(offset){
+    case HOST_OFFSET(HOST_LDMA_TypeDef, CHEN):
+      for(uint32_t ch = 0; ch < DMA_CHAN_COUNT; ch++){
+          if(value & HOST_LDMA_CH_BIT(ch)){
+              HOST_SET(ldma->CHDONE, ldma->CHDONE & ~HOST_LDMA_CH_BIT(ch));
+              HOST_SET(ldma->CHBUSY, ldma->CHBUSY | HOST_LDMA_CH_BIT(ch));
+              host_ldma_load(ch, ldma->CH[ch].LINK);
+          }
+      }
+      HOST_SET(ldma->CHEN, 0);
+      break;
+    case HOST_OFFSET(HOST_LDMA_TypeDef, CHDIS):
+      for(uint32_t ch = 0; ch < DMA_CHAN_COUNT; ch++){
+          if(value & HOST_LDMA_CH_BIT(ch)){
+              host_ldma_stop(ch, false);
+          }
+      }
+      HOST_SET(ldma->CHDIS, 0);
+      break;
+    case HOST_OFFSET(HOST_LDMA_TypeDef, IFS):
+      HOST_SET(ldma->IF, ldma->IF | value);
+      HOST_SET(ldma->IFS, 0);
+      break;
+    case HOST_OFFSET(HOST_LDMA_TypeDef, IFC):
+      HOST_SET(ldma->IF, ldma->IF & ~value);
+      HOST_SET(ldma->IFC, 0);
+      break;
+    default:
+      break;
+  }
+  host_ldma_service();
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds the LDMA block, every channel idle.
+ *
+ ******************************************************************************/
+void host_ldma_open(void){
+  host_bus_add(&host_ldma_block);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Serves every channel whose request is up, called by the peripheral
+ * models each time their requests may have changed.
+ *
+ * @details
+ * Moving a unit runs the peripheral's register hooks, which call back in
+ * here. Those calls only ask for another pass.
+ *
+ ******************************************************************************/
+void host_ldma_service(void){
+  bool moved;
+
+  if(host_ldma.servicing){
+      host_ldma.again = true;
+      return;
+  }
+  host_ldma.servicing = true;
+  do{
+      host_ldma.again = false;
+      moved = false;
+      for(uint32_t ch = 0; ch < DMA_CHAN_COUNT; ch++){
+          moved |= host_ldma_run(ch);
+      }
+  }while(moved || host_ldma.again);
+  host_ldma.servicing = false;
+  host_ldma_irq();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Units the LDMA moved since host_init.
+ *
+ ******************************************************************************/
+uint32_t host_ldma_units(void){
+  return host_ldma.units;
+}
+
+//***********************************************************************************
+// Stand-in emlib LDMA functions
+//***********************************************************************************
+
+void LDMA_Init(const LDMA_Init_t *init){
+  host_cpu_write(&HOST_LDMA->CTRL, init->ldmaInitCtrlNumFixed);
+  host_cpu_write(&HOST_LDMA->IEN, LDMA_IF_ERROR);
+  host_cpu_write(&HOST_LDMA->IFC, 0xFFFFFFFFUL);
+  NVIC_ClearPendingIRQ(LDMA_IRQn);
+  NVIC_EnableIRQ(LDMA_IRQn);
+}
+
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor){
+  EFM_ASSERT((ch >= 0) && (ch < DMA_CHAN_COUNT));
+  host_cpu_write(&HOST_LDMA->CH[ch].REQSEL, transfer->ldmaReqSel);
+  host_cpu_write(&HOST_LDMA->CH[ch].LINK, (uint32_t)(uintptr_t)descriptor);
+  host_cpu_write(&HOST_LDMA->IFC, HOST_LDMA_CH_BIT(ch));
+  host_cpu_write(&HOST_LDMA->IEN, host_ldma_regs()->IEN | HOST_LDMA_CH_BIT(ch));
+  host_cpu_write(&HOST_LDMA->CHEN, HOST_LDMA_CH_BIT(ch));
+}
+
+void LDMA_StopTransfer(int ch){
+  host_cpu_write(&HOST_LDMA->IEN, host_ldma_regs()->IEN & ~HOST_LDMA_CH_BIT(ch));
+  host_cpu_write(&HOST_LDMA->CHDIS, HOST_LDMA_CH_BIT(ch));
+}
+
+bool LDMA_TransferDone(int ch){
+  uint32_t busy = host_cpu_read(&HOST_LDMA->CHBUSY);
+  uint32_t done = host_cpu_read(&HOST_LDMA->CHDONE);
+
+  return !(busy & HOST_LDMA_CH_BIT(ch)) && (done & HOST_LDMA_CH_BIT(ch));
+}
+
+uint32_t LDMA_TransferRemainingCount(int ch){
+  if(!(host_cpu_read(&HOST_LDMA->CHBUSY) & HOST_LDMA_CH_BIT(ch))){
+      return 0;
+  }
+  return host_cpu_read(&HOST_LDMA->CH[ch].REMAIN) + 1;
+}
+
+uint32_t LDMA_IntGet(void){
+  return host_cpu_read(&HOST_LDMA->IF);
+}
+
+uint32_t LDMA_IntGetEnabled(void){
+  uint32_t ien = host_cpu_read(&HOST_LDMA->IEN);
+
+  return host_cpu_read(&HOST_LDMA->IF) & ien;
+}
+
+void LDMA_IntClear(uint32_t flags){
+  host_cpu_write(&HOST_LDMA->IFC, flags);
+}
+
+void LDMA_IntEnable(uint32_t flags){
+  host_cpu_write(&HOST_LDMA->IEN, host_ldma_regs()->IEN | flags);
+}
+
+void LDMA_IntDisable(uint32_t flags){
+  host_cpu_write(&HOST_LDMA->IEN, host_ldma_regs()->IEN & ~flags);
+}
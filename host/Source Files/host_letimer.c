@@ -0,0 +1,336 @@
+/**
+ * @file
+ * host_letimer.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * LETIMER0 of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_letimer.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_LETIMER_TOP    0xFFFFUL
+#define HOST_LETIMER_FLAGS  (LETIMER_IF_COMP0 | LETIMER_IF_COMP1 | LETIMER_IF_UF | LETIMER_IF_REP0 | LETIMER_IF_REP1)
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief LETIMER0
+ * @details
+ *  A down counter on the LFA clock. It wraps from 0 to COMP0 with COMP0TOP
+ *  set or to 0xFFFF without, setting UF, and sets COMP0 and COMP1 on the
+ *  tick CNT gets to them. Ticks are counted from the time it was started or
+ *  CNT was written, so a 32.768 kHz clock does not drift against HFCLK.
+ *  CNT is brought up to date before the core reads it. The compare and
+ *  control values are copied when written so a late catch up still uses
+ *  the ones that were set at the time.
+ *
+ ******************************************************************************/
+static struct{
+  bool      running;
+  uint32_t  hz;               // LFA rate when it was started
+  uint64_t  origin;           // time of tick 0
+  uint64_t  ticks;            // ticks since origin already counted
+  uint32_t  cnt;
+  uint32_t  ctrl;
+  uint32_t  comp0;
+  uint32_t  comp1;
+}host_letimer;
+
+static void host_letimer_read(uint32_t offset);
+static void host_letimer_write(uint32_t offset, uint32_t value);
+static uint32_t host_letimer_em(void);
+static uint64_t host_letimer_next(void);
+static void host_letimer_advance(uint64_t cycles);
+
+static HOST_BLOCK host_letimer_block = { "LETIMER0", LETIMER0_BASE, host_letimer_read, host_letimer_write, NULL };
+static HOST_MODEL host_letimer_model = { "LETIMER0", host_letimer_em, host_letimer_next, host_letimer_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the LETIMER0 registers.
+ *
+ ******************************************************************************/
+static LETIMER_TypeDef *host_letimer_regs(void){
+  return host_alias(LETIMER0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Value CNT takes after an underflow.
+ *
+ ******************************************************************************/
+static uint32_t host_letimer_reload(void){
+  return (host_letimer.ctrl & LETIMER_CTRL_COMP0TOP) ? host_letimer.comp0 : HOST_LETIMER_TOP;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ticks until CNT gets to value, HOST_NEVER if it never does.
+ *
+ ******************************************************************************/
+static uint64_t host_letimer_distance(uint32_t value){
+  uint32_t reload = host_letimer_reload();
+
+  if(value < host_letimer.cnt){
+      return host_letimer.cnt - value;
+  }
+  if(value > reload){
+      return HOST_NEVER;
+  }
+  return (uint64_t)host_letimer.cnt + 1 + (reload - value);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ticks until the next flag is set.
+ *
+ ******************************************************************************/
+static uint64_t host_letimer_event(void){
+  uint64_t ticks = (uint64_t)host_letimer.cnt + 1;     // underflow
+  uint64_t comp0 = host_letimer_distance(host_letimer.comp0);
+  uint64_t comp1 = host_letimer_distance(host_letimer.comp1);
+
+  if(comp0 < ticks){
+      ticks = comp0;
+  }
+  if(comp1 < ticks){
+      ticks = comp1;
+  }
+  return ticks;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Time of a tick.
+ *
+ ******************************************************************************/
+static uint64_t host_letimer_tick_time(uint64_t tick){
+  return host_letimer.origin + (tick * HOST_HFCLK_HZ + host_letimer.hz - 1) / host_letimer.hz;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Restarts the tick count at the current time.
+ *
+ ******************************************************************************/
+static void host_letimer_rebase(void){
+  host_letimer.hz = host_cmu_hz(cmuClock_LETIMER0);
+  host_letimer.origin = host_now();
+  host_letimer.ticks = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Counts the ticks up to now, setting the flags on the way, and leaves CNT,
+ * IF and the interrupt line current.
+ *
+ ******************************************************************************/
+static void host_letimer_sync(void){
+  LETIMER_TypeDef *letimer = host_letimer_regs();
+  uint32_t flags = letimer->IF;
+
+  if(host_letimer.running && host_letimer.hz){
+      uint64_t now_ticks = ((host_now() - host_letimer.origin) * host_letimer.hz) / HOST_HFCLK_HZ;
+      while(host_letimer.ticks < now_ticks){
+          uint64_t event = host_letimer_event();
+          if(host_letimer.ticks + event > now_ticks){
+              host_letimer.cnt -= (uint32_t)(now_ticks - host_letimer.ticks);
+              host_letimer.ticks = now_ticks;
+              break;
+          }
+          host_letimer.ticks += event;
+          if(event == (uint64_t)host_letimer.cnt + 1){
+              host_letimer.cnt = host_letimer_reload();
+              flags |= LETIMER_IF_UF;
+          }
+          else{
+              host_letimer.cnt -= (uint32_t)event;
+          }
+          if(host_letimer.cnt == host_letimer.comp0){
+              flags |= LETIMER_IF_COMP0;
+          }
+          if(host_letimer.cnt == host_letimer.comp1){
+              flags |= LETIMER_IF_COMP1;
+          }
+      }
+  }
+  HOST_SET(letimer->CNT, host_letimer.cnt);
+  HOST_SET(letimer->IF, flags);
+  host_irq_level(LETIMER0_IRQn, (flags & letimer->IEN) != 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Read hook of LETIMER0, CNT and IF are brought up to date first.
+ *
+ ******************************************************************************/
+static void host_letimer_read(uint32_t offset){
+  (void)offset;
+  host_letimer_sync();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of LETIMER0.
+ *
+ ******************************************************************************/
+static void host_letimer_write(uint32_t offset, uint32_t value){
+  LETIMER_TypeDef *letimer = host_letimer_regs();
+
+  host_letimer_sync();
+  switch(offset){
+    case HOST_OFFSET(LETIMER_TypeDef, CTRL):
+      host_letimer.ctrl = value;
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, COMP0):
+      host_letimer.comp0 = value & HOST_LETIMER_TOP;
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, COMP1):
+      host_letimer.comp1 = value & HOST_LETIMER_TOP;
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, CNT):
+      host_letimer.cnt = value & HOST_LETIMER_TOP;
+      host_letimer_rebase();
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, CMD):
+      if((value & LETIMER_CMD_START) && !host_letimer.running){
+          host_letimer.running = true;
+          host_letimer_rebase();
+      }
+      if(value & LETIMER_CMD_STOP){
+          host_letimer.running = false;
+      }
+      if(value & LETIMER_CMD_CLEAR){
+          host_letimer.cnt = 0;
+          host_letimer_rebase();
+      }
+      HOST_SET(letimer->STATUS, host_letimer.running ? LETIMER_STATUS_RUNNING : 0);
+      HOST_SET(letimer->CMD, 0);
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, IFS):
+      HOST_SET(letimer->IF, letimer->IF | (value & HOST_LETIMER_FLAGS));
+      HOST_SET(letimer->IFS, 0);
+      break;
+    case HOST_OFFSET(LETIMER_TypeDef, IFC):
+      HOST_SET(letimer->IF, letimer->IF & ~value);
+      HOST_SET(letimer->IFC, 0);
+      break;
+    default:
+      break;
+  }
+  host_letimer_sync();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Deepest energy mode LETIMER0 runs in, that of its LFA clock.
+ *
+ ******************************************************************************/
+static uint32_t host_letimer_em(void){
+  return host_cmu_em(cmuClock_LETIMER0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the tick of the next flag.
+ *
+ ******************************************************************************/
+static uint64_t host_letimer_next(void){
+  uint64_t when;
+
+  if(!host_letimer.running || !host_letimer.hz){
+      return HOST_NEVER;
+  }
+  when = host_letimer_tick_time(host_letimer.ticks + host_letimer_event());
+  return (when > host_now()) ? when - host_now() : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Counts the ticks that came due.
+ *
+ ******************************************************************************/
+static void host_letimer_advance(uint64_t cycles){
+  (void)cycles;
+  host_letimer_sync();
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds LETIMER0, stopped at 0.
+ *
+ ******************************************************************************/
+void host_letimer_open(void){
+  host_bus_add(&host_letimer_block);
+  host_model_add(&host_letimer_model);
+}
+
+//***********************************************************************************
+// Stand-in emlib LETIMER functions
+//***********************************************************************************
+
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init){
+  uint32_t ctrl = (uint32_t)init->repMode |
+                  ((uint32_t)init->ufoa0 << _LETIMER_CTRL_UFOA0_SHIFT) |
+                  ((uint32_t)init->ufoa1 << _LETIMER_CTRL_UFOA1_SHIFT);
+
+  EFM_ASSERT(init->repMode == letimerRepeatFree);     //the only mode the model counts
+  if(!init->enable && (host_cpu_read(&letimer->STATUS) & LETIMER_STATUS_RUNNING)){
+      host_cpu_write(&letimer->CMD, LETIMER_CMD_STOP);
+  }
+  ctrl |= init->out0Pol ? LETIMER_CTRL_OPOL0 : 0;
+  ctrl |= init->out1Pol ? LETIMER_CTRL_OPOL1 : 0;
+  ctrl |= init->bufTop ? LETIMER_CTRL_BUFTOP : 0;
+  ctrl |= init->comp0Top ? LETIMER_CTRL_COMP0TOP : 0;
+  ctrl |= init->debugRun ? LETIMER_CTRL_DEBUGRUN : 0;
+  host_cpu_write(&letimer->CTRL, ctrl);
+  if(init->enable && !(host_cpu_read(&letimer->STATUS) & LETIMER_STATUS_RUNNING)){
+      host_cpu_write(&letimer->CMD, LETIMER_CMD_START);
+  }
+}
+
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable){
+  host_cpu_write(&letimer->CMD, enable ? LETIMER_CMD_START : LETIMER_CMD_STOP);
+}
+
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value){
+  EFM_ASSERT(comp < 2);
+  host_cpu_write(comp ? &letimer->COMP1 : &letimer->COMP0, value);
+}
+
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef *letimer, unsigned int comp){
+  EFM_ASSERT(comp < 2);
+  return host_cpu_read(comp ? &letimer->COMP1 : &letimer->COMP0);
+}
+
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef *letimer){
+  return host_cpu_read(&letimer->CNT);
+}
+
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value){
+  EFM_ASSERT(rep < 2);
+  host_cpu_write(rep ? &letimer->REP1 : &letimer->REP0, value);
+}
@@ -0,0 +1,507 @@
+/**
+ * @file
+ * host_leuart.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * LEUART0 and its line of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_ldma.h"
+#include "em_leuart.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_LEUART_LINE_SIZE     256     // bytes the peer can have on the way, a power of two
+#define HOST_LEUART_TOLERANCE     3       // percent the two rates can be apart
+#define HOST_LEUART_FRAME_BITS    10      // start, 8 data, stop
+
+#define HOST_LEUART_TX_FLAGS      (LEUART_IF_TXBL)
+#define HOST_LEUART_RX_FLAGS      (LEUART_IF_RXDATAV)
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief LEUART0
+ * @details
+ *  The transmitter has TXDATA and a shift register, the receiver RXDATA and
+ *  a shift register, like the EFR32 LEUART with TXBIL clear. TXBL and
+ *  RXDATAV follow the buffers in both STATUS and IF and cannot be cleared,
+ *  the other flags are latched until IFC. A frame takes 10 bit times at the
+ *  rate CLKDIV gives from the LFB clock the model sees right now, so a rate
+ *  set up for one clock and run on another is garbled like on the board.
+ *
+ *  The peer on the line gets each byte when its stop bit is out and puts
+ *  bytes on the line with host_leuart_send. A byte the receiver cannot take
+ *  is counted in the stats by why it was lost.
+ *
+ ******************************************************************************/
+static struct{
+  HOST_LEUART_PEER  peer;
+  HOST_LEUART_STATS stats;
+  // transmitter
+  bool              tx_full;              // TXDATA holds a byte
+  bool              tx_shifting;
+  uint8_t           tx_shift;
+  uint32_t          tx_baudrate;          // rate the shifting byte goes at
+  uint64_t          tx_end;
+  // line from the peer, free running indexes
+  struct{
+    uint8_t         byte;
+    uint32_t        baudrate;
+    uint64_t        end;                  // when its stop bit is in
+  }line[HOST_LEUART_LINE_SIZE];
+  uint32_t          line_head;
+  uint32_t          line_tail;
+  uint64_t          line_free;            // peer's line is busy until
+}host_leuart;
+
+static void host_leuart_read(uint32_t offset);
+static void host_leuart_write(uint32_t offset, uint32_t value);
+static uint32_t host_leuart_em(void);
+static uint64_t host_leuart_next(void);
+static void host_leuart_advance(uint64_t cycles);
+
+static HOST_BLOCK host_leuart_block = { "LEUART0", LEUART0_BASE, host_leuart_read, host_leuart_write, NULL };
+static HOST_MODEL host_leuart_model = { "LEUART0", host_leuart_em, host_leuart_next, host_leuart_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the LEUART0 registers.
+ *
+ ******************************************************************************/
+static LEUART_TypeDef *host_leuart_regs(void){
+  return host_alias(LEUART0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Rate CLKDIV gives from the LEUART0 clock, 0 while the clock is off.
+ *
+ ******************************************************************************/
+static uint32_t host_leuart_baudrate(void){
+  uint32_t hz = host_cmu_hz(cmuClock_LEUART0);
+
+  return (uint32_t)(((uint64_t)hz * 256) / (256 + (host_leuart_regs()->CLKDIV & ~7UL)));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles a frame takes at baudrate.
+ *
+ ******************************************************************************/
+static uint64_t host_leuart_frame(uint32_t baudrate){
+  return ((uint64_t)HOST_HFCLK_HZ * HOST_LEUART_FRAME_BITS + baudrate - 1) / baudrate;
+}
+
+/***************************************************************************//**
+ * @brief
+ * True if the two rates are close enough for the receiver to sample.
+ *
+ ******************************************************************************/
+static bool host_leuart_match(uint32_t baudrate, uint32_t peer){
+  uint32_t diff = (baudrate > peer) ? baudrate - peer : peer - baudrate;
+
+  return (baudrate != 0) && ((uint64_t)diff * 100 <= (uint64_t)peer * HOST_LEUART_TOLERANCE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the level flags from the buffers, the interrupt line from IF and IEN,
+ * and gives the LDMA a look at the new requests.
+ *
+ ******************************************************************************/
+static void host_leuart_update(void){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+  uint32_t status = leuart->STATUS & ~(LEUART_STATUS_TXBL | LEUART_STATUS_TXIDLE);
+  uint32_t flags = leuart->IF & ~(HOST_LEUART_TX_FLAGS | HOST_LEUART_RX_FLAGS);
+
+  if((status & LEUART_STATUS_TXENS) && !host_leuart.tx_full){
+      status |= LEUART_STATUS_TXBL;
+      flags |= LEUART_IF_TXBL;
+  }
+  if(!host_leuart.tx_full && !host_leuart.tx_shifting){
+      status |= LEUART_STATUS_TXIDLE;
+  }
+  if(status & LEUART_STATUS_RXDATAV){
+      flags |= LEUART_IF_RXDATAV;
+  }
+  HOST_SET(leuart->STATUS, status);
+  HOST_SET(leuart->IF, flags);
+  host_irq_level(LEUART0_IRQn, (flags & leuart->IEN) != 0);
+  host_ldma_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Moves TXDATA into the shift register if it is free.
+ *
+ ******************************************************************************/
+static void host_leuart_tx_start(void){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+  uint32_t baudrate = host_leuart_baudrate();
+
+  if(host_leuart.tx_shifting || !host_leuart.tx_full || !baudrate){
+      return;
+  }
+  host_leuart.tx_full = false;
+  host_leuart.tx_shifting = true;
+  host_leuart.tx_shift = (uint8_t)leuart->TXDATA;
+  host_leuart.tx_baudrate = baudrate;
+  host_leuart.tx_end = host_now() + host_leuart_frame(baudrate);
+  HOST_SET(leuart->STATUS, leuart->STATUS & ~LEUART_STATUS_TXC);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The stop bit of the shifting byte is out.
+ *
+ ******************************************************************************/
+static void host_leuart_tx_done(void){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+
+  host_leuart.tx_shifting = false;
+  host_leuart.stats.tx_bytes++;
+  if(host_leuart.peer){
+      host_leuart.peer(host_leuart.tx_shift, host_leuart.tx_baudrate);
+  }
+  host_leuart_tx_start();
+  if(!host_leuart.tx_shifting){
+      HOST_SET(leuart->STATUS, leuart->STATUS | LEUART_STATUS_TXC);
+      HOST_SET(leuart->IF, leuart->IF | LEUART_IF_TXC);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The stop bit of the byte at the line's tail is in.
+ *
+ ******************************************************************************/
+static void host_leuart_rx_done(void){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+  uint32_t index = host_leuart.line_tail++ & (HOST_LEUART_LINE_SIZE - 1);
+  uint8_t byte = host_leuart.line[index].byte;
+  uint32_t status = leuart->STATUS;
+  uint32_t flags = 0;
+
+  if(!(status & LEUART_STATUS_RXENS) || !host_leuart_baudrate()){
+      host_leuart.stats.rx_lost++;
+      return;
+  }
+  if(!host_leuart_match(host_leuart_baudrate(), host_leuart.line[index].baudrate)){
+      host_leuart.stats.rx_garbled++;
+      HOST_SET(leuart->IF, leuart->IF | LEUART_IF_FERR);
+      return;
+  }
+  if(byte == (uint8_t)leuart->STARTFRAME){
+      flags |= LEUART_IF_STARTF;
+      if(leuart->CTRL & LEUART_CTRL_SFUBRX){
+          status &= ~LEUART_STATUS_RXBLOCK;
+      }
+  }
+  if(status & LEUART_STATUS_RXBLOCK){
+      host_leuart.stats.rx_blocked++;
+      HOST_SET(leuart->IF, leuart->IF | flags);
+      return;
+  }
+  if(byte == (uint8_t)leuart->SIGFRAME){
+      flags |= LEUART_IF_SIGF;
+  }
+  if(status & LEUART_STATUS_RXDATAV){
+      host_leuart.stats.rx_overflow++;
+      flags |= LEUART_IF_RXOF;
+  }
+  else{
+      HOST_SET(leuart->RXDATA, byte);
+      status |= LEUART_STATUS_RXDATAV;
+  }
+  HOST_SET(leuart->STATUS, status);
+  HOST_SET(leuart->IF, leuart->IF | flags);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Read hook of LEUART0, reading RXDATA empties it.
+ *
+ ******************************************************************************/
+static void host_leuart_read(uint32_t offset){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+
+  if(offset == HOST_OFFSET(LEUART_TypeDef, RXDATA)){
+      HOST_SET(leuart->STATUS, leuart->STATUS & ~LEUART_STATUS_RXDATAV);
+      host_leuart_update();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs a CMD write.
+ *
+ ******************************************************************************/
+static void host_leuart_cmd(uint32_t cmd){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+  uint32_t status = leuart->STATUS;
+
+  if(cmd & LEUART_CMD_RXEN){
+      status |= LEUART_STATUS_RXENS;
+  }
+  if(cmd & LEUART_CMD_RXDIS){
+      status &= ~LEUART_STATUS_RXENS;
+  }
+  if(cmd & LEUART_CMD_TXEN){
+      status |= LEUART_STATUS_TXENS;
+  }
+  if(cmd & LEUART_CMD_TXDIS){
+      status &= ~LEUART_STATUS_TXENS;
+      host_leuart.tx_shifting = false;
+  }
+  if(cmd & LEUART_CMD_RXBLOCKEN){
+      status |= LEUART_STATUS_RXBLOCK;
+  }
+  if(cmd & LEUART_CMD_RXBLOCKDIS){
+      status &= ~LEUART_STATUS_RXBLOCK;
+  }
+  if(cmd & LEUART_CMD_CLEARTX){
+      host_leuart.tx_full = false;
+  }
+  if(cmd & LEUART_CMD_CLEARRX){
+      status &= ~LEUART_STATUS_RXDATAV;
+  }
+  HOST_SET(leuart->STATUS, status);
+  HOST_SET(leuart->CMD, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of LEUART0.
+ *
+ ******************************************************************************/
+static void host_leuart_write(uint32_t offset, uint32_t value){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+
+  switch(offset){
+    case HOST_OFFSET(LEUART_TypeDef, CMD):
+      host_leuart_cmd(value);
+      break;
+    case HOST_OFFSET(LEUART_TypeDef, TXDATA):
+      if((leuart->STATUS & LEUART_STATUS_TXENS) && !host_leuart.tx_full){
+          host_leuart.tx_full = true;
+          host_leuart_tx_start();
+      }
+      else if(leuart->STATUS & LEUART_STATUS_TXENS){
+          HOST_SET(leuart->IF, leuart->IF | LEUART_IF_TXOF);
+      }
+      break;
+    case HOST_OFFSET(LEUART_TypeDef, IFS):
+      HOST_SET(leuart->IF, leuart->IF | (value & _LEUART_IFC_MASK));
+      HOST_SET(leuart->IFS, 0);
+      break;
+    case HOST_OFFSET(LEUART_TypeDef, IFC):
+      HOST_SET(leuart->IF, leuart->IF & ~(value & _LEUART_IFC_MASK));
+      HOST_SET(leuart->IFC, 0);
+      break;
+    default:
+      break;
+  }
+  host_leuart_update();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Deepest energy mode LEUART0 runs in, that of its LFB clock.
+ *
+ ******************************************************************************/
+static uint32_t host_leuart_em(void){
+  return host_cmu_em(cmuClock_LEUART0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the next stop bit on either line.
+ *
+ ******************************************************************************/
+static uint64_t host_leuart_next(void){
+  uint64_t now = host_now();
+  uint64_t next = HOST_NEVER;
+
+  if(host_leuart.tx_shifting){
+      next = (host_leuart.tx_end > now) ? host_leuart.tx_end - now : 1;
+  }
+  if(host_leuart.line_tail != host_leuart.line_head){
+      uint64_t end = host_leuart.line[host_leuart.line_tail & (HOST_LEUART_LINE_SIZE - 1)].end;
+      uint64_t cycles = (end > now) ? end - now : 1;
+      if(cycles < next){
+          next = cycles;
+      }
+  }
+  return next;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Finishes the frames that came due.
+ *
+ ******************************************************************************/
+static void host_leuart_advance(uint64_t cycles){
+  uint64_t now = host_now();
+  bool changed = false;
+  (void)cycles;
+
+  if(host_leuart.tx_shifting && (host_leuart.tx_end <= now)){
+      host_leuart_tx_done();
+      changed = true;
+  }
+  while((host_leuart.line_tail != host_leuart.line_head) &&
+        (host_leuart.line[host_leuart.line_tail & (HOST_LEUART_LINE_SIZE - 1)].end <= now)){
+      host_leuart_rx_done();
+      changed = true;
+  }
+  if(changed){
+      host_leuart_update();
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds LEUART0, disabled, with nothing on the line.
+ *
+ ******************************************************************************/
+void host_leuart_open(void){
+  host_bus_add(&host_leuart_block);
+  host_model_add(&host_leuart_model);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets what is on the other end of the line, NULL for nothing.
+ *
+ ******************************************************************************/
+void host_leuart_peer(HOST_LEUART_PEER peer){
+  host_leuart.peer = peer;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The peer sends a byte at baudrate, after the ones it already sent.
+ *
+ * @details
+ * A byte sent while LEUART0 is stopped, because its clock does not run in
+ * the energy mode the core is in, is lost.
+ *
+ ******************************************************************************/
+void host_leuart_send(uint8_t byte, uint32_t baudrate){
+  uint64_t start = host_now();
+  uint32_t index = host_leuart.line_head & (HOST_LEUART_LINE_SIZE - 1);
+
+  EFM_ASSERT(baudrate);
+  host_leuart.stats.rx_bytes++;
+  if(host_em() > host_leuart_em()){
+      host_leuart.stats.rx_lost++;
+      return;
+  }
+  if(host_leuart.line_head - host_leuart.line_tail == HOST_LEUART_LINE_SIZE){
+      host_fail("the LEUART0 peer sent more than %u bytes ahead of the line", HOST_LEUART_LINE_SIZE);
+  }
+  if(host_leuart.line_free > start){
+      start = host_leuart.line_free;
+  }
+  host_leuart.line_free = start + host_leuart_frame(baudrate);
+  host_leuart.line[index].byte = byte;
+  host_leuart.line[index].baudrate = baudrate;
+  host_leuart.line[index].end = host_leuart.line_free;
+  host_leuart.line_head++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Line counters since host_init.
+ *
+ ******************************************************************************/
+void host_leuart_stats(HOST_LEUART_STATS *stats){
+  *stats = host_leuart.stats;
+}
+
+/***************************************************************************//**
+ * @brief
+ * LDMA request of LEUART0.
+ *
+ * @param[out] wakeup
+ * True if the request may wake the LDMA out of EM2.
+ *
+ ******************************************************************************/
+bool host_leuart_dma_request(uint32_t signal, bool *wakeup){
+  LEUART_TypeDef *leuart = host_leuart_regs();
+
+  switch(signal){
+    case ldmaPeripheralSignal_LEUART0_TXBL:
+      *wakeup = (leuart->CTRL & LEUART_CTRL_TXDMAWU) != 0;
+      return (leuart->STATUS & LEUART_STATUS_TXBL) != 0;
+    case ldmaPeripheralSignal_LEUART0_TXEMPTY:
+      *wakeup = (leuart->CTRL & LEUART_CTRL_TXDMAWU) != 0;
+      return (leuart->STATUS & LEUART_STATUS_TXIDLE) != 0;
+    case ldmaPeripheralSignal_LEUART0_RXDATAV:
+      *wakeup = (leuart->CTRL & LEUART_CTRL_RXDMAWU) != 0;
+      return (leuart->STATUS & LEUART_STATUS_RXDATAV) != 0;
+    default:
+      *wakeup = false;
+      return false;
+  }
+}
+
+//***********************************************************************************
+// Stand-in emlib LEUART functions
+//***********************************************************************************
+
+void LEUART_Enable(LEUART_TypeDef *leuart, LEUART_Enable_TypeDef enable){
+  uint32_t on = (uint32_t)enable & (LEUART_CMD_RXEN | LEUART_CMD_TXEN);
+  uint32_t off = ~(uint32_t)enable & (LEUART_CMD_RXEN | LEUART_CMD_TXEN);
+
+  host_cpu_write(&leuart->CMD, on | (off << 1));      //each DIS bit is one above its EN bit
+}
+
+void LEUART_BaudrateSet(LEUART_TypeDef *leuart, uint32_t refFreq, uint32_t baudrate){
+  uint64_t clkdiv;
+
+  if(!refFreq){
+      refFreq = CMU_ClockFreqGet(cmuClock_LEUART0);
+  }
+  EFM_ASSERT(baudrate && (refFreq >= baudrate));
+  clkdiv = ((uint64_t)refFreq * 256) / baudrate;
+  clkdiv = (clkdiv > 256) ? ((clkdiv - 256) & ~7ULL) : 0;
+  host_cpu_write(&leuart->CLKDIV, (uint32_t)clkdiv);
+}
+
+uint32_t LEUART_BaudrateGet(LEUART_TypeDef *leuart){
+  uint32_t clkdiv = host_cpu_read(&leuart->CLKDIV);
+
+  return (uint32_t)(((uint64_t)CMU_ClockFreqGet(cmuClock_LEUART0) * 256) / (256 + clkdiv));
+}
+
+void LEUART_Init(LEUART_TypeDef *leuart, const LEUART_Init_TypeDef *init){
+  EFM_ASSERT((init->databits == leuartDatabits8) && (init->parity == leuartNoParity) &&
+             (init->stopbits == leuartStopbits1));       //the only frame the model sends
+  LEUART_Enable(leuart, leuartDisable);
+  host_cpu_write(&leuart->CTRL, 0);
+  LEUART_BaudrateSet(leuart, init->refFreq, init->baudrate);
+  LEUART_Enable(leuart, init->enable);
+}
@@ -0,0 +1,269 @@
+/**
+ * @file
+ * host_si1133.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Si1133 light sensor of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "host_model.h"
+
+#include "si1133.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_SI1133_PARAMS      0x40
+#define HOST_SI1133_PARAM_MASK  0x3F
+#define HOST_SI1133_PAUSE       0x12
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Si1133
+ * @details
+ *  A register slave with the command side of the Si1133 on top. Commands
+ *  finish as soon as they are written and count up CMD_CTR in RESPONSE0.
+ *  PARAM_SET takes INPUT0 into the parameter table, and the channel table
+ *  there decides what a measurement puts in HOSTOUT. After START it
+ *  measures every MEAS_RATE on its own, sets IRQ_STATUS and pulls INT low
+ *  for the enabled channels, until IRQ_STATUS is read. It does not answer
+ *  while SENSOR_EN is low. It has its own clock, so it runs in every energy
+ *  mode.
+ *
+ ******************************************************************************/
+static struct{
+  HOST_I2C_REGS     slave;
+  bool              (*regs_start)(void *context, bool read);
+  uint8_t           (*regs_read)(void *context);
+  uint8_t           params[HOST_SI1133_PARAMS];
+  bool              running;
+  uint64_t          next_meas;
+  int32_t           white;
+  int32_t           uv;
+  int32_t           ir;
+  HOST_SI1133_STATE state;
+}host_si1133;
+
+static uint32_t host_si1133_em(void);
+static uint64_t host_si1133_next(void);
+static void host_si1133_advance(uint64_t cycles);
+
+static HOST_MODEL host_si1133_model = { "Si1133", host_si1133_em, host_si1133_next, host_si1133_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Counts a command that went through in RESPONSE0.
+ *
+ ******************************************************************************/
+static void host_si1133_count(void){
+  uint8_t *response = &host_si1133.slave.regs[RESPONSE0];
+
+  *response = (*response & ~RESPONSE0_CMD_CTR) | ((*response + 1) & RESPONSE0_CMD_CTR);
+  host_si1133.state.commands++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles of one MEAS_RATE period.
+ *
+ ******************************************************************************/
+static uint64_t host_si1133_period(void){
+  uint32_t rate = ((uint32_t)host_si1133.params[MEAS_RATE_H] << 8) | host_si1133.params[MEAS_RATE_L];
+
+  return HOST_US((uint64_t)(rate ? rate : 1) * SI1133_MEAS_RATE_US);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Measures every channel in CHAN_LIST into HOSTOUT and raises the
+ * interrupt of the enabled ones.
+ *
+ ******************************************************************************/
+static void host_si1133_measure(void){
+  uint8_t *regs = host_si1133.slave.regs;
+  uint8_t *out = &regs[HOSTOUT0];
+  uint32_t channels = host_si1133.params[CHAN_LIST];
+
+  for(uint32_t n = 0; n < SI1133_MAX_CHANNELS; n++){
+      uint8_t adcmux = host_si1133.params[ADCCONFIG0 + SI1133_CHAN_PARAMS*n] & 0x1F;
+      int32_t value;
+      if(!(channels & (1u << n))){
+          continue;
+      }
+      switch(adcmux){
+        case SI1133_ADCMUX_WHITE:
+        case SI1133_ADCMUX_LARGE_WHITE:
+          value = host_si1133.white;
+          break;
+        case SI1133_ADCMUX_UV:
+        case SI1133_ADCMUX_UV_DEEP:
+          value = host_si1133.uv;
+          break;
+        default:
+          value = host_si1133.ir;
+          break;
+      }
+      if(host_si1133.params[ADCPOST0 + SI1133_CHAN_PARAMS*n] & ADCPOST_24BIT){
+          *out++ = (uint8_t)(value >> 16);
+      }
+      *out++ = (uint8_t)(value >> 8);
+      *out++ = (uint8_t)value;
+  }
+  regs[IRQ_STATUS] |= channels & regs[IRQ_ENABLE];
+  host_si1133.state.measurements++;
+  if(regs[IRQ_STATUS]){
+      host_gpio_drive(SI1133_INT_PORT, SI1133_INT_PIN, true);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs a command written to COMMAND.
+ *
+ ******************************************************************************/
+static void host_si1133_on_write(HOST_I2C_REGS *slave, uint8_t reg, uint8_t value){
+  if(reg != COMMAND_REG){
+      return;
+  }
+  if(value == RESET_CMD_CTR){
+      slave->regs[RESPONSE0] = 0;
+      return;
+  }
+  if(slave->regs[RESPONSE0] & RESPONSE0_CMD_ERR){
+      return;
+  }
+  if((value & PARAM_SET) && ((value & HOST_SI1133_PARAM_MASK) < HOST_SI1133_PARAMS)){
+      host_si1133.params[value & HOST_SI1133_PARAM_MASK] = slave->regs[INPUT0];
+  }
+  else if(value == FORCE){
+      host_si1133_measure();
+  }
+  else if(value == START){
+      host_si1133.running = true;
+      host_si1133.next_meas = host_now() + host_si1133_period();
+  }
+  else if(value == HOST_SI1133_PAUSE){
+      host_si1133.running = false;
+  }
+  host_si1133_count();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Does not answer while SENSOR_EN is low.
+ *
+ ******************************************************************************/
+static bool host_si1133_start(void *context, bool read){
+  if(!host_gpio_get(SI1133_SENSOR_EN_PORT, SI1133_SENSOR_EN_PIN)){
+      return false;
+  }
+  return host_si1133.regs_start(context, read);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reading IRQ_STATUS clears it and lets INT go.
+ *
+ ******************************************************************************/
+static uint8_t host_si1133_read(void *context){
+  uint8_t reg = host_si1133.slave.pointer;
+  uint8_t byte = host_si1133.regs_read(context);
+
+  if(reg == IRQ_STATUS){
+      host_si1133.slave.regs[IRQ_STATUS] = 0;
+      host_gpio_drive(SI1133_INT_PORT, SI1133_INT_PIN, false);
+  }
+  return byte;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The Si1133 runs on its own clock whatever the core does.
+ *
+ ******************************************************************************/
+static uint32_t host_si1133_em(void){
+  return HOST_EM_COUNT - 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the next measurement.
+ *
+ ******************************************************************************/
+static uint64_t host_si1133_next(void){
+  if(!host_si1133.running){
+      return HOST_NEVER;
+  }
+  return (host_si1133.next_meas > host_now()) ? host_si1133.next_meas - host_now() : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the measurements that came due.
+ *
+ ******************************************************************************/
+static void host_si1133_advance(uint64_t cycles){
+  (void)cycles;
+  while(host_si1133.running && (host_si1133.next_meas <= host_now())){
+      host_si1133_measure();
+      host_si1133.next_meas += host_si1133_period();
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Puts an Si1133 on the bus of i2c, on the ThunderBoard pins.
+ *
+ ******************************************************************************/
+void host_si1133_init(I2C_TypeDef *i2c){
+  host_i2c_regs_init(&host_si1133.slave, SI1133_ADDRESS);
+  host_si1133.slave.on_write = host_si1133_on_write;
+  host_si1133.regs_start = host_si1133.slave.device.start;
+  host_si1133.regs_read = host_si1133.slave.device.read;
+  host_si1133.slave.device.start = host_si1133_start;
+  host_si1133.slave.device.read = host_si1133_read;
+  host_i2c_attach(i2c, &host_si1133.slave.device);
+  host_i2c_pins(i2c, SI1133_SCL_PORT, SI1133_SCL_PIN, SI1133_SDA_PORT, SI1133_SDA_PIN);
+  host_model_add(&host_si1133_model);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Counts the next measurements return for white, UV and IR channels.
+ *
+ ******************************************************************************/
+void host_si1133_light(int32_t white, int32_t uv, int32_t ir){
+  host_si1133.white = white;
+  host_si1133.uv = uv;
+  host_si1133.ir = ir;
+}
+
+/***************************************************************************//**
+ * @brief
+ * What the Si1133 has done since host_si1133_init.
+ *
+ ******************************************************************************/
+void host_si1133_state(HOST_SI1133_STATE *state){
+  host_si1133.state.running = host_si1133.running;
+  host_si1133.state.irq_status = host_si1133.slave.regs[IRQ_STATUS];
+  *state = host_si1133.state;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * host_timer.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * TIMER0 of the host build
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "em_timer.h"
+
+#include "host_model.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_TIMER_TOP      0xFFFFUL
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief TIMER0
+ * @details
+ *  An up or down counter on HFPERCLK through the prescaler, wrapping between
+ *  0 and TOP and setting OF or UF, and stopping at the wrap with OSMEN set.
+ *  Nothing in the firmware uses it any more, it is here for the TIMER0
+ *  delay loops the benchmarks compare against. Every tick is an event, so
+ *  a loop polling CNT sees each value it would see on the board.
+ *
+ ******************************************************************************/
+static struct{
+  bool      running;
+  uint64_t  period;           // cycles a tick
+  uint64_t  next_tick;
+}host_timer;
+
+static void host_timer_write(uint32_t offset, uint32_t value);
+static uint32_t host_timer_em(void);
+static uint64_t host_timer_next(void);
+static void host_timer_advance(uint64_t cycles);
+
+static HOST_BLOCK host_timer_block = { "TIMER0", TIMER0_BASE, NULL, host_timer_write, NULL };
+static HOST_MODEL host_timer_model = { "TIMER0", host_timer_em, host_timer_next, host_timer_advance, NULL };
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The model side copy of the TIMER0 registers.
+ *
+ ******************************************************************************/
+static TIMER_TypeDef *host_timer_regs(void){
+  return host_alias(TIMER0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the TIMER0 interrupt line from IF and IEN.
+ *
+ ******************************************************************************/
+static void host_timer_irq(void){
+  TIMER_TypeDef *timer = host_timer_regs();
+
+  host_irq_level(TIMER0_IRQn, (timer->IF & timer->IEN) != 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * One tick of the counter.
+ *
+ ******************************************************************************/
+static void host_timer_tick(void){
+  TIMER_TypeDef *timer = host_timer_regs();
+  uint32_t cnt = timer->CNT;
+  uint32_t top = timer->TOP;
+  bool wrapped;
+
+  if((timer->CTRL & _TIMER_CTRL_MODE_MASK) == timerModeDown){
+      wrapped = (cnt == 0);
+      cnt = wrapped ? top : cnt - 1;
+      if(wrapped){
+          HOST_SET(timer->IF, timer->IF | TIMER_IF_UF);
+      }
+  }
+  else{
+      wrapped = (cnt >= top);
+      cnt = wrapped ? 0 : cnt + 1;
+      if(wrapped){
+          HOST_SET(timer->IF, timer->IF | TIMER_IF_OF);
+      }
+  }
+  HOST_SET(timer->CNT, cnt);
+  if(wrapped && (timer->CTRL & TIMER_CTRL_OSMEN)){
+      host_timer.running = false;
+      HOST_SET(timer->STATUS, 0);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Write hook of TIMER0.
+ *
+ ******************************************************************************/
+static void host_timer_write(uint32_t offset, uint32_t value){
+  TIMER_TypeDef *timer = host_timer_regs();
+
+  switch(offset){
+    case HOST_OFFSET(TIMER_TypeDef, CMD):
+      if((value & TIMER_CMD_START) && !host_timer.running){
+          uint32_t prescale = (timer->CTRL & _TIMER_CTRL_PRESC_MASK) >> _TIMER_CTRL_PRESC_SHIFT;
+          uint32_t hz = host_cmu_hz(cmuClock_TIMER0);
+          EFM_ASSERT(hz);
+          host_timer.running = true;
+          host_timer.period = ((uint64_t)HOST_HFCLK_HZ << prescale) / hz;
+          host_timer.next_tick = host_now() + host_timer.period;
+      }
+      if(value & TIMER_CMD_STOP){
+          host_timer.running = false;
+      }
+      HOST_SET(timer->STATUS, host_timer.running ? TIMER_STATUS_RUNNING : 0);
+      HOST_SET(timer->CMD, 0);
+      break;
+    case HOST_OFFSET(TIMER_TypeDef, IFS):
+      HOST_SET(timer->IF, timer->IF | value);
+      HOST_SET(timer->IFS, 0);
+      break;
+    case HOST_OFFSET(TIMER_TypeDef, IFC):
+      HOST_SET(timer->IF, timer->IF & ~value);
+      HOST_SET(timer->IFC, 0);
+      break;
+    default:
+      break;
+  }
+  host_timer_irq();
+}
+
+/***************************************************************************//**
+ * @brief
+ * TIMER0 is on HFPERCLK, which stops in EM2.
+ *
+ ******************************************************************************/
+static uint32_t host_timer_em(void){
+  return 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Cycles to the next tick.
+ *
+ ******************************************************************************/
+static uint64_t host_timer_next(void){
+  if(!host_timer.running){
+      return HOST_NEVER;
+  }
+  return (host_timer.next_tick > host_now()) ? host_timer.next_tick - host_now() : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the ticks that came due.
+ *
+ ******************************************************************************/
+static void host_timer_advance(uint64_t cycles){
+  (void)cycles;
+  while(host_timer.running && (host_timer.next_tick <= host_now())){
+      host_timer_tick();
+      host_timer.next_tick += host_timer.period;
+  }
+  host_timer_irq();
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Adds TIMER0, stopped with TOP at its reset value.
+ *
+ ******************************************************************************/
+void host_timer_open(void){
+  host_bus_add(&host_timer_block);
+  host_model_add(&host_timer_model);
+  HOST_SET(host_timer_regs()->TOP, HOST_TIMER_TOP);
+}
+
+//***********************************************************************************
+// Stand-in emlib TIMER functions
+//***********************************************************************************
+
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init){
+  uint32_t ctrl = ((uint32_t)init->mode & _TIMER_CTRL_MODE_MASK) |
+                  ((uint32_t)init->prescale << _TIMER_CTRL_PRESC_SHIFT);
+
+  EFM_ASSERT(init->clkSel == timerClkSelHFPerClk);
+  EFM_ASSERT((init->mode == timerModeUp) || (init->mode == timerModeDown));
+  if(init->oneShot){
+      ctrl |= TIMER_CTRL_OSMEN;
+  }
+  host_cpu_write(&timer->CMD, TIMER_CMD_STOP);
+  host_cpu_write(&timer->CTRL, ctrl);
+  if(init->enable){
+      host_cpu_write(&timer->CMD, TIMER_CMD_START);
+  }
+}
+
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable){
+  host_cpu_write(&timer->CMD, enable ? TIMER_CMD_START : TIMER_CMD_STOP);
+}
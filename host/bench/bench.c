@@ -0,0 +1,193 @@
+/**
+ * @file
+ * bench.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Runs the whole application on the host and reports what each application
+ * period costs
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host.h"
+#include "app.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define BENCH_PERIODS       10                      // default, the first argument overrides it
+#define BENCH_PERIOD        HOST_MS(APP_SAMPLE_PER_MS)
+#define BENCH_BOOT          HOST_MS(3000)           // configuration, AT commands and the first samples
+#define BENCH_SETTLE        HOST_MS(2000)           // backlog goes out once the central is on
+#define BENCH_IRQS          5
+
+// Light the Si1133 sees, in counts
+#define BENCH_WHITE         2000
+#define BENCH_UV            40
+#define BENCH_IR            300
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief Benchmark
+ * @details
+ *  main.c is built with main renamed to thunderboard_main and run by
+ *  host_run with an HM-18 on LEUART0 and an Si1133 on I2C1. Once it has
+ *  booted and a central has connected, each application period is run on
+ *  its own and what it cost is printed as one row: the interrupt handler
+ *  entries, the awake cycles and where they went, the time in each energy
+ *  mode, and the bytes the LEUART, I2C1 and the LDMA moved. The cycle
+ *  counts are virtual, see host.h for what they count.
+ *
+ ******************************************************************************/
+typedef struct{
+  HOST_ENERGY         energy;
+  HOST_LEUART_STATS   leuart;
+  HOST_I2C_STATS      i2c;
+  uint32_t            ldma_units;
+  uint32_t            central_bytes;
+  uint32_t            irqs[BENCH_IRQS];
+}BENCH_SAMPLE;
+
+static const IRQn_Type bench_irqs[BENCH_IRQS] = { LETIMER0_IRQn, LEUART0_IRQn, LDMA_IRQn, I2C1_IRQn, GPIO_ODD_IRQn };
+
+void thunderboard_main(void);
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Takes the counters. Energy and interrupt counts start over at
+ * host_stats_reset, the others count from host_init.
+ *
+ ******************************************************************************/
+static void bench_sample(BENCH_SAMPLE *sample){
+  HOST_HM18_STATE hm18;
+
+  host_energy(&sample->energy);
+  host_leuart_stats(&sample->leuart);
+  host_i2c_stats(I2C1, &sample->i2c);
+  host_hm18_state(&hm18);
+  sample->ldma_units = host_ldma_units();
+  sample->central_bytes = hm18.central_bytes;
+  for(uint32_t i = 0; i < BENCH_IRQS; i++){
+      sample->irqs[i] = host_irq_count(bench_irqs[i]);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds what one period cost to sum.
+ *
+ ******************************************************************************/
+static void bench_add(BENCH_SAMPLE *sum, const BENCH_SAMPLE *before, const BENCH_SAMPLE *after){
+  for(uint32_t em = 0; em < HOST_EM_COUNT; em++){
+      sum->energy.em_cycles[em] += after->energy.em_cycles[em];
+  }
+  sum->energy.bus_cycles += after->energy.bus_cycles;
+  sum->energy.irq_cycles += after->energy.irq_cycles;
+  sum->energy.spin_cycles += after->energy.spin_cycles;
+  sum->energy.wake_cycles += after->energy.wake_cycles;
+  for(uint32_t i = 0; i < BENCH_IRQS; i++){
+      sum->irqs[i] += after->irqs[i];
+  }
+  sum->leuart.tx_bytes += after->leuart.tx_bytes - before->leuart.tx_bytes;
+  sum->i2c.bytes_out += after->i2c.bytes_out - before->i2c.bytes_out;
+  sum->i2c.bytes_in += after->i2c.bytes_in - before->i2c.bytes_in;
+  sum->ldma_units += after->ldma_units - before->ldma_units;
+  sum->central_bytes += after->central_bytes - before->central_bytes;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Percent of total.
+ *
+ ******************************************************************************/
+static double bench_percent(uint64_t part, uint64_t total){
+  return total ? (100.0*(double)part)/(double)total : 0.0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Prints a row, sum divided by the periods in it.
+ *
+ ******************************************************************************/
+static void bench_row(const char *label, const BENCH_SAMPLE *sum, uint32_t periods){
+  const HOST_ENERGY *e = &sum->energy;
+  double n = periods;
+  uint64_t total = 0;
+
+  for(uint32_t em = 0; em < HOST_EM_COUNT; em++){
+      total += e->em_cycles[em];
+  }
+  printf("%-6s", label);
+  for(uint32_t i = 0; i < BENCH_IRQS; i++){
+      printf(" %6.1f", sum->irqs[i]/n);
+  }
+  printf(" %9.0f %7.0f %7.0f %7.0f %6.2f %6.2f %6.2f %6.1f %6.1f %6.1f %6.1f\n",
+         e->em_cycles[0]/n, e->bus_cycles/n, e->irq_cycles/n, (e->spin_cycles + e->wake_cycles)/n,
+         bench_percent(e->em_cycles[0], total),
+         bench_percent(e->em_cycles[1] + e->em_cycles[2], total),
+         bench_percent(e->em_cycles[3] + e->em_cycles[4], total),
+         sum->leuart.tx_bytes/n, (sum->i2c.bytes_out + sum->i2c.bytes_in)/n,
+         sum->ldma_units/n, sum->central_bytes/n);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(int argc, char *argv[]){
+  uint32_t periods = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BENCH_PERIODS;
+  BENCH_SAMPLE before;
+  BENCH_SAMPLE after;
+  BENCH_SAMPLE period;
+  BENCH_SAMPLE sum = { 0 };
+
+  if(!periods){
+      fprintf(stderr, "usage: %s [periods]\n", argv[0]);
+      return 2;
+  }
+  host_init();
+  host_hm18_init();
+  host_si1133_init(I2C1);
+  host_si1133_light(BENCH_WHITE, BENCH_UV, BENCH_IR);
+  if(host_run(thunderboard_main, BENCH_BOOT)){
+      host_fail("main returned");
+  }
+  host_hm18_connect(true);
+  host_run(thunderboard_main, BENCH_SETTLE);
+
+  printf("per %u ms application period, virtual cycles at %u MHz\n", APP_SAMPLE_PER_MS, HOST_HFCLK_HZ/1000000);
+  printf("%-6s %6s %6s %6s %6s %6s %9s %7s %7s %7s %6s %6s %6s %6s %6s %6s %6s\n",
+         "period", "LETIM", "LEUART", "LDMA", "I2C1", "GPIO",
+         "awake", "bus", "irq", "spin+wk", "EM0%", "EM1-2%", "EM3%",
+         "uartB", "i2cB", "dmaU", "cntrlB");
+  for(uint32_t p = 0; p < periods; p++){
+      char label[12];
+      host_stats_reset();
+      bench_sample(&before);
+      host_run(thunderboard_main, BENCH_PERIOD);
+      bench_sample(&after);
+      period = (BENCH_SAMPLE){ 0 };
+      bench_add(&period, &before, &after);
+      bench_add(&sum, &before, &after);
+      snprintf(label, sizeof(label), "%u", (unsigned)(p + 1));
+      bench_row(label, &period, 1);
+  }
+  bench_row("mean", &sum, periods);
+  return 0;
+}
@@ -0,0 +1,10 @@
+/*
+ * HW_Delay.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * app.h includes the delay header with this spelling, which only a case
+ * insensitive file system finds. Forwards to the real one.
+ */
+#include "HW_delay.h"
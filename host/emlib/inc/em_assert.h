@@ -0,0 +1,18 @@
+/*
+ * em_assert.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_assert.h in the host build, it is not the
+ * vendor file. The expression is always evaluated, as on the board, and a
+ * failed assert ends the run with the file and line.
+ */
+#ifndef EM_ASSERT_HG
+#define EM_ASSERT_HG
+
+#define EFM_ASSERT(expr)    ((expr) ? ((void)0) : host_assert_failed(__FILE__, __LINE__))
+
+void host_assert_failed(const char *file, int line) __attribute__((noreturn));
+
+#endif
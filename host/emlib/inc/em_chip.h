@@ -0,0 +1,16 @@
+/*
+ * em_chip.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_chip.h in the host build, it is not the
+ * vendor file. There are no chip errata to fix on the host.
+ */
+#ifndef EM_CHIP_HG
+#define EM_CHIP_HG
+
+static inline void CHIP_Init(void){
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * em_cmu.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_cmu.h in the host build, it is not the
+ * vendor file. The clock tree is kept in the CMU block, where the LEUART and
+ * LETIMER models look up the clock they run from.
+ */
+#ifndef EM_CMU_HG
+#define EM_CMU_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  cmuClock_HF,
+  cmuClock_HFPER,
+  cmuClock_CORELE,
+  cmuClock_LFA,
+  cmuClock_LFB,
+  cmuClock_GPIO,
+  cmuClock_LDMA,
+  cmuClock_I2C0,
+  cmuClock_I2C1,
+  cmuClock_TIMER0,
+  cmuClock_TIMER1,
+  cmuClock_LETIMER0,
+  cmuClock_LEUART0
+}CMU_Clock_TypeDef;
+
+typedef enum{
+  cmuOsc_LFXO,
+  cmuOsc_LFRCO,
+  cmuOsc_HFXO,
+  cmuOsc_HFRCO,
+  cmuOsc_AUXHFRCO,
+  cmuOsc_ULFRCO
+}CMU_Osc_TypeDef;
+
+typedef enum{
+  cmuSelect_Error,
+  cmuSelect_Disabled,
+  cmuSelect_LFXO,
+  cmuSelect_LFRCO,
+  cmuSelect_ULFRCO,
+  cmuSelect_HFCLKLE,
+  cmuSelect_HFXO,
+  cmuSelect_HFRCO
+}CMU_Select_TypeDef;
+
+typedef enum{
+  cmuHFRCOFreq_19M0Hz = 19000000,
+  cmuHFRCOFreq_26M0Hz = 26000000,
+  cmuHFRCOFreq_38M0Hz = 38000000
+}CMU_HFRCOFreq_TypeDef;
+
+typedef struct{
+  uint16_t ctuneStartup;
+  uint16_t ctuneSteadyState;
+}CMU_HFXOInit_TypeDef;
+
+#define CMU_HFXOINIT_DEFAULT    { 0x142, 0x142 }
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+CMU_Select_TypeDef CMU_ClockSelectGet(CMU_Clock_TypeDef clock);
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait);
+void CMU_HFRCOBandSet(CMU_HFRCOFreq_TypeDef setFreq);
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *hfxoInit);
+
+#endif
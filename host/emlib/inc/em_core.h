@@ -0,0 +1,37 @@
+/*
+ * em_core.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_core.h in the host build, it is not the
+ * vendor file. PRIMASK is kept by host_core.c, interrupts held off by a
+ * critical section run when it ends.
+ */
+#ifndef EM_CORE_HG
+#define EM_CORE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef uint32_t CORE_irqState_t;
+
+#define CORE_DECLARE_IRQ_STATE          CORE_irqState_t irqState
+#define CORE_ENTER_CRITICAL()           irqState = CORE_EnterCritical()
+#define CORE_EXIT_CRITICAL()            CORE_ExitCritical(irqState)
+#define CORE_ENTER_ATOMIC()             irqState = CORE_EnterAtomic()
+#define CORE_EXIT_ATOMIC()              CORE_ExitAtomic(irqState)
+#define CORE_CRITICAL_SECTION(yourcode) { CORE_DECLARE_IRQ_STATE; CORE_ENTER_CRITICAL(); { yourcode } CORE_EXIT_CRITICAL(); }
+#define CORE_ATOMIC_SECTION(yourcode)   { CORE_DECLARE_IRQ_STATE; CORE_ENTER_ATOMIC(); { yourcode } CORE_EXIT_ATOMIC(); }
+
+CORE_irqState_t CORE_EnterCritical(void);
+void CORE_ExitCritical(CORE_irqState_t irqState);
+CORE_irqState_t CORE_EnterAtomic(void);
+void CORE_ExitAtomic(CORE_irqState_t irqState);
+bool CORE_InIrqContext(void);
+
+#endif
@@ -0,0 +1,371 @@
+/*
+ * em_device.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs EFR32MG12P device header in the host build, it is
+ * not the vendor file. Only the registers, bits and core functions the
+ * drivers use are here. The peripherals sit at their real addresses, see
+ * host_bus.c, so the drivers run unchanged.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef EM_DEVICE_HG
+#define EM_DEVICE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define __IM      volatile const    // read only
+#define __OM      volatile          // write only
+#define __IOM     volatile          // read and write
+
+#define DMA_CHAN_COUNT          8
+#define GPIO_PORT_COUNT         12
+
+// Peripheral base addresses, as on the EFR32MG12P
+#define GPIO_BASE               (0x4000A000UL)
+#define I2C0_BASE               (0x4000C000UL)
+#define I2C1_BASE               (0x4000C400UL)
+#define TIMER0_BASE             (0x40018000UL)
+#define LETIMER0_BASE           (0x40046000UL)
+#define LEUART0_BASE            (0x4004A000UL)
+#define LDMA_BASE               (0x400E2000UL)
+#define EMU_BASE                (0x400E3000UL)
+#define CMU_BASE                (0x400E4000UL)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+// Interrupt numbers of the EFR32MG12P, the ones without a model are left out
+typedef enum{
+  EMU_IRQn          = 0,
+  LDMA_IRQn         = 9,
+  GPIO_EVEN_IRQn    = 10,
+  TIMER0_IRQn       = 11,
+  I2C0_IRQn         = 17,
+  GPIO_ODD_IRQn     = 18,
+  LEUART0_IRQn      = 22,
+  LETIMER0_IRQn     = 27,
+  I2C1_IRQn         = 39,
+  EXT_IRQ_COUNT     = 64
+}IRQn_Type;
+
+typedef struct{
+  __IOM uint32_t CTRL;
+  __IOM uint32_t CMD;
+  __IM  uint32_t STATUS;
+  __IOM uint32_t CLKDIV;
+  __IOM uint32_t STARTFRAME;
+  __IOM uint32_t SIGFRAME;
+  __IM  uint32_t RXDATAX;
+  __IM  uint32_t RXDATA;
+  __IM  uint32_t RXDATAXP;
+  __IOM uint32_t TXDATAX;
+  __IOM uint32_t TXDATA;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+  __IOM uint32_t PULSECTRL;
+  __IOM uint32_t FREEZE;
+  __IM  uint32_t SYNCBUSY;
+  uint32_t       RESERVED0[3];
+  __IOM uint32_t ROUTEPEN;
+  __IOM uint32_t ROUTELOC0;
+  uint32_t       RESERVED1[2];
+  __IOM uint32_t INPUT;
+}LEUART_TypeDef;
+
+typedef struct{
+  __IOM uint32_t CTRL;
+  __IOM uint32_t CMD;
+  __IM  uint32_t STATE;
+  __IM  uint32_t STATUS;
+  __IOM uint32_t CLKDIV;
+  __IOM uint32_t SADDR;
+  __IOM uint32_t SADDRMASK;
+  __IM  uint32_t RXDATA;
+  __IM  uint32_t RXDOUBLE;
+  __IM  uint32_t RXDATAP;
+  __IM  uint32_t RXDOUBLEP;
+  __IOM uint32_t TXDATA;
+  __IOM uint32_t TXDOUBLE;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+  __IOM uint32_t ROUTEPEN;
+  __IOM uint32_t ROUTELOC0;
+}I2C_TypeDef;
+
+typedef struct{
+  __IOM uint32_t CTRL;
+  __OM  uint32_t CMD;
+  __IM  uint32_t STATUS;
+  __IOM uint32_t CNT;
+  __IOM uint32_t COMP0;
+  __IOM uint32_t COMP1;
+  __IOM uint32_t REP0;
+  __IOM uint32_t REP1;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+  uint32_t       RESERVED0[1];
+  __IM  uint32_t SYNCBUSY;
+  uint32_t       RESERVED1[2];
+  __IOM uint32_t PRSSEL;
+  uint32_t       RESERVED2[11];
+  __IOM uint32_t ROUTEPEN;
+  __IOM uint32_t ROUTELOC0;
+}LETIMER_TypeDef;
+
+typedef struct{
+  __IOM uint32_t CTRL;
+  __OM  uint32_t CMD;
+  __IM  uint32_t STATUS;
+  __IM  uint32_t IF;
+  __OM  uint32_t IFS;
+  __OM  uint32_t IFC;
+  __IOM uint32_t IEN;
+  __IOM uint32_t TOP;
+  __IOM uint32_t TOPB;
+  __IOM uint32_t CNT;
+  uint32_t       RESERVED0[1];
+  __IOM uint32_t LOCK;
+  __IOM uint32_t ROUTEPEN;
+  __IOM uint32_t ROUTELOC0;
+}TIMER_TypeDef;
+
+// Only the clock tree state the stand-in CMU functions keep
+typedef struct{
+  __IOM uint32_t CTRL;
+  __IOM uint32_t HFRCOCTRL;
+  __OM  uint32_t OSCENCMD;
+  __IM  uint32_t STATUS;
+  __IOM uint32_t LFACLKSEL;
+  __IOM uint32_t LFBCLKSEL;
+  __IOM uint32_t HFBUSCLKEN0;
+  __IOM uint32_t HFPERCLKEN0;
+  __IOM uint32_t LFACLKEN0;
+  __IOM uint32_t LFBCLKEN0;
+}CMU_TypeDef;
+
+// Only the energy mode state the stand-in EMU functions keep
+typedef struct{
+  __IOM uint32_t CTRL;
+  __IM  uint32_t STATUS;
+  __IOM uint32_t DCDCCTRL;
+  __IOM uint32_t EM23CTRL;
+}EMU_TypeDef;
+
+#define LEUART0                 ((LEUART_TypeDef *) LEUART0_BASE)
+#define I2C0                    ((I2C_TypeDef *) I2C0_BASE)
+#define I2C1                    ((I2C_TypeDef *) I2C1_BASE)
+#define LETIMER0                ((LETIMER_TypeDef *) LETIMER0_BASE)
+#define TIMER0                  ((TIMER_TypeDef *) TIMER0_BASE)
+#define CMU                     ((CMU_TypeDef *) CMU_BASE)
+#define EMU                     ((EMU_TypeDef *) EMU_BASE)
+
+// LEUART
+#define LEUART_CTRL_SFUBRX                (0x1UL << 8)
+#define LEUART_CTRL_RXDMAWU               (0x1UL << 12)
+#define LEUART_CTRL_TXDMAWU               (0x1UL << 13)
+#define LEUART_CMD_RXEN                   (0x1UL << 0)
+#define LEUART_CMD_RXDIS                  (0x1UL << 1)
+#define LEUART_CMD_TXEN                   (0x1UL << 2)
+#define LEUART_CMD_TXDIS                  (0x1UL << 3)
+#define LEUART_CMD_RXBLOCKEN              (0x1UL << 4)
+#define LEUART_CMD_RXBLOCKDIS             (0x1UL << 5)
+#define LEUART_CMD_CLEARTX                (0x1UL << 6)
+#define LEUART_CMD_CLEARRX                (0x1UL << 7)
+#define LEUART_STATUS_RXENS               (0x1UL << 0)
+#define LEUART_STATUS_TXENS               (0x1UL << 1)
+#define LEUART_STATUS_RXBLOCK             (0x1UL << 2)
+#define LEUART_STATUS_TXC                 (0x1UL << 3)
+#define LEUART_STATUS_TXBL                (0x1UL << 4)
+#define LEUART_STATUS_RXDATAV             (0x1UL << 5)
+#define LEUART_STATUS_RXFULL              (0x1UL << 6)
+#define LEUART_STATUS_TXIDLE              (0x1UL << 7)
+#define LEUART_IF_TXC                     (0x1UL << 0)
+#define LEUART_IF_TXBL                    (0x1UL << 1)
+#define LEUART_IF_RXDATAV                 (0x1UL << 2)
+#define LEUART_IF_RXOF                    (0x1UL << 3)
+#define LEUART_IF_RXUF                    (0x1UL << 4)
+#define LEUART_IF_TXOF                    (0x1UL << 5)
+#define LEUART_IF_PERR                    (0x1UL << 6)
+#define LEUART_IF_FERR                    (0x1UL << 7)
+#define LEUART_IF_MPAF                    (0x1UL << 8)
+#define LEUART_IF_STARTF                  (0x1UL << 9)
+#define LEUART_IF_SIGF                    (0x1UL << 10)
+#define _LEUART_IFC_MASK                  0x000007F9UL
+#define LEUART_IFC_TXC                    LEUART_IF_TXC
+#define LEUART_IFC_SIGF                   LEUART_IF_SIGF
+#define LEUART_IEN_TXC                    LEUART_IF_TXC
+#define LEUART_IEN_TXBL                   LEUART_IF_TXBL
+#define LEUART_IEN_RXDATAV                LEUART_IF_RXDATAV
+#define LEUART_IEN_RXOF                   LEUART_IF_RXOF
+#define LEUART_IEN_STARTF                 LEUART_IF_STARTF
+#define LEUART_IEN_SIGF                   LEUART_IF_SIGF
+#define LEUART_RXDATA_RXDATA_DEFAULT      0x00000000UL
+#define LEUART_TXDATA_TXDATA_DEFAULT      0x00000000UL
+#define LEUART_ROUTEPEN_RXPEN             (0x1UL << 0)
+#define LEUART_ROUTEPEN_TXPEN             (0x1UL << 1)
+#define LEUART_ROUTELOC0_RXLOC_LOC27      (0x1BUL << 0)
+#define LEUART_ROUTELOC0_TXLOC_LOC27      (0x1BUL << 8)
+
+// I2C
+#define I2C_CTRL_EN                       (0x1UL << 0)
+#define I2C_CTRL_AUTOACK                  (0x1UL << 2)
+#define I2C_CMD_START                     (0x1UL << 0)
+#define I2C_CMD_STOP                      (0x1UL << 1)
+#define I2C_CMD_ACK                       (0x1UL << 2)
+#define I2C_CMD_NACK                      (0x1UL << 3)
+#define I2C_CMD_CONT                      (0x1UL << 4)
+#define I2C_CMD_ABORT                     (0x1UL << 5)
+#define I2C_CMD_CLEARTX                   (0x1UL << 6)
+#define I2C_CMD_CLEARPC                   (0x1UL << 7)
+#define I2C_STATE_BUSY                    (0x1UL << 0)
+#define I2C_STATE_MASTER                  (0x1UL << 1)
+#define I2C_STATE_TRANSMITTER             (0x1UL << 2)
+#define I2C_STATE_NACKED                  (0x1UL << 3)
+#define I2C_STATE_BUSHOLD                 (0x1UL << 4)
+#define _I2C_STATE_STATE_SHIFT            5
+#define _I2C_STATE_STATE_MASK             0xE0UL
+#define I2C_STATE_STATE_IDLE              (0x0UL << 5)
+#define I2C_STATE_STATE_WAIT              (0x1UL << 5)
+#define I2C_STATE_STATE_START             (0x2UL << 5)
+#define I2C_STATE_STATE_ADDR              (0x3UL << 5)
+#define I2C_STATE_STATE_ADDRACK           (0x4UL << 5)
+#define I2C_STATE_STATE_DATA              (0x5UL << 5)
+#define I2C_STATE_STATE_DATAACK           (0x6UL << 5)
+#define I2C_STATUS_PSTART                 (0x1UL << 0)
+#define I2C_STATUS_PSTOP                  (0x1UL << 1)
+#define I2C_STATUS_PACK                   (0x1UL << 2)
+#define I2C_STATUS_PNACK                  (0x1UL << 3)
+#define I2C_STATUS_PABORT                 (0x1UL << 5)
+#define I2C_STATUS_TXC                    (0x1UL << 6)
+#define I2C_STATUS_TXBL                   (0x1UL << 7)
+#define I2C_STATUS_RXDATAV                (0x1UL << 8)
+#define I2C_STATUS_RXFULL                 (0x1UL << 9)
+#define I2C_IF_START                      (0x1UL << 0)
+#define I2C_IF_RSTART                     (0x1UL << 1)
+#define I2C_IF_ADDR                       (0x1UL << 2)
+#define I2C_IF_TXC                        (0x1UL << 3)
+#define I2C_IF_TXBL                       (0x1UL << 4)
+#define I2C_IF_RXDATAV                    (0x1UL << 5)
+#define I2C_IF_ACK                        (0x1UL << 6)
+#define I2C_IF_NACK                       (0x1UL << 7)
+#define I2C_IF_MSTOP                      (0x1UL << 8)
+#define I2C_IF_ARBLOST                    (0x1UL << 9)
+#define I2C_IF_BUSERR                     (0x1UL << 10)
+#define I2C_IF_BUSHOLD                    (0x1UL << 11)
+#define I2C_IF_TXOF                       (0x1UL << 12)
+#define I2C_IF_RXUF                       (0x1UL << 13)
+#define I2C_IF_CLTO                       (0x1UL << 16)
+#define I2C_IEN_START                     I2C_IF_START
+#define I2C_IEN_RXDATAV                   I2C_IF_RXDATAV
+#define I2C_IEN_ACK                       I2C_IF_ACK
+#define I2C_IEN_NACK                      I2C_IF_NACK
+#define I2C_IEN_MSTOP                     I2C_IF_MSTOP
+#define I2C_IEN_ARBLOST                   I2C_IF_ARBLOST
+#define I2C_IEN_BUSERR                    I2C_IF_BUSERR
+#define I2C_IEN_BUSHOLD                   I2C_IF_BUSHOLD
+#define I2C_ROUTEPEN_SDAPEN               (0x1UL << 0)
+#define I2C_ROUTEPEN_SCLPEN               (0x1UL << 1)
+#define I2C_ROUTELOC0_SDALOC_LOC17        (0x11UL << 0)
+#define I2C_ROUTELOC0_SCLLOC_LOC17        (0x11UL << 8)
+
+// LETIMER
+#define _LETIMER_CTRL_REPMODE_MASK        0x3UL
+#define _LETIMER_CTRL_UFOA0_SHIFT         2
+#define _LETIMER_CTRL_UFOA1_SHIFT         4
+#define LETIMER_CTRL_OPOL0                (0x1UL << 6)
+#define LETIMER_CTRL_OPOL1                (0x1UL << 7)
+#define LETIMER_CTRL_BUFTOP               (0x1UL << 8)
+#define LETIMER_CTRL_COMP0TOP             (0x1UL << 9)
+#define LETIMER_CTRL_DEBUGRUN             (0x1UL << 12)
+#define LETIMER_CMD_START                 (0x1UL << 0)
+#define LETIMER_CMD_STOP                  (0x1UL << 1)
+#define LETIMER_CMD_CLEAR                 (0x1UL << 2)
+#define LETIMER_STATUS_RUNNING            (0x1UL << 0)
+#define LETIMER_IF_COMP0                  (0x1UL << 0)
+#define LETIMER_IF_COMP1                  (0x1UL << 1)
+#define LETIMER_IF_UF                     (0x1UL << 2)
+#define LETIMER_IF_REP0                   (0x1UL << 3)
+#define LETIMER_IF_REP1                   (0x1UL << 4)
+#define LETIMER_IFC_COMP0                 LETIMER_IF_COMP0
+#define LETIMER_IFC_COMP1                 LETIMER_IF_COMP1
+#define LETIMER_IFC_UF                    LETIMER_IF_UF
+#define LETIMER_IEN_COMP0                 LETIMER_IF_COMP0
+#define LETIMER_IEN_COMP1                 LETIMER_IF_COMP1
+#define LETIMER_IEN_UF                    LETIMER_IF_UF
+#define LETIMER_ROUTEPEN_OUT0PEN          (0x1UL << 0)
+#define LETIMER_ROUTEPEN_OUT1PEN          (0x1UL << 1)
+#define LETIMER_ROUTELOC0_OUT0LOC_LOC17   (0x11UL << 0)
+#define LETIMER_ROUTELOC0_OUT1LOC_LOC16   (0x10UL << 8)
+
+// TIMER
+#define _TIMER_CTRL_MODE_MASK             0x3UL
+#define TIMER_CTRL_OSMEN                  (0x1UL << 4)
+#define _TIMER_CTRL_PRESC_SHIFT           24
+#define _TIMER_CTRL_PRESC_MASK            (0xFUL << 24)
+#define TIMER_CMD_START                   (0x1UL << 0)
+#define TIMER_CMD_STOP                    (0x1UL << 1)
+#define TIMER_STATUS_RUNNING              (0x1UL << 0)
+#define TIMER_IF_OF                       (0x1UL << 0)
+#define TIMER_IF_UF                       (0x1UL << 1)
+#define TIMER_ROUTELOC0_CC0LOC_LOC19      (0x13UL << 0)
+#define TIMER_ROUTELOC0_CC1LOC_LOC19      (0x13UL << 8)
+#define TIMER_ROUTELOC0_CC2LOC_LOC19      (0x13UL << 16)
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+// Core and NVIC, see host_core.c
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+
+static inline uint32_t __CLZ(uint32_t value){
+  return value ? (uint32_t)__builtin_clz(value) : 32;
+}
+
+static inline uint32_t __RBIT(uint32_t value){
+  uint32_t result = 0;
+
+  for(uint32_t i = 0; i < 32; i++){
+      result = (result << 1) | ((value >> i) & 1);
+  }
+  return result;
+}
+
+static inline void __NOP(void){
+  __asm__ volatile("" ::: "memory");
+}
+
+static inline void __DSB(void){
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __ISB(void){
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * em_emu.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_emu.h in the host build, it is not the
+ * vendor file. Entering EM1 to EM3 hands the core to the models until an
+ * interrupt wakes it, see host_sleep.
+ */
+#ifndef EM_EMU_HG
+#define EM_EMU_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  emuVScaleEM23_FastWakeup,
+  emuVScaleEM23_LowPower
+}EMU_VScaleEM23_TypeDef;
+
+typedef struct{
+  bool                    em23VregFullEn;
+  EMU_VScaleEM23_TypeDef  vScaleEM23Voltage;
+}EMU_EM23Init_TypeDef;
+
+typedef struct{
+  uint32_t                dcdcMode;
+  uint16_t                mVout;
+}EMU_DCDCInit_TypeDef;
+
+#define EMU_EM23INIT_DEFAULT    { false, emuVScaleEM23_FastWakeup }
+#define EMU_DCDCINIT_DEFAULT    { 0, 1800 }
+
+void EMU_EnterEM1(void);
+void EMU_EnterEM2(bool restore);
+void EMU_EnterEM3(bool restore);
+bool EMU_DCDCInit(const EMU_DCDCInit_TypeDef *dcdcInit);
+void EMU_EM23Init(const EMU_EM23Init_TypeDef *em23Init);
+
+#endif
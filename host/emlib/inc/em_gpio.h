@@ -0,0 +1,67 @@
+/*
+ * em_gpio.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_gpio.h in the host build, it is not the
+ * vendor file. The pins are modeled by host_gpio.c.
+ */
+#ifndef EM_GPIO_HG
+#define EM_GPIO_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  gpioPortA = 0,
+  gpioPortB = 1,
+  gpioPortC = 2,
+  gpioPortD = 3,
+  gpioPortF = 5,
+  gpioPortI = 8,
+  gpioPortJ = 9,
+  gpioPortK = 10
+}GPIO_Port_TypeDef;
+
+typedef enum{
+  gpioModeDisabled        = 0,
+  gpioModeInput           = 1,
+  gpioModeInputPull       = 2,
+  gpioModeInputPullFilter = 3,
+  gpioModePushPull        = 4,
+  gpioModePushPullAlternate = 5,
+  gpioModeWiredOr         = 6,
+  gpioModeWiredOrPullDown = 7,
+  gpioModeWiredAnd        = 8,
+  gpioModeWiredAndFilter  = 9,
+  gpioModeWiredAndPullUp  = 10,
+  gpioModeWiredAndPullUpFilter = 11
+}GPIO_Mode_TypeDef;
+
+typedef enum{
+  gpioDriveStrengthWeakAlternateWeak,
+  gpioDriveStrengthWeakAlternateStrong,
+  gpioDriveStrengthStrongAlternateWeak,
+  gpioDriveStrengthStrongAlternateStrong
+}GPIO_DriveStrength_TypeDef;
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out);
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo, bool risingEdge, bool fallingEdge, bool enable);
+uint32_t GPIO_IntGet(void);
+uint32_t GPIO_IntGetEnabled(void);
+void GPIO_IntClear(uint32_t flags);
+void GPIO_IntEnable(uint32_t flags);
+void GPIO_IntDisable(uint32_t flags);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * em_i2c.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_i2c.h in the host build, it is not the
+ * vendor file. Only the init is here, the bus is modeled by host_i2c.c.
+ */
+#ifndef EM_I2C_HG
+#define EM_I2C_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+#define I2C_FREQ_STANDARD_MAX   92000
+#define I2C_FREQ_FAST_MAX       392157
+#define I2C_FREQ_FASTPLUS_MAX   987167
+
+typedef enum{
+  i2cClockHLRStandard,
+  i2cClockHLRAsymetric,
+  i2cClockHLRFast
+}I2C_ClockHLR_TypeDef;
+
+typedef struct{
+  bool                  enable;
+  bool                  master;
+  uint32_t              refFreq;
+  uint32_t              freq;
+  I2C_ClockHLR_TypeDef  clhr;
+}I2C_Init_TypeDef;
+
+#define I2C_INIT_DEFAULT  { true, true, 0, I2C_FREQ_STANDARD_MAX, i2cClockHLRStandard }
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init);
+void I2C_Enable(I2C_TypeDef *i2c, bool enable);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * em_ldma.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_ldma.h in the host build, it is not the
+ * vendor file. The descriptors have the emlib layout, 16 bytes with 32 bit
+ * addresses, so the host build links without PIE to keep the driver buffers
+ * below 4 GB. The channels are modeled by host_ldma.c.
+ */
+#ifndef EM_LDMA_HG
+#define EM_LDMA_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+#define LDMA_IF_ERROR         (0x1UL << 31)
+
+typedef enum{
+  ldmaCtrlStructTypeXfer  = 0,
+  ldmaCtrlStructTypeSync  = 1,
+  ldmaCtrlStructTypeWrite = 2
+}LDMA_CtrlStructType_t;
+
+typedef enum{
+  ldmaCtrlReqModeBlock    = 0,
+  ldmaCtrlReqModeAll      = 1
+}LDMA_CtrlReqMode_t;
+
+typedef enum{
+  ldmaCtrlSrcIncOne       = 0,
+  ldmaCtrlSrcIncTwo       = 1,
+  ldmaCtrlSrcIncFour      = 2,
+  ldmaCtrlSrcIncNone      = 3
+}LDMA_CtrlSrcInc_t;
+
+typedef enum{
+  ldmaCtrlDstIncOne       = 0,
+  ldmaCtrlDstIncTwo       = 1,
+  ldmaCtrlDstIncFour      = 2,
+  ldmaCtrlDstIncNone      = 3
+}LDMA_CtrlDstInc_t;
+
+typedef enum{
+  ldmaCtrlSizeByte        = 0,
+  ldmaCtrlSizeHalf        = 1,
+  ldmaCtrlSizeWord        = 2
+}LDMA_CtrlSize_t;
+
+typedef enum{
+  ldmaLinkModeAbs         = 0,
+  ldmaLinkModeRel         = 1
+}LDMA_LinkMode_t;
+
+typedef enum{
+  ldmaPeripheralSignal_NONE,
+  ldmaPeripheralSignal_I2C0_RXDATAV,
+  ldmaPeripheralSignal_I2C0_TXBL,
+  ldmaPeripheralSignal_I2C1_RXDATAV,
+  ldmaPeripheralSignal_I2C1_TXBL,
+  ldmaPeripheralSignal_LEUART0_RXDATAV,
+  ldmaPeripheralSignal_LEUART0_TXBL,
+  ldmaPeripheralSignal_LEUART0_TXEMPTY
+}LDMA_PeripheralSignal_t;
+
+typedef union{
+  struct{
+    uint32_t  structType  : 2;
+    uint32_t  reserved0   : 1;
+    uint32_t  structReq   : 1;
+    uint32_t  xferCnt     : 11;
+    uint32_t  byteSwap    : 1;
+    uint32_t  blockSize   : 4;
+    uint32_t  doneIfs     : 1;
+    uint32_t  reqMode     : 1;
+    uint32_t  decLoopCnt  : 1;
+    uint32_t  ignoreSrec  : 1;
+    uint32_t  srcInc      : 2;
+    uint32_t  size        : 2;
+    uint32_t  dstInc      : 2;
+    uint32_t  srcAddrMode : 1;
+    uint32_t  dstAddrMode : 1;
+    uint32_t  srcAddr;
+    uint32_t  dstAddr;
+    uint32_t  linkMode    : 1;
+    uint32_t  link        : 1;
+    int32_t   linkAddr    : 30;
+  }xfer;
+  struct{
+    uint32_t  structType  : 2;
+    uint32_t  reserved0   : 1;
+    uint32_t  structReq   : 1;
+    uint32_t  xferCnt     : 11;
+    uint32_t  byteSwap    : 1;
+    uint32_t  blockSize   : 4;
+    uint32_t  doneIfs     : 1;
+    uint32_t  reqMode     : 1;
+    uint32_t  decLoopCnt  : 1;
+    uint32_t  ignoreSrec  : 1;
+    uint32_t  srcInc      : 2;
+    uint32_t  size        : 2;
+    uint32_t  dstInc      : 2;
+    uint32_t  srcAddrMode : 1;
+    uint32_t  dstAddrMode : 1;
+    uint32_t  immVal;
+    uint32_t  dstAddr;
+    uint32_t  linkMode    : 1;
+    uint32_t  link        : 1;
+    int32_t   linkAddr    : 30;
+  }wri;
+}LDMA_Descriptor_t;
+
+typedef struct{
+  uint32_t  ldmaReqSel;
+  uint8_t   ldmaCfgArbSlots;
+}LDMA_TransferCfg_t;
+
+typedef struct{
+  uint8_t   ldmaInitCtrlNumFixed;
+  uint8_t   ldmaInitIrqPriority;
+}LDMA_Init_t;
+
+#define LDMA_INIT_DEFAULT   { 8, 3 }
+
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal)  { (signal), 0 }
+
+#define LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(src, dest, count)   \
+  { .xfer = { .structType = ldmaCtrlStructTypeXfer, .structReq = 0, .xferCnt = (count) - 1, \
+              .doneIfs = 1, .reqMode = ldmaCtrlReqModeBlock, .srcInc = ldmaCtrlSrcIncOne,     \
+              .size = ldmaCtrlSizeByte, .dstInc = ldmaCtrlDstIncNone,                         \
+              .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest),  \
+              .linkMode = 0, .link = 0, .linkAddr = 0 } }
+
+#define LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(src, dest, count)   \
+  { .xfer = { .structType = ldmaCtrlStructTypeXfer, .structReq = 0, .xferCnt = (count) - 1, \
+              .doneIfs = 1, .reqMode = ldmaCtrlReqModeBlock, .srcInc = ldmaCtrlSrcIncNone,    \
+              .size = ldmaCtrlSizeByte, .dstInc = ldmaCtrlDstIncOne,                          \
+              .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest),  \
+              .linkMode = 0, .link = 0, .linkAddr = 0 } }
+
+#define LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, dest, count, linkjmp)   \
+  { .xfer = { .structType = ldmaCtrlStructTypeXfer, .structReq = 0, .xferCnt = (count) - 1, \
+              .doneIfs = 1, .reqMode = ldmaCtrlReqModeBlock, .srcInc = ldmaCtrlSrcIncNone,    \
+              .size = ldmaCtrlSizeByte, .dstInc = ldmaCtrlDstIncOne,                          \
+              .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest),  \
+              .linkMode = ldmaLinkModeRel, .link = 1, .linkAddr = (linkjmp) * 4 } }
+
+#define LDMA_DESCRIPTOR_SINGLE_WRITE(value, address)   \
+  { .wri = { .structType = ldmaCtrlStructTypeWrite, .structReq = 1, .xferCnt = 0,           \
+             .doneIfs = 1, .reqMode = ldmaCtrlReqModeBlock, .srcInc = ldmaCtrlSrcIncNone,     \
+             .size = ldmaCtrlSizeWord, .dstInc = ldmaCtrlDstIncNone,                          \
+             .immVal = (value), .dstAddr = (uint32_t)(uintptr_t)(address),                    \
+             .linkMode = 0, .link = 0, .linkAddr = 0 } }
+
+void LDMA_Init(const LDMA_Init_t *init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer, const LDMA_Descriptor_t *descriptor);
+void LDMA_StopTransfer(int ch);
+bool LDMA_TransferDone(int ch);
+uint32_t LDMA_TransferRemainingCount(int ch);
+uint32_t LDMA_IntGet(void);
+uint32_t LDMA_IntGetEnabled(void);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+void LDMA_IntDisable(uint32_t flags);
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * em_letimer.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_letimer.h in the host build, it is not
+ * the vendor file. The counter is modeled by host_letimer.c.
+ */
+#ifndef EM_LETIMER_HG
+#define EM_LETIMER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  letimerRepeatFree,
+  letimerRepeatOneshot,
+  letimerRepeatBuffered,
+  letimerRepeatDouble
+}LETIMER_RepeatMode_TypeDef;
+
+typedef enum{
+  letimerUFOANone,
+  letimerUFOAToggle,
+  letimerUFOAPulse,
+  letimerUFOAPwm
+}LETIMER_UFOA_TypeDef;
+
+typedef struct{
+  bool                        enable;
+  bool                        debugRun;
+  bool                        comp0Top;
+  bool                        bufTop;
+  uint8_t                     out0Pol;
+  uint8_t                     out1Pol;
+  LETIMER_UFOA_TypeDef        ufoa0;
+  LETIMER_UFOA_TypeDef        ufoa1;
+  LETIMER_RepeatMode_TypeDef  repMode;
+  uint32_t                    topValue;
+}LETIMER_Init_TypeDef;
+
+#define LETIMER_INIT_DEFAULT  { true, false, false, false, 0, 0, letimerUFOANone, letimerUFOANone, letimerRepeatFree, 0 }
+
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init);
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable);
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value);
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef *letimer, unsigned int comp);
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef *letimer);
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value);
+
+#endif
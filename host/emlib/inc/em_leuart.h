@@ -0,0 +1,59 @@
+/*
+ * em_leuart.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_leuart.h in the host build, it is not
+ * the vendor file. The UART is modeled by host_leuart.c.
+ */
+#ifndef EM_LEUART_HG
+#define EM_LEUART_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  leuartDisable   = 0,
+  leuartEnableRx  = LEUART_CMD_RXEN,
+  leuartEnableTx  = LEUART_CMD_TXEN,
+  leuartEnable    = LEUART_CMD_RXEN | LEUART_CMD_TXEN
+}LEUART_Enable_TypeDef;
+
+typedef enum{
+  leuartDatabits8,
+  leuartDatabits9
+}LEUART_Databits_TypeDef;
+
+typedef enum{
+  leuartNoParity,
+  leuartEvenParity,
+  leuartOddParity
+}LEUART_Parity_TypeDef;
+
+typedef enum{
+  leuartStopbits1,
+  leuartStopbits2
+}LEUART_Stopbits_TypeDef;
+
+typedef struct{
+  LEUART_Enable_TypeDef     enable;
+  uint32_t                  refFreq;
+  uint32_t                  baudrate;
+  LEUART_Databits_TypeDef   databits;
+  LEUART_Parity_TypeDef     parity;
+  LEUART_Stopbits_TypeDef   stopbits;
+}LEUART_Init_TypeDef;
+
+#define LEUART_INIT_DEFAULT   { leuartEnable, 0, 9600, leuartDatabits8, leuartNoParity, leuartStopbits1 }
+
+void LEUART_Init(LEUART_TypeDef *leuart, const LEUART_Init_TypeDef *init);
+void LEUART_Enable(LEUART_TypeDef *leuart, LEUART_Enable_TypeDef enable);
+void LEUART_BaudrateSet(LEUART_TypeDef *leuart, uint32_t refFreq, uint32_t baudrate);
+uint32_t LEUART_BaudrateGet(LEUART_TypeDef *leuart);
+
+#endif
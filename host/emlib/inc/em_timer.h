@@ -0,0 +1,68 @@
+/*
+ * em_timer.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Replaces the Silicon Labs emlib em_timer.h in the host build, it is not the
+ * vendor file. The counter is modeled by host_timer.c.
+ */
+#ifndef EM_TIMER_HG
+#define EM_TIMER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+
+typedef enum{
+  timerModeUp,
+  timerModeDown,
+  timerModeUpDown,
+  timerModeQDec
+}TIMER_Mode_TypeDef;
+
+typedef enum{
+  timerPrescale1,
+  timerPrescale2,
+  timerPrescale4,
+  timerPrescale8,
+  timerPrescale16,
+  timerPrescale32,
+  timerPrescale64,
+  timerPrescale128,
+  timerPrescale256,
+  timerPrescale512,
+  timerPrescale1024
+}TIMER_Prescale_TypeDef;
+
+typedef enum{
+  timerClkSelHFPerClk,
+  timerClkSelCC1,
+  timerClkSelCascade
+}TIMER_ClkSel_TypeDef;
+
+typedef struct{
+  bool                    enable;
+  bool                    debugRun;
+  TIMER_Prescale_TypeDef  prescale;
+  TIMER_ClkSel_TypeDef    clkSel;
+  bool                    count2x;
+  bool                    ati;
+  uint32_t                fallAction;
+  uint32_t                riseAction;
+  TIMER_Mode_TypeDef      mode;
+  bool                    dmaClrAct;
+  bool                    quadModeX4;
+  bool                    oneShot;
+  bool                    sync;
+}TIMER_Init_TypeDef;
+
+#define TIMER_INIT_DEFAULT  { true, false, timerPrescale1, timerClkSelHFPerClk, false, false, 0, 0, timerModeUp, false, false, false, false }
+
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init);
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable);
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * host_config.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Included ahead of every host build file. There is no DWT on the host, so the
+ * scheduler and profile time bases are a monotonic clock in ns instead, see
+ * scheduler.h and profile.h.
+ */
+#ifndef HOST_CONFIG_HG
+#define HOST_CONFIG_HG
+
+#include <stdint.h>
+
+#define SCHEDULER_CYCLES()        host_cycles()
+#define SCHEDULER_CYCLES_INIT()   ((void)0)
+#define PROFILE_CYCLES()          host_cycles()
+#define PROFILE_CYCLES_INIT()     ((void)0)
+
+uint32_t host_cycles(void);
+
+#endif
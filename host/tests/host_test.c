@@ -0,0 +1,163 @@
+/**
+ * @file
+ * host_test.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Case runner and board set up of the host tests
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "em_chip.h"
+#include "em_core.h"
+#include "em_emu.h"
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define HOST_TEST_SLICE     HOST_MS(1)      // main loop run between checks of host_test_wait
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t host_test_failures;     // checks failed in this process
+static uint32_t host_test_failed;       // cases failed, in the parent
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Counts and reports a failed check, the case carries on.
+ *
+ ******************************************************************************/
+void host_test_check(bool pass, const char *expr, const char *file, int line){
+  if(!pass){
+      host_test_failures++;
+      printf("  %s:%d: CHECK(%s) failed\n", file, line, expr);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * CHECK_EQ, reports both values.
+ *
+ ******************************************************************************/
+void host_test_check_eq(int64_t a, int64_t b, const char *expr, const char *file, int line){
+  if(a != b){
+      host_test_failures++;
+      printf("  %s:%d: CHECK_EQ(%s) failed, %lld != %lld\n", file, line, expr, (long long)a, (long long)b);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs a case in a child process with a fresh host_init.
+ *
+ * @details
+ * A case fails on a failed check, an EFM_ASSERT, host_fail or a crash.
+ *
+ ******************************************************************************/
+void host_test_case(const char *name, HOST_TEST_CASE test){
+  int status;
+  pid_t pid;
+
+  fflush(stdout);
+  pid = fork();
+  if(pid < 0){
+      perror("fork");
+      exit(2);
+  }
+  if(pid == 0){
+      host_init();
+      test();
+      fflush(stdout);
+      _exit(host_test_failures ? 1 : 0);
+  }
+  waitpid(pid, &status, 0);
+  if(WIFEXITED(status) && (WEXITSTATUS(status) == 0)){
+      printf("PASS %s\n", name);
+  }
+  else{
+      host_test_failed++;
+      printf("FAIL %s\n", name);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Exit status of a test program.
+ *
+ ******************************************************************************/
+int host_test_result(void){
+  return host_test_failed ? 1 : 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The clocks main sets up and the drivers app_peripheral_setup opens
+ * before the sensor and the BLE link.
+ *
+ ******************************************************************************/
+void host_test_board(void){
+  CHIP_Init();
+  CMU_HFRCOBandSet(MCU_HFXO_FREQ);
+  CMU_OscillatorEnable(cmuOsc_HFRCO, true, true);
+  CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+
+  scheduler_open();
+  sleep_open();
+  cmu_open();
+  sw_timer_open(SW_TIMER_CB, SW_TIMER_PRIO);
+  ldma_open();
+  gpio_open();
+}
+
+/***************************************************************************//**
+ * @brief
+ * The main loop of main.c, for host_run.
+ *
+ ******************************************************************************/
+void host_test_loop(void){
+  while(1){
+      if(!get_scheduled_events()){
+          CORE_DECLARE_IRQ_STATE;
+          CORE_ENTER_CRITICAL();
+          enter_sleep();
+          CORE_EXIT_CRITICAL();
+      }
+      scheduler_dispatch();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the main loop until done says so or cycles are up.
+ *
+ * @return
+ * done at the end.
+ *
+ ******************************************************************************/
+bool host_test_wait(bool (*done)(void), uint64_t cycles){
+  uint64_t end = host_now() + cycles;
+
+  while(!done() && (host_now() < end)){
+      uint64_t slice = end - host_now();
+      host_run(host_test_loop, (slice < HOST_TEST_SLICE) ? slice : HOST_TEST_SLICE);
+  }
+  return done();
+}
@@ -0,0 +1,49 @@
+/*
+ * host_test.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ *
+ * Checks and a case runner for the host tests. Each case runs in its own
+ * process, since host_init is once per process.
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef HOST_TEST_HG
+#define HOST_TEST_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The developer's include statements */
+#include "host.h"
+#include "app.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define CHECK(expr)         host_test_check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_EQ(a, b)      host_test_check_eq((int64_t)(a), (int64_t)(b), #a " == " #b, __FILE__, __LINE__)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef void (*HOST_TEST_CASE)(void);
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void host_test_check(bool pass, const char *expr, const char *file, int line);
+void host_test_check_eq(int64_t a, int64_t b, const char *expr, const char *file, int line);
+void host_test_case(const char *name, HOST_TEST_CASE test);
+int host_test_result(void);
+void host_test_board(void);
+void host_test_loop(void);
+bool host_test_wait(bool (*done)(void), uint64_t cycles);
+
+#endif
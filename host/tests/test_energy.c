@@ -0,0 +1,264 @@
+/**
+ * @file
+ * test_energy.c
+ * @author
+ * agent
+ * @date
+ * 10/17/26
+ * @brief
+ * Host tests of what waiting costs awake, the delays and the BLE receive
+ * monitor
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "em_cmu.h"
+#include "em_timer.h"
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_DELAY_MS       100
+#define TEST_RUN            HOST_MS(TEST_DELAY_MS + 20)
+#define TEST_SLEEP_AWAKE    1           // percent of the delay timer_delay may spend awake
+#define TEST_UNFRAMED       "the central talking outside a frame, nothing the board waits for"
+#define TEST_UNFRAMED_IRQS  2           // the byte that blocks the receiver, and one in flight
+#define TEST_STATS_SLACK    2           // ms the sleep stats may be off, a LETIMER tick at each end
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static bool test_delay_done;
+static bool test_async_done;
+static uint64_t test_delay_took;
+static HOST_ENERGY test_stats_energy;
+static SLEEP_STATS test_stats;
+static SW_TIMER test_async_timer;
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * timer_delay as it was before the sleeping delay, counting TIMER0 down at
+ * HFPERCLK/1024 in EM0.
+ *
+ ******************************************************************************/
+static void test_busy_delay(uint32_t ms_delay){
+  uint32_t timer_clk_freq = CMU_ClockFreqGet(cmuClock_HFPER);
+  uint32_t delay_count = ms_delay *(timer_clk_freq/1000) / 1024;
+  TIMER_Init_TypeDef delay_counter_init = TIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  delay_counter_init.oneShot = true;
+  delay_counter_init.enable = false;
+  delay_counter_init.mode = timerModeDown;
+  delay_counter_init.prescale = timerPrescale1024;
+  delay_counter_init.debugRun = false;
+  TIMER_Init(TIMER0, &delay_counter_init);
+  TIMER0->CNT = delay_count;
+  TIMER_Enable(TIMER0, true);
+  while(TIMER0->CNT != 0);
+  TIMER_Enable(TIMER0, false);
+  CMU_ClockEnable(cmuClock_TIMER0, false);
+}
+
+static void test_busy_entry(void){
+  uint64_t start = host_now();
+
+  test_busy_delay(TEST_DELAY_MS);
+  test_delay_took = host_now() - start;
+  test_delay_done = true;
+  host_test_loop();
+}
+
+static void test_sleep_entry(void){
+  uint64_t start = host_now();
+
+  timer_delay(TEST_DELAY_MS);
+  test_delay_took = host_now() - start;
+  test_delay_done = true;
+  host_test_loop();
+}
+
+static void test_stats_entry(void){
+  timer_delay(TEST_DELAY_MS);
+  sleep_stats_get(&test_stats);
+  host_energy(&test_stats_energy);
+  test_delay_done = true;
+  host_test_loop();
+}
+
+static void test_async_cb(void){
+  test_async_done = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs entry through a TEST_DELAY_MS delay.
+ *
+ * @return
+ * Cycles awake, spin and wake up cycles included.
+ *
+ ******************************************************************************/
+static uint64_t test_delay_awake(void (*entry)(void)){
+  HOST_ENERGY energy;
+
+  host_test_board();
+  host_stats_reset();
+  host_run(entry, TEST_RUN);
+  host_energy(&energy);
+  CHECK(test_delay_done);
+  CHECK(test_delay_took >= HOST_MS(TEST_DELAY_MS));
+  CHECK(test_delay_took < HOST_MS(TEST_DELAY_MS + 2));
+  return energy.em_cycles[0];
+}
+
+/***************************************************************************//**
+ * @brief
+ * The TIMER0 busy wait keeps the core in EM0 for the whole delay.
+ *
+ ******************************************************************************/
+static void test_delay_busy(void){
+  uint64_t awake = test_delay_awake(test_busy_entry);
+
+  printf("  TIMER0 busy wait, %u ms: %llu cycles awake\n", TEST_DELAY_MS, (unsigned long long)awake);
+  CHECK(awake >= HOST_MS(TEST_DELAY_MS));
+}
+
+/***************************************************************************//**
+ * @brief
+ * timer_delay sleeps through the delay on a software timer.
+ *
+ ******************************************************************************/
+static void test_delay_sleep(void){
+  HOST_ENERGY energy;
+  uint64_t awake = test_delay_awake(test_sleep_entry);
+
+  host_energy(&energy);
+  printf("  timer_delay, %u ms: %llu cycles awake\n", TEST_DELAY_MS, (unsigned long long)awake);
+  CHECK(awake < HOST_MS(TEST_DELAY_MS)*TEST_SLEEP_AWAKE/100);
+  CHECK(energy.em_cycles[2] + energy.em_cycles[3] > HOST_MS(TEST_DELAY_MS));
+}
+
+/***************************************************************************//**
+ * @brief
+ * timer_delay_async posts its event after the delay and the main loop
+ * sleeps meanwhile.
+ *
+ ******************************************************************************/
+static void test_delay_async(void){
+  HOST_ENERGY energy;
+
+  host_test_board();
+  scheduler_register(REPORT_TIMER_CB, test_async_cb, REPORT_TIMER_PRIO);
+  host_stats_reset();
+  timer_delay_async(&test_async_timer, TEST_DELAY_MS, REPORT_TIMER_CB);
+  host_run(host_test_loop, HOST_MS(TEST_DELAY_MS - 1));
+  CHECK(!test_async_done);
+  host_run(host_test_loop, HOST_MS(2));
+  CHECK(test_async_done);
+  host_energy(&energy);
+  CHECK(energy.em_cycles[0] < HOST_MS(TEST_DELAY_MS)*TEST_SLEEP_AWAKE/100);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The sleep stats, timed by the LETIMER count sw_timer_open gives
+ * sleep_clock_set, agree with the model on the time slept.
+ *
+ ******************************************************************************/
+static void test_sleep_stats(void){
+  uint64_t slept = 0;
+  uint32_t slept_ms = 0;
+
+  host_test_board();
+  sleep_stats_reset();
+  host_stats_reset();
+  host_run(test_stats_entry, TEST_RUN);
+  CHECK(test_delay_done);
+  for(uint32_t em = EM1; em < MAX_ENERGY_MODES; em++){
+      slept += test_stats_energy.em_cycles[em];
+      slept_ms += test_stats.residency_ms[em];
+  }
+  slept /= HOST_MS(1);
+  printf("  timer_delay, %u ms: %u ms asleep by the sleep stats, %llu by the model\n", TEST_DELAY_MS,
+         (unsigned)slept_ms, (unsigned long long)slept);
+  CHECK(slept_ms + TEST_STATS_SLACK >= slept);
+  CHECK(slept_ms <= slept + TEST_STATS_SLACK);
+  CHECK(test_stats.elapsed_ms + TEST_STATS_SLACK >= TEST_DELAY_MS);
+}
+
+static bool test_ble_ready(void){
+  HOST_HM18_STATE state;
+
+  host_hm18_state(&state);
+  return state.noti && ble_connected();
+}
+
+/***************************************************************************//**
+ * @brief
+ * While a central is connected, bytes it sends outside a frame block the
+ * receiver after the first, so the rest cost no interrupt.
+ *
+ ******************************************************************************/
+static void test_monitor_cost(void){
+  BLE_OPEN_STRUCT open = {
+      .tx_evt = 0,
+      .rx_evt = BLE_RX_DONE_CB,
+      .format = BLE_FORMAT_TEXT,
+      .at_evt = BLE_AT_CB,
+      .at_prio = BLE_AT_PRIO,
+      .at_timeout_evt = BLE_AT_TIMEOUT_CB,
+      .at_timeout_prio = BLE_AT_TIMEOUT_PRIO,
+      .link_evt = BLE_LINK_CB,
+      .link_prio = BLE_LINK_PRIO
+  };
+  HOST_LEUART_STATS before;
+  HOST_LEUART_STATS after;
+  uint32_t len = strlen(TEST_UNFRAMED);
+  uint32_t irqs;
+
+  host_test_board();
+  host_hm18_init();
+  ble_open(&open);
+  host_run(host_test_loop, HOST_MS(500));
+  host_hm18_connect(true);
+  CHECK(host_test_wait(test_ble_ready, HOST_MS(500)));
+
+  host_leuart_stats(&before);
+  host_stats_reset();
+  host_hm18_central_send(TEST_UNFRAMED);
+  host_run(host_test_loop, HOST_MS(len*10*1000/HM10_BAUDRATE + 10));
+  host_leuart_stats(&after);
+  irqs = host_irq_count(LEUART0_IRQn);
+
+  printf("  %u unframed bytes while connected: %u LEUART0 interrupts, %u blocked\n",
+         (unsigned)len, (unsigned)irqs, (unsigned)(after.rx_blocked - before.rx_blocked));
+  CHECK(irqs <= TEST_UNFRAMED_IRQS);
+  CHECK(after.rx_blocked - before.rx_blocked >= len - TEST_UNFRAMED_IRQS);
+  CHECK(ble_connected());
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("delay_busy", test_delay_busy);
+  host_test_case("delay_sleep", test_delay_sleep);
+  host_test_case("delay_async", test_delay_async);
+  host_test_case("sleep_stats", test_sleep_stats);
+  host_test_case("ble_monitor_cost", test_monitor_cost);
+  return host_test_result();
+}
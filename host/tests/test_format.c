@@ -0,0 +1,211 @@
+/**
+ * @file
+ * test_format.c
+ * @author
+ * agent
+ * @date
+ * 10/17/26
+ * @brief
+ * format.c against snprintf, for output and for time per message
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_MSG_SIZE       APP_BATCH_MSG_SIZE
+#define TEST_BENCH_RUNS     200000
+#define TEST_MAX_DECIMALS   3           // app.c uses 1 and 3
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const int32_t test_values[] = {
+    0, 1, -1, 5, -5, 9, 10, -10, 99, 100, 999, 1000, -1000, 12345, -12345,
+    65535, 65536, 999999, 1000000, 123456789, -123456789, 1000000000,
+    INT32_MAX, INT32_MIN + 1, INT32_MIN
+};
+
+// A full light batch, what scheduled_batch_timer_cb formats
+static const uint32_t test_batch[APP_BATCH_SAMPLES] = {
+    412, 398, 405, 1, 65535, 420, 0, 4095
+};
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Nanoseconds of the host's monotonic clock.
+ *
+ ******************************************************************************/
+static uint64_t test_ns(void){
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The light message the way app.c builds it.
+ *
+ ******************************************************************************/
+static uint32_t test_light_format(char *msg, uint32_t uvi_milli){
+  FORMAT_BUFFER fmt;
+
+  format_open(&fmt, msg, TEST_MSG_SIZE);
+  format_string(&fmt, "light n=");
+  format_uint(&fmt, APP_BATCH_SAMPLES);
+  format_string(&fmt, " min=");
+  format_uint(&fmt, 0);
+  format_string(&fmt, " max=");
+  format_uint(&fmt, 65535);
+  format_string(&fmt, " mean=");
+  format_uint(&fmt, 6991);
+  format_string(&fmt, " uvi=");
+  format_fixed(&fmt, (int32_t)uvi_milli, 3);
+  format_string(&fmt, " lux=");
+  format_uint(&fmt, 2150);
+  format_char(&fmt, ':');
+  for(uint32_t i = 0; i < APP_BATCH_SAMPLES; i++){
+      format_char(&fmt, ' ');
+      format_uint(&fmt, test_batch[i]);
+  }
+  format_char(&fmt, '\n');
+  return fmt.len;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The same message the way app.c built it before format.c.
+ *
+ ******************************************************************************/
+static uint32_t test_light_sprintf(char *msg, uint32_t uvi_milli){
+  int len = snprintf(msg, TEST_MSG_SIZE, "light n=%u min=%u max=%u mean=%u uvi=%.3f lux=%u:",
+                     APP_BATCH_SAMPLES, 0u, 65535u, 6991u, (double)uvi_milli/1000.0, 2150u);
+
+  for(uint32_t i = 0; i < APP_BATCH_SAMPLES; i++){
+      len += snprintf(&msg[len], TEST_MSG_SIZE - len, " %u", (unsigned)test_batch[i]);
+  }
+  len += snprintf(&msg[len], TEST_MSG_SIZE - len, "\n");
+  return (uint32_t)len;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Every helper gives what the printf conversion it replaces gives.
+ *
+ ******************************************************************************/
+static void test_format_values(void){
+  char buf[32];
+  char expect[32];
+  FORMAT_BUFFER fmt;
+
+  for(uint32_t n = 0; n < sizeof(test_values)/sizeof(test_values[0]); n++){
+      int32_t value = test_values[n];
+
+      format_open(&fmt, buf, sizeof(buf));
+      format_int(&fmt, value);
+      snprintf(expect, sizeof(expect), "%d", (int)value);
+      CHECK(!strcmp(buf, expect));
+
+      format_open(&fmt, buf, sizeof(buf));
+      format_uint(&fmt, (uint32_t)value);
+      snprintf(expect, sizeof(expect), "%u", (unsigned)value);
+      CHECK(!strcmp(buf, expect));
+
+      format_open(&fmt, buf, sizeof(buf));
+      format_hex(&fmt, (uint32_t)value, 8);
+      snprintf(expect, sizeof(expect), "%08X", (unsigned)value);
+      CHECK(!strcmp(buf, expect));
+
+      for(uint32_t decimals = 0; decimals <= TEST_MAX_DECIMALS; decimals++){
+          double scale = (decimals == 0) ? 1.0 : (decimals == 1) ? 10.0 : (decimals == 2) ? 100.0 : 1000.0;
+          format_open(&fmt, buf, sizeof(buf));
+          format_fixed(&fmt, value, decimals);
+          snprintf(expect, sizeof(expect), "%.*f", (int)decimals, (double)value/scale);
+          CHECK(!strcmp(buf, expect));
+      }
+      CHECK(!fmt.overflow);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * What does not fit is cut off, still terminated, and flagged.
+ *
+ ******************************************************************************/
+static void test_format_overflow(void){
+  char buf[8];
+  FORMAT_BUFFER fmt;
+
+  memset(buf, 'x', sizeof(buf));
+  format_open(&fmt, buf, 6);
+  format_string(&fmt, "abc");
+  format_int(&fmt, -12345);
+  CHECK(fmt.overflow);
+  CHECK_EQ(fmt.len, 5);
+  CHECK_EQ(strlen(buf), 5);
+  CHECK_EQ(buf[6], 'x');
+}
+
+/***************************************************************************//**
+ * @brief
+ * The light message from format.c and from snprintf with %.3f, the same
+ * bytes, and how long each takes here. Host time is only a hint of the
+ * ratio on the Cortex-M4, the size side is tools/map_size.py.
+ *
+ ******************************************************************************/
+static void test_format_bench(void){
+  char msg[TEST_MSG_SIZE];
+  char expect[TEST_MSG_SIZE];
+  volatile uint32_t sink = 0;
+  uint64_t start;
+  uint64_t format_ns;
+  uint64_t sprintf_ns;
+
+  for(uint32_t uvi = 0; uvi < 20000; uvi += 7){
+      CHECK_EQ(test_light_format(msg, uvi), test_light_sprintf(expect, uvi));
+      CHECK(!strcmp(msg, expect));
+  }
+
+  start = test_ns();
+  for(uint32_t i = 0; i < TEST_BENCH_RUNS; i++){
+      sink += test_light_format(msg, i & 0x3FFF);
+  }
+  format_ns = test_ns() - start;
+  start = test_ns();
+  for(uint32_t i = 0; i < TEST_BENCH_RUNS; i++){
+      sink += test_light_sprintf(msg, i & 0x3FFF);
+  }
+  sprintf_ns = test_ns() - start;
+  (void)sink;
+
+  printf("  light message: format %.1f ns, snprintf %.1f ns, %.1fx\n",
+         (double)format_ns/TEST_BENCH_RUNS, (double)sprintf_ns/TEST_BENCH_RUNS,
+         format_ns ? (double)sprintf_ns/(double)format_ns : 0.0);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("format_values", test_format_values);
+  host_test_case("format_overflow", test_format_overflow);
+  host_test_case("format_bench", test_format_bench);
+  return host_test_result();
+}
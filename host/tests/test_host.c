@@ -0,0 +1,216 @@
+/**
+ * @file
+ * test_host.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Smoke tests of the host build, one driver stack each
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_PERIOD_MS      100
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t test_ticks;
+static bool test_ready;
+static bool test_result;
+static SW_TIMER test_timer;
+
+static const SI1133_CHANNEL test_channels[] = {
+    { .adcmux = SI1133_ADCMUX_WHITE },
+    { .adcmux = SI1133_ADCMUX_UV, .out24 = true }
+};
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+static void test_tick_cb(void){
+  test_ticks++;
+}
+
+static void test_ready_cb(void){
+  test_ready = true;
+}
+
+static void test_result_cb(void){
+  Si1133_request_result(SI1133_REG_READ_CB);
+}
+
+static void test_read_cb(void){
+  test_result = true;
+}
+
+static void test_error_cb(void){
+  CHECK(false);
+}
+
+static bool test_is_ready(void){
+  return test_ready;
+}
+
+static bool test_has_result(void){
+  return test_result;
+}
+
+static bool test_noti_on(void){
+  HOST_HM18_STATE state;
+
+  host_hm18_state(&state);
+  return state.noti;
+}
+
+/***************************************************************************//**
+ * @brief
+ * A periodic software timer on LETIMER0 posts on time, and the core sleeps
+ * in EM3 in between.
+ *
+ ******************************************************************************/
+static void test_sw_timer(void){
+  HOST_ENERGY energy;
+
+  host_test_board();
+  scheduler_register(REPORT_TIMER_CB, test_tick_cb, REPORT_TIMER_PRIO);
+  host_stats_reset();
+  sw_timer_start(&test_timer, TEST_PERIOD_MS, TEST_PERIOD_MS, REPORT_TIMER_CB);
+  host_run(host_test_loop, HOST_MS(10*TEST_PERIOD_MS + TEST_PERIOD_MS/2));
+  CHECK_EQ(test_ticks, 10);
+
+  host_energy(&energy);
+  CHECK(energy.em_cycles[3] > 99*(energy.em_cycles[0] + energy.em_cycles[3])/100);
+  CHECK(host_irq_count(LETIMER0_IRQn) >= 10);
+}
+
+/***************************************************************************//**
+ * @brief
+ * format.c gives what printf does for the conversions the app uses.
+ *
+ ******************************************************************************/
+static void test_format(void){
+  char buf[32];
+  char expect[32];
+  FORMAT_BUFFER fmt;
+
+  format_open(&fmt, buf, sizeof(buf));
+  format_int(&fmt, -1234567);
+  format_char(&fmt, ' ');
+  format_fixed(&fmt, -1234, 2);
+  format_char(&fmt, ' ');
+  format_hex(&fmt, 0xBEEF, 6);
+  snprintf(expect, sizeof(expect), "%d %.2f %06X", -1234567, -12.34, 0xBEEF);
+  CHECK(!strcmp(buf, expect));
+  CHECK(!fmt.overflow);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The Si1133 driver configures the sensor over I2C1 and reads a result
+ * when INT falls.
+ *
+ ******************************************************************************/
+static void test_si1133(void){
+  SI1133_OPEN_STRUCT open = {
+      .channels = test_channels,
+      .channel_count = 2,
+      .period_ms = 100,
+      .result_evt = SI1133_RESULT_CB,
+      .ready_evt = SI1133_READY_CB,
+      .error_evt = SI1133_ERROR_CB,
+      .supervise_evt = I2C1_SUPERVISE_CB,
+      .supervise_prio = I2C1_SUPERVISE_PRIO,
+      .config_evt = SI1133_CONFIG_CB,
+      .config_prio = SI1133_CONFIG_PRIO,
+      .i2c_error_evt = SI1133_I2C_ERROR_CB,
+      .i2c_error_prio = SI1133_I2C_ERROR_PRIO
+  };
+  SI1133_RESULT result;
+
+  host_test_board();
+  host_si1133_init(I2C1);
+  host_si1133_light(1234, -5, 0);
+  scheduler_register(SI1133_READY_CB, test_ready_cb, SI1133_READY_PRIO);
+  scheduler_register(SI1133_RESULT_CB, test_result_cb, SI1133_RESULT_PRIO);
+  scheduler_register(SI1133_REG_READ_CB, test_read_cb, SI1133_REG_READ_PRIO);
+  scheduler_register(SI1133_ERROR_CB, test_error_cb, SI1133_ERROR_PRIO);
+  Si1133_i2c_open(&open);
+
+  CHECK(host_test_wait(test_is_ready, HOST_MS(500)));
+  CHECK(host_test_wait(test_has_result, HOST_MS(300)));
+  Si1133_result(&result);
+  CHECK_EQ(result.count, 2);
+  CHECK_EQ(result.value[0], 1234);
+  CHECK_EQ(result.value[1], -5);
+}
+
+/***************************************************************************//**
+ * @brief
+ * ble_open finds the HM-18 and turns its notices on.
+ *
+ ******************************************************************************/
+static void test_ble_open(void){
+  BLE_OPEN_STRUCT open = {
+      .tx_evt = 0,
+      .rx_evt = BLE_RX_DONE_CB,
+      .format = BLE_FORMAT_TEXT,
+      .at_evt = BLE_AT_CB,
+      .at_prio = BLE_AT_PRIO,
+      .at_timeout_evt = BLE_AT_TIMEOUT_CB,
+      .at_timeout_prio = BLE_AT_TIMEOUT_PRIO,
+      .link_evt = BLE_LINK_CB,
+      .link_prio = BLE_LINK_PRIO
+  };
+
+  host_test_board();
+  host_hm18_init();
+  ble_open(&open);
+  CHECK(host_test_wait(test_noti_on, HOST_MS(1000)));
+}
+
+/***************************************************************************//**
+ * @brief
+ * With no central connected ble_write_owned keeps the buffer back and
+ * releases it at once, and says so when it is too long to keep.
+ *
+ ******************************************************************************/
+static void test_ble_backlog(void){
+  static uint8_t msg[BLE_BACKLOG_MAX_MSG + 1];
+
+  test_ble_open();
+  memset(msg, 'b', sizeof(msg));
+  CHECK(!ble_connected());
+  CHECK(ble_write_owned(msg, BLE_BACKLOG_MAX_MSG, BLE_TX_DONE_CB));
+  CHECK(get_scheduled_events() & BLE_TX_DONE_CB);
+  remove_scheduled_event(BLE_TX_DONE_CB);
+  CHECK(!ble_write_owned(msg, sizeof(msg), BLE_TX_DONE_CB));
+  CHECK(get_scheduled_events() & BLE_TX_DONE_CB);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("sw_timer", test_sw_timer);
+  host_test_case("format", test_format);
+  host_test_case("si1133", test_si1133);
+  host_test_case("ble_open", test_ble_open);
+  host_test_case("ble_backlog", test_ble_backlog);
+  return host_test_result();
+}
@@ -0,0 +1,506 @@
+/**
+ * @file
+ * test_i2c.c
+ * @author
+ * agent
+ * @date
+ * 10/17/26
+ * @brief
+ * Host tests of the I2C driver against a register slave on I2C1, with and
+ * without faults on the bus
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_ADDRESS        0x40
+#define TEST_TRANSFERS      I2C_QUEUE_SIZE
+#define TEST_EVT_BIT        20                          // bits and priorities of the done events
+#define TEST_EVT(n)         (1u << (TEST_EVT_BIT + (n)))
+#define TEST_READ_LEN       6
+#define TEST_WAIT           HOST_MS(50)
+#define TEST_LONG_READ      32
+#define TEST_LONG_REG       0x80
+#define TEST_DMA_IRQS       8           // the register write, the repeated START, the last byte and STOP
+#define TEST_LDMA_LATE      HOST_US(200)  // about eight byte times at 400 kHz
+#define TEST_FAULT_WAIT     HOST_MS(200)  // all the back offs and timeouts of a transfer
+#define TEST_SLOW_READ      200         // bytes, longer on a standard rate bus than I2C_TIMEOUT_MS
+#define TEST_SDA_CLOCKS     5           // a slave that needs fewer than I2C_RECOVERY_CLOCKS
+#define TEST_BACKOFFS_MS    (I2C_BACKOFF_MS*((1u << I2C_RETRIES) - 1))   // 5 + 10 + 20
+
+#define TEST_DONE(n)        static void test_done_##n(void){ test_done(n); }
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// What one queued transfer should do on the bus
+typedef struct{
+  uint8_t   tx[3];                  // register, then data
+  uint32_t  tx_len;
+  uint8_t   rx[TEST_READ_LEN];
+  uint32_t  rx_len;
+}TEST_TRANSFER;
+
+static HOST_I2C_REGS test_slave;
+static TEST_TRANSFER test_transfers[TEST_TRANSFERS];
+static uint32_t test_done_order[TEST_TRANSFERS];
+static uint32_t test_done_count[TEST_TRANSFERS];
+static uint32_t test_dones;
+static uint32_t test_errors;
+static uint64_t test_first_done_at;
+static uint8_t test_long_rx[TEST_LONG_READ];
+static uint8_t test_slow_rx[TEST_SLOW_READ];
+
+static void test_done(uint32_t n);
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+TEST_DONE(0) TEST_DONE(1) TEST_DONE(2) TEST_DONE(3)
+TEST_DONE(4) TEST_DONE(5) TEST_DONE(6) TEST_DONE(7)
+
+static const SCHEDULER_HANDLER test_done_handlers[TEST_TRANSFERS] = {
+    test_done_0, test_done_1, test_done_2, test_done_3,
+    test_done_4, test_done_5, test_done_6, test_done_7
+};
+
+/***************************************************************************//**
+ * @brief
+ * Done event of transfer n. A read must have its bytes by now.
+ *
+ ******************************************************************************/
+static void test_done(uint32_t n){
+  TEST_TRANSFER *transfer = &test_transfers[n];
+
+  if(transfer->rx_len){
+      CHECK(!memcmp(transfer->rx, &test_slave.regs[transfer->tx[0]], transfer->rx_len));
+  }
+  if(!test_dones){
+      test_first_done_at = host_now();
+  }
+  if(test_dones < TEST_TRANSFERS){
+      test_done_order[test_dones] = n;
+  }
+  test_dones++;
+  test_done_count[n]++;
+}
+
+static void test_error_cb(void){
+  test_errors++;
+}
+
+static bool test_all_done(void){
+  return test_dones >= TEST_TRANSFERS;
+}
+
+static bool test_first_done(void){
+  return test_dones >= 1;
+}
+
+static bool test_bus_idle(void){
+  return is_available(I2C1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Opens I2C1 at freq the way Si1133_i2c_open does, with a register slave on
+ * it in place of the Si1133, and registers the done and error events.
+ *
+ ******************************************************************************/
+static void test_i2c_open_at(uint32_t freq, bool rx_dma){
+  I2C_OPEN_STRUCT open;
+
+  memset(&open, 0, sizeof(open));
+  open.freq = freq;
+  open.clhr = i2cClockHLRAsymetric;
+  open.master = true;
+  open.enable = true;
+  open.out_scl_en = true;
+  open.out_sda_en = true;
+  open.scl_out_route0 = I2C_OUT_SCL_PC5;
+  open.sda_out_route0 = I2C_OUT_SDA_PC4;
+  open.ack_irq_enable = true;
+  open.rxdatav_irq_enable = true;
+  open.stop_irq_enable = true;
+  open.rx_dma_en = rx_dma;
+  open.scl_port = SI1133_SCL_PORT;
+  open.scl_pin = SI1133_SCL_PIN;
+  open.sda_port = SI1133_SDA_PORT;
+  open.sda_pin = SI1133_SDA_PIN;
+  open.supervise_evt = I2C1_SUPERVISE_CB;
+  open.supervise_prio = I2C1_SUPERVISE_PRIO;
+  open.error_evt = SI1133_I2C_ERROR_CB;
+
+  host_test_board();
+  host_i2c_regs_init(&test_slave, TEST_ADDRESS);
+  for(uint32_t reg = 0; reg < sizeof(test_slave.regs); reg++){
+      test_slave.regs[reg] = (uint8_t)(reg ^ 0x5A);
+  }
+  host_i2c_attach(I2C1, &test_slave.device);
+  host_i2c_pins(I2C1, SI1133_SCL_PORT, SI1133_SCL_PIN, SI1133_SDA_PORT, SI1133_SDA_PIN);
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      scheduler_register(TEST_EVT(n), test_done_handlers[n], TEST_EVT_BIT + n);
+  }
+  scheduler_register(SI1133_I2C_ERROR_CB, test_error_cb, SI1133_I2C_ERROR_PRIO);
+  i2c_open(I2C1, &open);
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  test_slave.log_count = 0;
+}
+
+static void test_i2c_open(bool rx_dma){
+  test_i2c_open_at(I2C_FREQ_FAST_MAX, rx_dma);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets transfer n up, writes at even n and write then read at odd n, each
+ * at its own register.
+ *
+ ******************************************************************************/
+static void test_script(uint32_t n, uint32_t rx_len){
+  TEST_TRANSFER *transfer = &test_transfers[n];
+
+  memset(transfer, 0, sizeof(*transfer));
+  transfer->tx[0] = (uint8_t)(0x10*(n + 1));
+  if(n & 1){
+      transfer->tx_len = 1;
+      transfer->rx_len = rx_len;
+  }
+  else{
+      transfer->tx[1] = (uint8_t)(0xA0 + n);
+      transfer->tx[2] = (uint8_t)(0xB0 + n);
+      transfer->tx_len = 3;
+  }
+}
+
+static bool test_queue(uint32_t n){
+  TEST_TRANSFER *transfer = &test_transfers[n];
+
+  return i2c_transfer(I2C1, TEST_ADDRESS, transfer->tx, transfer->tx_len,
+                      transfer->rx_len ? transfer->rx : NULL, transfer->rx_len, TEST_EVT(n));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Checks the slave saw the transfers of the script in queue order, a read
+ * as its register write and then the read.
+ *
+ ******************************************************************************/
+static void test_check_bus(void){
+  uint32_t log = 0;
+
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      TEST_TRANSFER *transfer = &test_transfers[n];
+      HOST_I2C_XFER *xfer = &test_slave.log[log++];
+      CHECK(!xfer->read);
+      CHECK_EQ(xfer->reg, transfer->tx[0]);
+      CHECK_EQ(xfer->length, transfer->tx_len - 1);
+      if(transfer->rx_len){
+          xfer = &test_slave.log[log++];
+          CHECK(xfer->read);
+          CHECK_EQ(xfer->reg, transfer->tx[0]);
+          CHECK_EQ(xfer->length, transfer->rx_len);
+          CHECK_EQ(xfer->nack_at, transfer->rx_len);
+      }
+      else{
+          CHECK_EQ(test_slave.regs[transfer->tx[0]], transfer->tx[1]);
+          CHECK_EQ(test_slave.regs[transfer->tx[0] + 1], transfer->tx[2]);
+      }
+  }
+  CHECK_EQ(test_slave.log_count, log);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A full queue of transfers queued at once goes out in order, one more is
+ * refused until there is room, and every transfer posts its own done event
+ * once, with the bytes read in place.
+ *
+ ******************************************************************************/
+static void test_queue_order(void){
+  test_i2c_open(false);
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      test_script(n, TEST_READ_LEN);
+      CHECK(test_queue(n));
+  }
+  CHECK(!i2c_transfer(I2C1, TEST_ADDRESS, test_transfers[0].tx, 1, NULL, 0, TEST_EVT(0)));   //full
+  CHECK(!is_available(I2C1));
+
+  CHECK(host_test_wait(test_all_done, TEST_WAIT));
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  test_check_bus();
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      CHECK_EQ(test_done_count[n], 1);
+      CHECK_EQ(test_done_order[n], n);
+  }
+  CHECK_EQ(test_errors, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Transfers queued one at a time while the bus is busy join the queue
+ * behind the one on the bus and go out in order too.
+ *
+ ******************************************************************************/
+static void test_queue_refill(void){
+  uint32_t queued = 0;
+
+  test_i2c_open(false);
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      test_script(n, 2);
+  }
+  while(test_dones < TEST_TRANSFERS){
+      if((queued < TEST_TRANSFERS) && test_queue(queued)){
+          queued++;
+      }
+      host_run(host_test_loop, HOST_US(30));
+  }
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  test_check_bus();
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      CHECK_EQ(test_done_order[n], n);
+  }
+  CHECK_EQ(test_errors, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads TEST_LONG_READ registers in one transfer and checks the bytes and
+ * that only the last one was nacked, as the read stop needs.
+ *
+ * @return
+ * I2C1 interrupt entries of the read.
+ *
+ ******************************************************************************/
+static uint32_t test_long_read(void){
+  static const uint8_t reg = TEST_LONG_REG;
+  HOST_I2C_XFER *xfer = &test_slave.log[1];
+
+  memset(test_long_rx, 0, sizeof(test_long_rx));
+  host_stats_reset();
+  CHECK(i2c_transfer(I2C1, TEST_ADDRESS, &reg, 1, test_long_rx, TEST_LONG_READ, TEST_EVT(0)));
+  CHECK(host_test_wait(test_first_done, TEST_WAIT));
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  CHECK(!memcmp(test_long_rx, &test_slave.regs[TEST_LONG_REG], TEST_LONG_READ));
+  CHECK_EQ(test_slave.log_count, 2);
+  CHECK(xfer->read);
+  CHECK_EQ(xfer->length, TEST_LONG_READ);
+  CHECK_EQ(xfer->nack_at, TEST_LONG_READ);
+  CHECK_EQ(test_errors, 0);
+  return host_irq_count(I2C1_IRQn);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Without the LDMA every byte read interrupts, with it only the ends of
+ * the transfer do.
+ *
+ ******************************************************************************/
+static void test_rx_irq(void){
+  uint32_t irqs;
+
+  test_i2c_open(false);
+  irqs = test_long_read();
+  printf("  %u byte read without the LDMA: %u I2C1 interrupts\n", TEST_LONG_READ, (unsigned)irqs);
+  CHECK(irqs >= TEST_LONG_READ);
+  CHECK_EQ(host_irq_count(LDMA_IRQn), 0);
+}
+
+static void test_rx_dma(void){
+  uint32_t irqs;
+
+  test_i2c_open(true);
+  irqs = test_long_read();
+  printf("  %u byte read with the LDMA: %u I2C1 interrupts, %u LDMA\n", TEST_LONG_READ, (unsigned)irqs,
+         (unsigned)host_irq_count(LDMA_IRQn));
+  CHECK(irqs <= TEST_DMA_IRQS);
+  CHECK_EQ(host_irq_count(LDMA_IRQn), 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The LDMA interrupt runs long after the last byte came in. AUTOACK must
+ * be off by then anyway, so the last byte is still the only one nacked and
+ * nothing is read past it.
+ *
+ ******************************************************************************/
+static void test_rx_dma_late(void){
+  test_i2c_open(true);
+  host_irq_delay(LDMA_IRQn, TEST_LDMA_LATE);
+  test_long_read();
+  host_irq_delay(LDMA_IRQn, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A read that takes longer on the bus than I2C_TIMEOUT_MS gets a deadline
+ * to match, so it goes through on the first try.
+ *
+ ******************************************************************************/
+static void test_slow_read(void){
+  static const uint8_t reg = 0;
+  uint64_t start;
+
+  test_i2c_open_at(I2C_FREQ_STANDARD_MAX, true);
+  start = host_now();
+  CHECK(i2c_transfer(I2C1, TEST_ADDRESS, &reg, 1, test_slow_rx, TEST_SLOW_READ, TEST_EVT(0)));
+  CHECK(host_test_wait(test_first_done, TEST_FAULT_WAIT));
+  CHECK(test_first_done_at - start > HOST_MS(I2C_TIMEOUT_MS));
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  CHECK(!memcmp(test_slow_rx, test_slave.regs, TEST_SLOW_READ));
+  CHECK_EQ(test_slave.log_count, 2);
+  CHECK_EQ(test_slave.log[1].length, TEST_SLOW_READ);
+  CHECK_EQ(test_errors, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues the whole script with fault armed for the first transfer, and
+ * checks the driver gets every transfer through anyway, in order, each done
+ * once and with no error event. The first is done no sooner than its first
+ * back off, so it was retried.
+ *
+ ******************************************************************************/
+static void test_fault_recovers(HOST_I2C_FAULT fault, uint32_t count){
+  uint64_t start;
+
+  test_i2c_open(false);
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      test_script(n, TEST_READ_LEN);
+  }
+  host_i2c_fault(I2C1, fault, count);
+  start = host_now();
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      CHECK(test_queue(n));
+  }
+  CHECK(host_test_wait(test_all_done, TEST_FAULT_WAIT));
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  for(uint32_t n = 0; n < TEST_TRANSFERS; n++){
+      TEST_TRANSFER *transfer = &test_transfers[n];
+      CHECK_EQ(test_done_count[n], 1);
+      CHECK_EQ(test_done_order[n], n);
+      if(!transfer->rx_len){
+          CHECK_EQ(test_slave.regs[transfer->tx[0]], transfer->tx[1]);
+          CHECK_EQ(test_slave.regs[transfer->tx[0] + 1], transfer->tx[2]);
+      }
+  }
+  CHECK(test_first_done_at - start >= HOST_MS(I2C_BACKOFF_MS));
+  CHECK_EQ(test_errors, 0);
+  CHECK_EQ(i2c_last_error(I2C1), I2C_ERR_NONE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Arms fault for every try of a write, I2C_RETRIES + 1 of them, and checks
+ * the write is dropped after the back offs with error_evt posted once and
+ * not its done event. A read queued behind it still goes through.
+ *
+ ******************************************************************************/
+static void test_fault_gives_up(HOST_I2C_FAULT fault, I2C_ERROR error){
+  uint64_t start;
+
+  test_i2c_open(false);
+  test_script(0, 0);
+  test_script(1, TEST_READ_LEN);
+  host_i2c_fault(I2C1, fault, I2C_RETRIES + 1);
+  start = host_now();
+  CHECK(test_queue(0));
+  CHECK(test_queue(1));
+  CHECK(host_test_wait(test_first_done, TEST_FAULT_WAIT));
+  CHECK(host_now() - start >= HOST_MS(TEST_BACKOFFS_MS));
+  CHECK(host_test_wait(test_bus_idle, TEST_WAIT));
+  CHECK_EQ(test_errors, 1);
+  CHECK_EQ(test_done_count[0], 0);
+  CHECK_EQ(test_done_count[1], 1);
+  CHECK_EQ(i2c_last_error(I2C1), error);
+  CHECK(test_slave.regs[test_transfers[0].tx[0]] != test_transfers[0].tx[1]);
+}
+
+static void test_nack_addr(void){
+  test_fault_recovers(HOST_I2C_NACK_ADDR, 2);
+}
+
+static void test_nack_data(void){
+  test_fault_recovers(HOST_I2C_NACK_DATA, 2);
+}
+
+static void test_arblost(void){
+  test_fault_recovers(HOST_I2C_ARBLOST, 1);
+}
+
+static void test_buserr(void){
+  test_fault_recovers(HOST_I2C_BUSERR, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A slave holding SDA low keeps the START from going out until the transfer
+ * times out, and the SCL recovery before the retry frees it.
+ *
+ ******************************************************************************/
+static void test_sda_stuck(void){
+  test_fault_recovers(HOST_I2C_SDA_STUCK, TEST_SDA_CLOCKS);
+  CHECK(GPIO_PinInGet(SI1133_SDA_PORT, SI1133_SDA_PIN));
+}
+
+static void test_scl_stuck(void){
+  test_fault_recovers(HOST_I2C_SCL_STUCK, 1);
+}
+
+static void test_lost_ack(void){
+  test_fault_recovers(HOST_I2C_LOST_ACK, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * A slave that never answers its address, one stretching SCL on every try,
+ * and a bus that drops the ACK of every try, each reported as its error.
+ *
+ ******************************************************************************/
+static void test_nack_gives_up(void){
+  test_fault_gives_up(HOST_I2C_NACK_ADDR, I2C_ERR_NACK);
+}
+
+static void test_scl_gives_up(void){
+  test_fault_gives_up(HOST_I2C_SCL_STUCK, I2C_ERR_TIMEOUT);
+}
+
+static void test_lost_ack_gives_up(void){
+  test_fault_gives_up(HOST_I2C_LOST_ACK, I2C_ERR_BUSHOLD);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("i2c_queue_order", test_queue_order);
+  host_test_case("i2c_queue_refill", test_queue_refill);
+  host_test_case("i2c_rx_irq", test_rx_irq);
+  host_test_case("i2c_rx_dma", test_rx_dma);
+  host_test_case("i2c_rx_dma_late", test_rx_dma_late);
+  host_test_case("i2c_slow_read", test_slow_read);
+  host_test_case("i2c_fault_nack_addr", test_nack_addr);
+  host_test_case("i2c_fault_nack_data", test_nack_data);
+  host_test_case("i2c_fault_arblost", test_arblost);
+  host_test_case("i2c_fault_buserr", test_buserr);
+  host_test_case("i2c_fault_sda_stuck", test_sda_stuck);
+  host_test_case("i2c_fault_scl_stuck", test_scl_stuck);
+  host_test_case("i2c_fault_lost_ack", test_lost_ack);
+  host_test_case("i2c_fault_nack_gives_up", test_nack_gives_up);
+  host_test_case("i2c_fault_scl_gives_up", test_scl_gives_up);
+  host_test_case("i2c_fault_lost_ack_gives_up", test_lost_ack_gives_up);
+  return host_test_result();
+}
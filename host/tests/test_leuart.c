@@ -0,0 +1,208 @@
+/**
+ * @file
+ * test_leuart.c
+ * @author
+ * agent
+ * @date
+ * 10/17/26
+ * @brief
+ * Host tests of the LEUART transmit path
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_MESSAGES       8
+#define TEST_MESSAGE_LEN    32
+#define TEST_LINE_SIZE      4096
+#define TEST_DMA_IRQS       2           // TXC, and a TXBL the LDMA leaves set at most
+#define TEST_STRESS_BYTES   (TEST_LINE_SIZE - 128)
+#define TEST_STRESS_MAX_MSG 100
+#define TEST_STRESS_SLICE   HOST_US(700)  // under a byte time at 9600, so calls land mid byte
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint8_t test_line[TEST_LINE_SIZE];
+static uint32_t test_line_len;
+static uint32_t test_expect_len;
+static uint32_t test_random = 1;
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * The other end of the line, keeps what the board sent.
+ *
+ ******************************************************************************/
+static void test_peer(uint8_t byte, uint32_t baudrate){
+  (void)baudrate;
+  if(test_line_len < TEST_LINE_SIZE){
+      test_line[test_line_len] = byte;
+  }
+  test_line_len++;
+}
+
+static bool test_tx_done(void){
+  return (test_line_len >= test_expect_len) && !leuart_tx_busy(LEUART0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Pseudo random numbers, the same every run.
+ *
+ ******************************************************************************/
+static uint32_t test_rand(void){
+  test_random = test_random*1103515245u + 12345u;
+  return test_random >> 16;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Opens LEUART0 the way ble_open does, with the receiver off and the
+ * transmit path picked by tx_dma.
+ *
+ ******************************************************************************/
+static void test_leuart_open(bool tx_dma){
+  LEUART_OPEN_STRUCT open;
+
+  memset(&open, 0, sizeof(open));
+  open.baudrate = HM10_BAUDRATE;
+  open.databits = HM10_DATABITS;
+  open.enable = HM10_ENABLE;
+  open.parity = HM10_PARITY;
+  open.refFreq = HM10_REFFREQ;
+  open.stopbits = HM10_STOPBITS;
+  open.tx_en = true;
+  open.tx_loc = LEUART_TX_ROUTE_LOC;
+  open.tx_pin_en = true;
+  open.tx_dma_en = tx_dma;
+
+  host_test_board();
+  host_leuart_peer(test_peer);
+  leuart_open(LEUART0, &open);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends TEST_MESSAGES messages one after the other and checks they all went
+ * out as they were.
+ *
+ * @return
+ * LEUART0 interrupt entries per message.
+ *
+ ******************************************************************************/
+static uint32_t test_leuart_messages(void){
+  char message[TEST_MESSAGE_LEN];
+  uint32_t irqs;
+
+  host_stats_reset();
+  for(uint32_t n = 0; n < TEST_MESSAGES; n++){
+      for(uint32_t i = 0; i < TEST_MESSAGE_LEN; i++){
+          message[i] = (char)('A' + (n + i) % 26);
+      }
+      test_expect_len += TEST_MESSAGE_LEN;
+      CHECK(leuart_start(LEUART0, message, TEST_MESSAGE_LEN));
+      CHECK(host_test_wait(test_tx_done, HOST_MS(100)));
+      CHECK_EQ(test_line_len, test_expect_len);
+      CHECK(!memcmp(&test_line[n*TEST_MESSAGE_LEN], message, TEST_MESSAGE_LEN));
+  }
+  irqs = host_irq_count(LEUART0_IRQn)/TEST_MESSAGES;
+  printf("  %u LEUART0 interrupts per %u byte message\n", (unsigned)irqs, TEST_MESSAGE_LEN);
+  return irqs;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Without the LDMA every byte is written by the TXBL handler.
+ *
+ ******************************************************************************/
+static void test_tx_irq(void){
+  test_leuart_open(false);
+  CHECK(test_leuart_messages() >= TEST_MESSAGE_LEN);
+  CHECK_EQ(host_ldma_units(), 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * With the LDMA feeding TXDATA only the end of a message interrupts the
+ * core, and the LDMA itself does not.
+ *
+ ******************************************************************************/
+static void test_tx_dma(void){
+  test_leuart_open(true);
+  CHECK(test_leuart_messages() <= TEST_DMA_IRQS);
+  CHECK_EQ(host_irq_count(LDMA_IRQn), 0);
+  CHECK_EQ(host_ldma_units(), TEST_MESSAGES*TEST_MESSAGE_LEN);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes messages of random length as fast as the ring takes them, with the
+ * transmit interrupts running for a random part of a byte time between two
+ * calls. A call the ring cannot take must say so and leave the ring as it
+ * was, and what reaches the line must be every byte in the order written.
+ *
+ ******************************************************************************/
+static void test_tx_stress(bool tx_dma){
+  static char stream[TEST_STRESS_BYTES];
+  uint32_t written = 0;
+  uint32_t refused = 0;
+
+  for(uint32_t i = 0; i < TEST_STRESS_BYTES; i++){
+      stream[i] = (char)(i % 251);
+  }
+  test_leuart_open(tx_dma);
+  while(written < TEST_STRESS_BYTES){
+      uint32_t len = 1 + test_rand() % TEST_STRESS_MAX_MSG;
+      if(len > TEST_STRESS_BYTES - written){
+          len = TEST_STRESS_BYTES - written;
+      }
+      if(leuart_start(LEUART0, &stream[written], len)){
+          written += len;
+      }
+      else{
+          refused++;
+      }
+      host_run(host_test_loop, 1 + test_rand() % TEST_STRESS_SLICE);
+  }
+  test_expect_len = TEST_STRESS_BYTES;
+  CHECK(host_test_wait(test_tx_done, HOST_MS(500)));      // a full ring is 270 ms at 9600
+  CHECK_EQ(test_line_len, TEST_STRESS_BYTES);
+  CHECK(!memcmp(test_line, stream, TEST_STRESS_BYTES));
+  CHECK(refused > 0);
+  printf("  %u bytes, %u writes refused while the ring was full\n", (unsigned)TEST_STRESS_BYTES, (unsigned)refused);
+}
+
+static void test_tx_stress_irq(void){
+  test_tx_stress(false);
+}
+
+static void test_tx_stress_dma(void){
+  test_tx_stress(true);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("leuart_tx_irq", test_tx_irq);
+  host_test_case("leuart_tx_dma", test_tx_dma);
+  host_test_case("leuart_tx_stress_irq", test_tx_stress_irq);
+  host_test_case("leuart_tx_stress_dma", test_tx_stress_dma);
+  return host_test_result();
+}
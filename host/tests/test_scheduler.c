@@ -0,0 +1,241 @@
+/**
+ * @file
+ * test_scheduler.c
+ * @author
+ * agent
+ * @date
+ * 10/17/26
+ * @brief
+ * Host tests of the scheduler dispatch table, against the if-chain main.c
+ * had before it
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define TEST_EVENTS         SCHEDULER_MAX_EVENTS
+#define TEST_ROUNDS         2000
+#define TEST_PRIORITY(bit)  (((bit)*7 + 3) % TEST_EVENTS)   // a mix, so bit order is not priority order
+
+#define TEST_HANDLER(n)     static void test_handler_##n(void){ test_ran(n); }
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t test_order[TEST_EVENTS];        // bits in the order they ran
+static uint32_t test_runs;
+static uint32_t test_posted[TEST_EVENTS];       // host_cycles at the post
+static uint64_t test_latency[TEST_EVENTS];      // summed over the rounds
+static uint32_t test_by_priority[TEST_EVENTS];  // bit of each priority, the order of the chain
+
+static void test_ran(uint32_t bit);
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+TEST_HANDLER(0)  TEST_HANDLER(1)  TEST_HANDLER(2)  TEST_HANDLER(3)
+TEST_HANDLER(4)  TEST_HANDLER(5)  TEST_HANDLER(6)  TEST_HANDLER(7)
+TEST_HANDLER(8)  TEST_HANDLER(9)  TEST_HANDLER(10) TEST_HANDLER(11)
+TEST_HANDLER(12) TEST_HANDLER(13) TEST_HANDLER(14) TEST_HANDLER(15)
+TEST_HANDLER(16) TEST_HANDLER(17) TEST_HANDLER(18) TEST_HANDLER(19)
+TEST_HANDLER(20) TEST_HANDLER(21) TEST_HANDLER(22) TEST_HANDLER(23)
+TEST_HANDLER(24) TEST_HANDLER(25) TEST_HANDLER(26) TEST_HANDLER(27)
+TEST_HANDLER(28) TEST_HANDLER(29) TEST_HANDLER(30) TEST_HANDLER(31)
+
+static const SCHEDULER_HANDLER test_handlers[TEST_EVENTS] = {
+    test_handler_0,  test_handler_1,  test_handler_2,  test_handler_3,
+    test_handler_4,  test_handler_5,  test_handler_6,  test_handler_7,
+    test_handler_8,  test_handler_9,  test_handler_10, test_handler_11,
+    test_handler_12, test_handler_13, test_handler_14, test_handler_15,
+    test_handler_16, test_handler_17, test_handler_18, test_handler_19,
+    test_handler_20, test_handler_21, test_handler_22, test_handler_23,
+    test_handler_24, test_handler_25, test_handler_26, test_handler_27,
+    test_handler_28, test_handler_29, test_handler_30, test_handler_31
+};
+
+/***************************************************************************//**
+ * @brief
+ * Every handler, notes the order and the time since the post.
+ *
+ ******************************************************************************/
+static void test_ran(uint32_t bit){
+  test_latency[bit] += (uint32_t)(host_cycles() - test_posted[bit]);
+  if(test_runs < TEST_EVENTS){
+      test_order[test_runs] = bit;
+  }
+  test_runs++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Registers all 32 events with the priorities of TEST_PRIORITY.
+ *
+ ******************************************************************************/
+static void test_register(void){
+  scheduler_open();
+  for(uint32_t bit = 0; bit < TEST_EVENTS; bit++){
+      scheduler_register(1u << bit, test_handlers[bit], TEST_PRIORITY(bit));
+      test_by_priority[TEST_PRIORITY(bit)] = bit;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Posts the events in mask, lowest bit first.
+ *
+ ******************************************************************************/
+static void test_post(uint32_t mask){
+  for(uint32_t bit = 0; bit < TEST_EVENTS; bit++){
+      if(mask & (1u << bit)){
+          test_posted[bit] = host_cycles();
+          add_scheduled_event(1u << bit);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The main loop with the dispatch table, one handler a pass.
+ *
+ ******************************************************************************/
+static void test_table_loop(void){
+  while(scheduler_dispatch());
+}
+
+/***************************************************************************//**
+ * @brief
+ * The main loop as it was, an if per event in priority order, each reading
+ * the pending events, removing its own and calling its handler.
+ *
+ ******************************************************************************/
+static void test_chain_loop(void){
+  while(get_scheduled_events()){
+      for(uint32_t priority = 0; priority < TEST_EVENTS; priority++){
+          uint32_t event = 1u << test_by_priority[priority];
+          if(event & get_scheduled_events()){
+              remove_scheduled_event(event);
+              test_handlers[test_by_priority[priority]]();
+          }
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Mean post to dispatch time of the events in mask over TEST_ROUNDS posts.
+ *
+ * @return
+ * ns, the host_cycles unit.
+ *
+ ******************************************************************************/
+static double test_latency_of(void (*loop)(void), uint32_t mask){
+  uint64_t sum = 0;
+  uint32_t events = 0;
+
+  memset(test_latency, 0, sizeof(test_latency));
+  test_runs = 0;
+  for(uint32_t round = 0; round < TEST_ROUNDS; round++){
+      test_post(mask);
+      loop();
+  }
+  for(uint32_t bit = 0; bit < TEST_EVENTS; bit++){
+      if(mask & (1u << bit)){
+          sum += test_latency[bit];
+          events++;
+      }
+  }
+  CHECK_EQ(test_runs, events*TEST_ROUNDS);
+  return (double)sum/(double)(events*TEST_ROUNDS);
+}
+
+/***************************************************************************//**
+ * @brief
+ * With all 32 pending, each runs once and in priority order, and the stats
+ * see every post and run.
+ *
+ ******************************************************************************/
+static void test_order_all(void){
+  SCHEDULER_EVENT_STATS stats;
+
+  test_register();
+  test_post(0xFFFFFFFF);
+  CHECK_EQ(get_scheduled_events(), 0xFFFFFFFF);
+  test_table_loop();
+  CHECK_EQ(test_runs, TEST_EVENTS);
+  CHECK_EQ(get_scheduled_events(), 0);
+  for(uint32_t priority = 0; priority < TEST_EVENTS; priority++){
+      CHECK_EQ(test_order[priority], test_by_priority[priority]);
+  }
+  for(uint32_t bit = 0; bit < TEST_EVENTS; bit++){
+      scheduler_stats_get(1u << bit, &stats);
+      CHECK_EQ(stats.posts, 1);
+      CHECK_EQ(stats.runs, 1);
+      CHECK_EQ(stats.overruns, 0);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * A higher priority event posted between two dispatches runs before the
+ * lower ones still pending, which the chain only did on its next pass.
+ *
+ ******************************************************************************/
+static void test_order_repost(void){
+  test_register();
+  test_post(1u << test_by_priority[5] | 1u << test_by_priority[9]);
+  CHECK(scheduler_dispatch());
+  CHECK_EQ(test_order[0], test_by_priority[5]);
+  test_post(1u << test_by_priority[2]);
+  test_table_loop();
+  CHECK_EQ(test_runs, 3);
+  CHECK_EQ(test_order[1], test_by_priority[2]);
+  CHECK_EQ(test_order[2], test_by_priority[9]);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Post to dispatch time with the table and with the chain, for all 32
+ * events pending at once and for the lowest priority one alone, which the
+ * chain reaches last. Host ns, so only the ratio means much, and the table
+ * side also pays for SCHEDULER_STATS, a host clock read at each post and two
+ * at each dispatch, which the chain never had.
+ *
+ ******************************************************************************/
+static void test_latency_32(void){
+  uint32_t lowest = 1u << test_by_priority[TEST_EVENTS - 1];
+  double table_all;
+  double chain_all;
+  double table_one;
+  double chain_one;
+
+  test_register();
+  table_all = test_latency_of(test_table_loop, 0xFFFFFFFF);
+  chain_all = test_latency_of(test_chain_loop, 0xFFFFFFFF);
+  table_one = test_latency_of(test_table_loop, lowest);
+  chain_one = test_latency_of(test_chain_loop, lowest);
+  printf("  32 pending, mean:      table %6.1f ns, if-chain %6.1f ns\n", table_all, chain_all);
+  printf("  lowest priority alone: table %6.1f ns, if-chain %6.1f ns\n", table_one, chain_one);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+int main(void){
+  host_test_case("scheduler_order_all", test_order_all);
+  host_test_case("scheduler_order_repost", test_order_repost);
+  host_test_case("scheduler_latency_32", test_latency_32);
+  return host_test_result();
+}
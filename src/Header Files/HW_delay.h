@@ -8,9 +8,9 @@
 #ifndef SRC_HW_DELAY_H_
 #define SRC_HW_DELAY_H_
 
-#include "em_timer.h"
-#include "em_cmu.h"
+#include "sw_timer.h"
 
 void timer_delay(uint32_t ms_delay);
+void timer_delay_async(SW_TIMER *timer, uint32_t ms_delay, uint32_t event);
 
 #endif /* SRC_HW_DELAY_H_ */
@@ -5,17 +5,17 @@
 #define APP_HG
 
 /* System include statements */
-
+#include <string.h>
 
 /* Silicon Labs include statements */
 #include "em_cmu.h"
 #include "em_assert.h"
-#include <stdio.h>
 
 /* The developer's include statements */
 #include "cmu.h"
+#include "ldma.h"
 #include "gpio.h"
-#include "letimer.h"
+#include "sw_timer.h"
 #include "brd_config.h"
 #include "scheduler.h"
 #include "sleep_routines.h"
@@ -23,13 +23,16 @@
 #include "si1133.h"
 #include "ble.h"
 #include "HW_Delay.h"
+#include "format.h"
+#include "profile.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-#define   PWM_PER         1.0   // PWM period in seconds
-#define   PWM_ACT_PER     .002  // PWM active period in seconds
+// The sample and report rates are independent
+#define   APP_SAMPLE_PER_MS     1000  // Si1133 autonomous measurement period
+#define   APP_REPORT_PER_MS     1000  // z report period, software timer
 
 #define EXPECTED_VALUE    20
 
@@ -38,15 +41,92 @@
 
 #define SYSTEM_BLOCK_EM EM3
 
+// BLE_FORMAT_TEXT sends readable messages, BLE_FORMAT_BINARY sends the compact
+// frames below, decoded on the host by tools/ble_decode.py
+#define   APP_BLE_FORMAT        BLE_FORMAT_TEXT
+
+// Link rate set with ble_set_baud at boot. Above LEUART_LFXO_MAX_BAUD the
+// LEUART runs from HFCLKLE and the board stays out of EM2.
+#define   APP_BLE_BAUDRATE      HM10_BAUDRATE
+
+// Binary frame types
+#define   APP_FRAME_BOOT        0x01    //no values
+#define   APP_FRAME_Z           0x02    //z in tenths
+#define   APP_FRAME_LIGHT       0x03    //min, max, mean, UVI milli, lux, then the raw Si1133 readings
+#define   APP_FRAME_ERROR       0x04    //I2C_ERROR of a failed Si1133 transfer
+#define   APP_FRAME_SLEEP       0x05    //elapsed, EM0 to EM3 residency, then the held time of each SLEEP_TAG, all ms
+#define   APP_FRAME_PROFILE     0x06    //PROFILE_REGION, count, min, max, mean, in cycles, one frame a region
+
+// Commands received over BLE, whole frames
+#define   APP_CMD_STATS         "#STATS!"     //reply with the sleep stats
+#define   APP_STATS_MSG_SIZE    256           //both lines with every total at 10 digits
+#define   APP_CMD_PROFILE       "#PROF!"      //reply with the profile of every region
+#define   APP_PROFILE_MSG_SIZE  64            //one region a line
+
+// Si1133 channel table, the white channel drives the LED and the batch, UV
+// and IR give the UV index and lux of the latest reading
+#define   APP_CHAN_WHITE        0
+#define   APP_CHAN_UV           1
+#define   APP_CHAN_IR           2
+#define   APP_CHANNELS          3
+
+// Si1133 readings are sent in batches of APP_BATCH_SAMPLES, or whatever has
+// been collected once the oldest reading is APP_BATCH_DEADLINE_MS old
+#define   APP_BATCH_SAMPLES     8
+#define   APP_BATCH_DEADLINE_MS 10000
+#define   APP_BATCH_HEADER      5     //min, max, mean, UVI, lux
+#define   APP_BATCH_MSG_SIZE    (80 + APP_BATCH_SAMPLES*11)     //header plus 10 digits and a space a reading
+#if (APP_BATCH_SAMPLES + APP_BATCH_HEADER) > BLE_FRAME_MAX_VALUES
+#error "APP_BATCH_SAMPLES does not fit in one binary frame"
+#endif
+
 
 
 // Application scheduled events
-#define   LETIMER0_COMP0_CB     0x00000001   //0b000001
-#define   LETIMER0_COMP1_CB     0x00000002   //0b000010
-#define   LETIMER0_UF_CB        0x00000004   //0b000100
+#define   SW_TIMER_CB           0x00000001   //0b000001
+#define   SI1133_RESULT_CB      0x00000002   //0b000010
+#define   SI1133_READY_CB       0x00000004   //0b000100
 #define   SI1133_REG_READ_CB    0x00000008   //0b001000
 #define   BOOT_UP_CB            0x00000010   //0b010000
 #define   BLE_TX_DONE_CB        0x00000020   //0b100000
+#define   BLE_RX_DONE_CB        0x00000040   //0b1000000
+#define   SI1133_TX_DONE_CB     0x00000080   //0b10000000
+#define   REPORT_TIMER_CB       0x00000100   //0b100000000
+#define   BATCH_TIMER_CB        0x00000200   //0b1000000000
+#define   I2C1_SUPERVISE_CB     0x00000400   //0b10000000000
+#define   SI1133_ERROR_CB       0x00000800   //0b100000000000
+#define   SI1133_CONFIG_CB      0x00001000   //0b1000000000000, queued, RESPONSE0 payload
+#define   SI1133_I2C_ERROR_CB   0x00002000   //0b10000000000000
+#define   PROFILE_TX_DONE_CB    0x00004000   //0b100000000000000
+#define   BLE_AT_CB             0x00008000   //0b1000000000000000, queued, BLE_AT_RESULT payload
+#define   BLE_AT_TIMEOUT_CB     0x00010000   //0b10000000000000000
+#define   BLE_BAUD_DONE_CB      0x00020000   //0b100000000000000000
+#define   BLE_TEST_DONE_CB      0x00040000   //0b1000000000000000000, queued, BLE_AT_RESULT payload
+#define   BLE_LINK_CB           0x00080000   //0b10000000000000000000
+
+// Dispatch priority of each event, 0 runs first
+#define   SW_TIMER_PRIO         0
+#define   SI1133_RESULT_PRIO    1
+#define   SI1133_READY_PRIO     2
+#define   SI1133_REG_READ_PRIO  3
+#define   BOOT_UP_PRIO          4
+#define   BLE_TX_DONE_PRIO      5
+#define   BLE_RX_DONE_PRIO      6
+#define   SI1133_TX_DONE_PRIO   7
+#define   REPORT_TIMER_PRIO     8
+#define   BATCH_TIMER_PRIO      9
+#define   I2C1_SUPERVISE_PRIO   10
+#define   SI1133_ERROR_PRIO     11
+#define   SI1133_I2C_ERROR_PRIO 12    //must run before SI1133_CONFIG_CB
+#define   SI1133_CONFIG_PRIO    13
+#define   PROFILE_TX_DONE_PRIO  14
+#define   BLE_AT_PRIO           15
+#define   BLE_AT_TIMEOUT_PRIO   16
+#define   BLE_BAUD_DONE_PRIO    17
+#define   BLE_TEST_DONE_PRIO    18
+#define   BLE_LINK_PRIO         19
+
+#define   APP_MSG_SIZE          60
 
 
 //***********************************************************************************
@@ -58,12 +138,21 @@
 // function prototypes
 //***********************************************************************************
 void app_peripheral_setup(void);
-void scheduled_letimer0_uf_cb(void);
-void scheduled_letimer0_comp0_cb(void);
-void scheduled_letimer0_comp1_cb(void);
+void scheduled_si1133_result_cb(void);
+void scheduled_si1133_ready_cb(void);
+void scheduled_report_timer_cb(void);
+void scheduled_batch_timer_cb(void);
 void scheduled_boot_up_cb(void);
 void scheduled_si1133_read_cb(void);
 void scheduled_ble_tx_done_cb(void);
+void scheduled_ble_rx_done_cb(void);
+void scheduled_si1133_tx_done_cb(void);
+void scheduled_si1133_error_cb(void);
+#if PROFILE_ENABLED
+void scheduled_profile_tx_done_cb(void);
+#endif
+void scheduled_ble_baud_done_cb(void);
+void scheduled_ble_test_done_cb(uint32_t result);
 void led_color_open(void);
 
 #endif
@@ -19,23 +19,174 @@
 #include "gpio.h"
 #include "brd_config.h"
 #include "HW_delay.h"
+#include "scheduler.h"
+#include "sw_timer.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define BLE_TX_DMA    true    // LDMA feeds the LEUART, one interrupt per message
+
+// Frames from the phone look like "#command!". Bytes before the start frame
+// go to the AT and notification matching in ble.c, and the signal frame ends
+// the frame.
+#define BLE_RX_STARTFRAME   '#'
+#define BLE_RX_SIGFRAME     '!'
+#define BLE_RX_MAX_FRAME    32
+
+// Binary telemetry frames: BLE_FRAME_SYNC, type, sequence, payload length,
+// payload of zigzag varints, then a CRC-8 (poly 0x07) over everything after
+// the sync byte. Decoded on the host by tools/ble_decode.py.
+#define BLE_FRAME_SYNC        0xA5
+#define BLE_FRAME_CRC_POLY    0x07
+#define BLE_FRAME_MAX_VALUES  16
+#define BLE_VARINT_MAX        5       // bytes in the varint of a 32 bit value
+#define BLE_FRAME_HEADER      4
+#define BLE_FRAME_MAX         (BLE_FRAME_HEADER + BLE_FRAME_MAX_VALUES*BLE_VARINT_MAX + 1)
+
+// AT commands, the HM-18 only answers them while no central is connected.
+// Commands have no line ending, the module takes a quiet line as the end.
+#define BLE_AT_TIMEOUT_MS     500     // default wait for a reply
+#define BLE_AT_RESET_MS       1000    // restart time after OK+RESET
+#define BLE_AT_GAP_MS         50      // quiet line before each command
+#define BLE_AT_MAX_CMD        24
+#define BLE_AT_MAX_REPLY      24
+#define BLE_AT_MAX_NAME       12
+#define BLE_TEST_COMMANDS     4       // results ble_test posts
+
+// Notifications the module sends on its own once AT+NOTI1 is set
+#define BLE_NOTI_CONN         "OK+CONN"
+#define BLE_NOTI_LOST         "OK+LOST"
+
+// Messages written while no central is connected are kept in a backlog of
+// BLE_BACKLOG_SIZE bytes, oldest dropped first, and sent on reconnect. Must
+// be a power of two.
+#ifndef BLE_BACKLOG_SIZE
+#define BLE_BACKLOG_SIZE      512
+#endif
+#define BLE_BACKLOG_MASK      (BLE_BACKLOG_SIZE - 1)
+#if (BLE_BACKLOG_SIZE & BLE_BACKLOG_MASK) != 0
+#error "BLE_BACKLOG_SIZE must be a power of two"
+#endif
+#define BLE_BACKLOG_LEN       2       // length in front of each message
+#define BLE_BACKLOG_MAX_MSG   LEUART_TX_BUFFER_SIZE
+#define BLE_BACKLOG_RETRY_MS  20      // wait for room in the transmit ring
+
+// Commands waiting for the module, must be a power of two.
+#ifndef BLE_AT_QUEUE_SIZE
+#define BLE_AT_QUEUE_SIZE     8
+#endif
+#define BLE_AT_QUEUE_MASK     (BLE_AT_QUEUE_SIZE - 1)
+#if (BLE_AT_QUEUE_SIZE & BLE_AT_QUEUE_MASK) != 0
+#error "BLE_AT_QUEUE_SIZE must be a power of two"
+#endif
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+typedef enum{
+  BLE_FORMAT_TEXT,        //ble_write strings as they are
+  BLE_FORMAT_BINARY       //ble_write_frame compact frames
+}BLE_FORMAT;
+
+// Payload of the done event of an AT command, and of at_evt
+typedef enum{
+  BLE_AT_TIMEOUT,         //no reply, or the command could not be sent
+  BLE_AT_OK               //the expected reply came in
+}BLE_AT_RESULT;
+
+// Takes the result of a command queued by ble.c itself
+typedef void (*BLE_AT_HANDLER)(BLE_AT_RESULT result);
+
+// ble_set_baud steps
+typedef enum{
+  ble_baud_idle,
+  ble_baud_set,           //AT+BAUD sent, waiting for OK+Set:
+  ble_baud_reset,         //AT+RESET sent, the module may restart even if no reply comes
+  ble_baud_verify,        //LEUART at the new rate, AT sent once the module is back
+  ble_baud_revert_set,    //AT+BAUD with the old rate sent at the new rate
+  ble_baud_revert_reset,  //AT+RESET sent at the new rate
+  ble_baud_revert_verify, //LEUART back at the old rate, AT sent once the module is back
+  ble_baud_restore        //no reply at the new rate, AT+BAUD with the old rate sent at the old rate
+}BLE_BAUD_STATE;
+
+typedef enum{
+  ble_at_idle,
+  ble_at_delay,           //timer running until the command is sent
+  ble_at_wait             //command sent, timer running until the reply is late
+}BLE_AT_STATE;
+
+typedef struct{
+  char              cmd[BLE_AT_MAX_CMD];
+  char              expect[BLE_AT_MAX_REPLY];     //the reply or the start of it
+  uint32_t          delay_ms;                     //quiet line before cmd, at least BLE_AT_GAP_MS
+  uint32_t          timeout_ms;
+  uint32_t          done_evt;                     //posted with the BLE_AT_RESULT
+  BLE_AT_HANDLER    handler;                      //gets the result instead, NULL for done_evt
+  uint32_t          baudrate;                     //LEUART0 rate cmd goes out at, 0 for the one it has
+}BLE_AT_COMMAND;
+
+typedef struct{
+  BLE_AT_COMMAND    queue[BLE_AT_QUEUE_SIZE];
+  uint32_t          head;               //Free running, only moved by ble_at_push
+  uint32_t          tail;               //Free running, the command being run, only moved by ble_at_complete
+  BLE_AT_STATE      state;
+  uint32_t          matched;            //bytes of expect seen so far
+  volatile bool     waiting;            //cleared by the reply or the timeout, whichever is first
+  uint32_t          at_evt;
+  uint32_t          at_timeout_evt;
+  SW_TIMER          timer;
+}BLE_AT_STATE_MACHINE;
+
+typedef struct{
+  BLE_BAUD_STATE    state;
+  uint32_t          old_rate;
+  uint32_t          new_rate;
+  uint32_t          done_evt;
+  bool              failed;             //the module stopped answering, at either rate
+}BLE_BAUD_STATE_MACHINE;
+
+typedef struct{
+  uint8_t           backlog[BLE_BACKLOG_SIZE];
+  uint32_t          head;               //Free running, only moved by ble_backlog_put
+  uint32_t          tail;               //Free running, only moved by ble_backlog_put and ble_backlog_flush
+  uint32_t          dropped;            //messages dropped to make room
+  volatile bool     connected;          //only moved by the LEUART interrupt after ble_open
+  uint32_t          conn_matched;       //bytes of BLE_NOTI_CONN seen, LEUART interrupt only
+  uint32_t          lost_matched;       //bytes of BLE_NOTI_LOST seen, LEUART interrupt only
+  uint32_t          link_evt;
+  SW_TIMER          timer;
+}BLE_LINK_STATE_MACHINE;
+
+typedef struct{
+  uint32_t    tx_evt;
+  uint32_t    rx_evt;
+  BLE_FORMAT  format;
+  uint32_t    at_evt;             //queued, BLE_AT_RESULT payload, handled in ble.c
+  uint32_t    at_prio;
+  uint32_t    at_timeout_evt;     //handled in ble.c
+  uint32_t    at_timeout_prio;
+  uint32_t    link_evt;           //handled in ble.c
+  uint32_t    link_prio;
+}BLE_OPEN_STRUCT;
 
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-void ble_open(uint32_t tx_event, uint32_t rx_event);
-void ble_write(char *string);
+void ble_open(BLE_OPEN_STRUCT *ble_settings);
+BLE_FORMAT ble_get_format(void);
+bool ble_write(char *string);
+bool ble_write_owned(const uint8_t *data, uint32_t len, uint32_t release_evt);
+bool ble_write_frame(uint8_t type, const int32_t *values, uint32_t count);
+uint32_t ble_read(char *string, uint32_t max_len);
+bool ble_at_queue(const char *cmd, const char *expect, uint32_t timeout_ms, uint32_t done_evt);
+bool ble_set_baud(uint32_t baudrate, uint32_t done_evt);
+uint32_t ble_get_baud(void);
+bool ble_baud_failed(void);
+bool ble_connected(void);
 
-bool ble_test(char *mod_name);
+bool ble_test(char *mod_name, uint32_t done_evt);
 
 #endif
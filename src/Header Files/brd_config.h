@@ -98,6 +98,8 @@
 #define SI1133_SDA_PIN 4
 #define SI1133_SENSOR_EN_PORT gpioPortF
 #define SI1133_SENSOR_EN_PIN 9
+#define SI1133_INT_PORT gpioPortF     //open drain, low while a result is waiting
+#define SI1133_INT_PIN 11
 
 //HM10 Stuff
 #define HM10_LEUART0 LEUART0
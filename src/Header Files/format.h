@@ -0,0 +1,51 @@
+/*
+ * format.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef FORMAT_HG
+#define FORMAT_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define FORMAT_MAX_DECIMALS     9     // 10^9 is the largest power of ten in 32 bits
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct{
+  char          *buf;         //Caller's storage
+  uint32_t      size;         //Size of buf in bytes, including the null terminator
+  uint32_t      len;          //Characters written so far, not counting the null
+  bool          overflow;     //Set once something did not fit
+}FORMAT_BUFFER;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void format_open(FORMAT_BUFFER *fmt, char *buf, uint32_t size);
+void format_char(FORMAT_BUFFER *fmt, char c);
+void format_string(FORMAT_BUFFER *fmt, const char *string);
+void format_uint(FORMAT_BUFFER *fmt, uint32_t value);
+void format_int(FORMAT_BUFFER *fmt, int32_t value);
+void format_fixed(FORMAT_BUFFER *fmt, int32_t value, uint32_t decimals);
+void format_hex(FORMAT_BUFFER *fmt, uint32_t value, uint32_t digits);
+
+#endif
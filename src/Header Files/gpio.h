@@ -5,7 +5,8 @@
 #define GPIO_HG
 
 /* System include statements */
-
+#include <stdbool.h>
+#include <stdint.h>
 
 /* Silicon Labs include statements */
 #include "em_cmu.h"
@@ -14,10 +15,15 @@
 
 /* The developer's include statements */
 #include "brd_config.h"
+#include "scheduler.h"
+#include "profile.h"
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define GPIO_INT_COUNT    16      // external interrupt lines, one per pin number
+#define GPIO_EVEN_INTS    0x5555
+#define GPIO_ODD_INTS     0xAAAA
 
 //***********************************************************************************
 // global variables
@@ -28,5 +34,8 @@
 // function prototypes
 //***********************************************************************************
 void gpio_open(void);
+void gpio_int_open(GPIO_Port_TypeDef port, uint32_t pin, bool rising, bool falling, uint32_t event);
+void GPIO_EVEN_IRQHandler(void);
+void GPIO_ODD_IRQHandler(void);
 
 #endif
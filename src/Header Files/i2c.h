@@ -11,16 +11,19 @@
 #define I2C_HG
 
 /* System include statements */
-
+#include <stdint.h>
 
 /* Silicon Labs include statements */
 #include "em_i2c.h"
 #include <stdbool.h>
 #include "em_cmu.h"
+#include "em_gpio.h"
 
 /* The developer's include statements */
 #include "sleep_routines.h"
 #include "scheduler.h"
+#include "ldma.h"
+#include "sw_timer.h"
 
 //***********************************************************************************
 // defined files
@@ -28,6 +31,28 @@
 
 #define I2C_EM_BLOCK EM2 // 2 = first mode it cannot enter
 
+// Transfers waiting on each bus, must be a power of two
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE    8
+#endif
+#define I2C_QUEUE_MASK    (I2C_QUEUE_SIZE - 1)
+#if (I2C_QUEUE_SIZE & I2C_QUEUE_MASK) != 0
+#error "I2C_QUEUE_SIZE must be a power of two"
+#endif
+
+#define I2C_TX_INLINE     8   // tx bytes copied into the queue, longer tx buffers are used in place
+#define I2C_DMA_MIN_RX    3   // shorter reads are not worth setting up the LDMA for
+
+// Fault handling
+#define I2C_TIMEOUT_MS      10  // margin on a transfer's time on the bus, and the whole bus reset
+#define I2C_BYTE_BITS       9   // 8 data bits and the ACK
+#define I2C_FRAME_BITS      3   // START, repeated START and STOP
+#define I2C_SUPERVISE_MS    5   // how often a busy bus is checked for a timeout or a retry
+#define I2C_RETRIES         3   // tries after the first before the error event is posted
+#define I2C_BACKOFF_MS      5   // wait before the first retry, doubled for each one after
+#define I2C_RECOVERY_CLOCKS 9   // SCL pulses to free a slave holding SDA low
+#define I2C_RECOVERY_DELAY  50  // busy loop passes a half SCL period, the slave does not care how slow
+
 
 //***********************************************************************************
 // global variables
@@ -46,31 +71,83 @@ typedef struct {
   bool                  ack_irq_enable;
   bool                  rxdatav_irq_enable;
   bool                  stop_irq_enable;
+  bool                  rx_dma_en;        // LDMA moves all but the last byte of longer reads
 
+  GPIO_Port_TypeDef     scl_port;         // pins are driven by hand to recover a stuck bus
+  uint32_t              scl_pin;
+  GPIO_Port_TypeDef     sda_port;
+  uint32_t              sda_pin;
+  uint32_t              supervise_evt;    // used by the driver for timeouts and retries
+  uint32_t              supervise_prio;
+  uint32_t              error_evt;        // posted when a transfer fails for good, 0 for none
 
 } I2C_OPEN_STRUCT ;
 
 
 typedef enum{
-  initialize_write,
-  communicate_register,
-  initialize_read,
-  write_data,
-  receive_data,
-  verify_stop
+  initialize_write,         //START and address + write sent
+  write_data,               //sending tx bytes
+  initialize_read,          //repeated START and address + read sent
+  receive_data,             //reading rx bytes
+  verify_stop,              //STOP sent, waiting for MSTOP
+  backoff,                  //transfer failed, waiting to retry it
+  bus_reset,                //START and STOP sent by i2c_open, waiting for MSTOP
+  bus_recover               //SCL recovery running from i2c_supervise, interrupts are ignored
 }DEFINED_STATES;
 
+typedef enum{
+  I2C_ERR_NONE,
+  I2C_ERR_NACK,             //device did not ack its address or a tx byte
+  I2C_ERR_ARBLOST,          //lost arbitration, normally SDA held low
+  I2C_ERR_BUSERR,           //misplaced START or STOP on the bus
+  I2C_ERR_BUSHOLD,          //timed out with the bus held, normally SCL held low
+  I2C_ERR_TIMEOUT           //timed out for any other reason, like a dropped byte
+}I2C_ERROR;
+
+
+// One queued transfer: START, address + write, tx bytes, then if there is
+// anything to read a repeated START, address + read, rx bytes, and STOP.
+typedef struct {
+  uint32_t        device_address;
+  const uint8_t   *tx;                      //Points at tx_inline when tx fit in it
+  uint32_t        tx_len;
+  uint8_t         *rx;                      //Points at rx_inline for i2c_start reads
+  uint32_t        rx_len;
+  uint8_t         tx_inline[I2C_TX_INLINE]; //Short writes are copied so the caller can reuse its buffer
+  uint8_t         rx_inline[sizeof(uint32_t)];
+  uint32_t        *packed;                  //i2c_start reads are packed big endian into here
+  uint32_t        call_back;                //Posted when the transfer is done
+} I2C_TRANSFER;
 
 typedef struct {
-  uint32_t        *data;                    //This holds the data that was sent to us
-  uint32_t        bytes_expected;           //This will be used in iterating, tells us how many bytes we expect
   volatile bool   i2c_available;                //Tells whether the pearl gecko is available or not
   DEFINED_STATES  current_state;            //gives the current state of the state machine
-  uint32_t        device_address;           //This is the address of the device we are communicating with
   I2C_TypeDef     *i2cx;                     //Tells us which i2c to use
-  uint32_t        register_address;        //This is the address we wish to talk to
-  bool            mode;                    //0 for write 1 for read
-  uint32_t        i2c_call_back;              //Tells us which interrupts were triggered
+  I2C_TRANSFER    *transfer;               //The transfer on the bus
+  uint32_t        tx_count;                 //tx bytes sent so far
+  uint32_t        rx_count;                 //rx bytes read so far
+  bool            rx_dma;                   //Reads of I2C_DMA_MIN_RX or more go through the LDMA
+  uint32_t        dma_ch;
+  LDMA_TransferCfg_t dma_cfg;
+  LDMA_Descriptor_t  dma_desc[2];           //The bytes, then the write that turns AUTOACK off
+  volatile bool   dma_armed;                //The LDMA has the read, from i2c_rx_arm to i2c_dma_done
+  GPIO_Port_TypeDef scl_port;
+  uint32_t        scl_pin;
+  GPIO_Port_TypeDef sda_port;
+  uint32_t        sda_pin;
+  SW_TIMER        supervise;                //Runs while the bus is busy
+  uint32_t        supervise_evt;
+  uint32_t        error_evt;
+  uint32_t        freq;                     //bus rate, for the transfer timeouts
+  uint32_t        deadline;                 //sw_timer_now value of the timeout, or the end of a back off
+  uint32_t        retries;                  //of the transfer on the bus
+  I2C_ERROR       error;                    //of the try on the bus
+  I2C_ERROR       last_error;               //of the last transfer that failed for good
+  bool            recover;                  //bus needs the SCL recovery before the retry
+  SLEEP_TAG       sleep_tag;                //this bus's block in the sleep stats
+  I2C_TRANSFER    queue[I2C_QUEUE_SIZE];
+  volatile uint32_t queue_head;            //Only moved by i2c_start and i2c_transfer
+  volatile uint32_t queue_tail;            //Only moved by the ISR
 } I2C_STATE_MACHINE;
 
 
@@ -78,7 +155,10 @@ typedef struct {
 // function prototypes
 //***********************************************************************************
 void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init);
-void i2c_start(bool mode, uint32_t *data, uint32_t bytes_expected, uint32_t device_address, uint32_t register_address, I2C_TypeDef *i2cx,uint32_t call_back);
+bool i2c_start(bool mode, uint32_t *data, uint32_t bytes_expected, uint32_t device_address, uint32_t register_address, I2C_TypeDef *i2cx,uint32_t call_back);
+bool i2c_transfer(I2C_TypeDef *i2c, uint32_t device_address, const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len, uint32_t call_back);
+void i2c_wait(I2C_TypeDef *i2c);
+I2C_ERROR i2c_last_error(I2C_TypeDef *i2c);
 
 void I2C0_IRQHandler();
 void I2C1_IRQHandler();
@@ -0,0 +1,51 @@
+/*
+ * ldma.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef LDMA_HG
+#define LDMA_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_ldma.h"
+#include "em_cmu.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "profile.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+// LDMA channel assignments, one channel per peripheral direction
+#define LEUART0_TX_DMA_CH     0
+#define I2C0_RX_DMA_CH        1
+#define I2C1_RX_DMA_CH        2
+
+#define LDMA_CALLBACK_CHANNELS  DMA_CHAN_COUNT
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+// Called from the LDMA interrupt when a channel's transfer is done
+typedef void (*LDMA_CALLBACK)(void *context);
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void ldma_open(void);
+void ldma_register(uint32_t channel, LDMA_CALLBACK callback, void *context);
+void LDMA_IRQHandler(void);
+
+#endif
@@ -15,6 +15,7 @@
 
 /* The developer's include statements */
 #include "sleep_routines.h"
+#include "profile.h"
 
 
 //***********************************************************************************
@@ -22,6 +23,7 @@
 //***********************************************************************************
 #define LETIMER_HZ    1000      // Utilizing ULFRCO oscillator for LETIMERs
 #define LETIMER_EM    EM4       //Using the ULFRCO, block from entering energy mode 4
+#define LETIMER_TOP   0xFFFF    //Counter mode counts down from here
 
 //***********************************************************************************
 // global variables
@@ -43,12 +45,22 @@ typedef struct {
   uint32_t  uf_cb;
 } APP_LETIMER_PWM_TypeDef ;
 
+typedef struct {
+  bool      debugRun;           // True = keep LETIMER running will halted
+  uint32_t  comp1_cb;           // posted when the count armed with letimer_compare_arm is reached
+  uint32_t  uf_cb;              // posted every time the 16 bit counter wraps
+} APP_LETIMER_COUNTER_TypeDef ;
+
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
 void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct);
+void letimer_counter_open(LETIMER_TypeDef *letimer, APP_LETIMER_COUNTER_TypeDef *app_letimer_struct);
 void letimer_start(LETIMER_TypeDef *letimer, bool enable);
+uint32_t letimer_count(LETIMER_TypeDef *letimer);
+void letimer_compare_arm(LETIMER_TypeDef *letimer, uint32_t count);
+void letimer_compare_disarm(LETIMER_TypeDef *letimer);
 void LETIMER0_IRQHandler(void);
 
 #endif
@@ -6,6 +6,7 @@
 
 #include "em_leuart.h"
 #include "sleep_routines.h"
+#include "ldma.h"
 
 
 //***********************************************************************************
@@ -15,6 +16,44 @@
 #define LEUART_TX_EM		EM3
 #define LEUART_RX_EM		EM3
 
+// Transmit ring size in bytes, must be a power of two. Can be set on the command line.
+#ifndef LEUART_TX_BUFFER_SIZE
+#define LEUART_TX_BUFFER_SIZE	256
+#endif
+#define LEUART_TX_BUFFER_MASK	(LEUART_TX_BUFFER_SIZE - 1)
+#if (LEUART_TX_BUFFER_SIZE & LEUART_TX_BUFFER_MASK) != 0
+#error "LEUART_TX_BUFFER_SIZE must be a power of two"
+#endif
+
+// Receive ring size in bytes, must be a power of two. Can be set on the command line.
+#ifndef LEUART_RX_BUFFER_SIZE
+#define LEUART_RX_BUFFER_SIZE	128
+#endif
+#define LEUART_RX_BUFFER_MASK	(LEUART_RX_BUFFER_SIZE - 1)
+#if (LEUART_RX_BUFFER_SIZE & LEUART_RX_BUFFER_MASK) != 0
+#error "LEUART_RX_BUFFER_SIZE must be a power of two"
+#endif
+
+// Number of messages that can be waiting to transmit, must be a power of two.
+#ifndef LEUART_TX_QUEUE_SIZE
+#define LEUART_TX_QUEUE_SIZE	8
+#endif
+#define LEUART_TX_QUEUE_MASK	(LEUART_TX_QUEUE_SIZE - 1)
+#if (LEUART_TX_QUEUE_SIZE & LEUART_TX_QUEUE_MASK) != 0
+#error "LEUART_TX_QUEUE_SIZE must be a power of two"
+#endif
+
+#define LEUART_TX_DMA_MAX	2048	// Largest single LDMA transfer (XFERCNT is 11 bits)
+
+// Fastest rate sampled reliably from the 32.768 kHz LFXO. Faster rates move LFB
+// to HFCLKLE, which stops in EM2, so the LEUART then blocks LEUART_HF_EM.
+#define LEUART_LFXO_MAX_BAUD	9600
+#define LEUART_HF_EM		EM2
+
+// Called from the LEUART interrupt with each byte received outside a frame,
+// returns false to block the receiver until the next start frame
+typedef bool (*LEUART_RX_CALLBACK)(void *context, char byte);
+
 /***************************************************************************//**
  * @addtogroup leuart
  * @{
@@ -43,20 +82,49 @@ typedef struct {
 	uint32_t					tx_pin_en;
 	bool						rx_en;
 	bool						tx_en;
+	bool						tx_dma_en;
 	uint32_t					rx_done_evt;
 	uint32_t					tx_done_evt;
 	uint32_t        refFreq;
 } LEUART_OPEN_STRUCT;
 
 typedef struct{
-  char        data[100];
-  uint32_t      length;
-  uint32_t      count;
+  const uint8_t   *data;                    //Caller's storage, NULL when the bytes are in the transmit ring
+  uint32_t        length;
+  uint32_t        release_evt;              //Posted once data can be reused
+}LEUART_TX_SEGMENT;
+
+typedef struct{
+  uint8_t           tx_buffer[LEUART_TX_BUFFER_SIZE];
+  volatile uint32_t tx_head;                //Free running write index, only moved by leuart_start()
+  volatile uint32_t tx_tail;                //Free running read index, only moved by the ISR
+  LEUART_TX_SEGMENT tx_queue[LEUART_TX_QUEUE_SIZE];
+  volatile uint32_t tx_q_head;              //Only moved by leuart_start() and leuart_start_owned()
+  volatile uint32_t tx_q_tail;              //Only moved by the ISR
+  uint32_t          tx_sent;                //Bytes of the tail segment already sent
+  uint32_t          dma_count;              //Bytes in the LDMA run that is going out
   volatile bool available;
-  uint32_t        bytes_expected;
   DEFINED_LEUART_STATES  current_state;
-  bool            mode;                    //0 for write 1 for read
-  uint32_t        leuart_call_back;              //Tells us which interrupts were triggered
+  bool            tx_dma;                  //true when LDMA feeds TXDATA instead of TXBL
+  LEUART_Enable_TypeDef enable;         //From the open struct, used again by leuart_baud_set()
+  char              rx_buffer[LEUART_RX_BUFFER_SIZE];
+  volatile uint32_t rx_head;                //Free running write index, only moved by the ISR
+  volatile uint32_t rx_tail;                //Free running read index, only moved by leuart_receive()
+  uint32_t          rx_overflow;            //Bytes dropped because the ring was full
+  volatile uint32_t rx_frames_in;           //Signal frames seen, only moved by the ISR
+  uint32_t          rx_frames_out;          //Frames read, only moved by leuart_receive()
+  uint32_t          rx_done_evt;            //Posted when a whole frame is in the ring
+  bool              rx_en;
+  bool              rxblocken;              //Block the receiver again after every signal frame
+  bool              startframe_en;
+  char              startframe;
+  bool              sigframe_en;
+  char              sigframe;
+  bool              rx_in_frame;            //Start frame seen, signal frame not yet
+  LEUART_RX_CALLBACK rx_monitor;            //Gets the bytes outside frames while the receiver is unblocked for it
+  void              *rx_context;
+  uint32_t          baudrate;
+  bool              hf_clock;               //LFB is on HFCLKLE and LEUART_HF_EM is blocked
   LEUART_TypeDef *leuart;
 }LEUART_STATE_MACHINE;
 
@@ -73,8 +141,13 @@ typedef struct{
 //***********************************************************************************
 void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings);
 void LEUART0_IRQHandler(void);
-void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
+bool leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
+bool leuart_start_owned(LEUART_TypeDef *leuart, const uint8_t *data, uint32_t length, uint32_t release_evt);
+uint32_t leuart_receive(LEUART_TypeDef *leuart, char *string, uint32_t max_len);
 bool leuart_tx_busy(LEUART_TypeDef *leuart);
+bool leuart_baud_set(LEUART_TypeDef *leuart, uint32_t baudrate);
+uint32_t leuart_baud_get(LEUART_TypeDef *leuart);
+void leuart_rx_monitor(LEUART_TypeDef *leuart, LEUART_RX_CALLBACK callback, void *context);
 
 uint32_t leuart_status(LEUART_TypeDef *leuart);
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update);
@@ -0,0 +1,95 @@
+/*
+ * profile.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef PROFILE_HG
+#define PROFILE_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_core.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+// 1 builds the PROFILE_ENTER and PROFILE_EXIT regions in, 0 leaves no code behind
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED     0
+#endif
+
+// Time base of the regions, the core cycle counter. A host build defines both,
+// e.g. PROFILE_CYCLES() as a monotonic clock in ns.
+#ifndef PROFILE_CYCLES
+#define PROFILE_CYCLES()        (DWT->CYCCNT)
+#define PROFILE_CYCLES_INIT()   do{ CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; }while(0)
+#endif
+
+// Brackets a region, both in the same block. An interrupt that comes in
+// during a region is counted in it.
+#if PROFILE_ENABLED
+#define PROFILE_ENTER(region)   uint32_t profile_start_##region = PROFILE_CYCLES()
+#define PROFILE_EXIT(region)    profile_record(region, PROFILE_CYCLES() - profile_start_##region)
+#else
+#define PROFILE_ENTER(region)
+#define PROFILE_EXIT(region)
+#endif
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+// Instrumented regions, profile_name has the name of each
+typedef enum{
+  PROF_LEUART0_IRQ,
+  PROF_I2C0_IRQ,
+  PROF_I2C1_IRQ,
+  PROF_LETIMER0_IRQ,
+  PROF_GPIO_IRQ,
+  PROF_LDMA_IRQ,
+  PROF_SI1133_READ_CB,
+  PROF_REPORT_TIMER_CB,
+  PROF_BATCH_TIMER_CB,
+  PROFILE_REGIONS
+}PROFILE_REGION;
+
+// Since profile_reset, in PROFILE_CYCLES
+typedef struct{
+  uint32_t  count;
+  uint32_t  min;              // 0 until the region has run
+  uint32_t  max;
+  uint64_t  total;
+}PROFILE_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+#if PROFILE_ENABLED
+void profile_open(void);
+void profile_reset(void);
+void profile_record(PROFILE_REGION region, uint32_t cycles);
+void profile_get(PROFILE_REGION region, PROFILE_STATS *stats);
+const char *profile_name(PROFILE_REGION region);
+#else
+// Built out, profile.c is empty and these leave nothing behind
+static inline void profile_open(void){}
+static inline void profile_reset(void){}
+static inline void profile_record(PROFILE_REGION region, uint32_t cycles){ (void)region; (void)cycles; }
+static inline void profile_get(PROFILE_REGION region, PROFILE_STATS *stats){ (void)region; *stats = (PROFILE_STATS){ 0 }; }
+static inline const char *profile_name(PROFILE_REGION region){ (void)region; return ""; }
+#endif
+
+#endif
@@ -7,8 +7,10 @@
 
 /* System include statements */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Silicon Labs include statements */
+#include "em_device.h"
 #include "em_assert.h"
 #include "em_core.h"
 #include "em_emu.h"
@@ -19,11 +21,58 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define SCHEDULER_MAX_EVENTS    32      // one per bit of the event mask, also the number of priorities
+
+// Records shared by the queued events, see scheduler_register_queued
+#ifndef SCHEDULER_QUEUE_SIZE
+#define SCHEDULER_QUEUE_SIZE    16
+#endif
+#if SCHEDULER_QUEUE_SIZE > 255
+#error "SCHEDULER_QUEUE_SIZE must fit a uint8_t record index"
+#endif
+#define SCHEDULER_NO_RECORD     0xFF    // end of a list of records
+
+// Per event timing, 0 leaves it out of add_scheduled_event and scheduler_dispatch
+#ifndef SCHEDULER_STATS
+#define SCHEDULER_STATS         1
+#endif
+
+// Time base of the stats, the core cycle counter. It stops while the core
+// sleeps, which is fine since events are posted and run while awake. A build
+// without the DWT defines both.
+#ifndef SCHEDULER_CYCLES
+#define SCHEDULER_CYCLES()      (DWT->CYCCNT)
+#define SCHEDULER_CYCLES_INIT() do{ CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; }while(0)
+#endif
 
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+typedef void (*SCHEDULER_HANDLER)(void);
+typedef void (*SCHEDULER_PAYLOAD_HANDLER)(uint32_t payload);
+
+// One post of a queued event
+typedef struct{
+  uint32_t  payload;
+  uint8_t   next;             // next record of the same event, or of the free list
+#if SCHEDULER_STATS
+  uint32_t  posted;           // SCHEDULER_CYCLES
+#endif
+}SCHEDULER_RECORD;
+
+// Stats of one event bit since scheduler_stats_reset, times in SCHEDULER_CYCLES
+typedef struct{
+  uint32_t  posts;
+  uint32_t  overruns;         // posts merged into one run because it was pending, or dropped for want of a record if queued
+  uint32_t  runs;             // handler calls by scheduler_dispatch
+  uint32_t  last_post;        // when the post that made it pending came in
+  uint32_t  last_dispatch;
+  uint32_t  latency_last;     // post to dispatch
+  uint32_t  latency_max;
+  uint32_t  run_last;         // handler run time
+  uint32_t  run_max;
+}SCHEDULER_EVENT_STATS;
 
 
 //***********************************************************************************
@@ -31,8 +80,14 @@
 //***********************************************************************************
 void scheduler_open(void);
 void add_scheduled_event(uint32_t event);
+bool scheduler_post(uint32_t event, uint32_t payload);
 void remove_scheduled_event(uint32_t event);
 uint32_t get_scheduled_events(void);
+void scheduler_register(uint32_t event, SCHEDULER_HANDLER handler, uint32_t priority);
+void scheduler_register_queued(uint32_t event, SCHEDULER_PAYLOAD_HANDLER handler, uint32_t priority);
+bool scheduler_dispatch(void);
+void scheduler_stats_reset(void);
+void scheduler_stats_get(uint32_t event, SCHEDULER_EVENT_STATS *stats);
 
 
 #endif
@@ -12,7 +12,7 @@
 #define HEADER_FILES_SI1133_H_
 
 /* System include statements */
-
+#include <stdint.h>
 
 /* Silicon Labs include statements */
 #include <stdbool.h>
@@ -21,10 +21,13 @@
 #include "i2c.h"
 #include "brd_config.h"
 #include "HW_delay.h"
+#include "gpio.h"
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define SI1133_ADDRESS  0x55
+
 #define PART_ID   0x00
 
 #define STANDARD_VALUE 51
@@ -33,16 +36,54 @@
 #define RESPONSE0     0x11
 #define INPUT0        0x0A
 #define COMMAND_REG   0x0B
-#define ADC_CONFIG0   0x02
-#define WHITE         0b01011
 #define PARAM_SET     0b10000000
-#define CHAN0_PREP    0b000001
 #define CHAN_LIST     0x01
 #define FORCE         0x11
 #define HOSTOUT0      0x13
 #define HOSTOUT1      0x14
 #define HOSTOUT2      0x15
 #define RESET_CMD_CTR 0x00
+#define RESPONSE0_CMD_CTR   0x0F    // incremented by every command that went through
+#define RESPONSE0_CMD_ERR   0x10    // last command failed, cleared by RESET_CMD_CTR
+
+// Autonomous mode
+#define IRQ_ENABLE    0x0F      // register, one bit a channel
+#define IRQ_STATUS    0x12      // register, cleared by reading it, right before HOSTOUT0
+#define START         0x13      // command, measures every MEAS_RATE until PAUSE
+#define MEAS_RATE_H   0x1A      // parameters
+#define MEAS_RATE_L   0x1B
+#define MEAS_COUNT0   0x1C
+#define MEAS_COUNTER_INDEX0   0b01000000    // channel is measured every MEAS_COUNT0 periods
+#define SI1133_MEAS_RATE_US   800           // unit of MEAS_RATE
+#define SI1133_AUTO_PARAMS    3             // MEAS_RATE_H, MEAS_RATE_L and MEAS_COUNT0
+
+// Channel parameters, channel n is at the channel 0 address + 4n
+#define ADCCONFIG0    0x02      // DECIM_RATE in bits 6:5, ADCMUX in bits 4:0
+#define ADCSENS0      0x03      // HSIG in bit 7, SW_GAIN in bits 6:4, HW_GAIN in bits 3:0
+#define ADCPOST0      0x04      // 24BIT_OUT in bit 6
+#define MEASCONFIG0   0x05      // COUNTER_INDEX in bits 7:6
+#define SI1133_CHAN_PARAMS    4
+#define ADCCONFIG_DECIM_SHIFT 5
+#define ADCSENS_HSIG          0b10000000
+#define ADCSENS_SW_GAIN_SHIFT 4
+#define ADCPOST_24BIT         0b01000000
+
+#define SI1133_MAX_CHANNELS   6
+#define SI1133_MAX_PARAMS     (1 + SI1133_MAX_CHANNELS*SI1133_CHAN_PARAMS)   // CHAN_LIST and the channel table
+
+// Fixed point conversions, see Si1133_uvi_milli and Si1133_lux
+#define SI1133_UVI_K1         187       // UVI = 0.0187*(uv + 0.00391*uv^2), in 10^-4 UVI
+#define SI1133_UVI_K2         731       // 0.0187*0.00391, in 10^-7 UVI
+#define SI1133_LUX_WHITE_Q16  32768     // lux a white count, Q16, calibrate for the enclosure window
+#define SI1133_LUX_IR_Q16     16384     // lux taken off an IR count, Q16
+
+// Start up configuration, see si1133_config_cb
+#define SI1133_MAX_STEPS      (SI1133_MAX_PARAMS + SI1133_AUTO_PARAMS + 1)  // and START
+#define SI1133_STEP_START     0xFF      // step that sends START instead of a parameter set
+#define SI1133_CMD_POLLS      10        // RESPONSE0 reads before a command counts as lost
+#define SI1133_CONFIG_RETRIES 3         // tries of a step after the first, each after RESET_CMD_CTR
+
+#define SI1133_BURST_MAX      (1 + 3*SI1133_MAX_CHANNELS)   // IRQ_STATUS, then a 16 or 24 bit result a channel
 
 #define NULL_CB       0
 
@@ -50,6 +91,77 @@
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+typedef enum{
+  SI1133_ADCMUX_SMALL_IR    = 0x00,
+  SI1133_ADCMUX_MEDIUM_IR   = 0x01,
+  SI1133_ADCMUX_LARGE_IR    = 0x02,
+  SI1133_ADCMUX_WHITE       = 0x0B,
+  SI1133_ADCMUX_LARGE_WHITE = 0x0D,
+  SI1133_ADCMUX_UV          = 0x18,
+  SI1133_ADCMUX_UV_DEEP     = 0x19
+}SI1133_ADCMUX;
+
+// One entry of the channel table, results come back in table order
+typedef struct{
+  SI1133_ADCMUX   adcmux;       // photodiode
+  uint8_t         decim_rate;   // 0 = 1024, 1 = 2048, 2 = 4096, 3 = 512 clocks a measurement
+  uint8_t         hw_gain;      // 0 to 11, integration time doubles each step
+  uint8_t         sw_gain;      // 0 to 7, 2^sw_gain measurements are added up
+  bool            hsig;         // high signal range, for bright light
+  bool            out24;        // 24 bit signed result instead of 16 bit
+}SI1133_CHANNEL;
+
+typedef struct{
+  const SI1133_CHANNEL  *channels;      // must stay valid, used to decode results
+  uint32_t              channel_count;  // 1 to SI1133_MAX_CHANNELS
+  uint32_t              period_ms;      // autonomous measurement period, 0 to only use Si1133_force_sense
+  uint32_t              result_evt;     // INT pin fell, a result is ready, autonomous mode only
+  uint32_t              ready_evt;      // configuration done, and measuring if period_ms is set
+  uint32_t              error_evt;      // a transfer failed for good, or the configuration gave up
+  uint32_t              supervise_evt;  // I2C driver timeouts and retries
+  uint32_t              supervise_prio;
+  uint32_t              config_evt;     // handled by the driver as a queued event, RESPONSE0 of a configuration step
+  uint32_t              config_prio;
+  uint32_t              i2c_error_evt;  // handled by the driver, must be a higher priority than config_evt
+  uint32_t              i2c_error_prio;
+}SI1133_OPEN_STRUCT;
+
+// One configuration step, a parameter set or SI1133_STEP_START
+typedef struct{
+  uint8_t         param;
+  uint8_t         value;
+}SI1133_STEP;
+
+typedef enum{
+  si1133_config_reset,          // RESET_CMD_CTR, before the first step and each retry
+  si1133_config_step,           // the current step
+  si1133_config_done,
+  si1133_config_failed
+}SI1133_CONFIG_STATE;
+
+typedef struct{
+  SI1133_CONFIG_STATE   state;
+  SI1133_STEP           steps[SI1133_MAX_STEPS];
+  uint32_t              step_count;
+  uint32_t              step;
+  uint32_t              cmd_ctr;        // CMD_CTR expected before the current step
+  uint32_t              irq_status;     // read to clear it before START
+  uint32_t              polls;
+  uint32_t              retries;
+  bool                  step_failed;    // one of the step's transfers failed for good
+  uint32_t              period_ms;
+  uint32_t              result_evt;
+  uint32_t              ready_evt;
+  uint32_t              error_evt;
+  uint32_t              config_evt;
+}SI1133_CONFIG_STATE_MACHINE;
+
+// One measurement of every channel, from one burst read
+typedef struct{
+  uint32_t        irq_status;
+  uint32_t        count;
+  int32_t         value[SI1133_MAX_CHANNELS];
+}SI1133_RESULT;
 
 
 
@@ -57,7 +169,7 @@
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-void Si1133_i2c_open();
+void Si1133_i2c_open(SI1133_OPEN_STRUCT *si1133_open);
 
 void Si1133_read(uint32_t bytes_expected,uint32_t register_address, uint32_t call_back);
 
@@ -65,8 +177,18 @@ void Si1133_write(uint32_t bytes_expected,uint32_t register_address, uint32_t ca
 
 void Si1133_force_sense();
 
-void Si1133_request_result();
+void Si1133_request_result(uint32_t callback);
+
+bool Si1133_int_pending(void);
 
 uint32_t result_read();
 
+void Si1133_result(SI1133_RESULT *result);
+
+uint32_t Si1133_uvi_milli(int32_t uv);
+
+uint32_t Si1133_lux(int32_t white, int32_t ir);
+
+I2C_ERROR Si1133_last_error(void);
+
 #endif /* HEADER_FILES_SI1133_H_ */
@@ -12,6 +12,8 @@
 #define HEADER_FILES_SLEEP_ROUTINES_H_
 
 /* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
 
 /* Silicon Labs include statements */
 #include "em_emu.h"
@@ -32,6 +34,30 @@
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+// Who holds a block, so the time each block is held can be reported
+typedef enum{
+  SLEEP_TAG_SYSTEM,       // app, for the whole run
+  SLEEP_TAG_LEUART_TX,
+  SLEEP_TAG_LEUART_RX,
+  SLEEP_TAG_I2C0,
+  SLEEP_TAG_I2C1,
+  SLEEP_TAG_LETIMER,
+  SLEEP_TAG_LEUART_CLK,   // LFB on HFCLKLE for a fast baud rate
+  SLEEP_TAGS
+}SLEEP_TAG;
+
+// Time source of the stats, a free running count of hz ticks a second. The
+// layer that owns the low energy timer registers it with sleep_clock_set.
+typedef uint32_t (*SLEEP_CLOCK)(void);
+
+// Totals since sleep_stats_reset, in ms of the registered clock
+typedef struct{
+  uint32_t elapsed_ms;
+  uint32_t residency_ms[MAX_ENERGY_MODES];    // EM0 is the time not spent in enter_sleep
+  uint32_t held_ms[SLEEP_TAGS];               // time the tag held at least one block
+  uint32_t blocks[SLEEP_TAGS];                // calls to sleep_block_mode
+  uint32_t em[SLEEP_TAGS];                    // mode the tag last blocked
+}SLEEP_STATS;
 
 
 //***********************************************************************************
@@ -39,12 +65,18 @@
 //***********************************************************************************
 void sleep_open(void);
 
-void sleep_block_mode(uint32_t EM);
+void sleep_block_mode(uint32_t EM, SLEEP_TAG tag);
 
-void sleep_unblock_mode(uint32_t EM);
+void sleep_unblock_mode(uint32_t EM, SLEEP_TAG tag);
 
 void enter_sleep(void);
 
 uint32_t current_block_energy_mode(void);
 
+void sleep_clock_set(SLEEP_CLOCK clock, uint32_t hz);
+
+void sleep_stats_reset(void);
+
+void sleep_stats_get(SLEEP_STATS *stats);
+
 #endif /* HEADER_FILES_SLEEP_ROUTINES_H_ */
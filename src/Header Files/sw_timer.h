@@ -0,0 +1,61 @@
+/*
+ * sw_timer.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef SW_TIMER_HG
+#define SW_TIMER_HG
+
+/* System include statements */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "letimer.h"
+#include "scheduler.h"
+#include "sleep_routines.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SW_TIMER_LETIMER            LETIMER0
+#define SW_TIMER_MS_TO_TICKS(ms)    ((uint32_t)(((uint64_t)(ms) * LETIMER_HZ) / 1000))
+#define SW_TIMER_MAX_TICKS          0x7FFFFFFF    // deadlines are compared by signed difference
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+// Owned by the caller, normally a static. Must not be changed while started.
+typedef struct SW_TIMER{
+  struct SW_TIMER   *next;
+  uint32_t          deadline;       // letimer_count value the timer expires at
+  uint32_t          period;         // ticks, 0 for a one shot timer
+  uint32_t          event;          // posted to the scheduler each time it expires
+  bool              active;
+}SW_TIMER;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void sw_timer_open(uint32_t service_evt, uint32_t priority);
+void sw_timer_start(SW_TIMER *timer, uint32_t delay_ms, uint32_t period_ms, uint32_t event);
+void sw_timer_stop(SW_TIMER *timer);
+void sw_timer_wait(SW_TIMER *timer);
+bool sw_timer_due(void);
+void sw_timer_poll(void);
+bool sw_timer_active(SW_TIMER *timer);
+uint32_t sw_timer_now(void);
+void sw_timer_service(void);
+
+#endif
@@ -31,21 +31,53 @@
 // Global functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ * Waits ms_delay milliseconds in the lowest energy mode allowed
+ *
+ *
+ * @details
+ * Starts a one shot software timer and sleeps on it instead of counting down
+ * TIMER0 in EM0, so the core is only awake for the LETIMER wake ups.
+ *
+ *
+ * @note
+ * Needs sw_timer_open. Code that can go back to the main loop while it waits
+ * should use timer_delay_async instead.
+ *
+ * @param[in] ms_delay
+ * The delay in milliseconds.
+ *
+ ******************************************************************************/
 void timer_delay(uint32_t ms_delay){
-	uint32_t timer_clk_freq = CMU_ClockFreqGet(cmuClock_HFPER);
-	uint32_t delay_count = ms_delay *(timer_clk_freq/1000) / 1024;
-	CMU_ClockEnable(cmuClock_TIMER0, true);
-	TIMER_Init_TypeDef delay_counter_init = TIMER_INIT_DEFAULT;
-		delay_counter_init.oneShot = true;
-		delay_counter_init.enable = false;
-		delay_counter_init.mode = timerModeDown;
-		delay_counter_init.prescale = timerPrescale1024;
-		delay_counter_init.debugRun = false;
-	TIMER_Init(TIMER0, &delay_counter_init);
-	TIMER0->CNT = delay_count;
-	TIMER_Enable(TIMER0, true);
-	while (TIMER0->CNT != 00);
-	TIMER_Enable(TIMER0, false);
-	CMU_ClockEnable(cmuClock_TIMER0, false);
+	SW_TIMER delay_timer = {0};
+
+	sw_timer_start(&delay_timer, ms_delay, 0, 0);
+	sw_timer_wait(&delay_timer);
 }
 
+/***************************************************************************//**
+ * @brief
+ * Posts event ms_delay milliseconds from now
+ *
+ *
+ * @details
+ * Returns right away, the work after the delay goes in the handler of event.
+ *
+ *
+ * @note
+ * Needs sw_timer_open
+ *
+ * @param[in] timer
+ * Caller owned timer, normally a static, which must stay valid until event.
+ *
+ * @param[in] ms_delay
+ * The delay in milliseconds.
+ *
+ * @param[in] event
+ * Scheduler event posted when the delay is over.
+ *
+ ******************************************************************************/
+void timer_delay_async(SW_TIMER *timer, uint32_t ms_delay, uint32_t event){
+	sw_timer_start(timer, ms_delay, 0, event);
+}
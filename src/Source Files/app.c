@@ -6,7 +6,8 @@
  * @date
  * 9/8/21
  * @brief
- * Initializes all peripherals and initializes LETIMER0 for PWM operation
+ * Initializes all peripherals, reads the Si1133 when it has a result, and
+ * runs the report timer
  *
  */
 
@@ -28,11 +29,49 @@ static uint32_t x = 3;
 static uint32_t y = 0;
 static int LED_COLOR;
 
+// Messages are sent straight out of these, so each one stays busy until the
+// LEUART posts its release event
+static char z_msg[APP_MSG_SIZE];
+static bool z_msg_busy;
+static char light_msg[APP_BATCH_MSG_SIZE];
+static bool light_msg_busy;
+
+// Si1133 readings waiting to be sent
+static uint32_t batch[APP_BATCH_SAMPLES];
+static uint32_t batch_count;
+static uint32_t uvi_milli;          //of the latest reading
+static uint32_t lux;
+
+// Every channel is measured each sample period and read in one burst
+static const SI1133_CHANNEL si1133_channels[APP_CHANNELS] = {
+    [APP_CHAN_WHITE] = { .adcmux = SI1133_ADCMUX_WHITE },
+    [APP_CHAN_UV]    = { .adcmux = SI1133_ADCMUX_UV, .decim_rate = 3, .hw_gain = 9 },
+    [APP_CHAN_IR]    = { .adcmux = SI1133_ADCMUX_MEDIUM_IR },
+};
+
+#if PROFILE_ENABLED
+// Profile report, one line a region, the next goes out when the last is sent
+static char profile_msg[APP_PROFILE_MSG_SIZE];
+static uint32_t profile_next = PROFILE_REGIONS;     //PROFILE_REGIONS when no report is going out
+#endif
+
+static SW_TIMER report_timer;
+static SW_TIMER batch_timer;        //deadline of the oldest reading in the batch
+static uint32_t ble_test_results;   //results of ble_test in so far
+static bool ble_test_failed;
+
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
 
-static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route);
+static bool app_batch_flush(void);
+static void app_sleep_stats_report(void);
+#if PROFILE_ENABLED
+static void app_profile_send(void);
+#endif
+static void app_scheduler_register(void);
+static void app_si1133_open(void);
+static void app_ble_open(void);
 
 //***********************************************************************************
 // Global functions
@@ -45,8 +84,8 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
  *
  * @details
  * Calls all of the other functions in their respective drivers. Specifically
- * it sets up the cmu and gpio. It also sets up LETIMER0 for pwm operation, then
- * starts our timer.
+ * it sets up the cmu and gpio. It also opens the software timers on LETIMER0,
+ * which the boot up callback starts.
  *
  *
  * @note
@@ -58,70 +97,116 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
 
 void app_peripheral_setup(void){
   scheduler_open();    //I put it before everything because if the timer starts we may have an interrupt B4 we are set up
+  profile_open();
+  app_scheduler_register();
   sleep_open();
   cmu_open();
+  sw_timer_open(SW_TIMER_CB, SW_TIMER_PRIO);     //before the drivers below, their timer_delay calls need it
+  sleep_stats_reset();                           //the LETIMER is counting now
+  ldma_open();
   gpio_open();
-  Si1133_i2c_open();
+  app_si1133_open();
   led_color_open();
-  sleep_block_mode(SYSTEM_BLOCK_EM);
-  ble_open(0,0);
-  app_letimer_pwm_open(PWM_PER, PWM_ACT_PER, PWM_ROUTE_0, PWM_ROUTE_1);
+  sleep_block_mode(SYSTEM_BLOCK_EM, SLEEP_TAG_SYSTEM);
+  app_ble_open();
   add_scheduled_event(BOOT_UP_CB); //check this position once we know what boot up does
 }
 
 /***************************************************************************//**
  * @brief
- * Initializes LETIMER0 for PWM operation
+ * Registers the handler of every application event with the scheduler
  *
  *
  * @details
- * Accesses members of the APP_LETIMER_PWM_TypeDef of the local variable
- * app_letimer_pwm_struct and sets it for the specific needs of the pwm signal.
- * That structure is then passed into the pwm open function written in
- * letimer.c. Refer to more detail there.
+ * The main loop calls scheduler_dispatch, which runs these handlers in the
+ * order of the *_PRIO values in app.h. A new event only needs a line here.
+ * SW_TIMER_CB is registered by sw_timer_open, and I2C1_SUPERVISE_CB,
+ * SI1133_CONFIG_CB and SI1133_I2C_ERROR_CB by Si1133_i2c_open. BLE_AT_CB,
+ * BLE_AT_TIMEOUT_CB and BLE_LINK_CB are registered by ble_open.
+ *
+ *
+ * @note
+ * Called in app_peripheral_setup right after scheduler_open
+ *
+ ******************************************************************************/
+static void app_scheduler_register(void){
+  scheduler_register(SI1133_RESULT_CB, scheduled_si1133_result_cb, SI1133_RESULT_PRIO);
+  scheduler_register(SI1133_READY_CB, scheduled_si1133_ready_cb, SI1133_READY_PRIO);
+  scheduler_register(SI1133_REG_READ_CB, scheduled_si1133_read_cb, SI1133_REG_READ_PRIO);
+  scheduler_register(BOOT_UP_CB, scheduled_boot_up_cb, BOOT_UP_PRIO);
+  scheduler_register(BLE_TX_DONE_CB, scheduled_ble_tx_done_cb, BLE_TX_DONE_PRIO);
+  scheduler_register(BLE_RX_DONE_CB, scheduled_ble_rx_done_cb, BLE_RX_DONE_PRIO);
+  scheduler_register(SI1133_TX_DONE_CB, scheduled_si1133_tx_done_cb, SI1133_TX_DONE_PRIO);
+  scheduler_register(REPORT_TIMER_CB, scheduled_report_timer_cb, REPORT_TIMER_PRIO);
+  scheduler_register(BATCH_TIMER_CB, scheduled_batch_timer_cb, BATCH_TIMER_PRIO);
+  scheduler_register(SI1133_ERROR_CB, scheduled_si1133_error_cb, SI1133_ERROR_PRIO);
+#if PROFILE_ENABLED
+  scheduler_register(PROFILE_TX_DONE_CB, scheduled_profile_tx_done_cb, PROFILE_TX_DONE_PRIO);
+#endif
+  scheduler_register(BLE_BAUD_DONE_CB, scheduled_ble_baud_done_cb, BLE_BAUD_DONE_PRIO);
+  scheduler_register_queued(BLE_TEST_DONE_CB, scheduled_ble_test_done_cb, BLE_TEST_DONE_PRIO);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Opens the Si1133 with the app channel table
+ *
  *
+ * @details
+ * The Si1133 is configured in the background and starts measuring every
+ * APP_SAMPLE_PER_MS on its own, then SI1133_READY_CB is posted.
  *
  *
  * @note
- *  This function should be called in the application file. It is called to
- *  set up and enable specific LETIMER for the user.
+ * Called in app_peripheral_setup after sw_timer_open and gpio_open
  *
- * @param[in] period
- * The overall period of the PWM waveform.
+ ******************************************************************************/
+static void app_si1133_open(void){
+  SI1133_OPEN_STRUCT si1133_open;
+
+  si1133_open.channels = si1133_channels;
+  si1133_open.channel_count = APP_CHANNELS;
+  si1133_open.period_ms = APP_SAMPLE_PER_MS;
+  si1133_open.result_evt = SI1133_RESULT_CB;
+  si1133_open.ready_evt = SI1133_READY_CB;
+  si1133_open.error_evt = SI1133_ERROR_CB;
+  si1133_open.supervise_evt = I2C1_SUPERVISE_CB;
+  si1133_open.supervise_prio = I2C1_SUPERVISE_PRIO;
+  si1133_open.config_evt = SI1133_CONFIG_CB;
+  si1133_open.config_prio = SI1133_CONFIG_PRIO;
+  si1133_open.i2c_error_evt = SI1133_I2C_ERROR_CB;
+  si1133_open.i2c_error_prio = SI1133_I2C_ERROR_PRIO;
+  Si1133_i2c_open(&si1133_open);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Opens the BLE link in APP_BLE_FORMAT
  *
  *
+ * @details
+ * Nothing needs to know when a message is out, so no tx event is used.
  *
  *
- * @param[in] act_period
- * This is the on period of the active waveform
+ * @note
+ * Called in app_peripheral_setup after sw_timer_open
  *
  ******************************************************************************/
+static void app_ble_open(void){
+  BLE_OPEN_STRUCT ble_open_struct;
 
-void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route){
-  // Initializing LETIMER0 for PWM operation by creating the
-  // letimer_pwm_struct and initializing all of its elements
-  // APP_LETIMER_PWM_TypeDef is defined in letimer.h
-  APP_LETIMER_PWM_TypeDef   app_letimer_pwm_struct;
-  app_letimer_pwm_struct.active_period      = act_period;
-  app_letimer_pwm_struct.debugRun           = false;
-  app_letimer_pwm_struct.enable             = false;
-  app_letimer_pwm_struct.out_pin_0_en       = true;   //We want pin 0 on
-  app_letimer_pwm_struct.out_pin_1_en       = true;   //We want pin 1 on
-  app_letimer_pwm_struct.out_pin_route0     = out0_route;
-  app_letimer_pwm_struct.out_pin_route1     = out1_route;
-  app_letimer_pwm_struct.period             = period;
-  app_letimer_pwm_struct.comp0_irq_enable   = false;            //false means disable
-  app_letimer_pwm_struct.comp0_cb           = LETIMER0_COMP0_CB;
-  app_letimer_pwm_struct.comp1_irq_enable   = true;             //true means enable
-  app_letimer_pwm_struct.comp1_cb           = LETIMER0_COMP1_CB;
-  app_letimer_pwm_struct.uf_irq_enable      = true;
-  app_letimer_pwm_struct.uf_cb              = LETIMER0_UF_CB;
-
-
-
-
-  letimer_pwm_open(LETIMER0, &app_letimer_pwm_struct);
+  ble_open_struct.tx_evt = 0;
+  ble_open_struct.rx_evt = BLE_RX_DONE_CB;
+  ble_open_struct.format = APP_BLE_FORMAT;
+  ble_open_struct.at_evt = BLE_AT_CB;
+  ble_open_struct.at_prio = BLE_AT_PRIO;
+  ble_open_struct.at_timeout_evt = BLE_AT_TIMEOUT_CB;
+  ble_open_struct.at_timeout_prio = BLE_AT_TIMEOUT_PRIO;
+  ble_open_struct.link_evt = BLE_LINK_CB;
+  ble_open_struct.link_prio = BLE_LINK_PRIO;
+  ble_open(&ble_open_struct);
 }
+
 /***************************************************************************//**
  * @brief
  *  Sets the static variable for LED color and initializes the the LEDs
@@ -146,76 +231,80 @@ void led_color_open(void){
 
 /***************************************************************************//**
  * @brief
- * The Callback function for the comp0 interrupt. Does nothing in this program
+ * This requests the result from the SI1133
  *
  *
  *
  * @details
- * Does nothing in this program
- *
- *
+ * calls Si1133_request_result, which posts SI1133_REG_READ_CB with the reading.
+ * The Si1133 measures on its own, so this one transfer is all a sample costs.
  *
  *
  *
  * @note
- * N/A
+ * Posted by the Si1133 interrupt pin every APP_SAMPLE_PER_MS
  ******************************************************************************/
-void scheduled_letimer0_comp0_cb(void){
-  //EFM_ASSERT(false);    //For now we don't use this, if we get here we done goofed
-  //EFM_ASSERT(!(get_scheduled_events() & LETIMER0_COMP0_CB));
+void scheduled_si1133_result_cb(void){
+  Si1133_request_result(SI1133_REG_READ_CB);
 }
+
 /***************************************************************************//**
  * @brief
- * The callback function for the comp1 interrupt that causes a sense of the Si1133
- *
+ * Reports that the Si1133 is configured and measuring
  *
  *
  * @details
- * This calls the force_sense function
- *
- *
+ * Only sent in text mode, in binary mode the first light frame shows it.
  *
  *
  * @note
- * Called when the comp1 interrupt is triggered
- *
+ * Posted by the Si1133 driver once its configuration is done
  ******************************************************************************/
-void scheduled_letimer0_comp1_cb(void){
-    Si1133_force_sense();
+void scheduled_si1133_ready_cb(void){
+  if(ble_get_format() != BLE_FORMAT_BINARY){
+      ble_write("si1133 ready\n");
   }
+}
+
 /***************************************************************************//**
  * @brief
- * This requests the result from the SI1133
+ * This does the math with x, y, and z and reports z
  *
  *
  *
  * @details
- * calls Si1133_request_result then does the math with x, y, and z
- *
- *
+ * z is kept in tenths so it can be formatted without the float printf
  *
  *
  *
  * @note
- * Called when the uf interrupt is triggered
+ * Called every APP_REPORT_PER_MS
  ******************************************************************************/
-void scheduled_letimer0_uf_cb(void){
-  //EFM_ASSERT(!(get_scheduled_events() & LETIMER0_UF_CB));
-  Si1133_request_result(SI1133_REG_READ_CB);
+void scheduled_report_timer_cb(void){
+   PROFILE_ENTER(PROF_REPORT_TIMER_CB);
    x = x+3;
    y = y+1;
-   float z = (float) x/y;
+   int32_t z = (int32_t)((x*10 + y/2)/y);    //x/y in tenths, rounded like %.1f
+   FORMAT_BUFFER fmt;
 
-   char data[60];
-   sprintf(data, "z = %.1f\n", z);
-   ble_write(data);
+   if(ble_get_format() == BLE_FORMAT_BINARY){
+       ble_write_frame(APP_FRAME_Z, &z, 1);
+   }
+   else if(!z_msg_busy){      //Last z is still going out, skip this one
+       format_open(&fmt, z_msg, APP_MSG_SIZE);
+       format_string(&fmt, "z = ");
+       format_fixed(&fmt, z, 1);
+       format_char(&fmt, '\n');
+       if(ble_write_owned((uint8_t *)z_msg, fmt.len, BLE_TX_DONE_CB)){
+           z_msg_busy = true;
+       }
+   }
+   PROFILE_EXIT(PROF_REPORT_TIMER_CB);
 }
 /***************************************************************************//**
  * @brief
  * This compares the data received by the S1133 turns blue if it is dark
- * it turns off when it is light. Also transmits "its dark" and the reading when
- * the data is less than our expected value. If it is greater than or equal to our expected value it
- * transmits the data and days "its light outside"
+ * it turns off when it is light. The reading is then added to the batch.
  *
  *
  *
@@ -223,45 +312,163 @@ void scheduled_letimer0_uf_cb(void){
  * Compares the data read from the si1133 to the the value of 20 which
  * was provided as the number needed in the lab doc. If is is less than 20
  * then we turn the blue led on. If the read data is greater than 20, then we
- * turn the led off.  Also transmits "its dark" and the reading when
- * the data is less than our expected value. If it is greater than or equal to our expected value it
- * transmits the data and days "its light outside"
+ * turn the led off. The reading is saved in the batch, and once there are
+ * APP_BATCH_SAMPLES readings the batch is sent as one message, so the LEUART
+ * and BLE radio wake up once a batch instead of once a reading. The UV index
+ * and lux come from the same burst read.
  *
  *
  * @note
- * This callback is triggered after the comp1 interrupt has been triggered
+ * This callback is triggered once the reading has been read from the Si1133
  ******************************************************************************/
 void scheduled_si1133_read_cb(void){
+  PROFILE_ENTER(PROF_SI1133_READ_CB);
+  SI1133_RESULT result;
   uint32_t read_data;
-  read_data = result_read();
+
+  Si1133_result(&result);
+  read_data = (uint32_t)result.value[APP_CHAN_WHITE];
+  uvi_milli = Si1133_uvi_milli(result.value[APP_CHAN_UV]);
+  lux = Si1133_lux(result.value[APP_CHAN_WHITE], result.value[APP_CHAN_IR]);
 
   if(read_data < EXPECTED_VALUE){
       leds_enabled(RGB_LED_1, COLOR_BLUE, true);
-      char data[60];
-      int int_data = (int) read_data;
-      sprintf(data, "It's dark = %d", int_data);
-      ble_write(data);
   }
-  else if(read_data >= EXPECTED_VALUE){
+  else{
       leds_enabled(RGB_LED_1, COLOR_BLUE, false);
-      char data[60];
-      int int_data = (int) read_data;
-      sprintf(data, "It's light outside = %d", int_data);
-      ble_write(data);
   }
+
+  if(batch_count < APP_BATCH_SAMPLES){
+      if(batch_count == 0){
+          sw_timer_start(&batch_timer, APP_BATCH_DEADLINE_MS, 0, BATCH_TIMER_CB);
+      }
+      batch[batch_count++] = read_data;
+  }
+  if(batch_count == APP_BATCH_SAMPLES){
+      app_batch_flush();    //if the last batch is still going out this is retried next reading
+  }
+  PROFILE_EXIT(PROF_SI1133_READ_CB);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the batched Si1133 readings
+ *
+ *
+ * @details
+ * Sends the min, max, and rounded mean of the batch and the UV index and lux
+ * of the latest reading, followed by the raw readings, as one binary frame or
+ * one line of text. If the text buffer is
+ * still going out from the last batch nothing is sent and the batch is kept,
+ * readings that come in while the batch is full are dropped.
+ *
+ *
+ * @note
+ * Called when the batch is full or its deadline has passed
+ *
+ * @return
+ * true if the batch was sent.
+ ******************************************************************************/
+static bool app_batch_flush(void){
+  uint32_t min = batch[0];
+  uint32_t max = batch[0];
+  uint32_t sum = 0;
+  uint32_t mean;
+  FORMAT_BUFFER fmt;
+
+  for(uint32_t i = 0; i < batch_count; i++){
+      if(batch[i] < min){
+          min = batch[i];
+      }
+      if(batch[i] > max){
+          max = batch[i];
+      }
+      sum += batch[i];
+  }
+  mean = (sum + batch_count/2) / batch_count;
+
+  if(ble_get_format() == BLE_FORMAT_BINARY){
+      int32_t values[APP_BATCH_SAMPLES + APP_BATCH_HEADER];
+      values[0] = (int32_t)min;
+      values[1] = (int32_t)max;
+      values[2] = (int32_t)mean;
+      values[3] = (int32_t)uvi_milli;
+      values[4] = (int32_t)lux;
+      for(uint32_t i = 0; i < batch_count; i++){
+          values[i + APP_BATCH_HEADER] = (int32_t)batch[i];
+      }
+      if(!ble_write_frame(APP_FRAME_LIGHT, values, batch_count + APP_BATCH_HEADER)){
+          return false;
+      }
+  }
+  else{
+      if(light_msg_busy){
+          return false;
+      }
+      format_open(&fmt, light_msg, APP_BATCH_MSG_SIZE);
+      format_string(&fmt, "light n=");
+      format_uint(&fmt, batch_count);
+      format_string(&fmt, " min=");
+      format_uint(&fmt, min);
+      format_string(&fmt, " max=");
+      format_uint(&fmt, max);
+      format_string(&fmt, " mean=");
+      format_uint(&fmt, mean);
+      format_string(&fmt, " uvi=");
+      format_fixed(&fmt, (int32_t)uvi_milli, 3);
+      format_string(&fmt, " lux=");
+      format_uint(&fmt, lux);
+      format_char(&fmt, ':');
+      for(uint32_t i = 0; i < batch_count; i++){
+          format_char(&fmt, ' ');
+          format_uint(&fmt, batch[i]);
+      }
+      format_char(&fmt, '\n');
+      if(!ble_write_owned((uint8_t *)light_msg, fmt.len, SI1133_TX_DONE_CB)){
+          return false;
+      }
+      light_msg_busy = true;
+  }
+  batch_count = 0;
+  sw_timer_stop(&batch_timer);
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the batch once its oldest reading is APP_BATCH_DEADLINE_MS old
+ *
+ *
+ * @details
+ * If the batch can't be sent yet it is tried again a sample period later.
+ *
+ *
+ * @note
+ * Posted by the batch timer, started by the first reading of a batch
+ ******************************************************************************/
+void scheduled_batch_timer_cb(void){
+  PROFILE_ENTER(PROF_BATCH_TIMER_CB);
+  if(batch_count && !app_batch_flush()){
+      sw_timer_start(&batch_timer, APP_SAMPLE_PER_MS, 0, BATCH_TIMER_CB);
+  }
+  PROFILE_EXIT(PROF_BATCH_TIMER_CB);
 }
 
 
 /***************************************************************************//**
  * @brief
  * This is a call back that is called upon start up. If needed it
- * runs the ble test. After, it transmits hello world then starts the LETIMER.
+ * runs the ble test. After, it transmits hello world then starts the sampling.
  *
  *
  *
  * @details
- * If requested, sets the board name and then runs the ble test. Then, it transmits the
- * phrase "Hello World". Finally, it starts the LETIMER.
+ * Transmits the phrase "Hello World", or a boot frame in binary mode, then
+ * starts the report timer. If requested, the ble test that sets the board
+ * name is queued, and if APP_BLE_BAUDRATE is not the rate of the link, the
+ * change of rate. Both run after "Hello World" is out, and ble.c keeps
+ * reports back until they are done. The Si1133 is still being configured in the
+ * background.
  *
  *
  *
@@ -271,32 +478,321 @@ void scheduled_si1133_read_cb(void){
  *
  ******************************************************************************/
 void scheduled_boot_up_cb(void){
+  if(ble_get_format() == BLE_FORMAT_BINARY){
+      ble_write_frame(APP_FRAME_BOOT, NULL, 0);
+  }
+  else{
+      char data[12] = "Hello World\0";
+      ble_write(data);
+  }
+  sw_timer_start(&report_timer, APP_REPORT_PER_MS, APP_REPORT_PER_MS, REPORT_TIMER_CB);
   #ifdef BLE_TEST_ENABLED
-  char ble_name[13] =  "TannerCoolBrd";
-  EFM_ASSERT(ble_test(ble_name));
-  timer_delay(2000);
+  char ble_name[BLE_AT_MAX_NAME + 1] = "TannerCoolBd";
+  bool queued = ble_test(ble_name, BLE_TEST_DONE_CB);
+  EFM_ASSERT(queued);
   #endif
-  char data[12] = "Hello World\0";
-  ble_write(data);
-  letimer_start(LETIMER0, true);  //This command will initiate the start of the LETIMER0
+  if(ble_get_baud() != APP_BLE_BAUDRATE){
+      bool started = ble_set_baud(APP_BLE_BAUDRATE, BLE_BAUD_DONE_CB);
+      EFM_ASSERT(started);    //APP_BLE_BAUDRATE is not a rate the module takes
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reports the rate the BLE link ended up at
+ *
+ *
+ * @details
+ * Only sent in text mode. The rate is the old one if the module did not
+ * take APP_BLE_BAUDRATE, and is marked failed if the module stopped
+ * answering at it.
+ *
+ *
+ * @note
+ * Posted by ble_set_baud once the link is up again
+ ******************************************************************************/
+void scheduled_ble_baud_done_cb(void){
+  char msg[APP_MSG_SIZE];
+  FORMAT_BUFFER fmt;
+
+  if(ble_get_format() == BLE_FORMAT_BINARY){
+      return;
+  }
+  format_open(&fmt, msg, APP_MSG_SIZE);
+  format_string(&fmt, "baud ");
+  format_uint(&fmt, ble_get_baud());
+  if(ble_baud_failed()){
+      format_string(&fmt, " failed");
+  }
+  format_char(&fmt, '\n');
+  ble_write(msg);
+}
+/***************************************************************************//**
+ * @brief
+ * Collects the results of ble_test
+ *
+ *
+ * @details
+ * Once all BLE_TEST_COMMANDS are in, reports in text mode whether any of
+ * them failed. A failed test no longer stops the board, the link still
+ * works if only the name was not taken.
+ *
+ *
+ * @note
+ * Queued handler of BLE_TEST_DONE_CB, posted by the AT queue in ble.c
+ *
+ * @param[in] result
+ * The BLE_AT_RESULT of one command.
+ ******************************************************************************/
+void scheduled_ble_test_done_cb(uint32_t result){
+  if(result != BLE_AT_OK){
+      ble_test_failed = true;
+  }
+  if(++ble_test_results < BLE_TEST_COMMANDS){
+      return;
+  }
+  if(ble_get_format() != BLE_FORMAT_BINARY){
+      ble_write(ble_test_failed ? "ble test failed\n" : "ble test ok\n");
+  }
+  ble_test_results = 0;
+  ble_test_failed = false;
+}
 
+/***************************************************************************//**
+ * @brief
+ * Frees the z message buffer
+ *
+ *
+ * @details
+ * Posted by the LEUART once the last byte of z_msg has been sent, so the next
+ * z can be written into it.
+ *
+ *
+ * @note
+ * Release event passed to ble_write_owned for z_msg
+ *
+ ******************************************************************************/
+void scheduled_ble_tx_done_cb(void){
+  z_msg_busy = false;
 }
+
 /***************************************************************************//**
  * @brief
- * Not used in this applications
+ * Frees the light batch message buffer
  *
  *
  * @details
+ * Posted by the LEUART once the last byte of light_msg has been sent, so the
+ * next batch can be written into it.
+ *
+ *
+ * @note
+ * Release event passed to ble_write_owned for light_msg
+ *
+ ******************************************************************************/
+void scheduled_si1133_tx_done_cb(void){
+  light_msg_busy = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reports a Si1133 transfer that failed after all of its retries
+ *
+ *
+ * @details
+ * Sends the I2C_ERROR as an error frame or a line of text. The failed reading
+ * is just missing. If it was the result read the Si1133 INT pin is still low
+ * and would never make another edge, so the read is tried again.
+ *
+ *
+ * @note
+ * Posted by the I2C driver in place of the transfer's call back
+ *
+ ******************************************************************************/
+void scheduled_si1133_error_cb(void){
+  int32_t error = (int32_t)Si1133_last_error();
+  char msg[APP_MSG_SIZE];
+  FORMAT_BUFFER fmt;
+
+  if(ble_get_format() == BLE_FORMAT_BINARY){
+      ble_write_frame(APP_FRAME_ERROR, &error, 1);
+  }
+  else{
+      format_open(&fmt, msg, APP_MSG_SIZE);
+      format_string(&fmt, "si1133 i2c error ");
+      format_int(&fmt, error);
+      format_char(&fmt, '\n');
+      ble_write(msg);
+  }
+
+  if(Si1133_int_pending()){
+      Si1133_request_result(SI1133_REG_READ_CB);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads a frame that was sent to the board over BLE
+ *
  *
+ * @details
+ * The LEUART only posts this event once a whole "#...!" frame is in its
+ * receive ring. Every frame is read out so the ring does not fill up.
+ * APP_CMD_STATS is answered with the sleep stats and APP_CMD_PROFILE with the
+ * profile, unless one is still going out, or with "profile off" when built
+ * without PROFILE_ENABLED. Other frames are ignored.
  *
  *
  * @note
+ * Called when the BLE receive done event is posted
+ *
+ ******************************************************************************/
+void scheduled_ble_rx_done_cb(void){
+  char frame[BLE_RX_MAX_FRAME];
+
+  while(ble_read(frame, BLE_RX_MAX_FRAME)){
+      if(!strcmp(frame, APP_CMD_STATS)){
+          app_sleep_stats_report();
+      }
+#if PROFILE_ENABLED
+      else if(!strcmp(frame, APP_CMD_PROFILE) && profile_next == PROFILE_REGIONS){
+          profile_next = 0;
+          app_profile_send();
+      }
+#else
+      else if(!strcmp(frame, APP_CMD_PROFILE)){
+          ble_write("profile off\n");
+      }
+#endif
+  }
+}
+
+#if PROFILE_ENABLED
+/***************************************************************************//**
+ * @brief
+ * Sends the profile of the next region
+ *
+ *
+ * @details
+ * In text mode one line goes out of profile_msg and PROFILE_TX_DONE_CB sends
+ * the line after it, so the whole report never has to fit in the LEUART
+ * ring. Binary frames are small and all go at once.
  *
  *
+ * @note
+ * Called for APP_CMD_PROFILE and by scheduled_profile_tx_done_cb
+ *
  ******************************************************************************/
+static void app_profile_send(void){
+  PROFILE_STATS stats;
+  int32_t values[5];
+  FORMAT_BUFFER fmt;
+  uint32_t mean;
 
+  while(profile_next < PROFILE_REGIONS){
+      profile_get(profile_next, &stats);
+      mean = stats.count ? (uint32_t)(stats.total / stats.count) : 0;
 
+      if(ble_get_format() == BLE_FORMAT_BINARY){
+          values[0] = (int32_t)profile_next;
+          values[1] = (int32_t)stats.count;
+          values[2] = (int32_t)stats.min;
+          values[3] = (int32_t)stats.max;
+          values[4] = (int32_t)mean;
+          ble_write_frame(APP_FRAME_PROFILE, values, 5);
+          profile_next++;
+          continue;
+      }
 
-void scheduled_ble_tx_done_cb(void){
+      format_open(&fmt, profile_msg, APP_PROFILE_MSG_SIZE);
+      format_string(&fmt, profile_name(profile_next));
+      format_string(&fmt, " n=");
+      format_uint(&fmt, stats.count);
+      format_string(&fmt, " min=");
+      format_uint(&fmt, stats.min);
+      format_string(&fmt, " max=");
+      format_uint(&fmt, stats.max);
+      format_string(&fmt, " avg=");
+      format_uint(&fmt, mean);
+      format_char(&fmt, '\n');
+      if(ble_write_owned((uint8_t *)profile_msg, fmt.len, PROFILE_TX_DONE_CB)){
+          profile_next++;
+      }
+      else{
+          profile_next = PROFILE_REGIONS;     //queue full, drop the rest of the report
+      }
+      return;
+  }
+}
 
+/***************************************************************************//**
+ * @brief
+ * Sends the next line of the profile report
+ *
+ *
+ * @note
+ * Release event passed to ble_write_owned for profile_msg
+ *
+ ******************************************************************************/
+void scheduled_profile_tx_done_cb(void){
+  app_profile_send();
+}
+#endif
+
+/***************************************************************************//**
+ * @brief
+ * Sends the energy mode residency and the time each sleep block was held
+ *
+ *
+ * @details
+ * Everything is in ms since sleep_stats_reset. A block held for a long time
+ * by a tag whose mode is shallow, like the LEUART transmitter keeping the
+ * board out of EM3, is where the battery goes.
+ *
+ *
+ * @note
+ * Called in scheduled_ble_rx_done_cb for APP_CMD_STATS
+ *
+ ******************************************************************************/
+static void app_sleep_stats_report(void){
+  static const char *tag_names[SLEEP_TAGS] = {"sys", "tx", "rx", "i2c0", "i2c1", "letimer", "leclk"};
+  SLEEP_STATS stats;
+  int32_t values[1 + EM4 + SLEEP_TAGS];
+  uint32_t count = 0;
+  char msg[APP_STATS_MSG_SIZE];
+  FORMAT_BUFFER fmt;
+
+  sleep_stats_get(&stats);
+  if(ble_get_format() == BLE_FORMAT_BINARY){
+      values[count++] = (int32_t)stats.elapsed_ms;
+      for(uint32_t em = EM0; em < EM4; em++){
+          values[count++] = (int32_t)stats.residency_ms[em];
+      }
+      for(uint32_t tag = 0; tag < SLEEP_TAGS; tag++){
+          values[count++] = (int32_t)stats.held_ms[tag];
+      }
+      ble_write_frame(APP_FRAME_SLEEP, values, count);
+      return;
+  }
+
+  format_open(&fmt, msg, APP_STATS_MSG_SIZE);
+  format_string(&fmt, "ms ");
+  format_uint(&fmt, stats.elapsed_ms);
+  for(uint32_t em = EM0; em < EM4; em++){
+      format_string(&fmt, " em");
+      format_uint(&fmt, em);
+      format_char(&fmt, ' ');
+      format_uint(&fmt, stats.residency_ms[em]);
+  }
+  format_string(&fmt, "\nheld");
+  for(uint32_t tag = 0; tag < SLEEP_TAGS; tag++){
+      format_char(&fmt, ' ');
+      format_string(&fmt, tag_names[tag]);
+      format_string(&fmt, " em");
+      format_uint(&fmt, stats.em[tag]);
+      format_char(&fmt, ' ');
+      format_uint(&fmt, stats.held_ms[tag]);
+  }
+  format_char(&fmt, '\n');
+  ble_write(msg);
 }
@@ -17,11 +17,24 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define BLE_BAUD_RATES    9
 
 
 //***********************************************************************************
 // private variables
 //***********************************************************************************
+static BLE_FORMAT ble_format;
+static uint8_t ble_sequence;
+static BLE_AT_STATE_MACHINE ble_at;
+static BLE_BAUD_STATE_MACHINE ble_baud;
+static BLE_LINK_STATE_MACHINE ble_link;
+static char ble_flush_msg[BLE_BACKLOG_MAX_MSG];
+
+// AT+BAUD parameter to rate. 1200 is left out, the module stops taking AT
+// commands at that rate.
+static const uint32_t ble_baud_table[BLE_BAUD_RATES] = {
+    9600, 19200, 38400, 57600, 115200, 4800, 2400, 0, 230400
+};
 
 /***************************************************************************//**
  * @brief BLE module
@@ -38,6 +51,680 @@
 // Private functions
 //***********************************************************************************
 
+static void ble_baud_step(BLE_AT_RESULT result);
+
+/***************************************************************************//**
+ * @brief
+ * Appends value to a frame as a zigzag varint
+ *
+ * @details
+ * Zigzag maps small negative numbers to small positive ones (0, -1, 1, -2 ...
+ * become 0, 1, 2, 3 ...) so both fit in one varint byte. Each varint byte holds
+ * 7 bits, least significant first, with the top bit set when more follow.
+ *
+ * @param[out] out
+ * Where the varint is written, at least BLE_VARINT_MAX bytes.
+ *
+ * @param[in] value
+ * The value to encode.
+ *
+ * @return
+ * Number of bytes written.
+ ******************************************************************************/
+static uint32_t ble_put_varint(uint8_t *out, int32_t value){
+  uint32_t zigzag;
+  uint32_t count = 0;
+
+  if(value < 0){
+      zigzag = ~((uint32_t)value << 1);
+  }
+  else{
+      zigzag = (uint32_t)value << 1;
+  }
+  while(zigzag >= 0x80){
+      out[count++] = (uint8_t)(zigzag | 0x80);
+      zigzag >>= 7;
+  }
+  out[count++] = (uint8_t)zigzag;
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ * CRC-8 with polynomial BLE_FRAME_CRC_POLY and an initial value of 0
+ *
+ * @details
+ * Done a bit at a time instead of with a table, frames are short and this
+ * keeps 256 bytes out of flash.
+ *
+ * @param[in] data
+ * The bytes to check.
+ *
+ * @param[in] len
+ * Number of bytes in data.
+ *
+ * @return
+ * The CRC.
+ ******************************************************************************/
+static uint8_t ble_crc8(const uint8_t *data, uint32_t len){
+  uint8_t crc = 0;
+
+  for(uint32_t i = 0; i < len; i++){
+      crc ^= data[i];
+      for(int bit = 0; bit < 8; bit++){
+          if(crc & 0x80){
+              crc = (uint8_t)((crc << 1) ^ BLE_FRAME_CRC_POLY);
+          }
+          else{
+              crc = (uint8_t)(crc << 1);
+          }
+      }
+  }
+  return crc;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Moves a match of pattern on by one byte
+ *
+ * @details
+ * A byte that breaks the match starts it over, so what is left of a longer
+ * reply than expected, like the "+LOST" of OK+LOST when AT breaks a
+ * connection, never spoils the next match.
+ *
+ * @param[in] pattern
+ * What to look for.
+ *
+ * @param[in,out] matched
+ * Bytes of pattern seen so far, back to 0 on a full match.
+ *
+ * @param[in] byte
+ * The byte received.
+ *
+ * @return
+ * true when byte completes pattern.
+ ******************************************************************************/
+static bool ble_match(const char *pattern, uint32_t *matched, char byte){
+  if(byte != pattern[*matched]){
+      *matched = 0;
+  }
+  if(byte == pattern[*matched]){
+      (*matched)++;
+      if(!pattern[*matched]){
+          *matched = 0;
+          return true;
+      }
+  }
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Watches the bytes the module sends outside "#...!" frames
+ *
+ * @details
+ * BLE_NOTI_CONN and BLE_NOTI_LOST move the connection state and post
+ * link_evt. While an AT command waits, its reply is matched too and
+ * BLE_AT_OK is posted to at_evt once all of expect has been seen, unless the
+ * timeout got there first.
+ *
+ * While disconnected the module only sends its replies and notifications, so
+ * the receiver stays unblocked. While connected, a byte that is not part of
+ * a notification or of a reply being waited for is the central's, sent
+ * outside a frame. The receiver is then blocked, so the rest of it wakes
+ * nothing, until the central's next start frame or the next AT command. A
+ * BLE_NOTI_LOST sent while it is blocked is missed, and the link is taken as
+ * connected until then.
+ *
+ * @note
+ * Runs in the LEUART interrupt, set with leuart_rx_monitor by ble_open. The
+ * command at the tail is not touched by the main loop while waiting.
+ *
+ * @param[in] context
+ * Not used.
+ *
+ * @param[in] byte
+ * The byte received.
+ *
+ * @return
+ * false to block the receiver.
+ ******************************************************************************/
+static bool ble_rx_monitor(void *context, char byte){
+  bool matched = ble_at.waiting;
+  (void)context;
+
+  if(ble_match(BLE_NOTI_CONN, &ble_link.conn_matched, byte)){
+      ble_link.connected = true;
+      add_scheduled_event(ble_link.link_evt);
+      matched = true;
+  }
+  if(ble_match(BLE_NOTI_LOST, &ble_link.lost_matched, byte)){
+      ble_link.connected = false;
+      add_scheduled_event(ble_link.link_evt);
+      matched = true;
+  }
+  if(ble_at.waiting &&
+     ble_match(ble_at.queue[ble_at.tail & BLE_AT_QUEUE_MASK].expect, &ble_at.matched, byte)){
+      ble_at.waiting = false;
+      scheduler_post(ble_at.at_evt, BLE_AT_OK);
+  }
+  return matched || ble_link.conn_matched || ble_link.lost_matched || !ble_link.connected;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the command at the tail of the queue and starts waiting for its reply
+ *
+ * @details
+ * Matching starts before the command goes out so a fast reply is not
+ * missed. The reply is BLE_AT_OK on at_evt or the timeout on
+ * at_timeout_evt. If the command does not fit in the transmit ring it counts
+ * as a timeout right away.
+ ******************************************************************************/
+static void ble_at_send(void){
+  BLE_AT_COMMAND *command = &ble_at.queue[ble_at.tail & BLE_AT_QUEUE_MASK];
+
+  ble_at.state = ble_at_wait;
+  ble_at.matched = 0;
+  ble_at.waiting = true;
+  leuart_rx_monitor(HM10_LEUART0, ble_rx_monitor, NULL);     //unblocks the receiver for the reply
+  if(!leuart_start(HM10_LEUART0, command->cmd, strlen(command->cmd))){
+      ble_at.waiting = false;
+      scheduler_post(ble_at.at_evt, BLE_AT_TIMEOUT);
+      return;
+  }
+  sw_timer_start(&ble_at.timer, command->timeout_ms, 0, ble_at.at_timeout_evt);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the command at the tail of the queue if nothing is running
+ *
+ * @details
+ * The command waits out its delay first, the module needs a quiet line to
+ * tell where the last command or message ended.
+ ******************************************************************************/
+static void ble_at_next(void){
+  if((ble_at.state != ble_at_idle) || (ble_at.tail == ble_at.head)){
+      return;
+  }
+  ble_at.state = ble_at_delay;
+  sw_timer_start(&ble_at.timer, ble_at.queue[ble_at.tail & BLE_AT_QUEUE_MASK].delay_ms, 0, ble_at.at_timeout_evt);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts a command in the AT queue and starts it if the queue was empty
+ *
+ * @param[in] cmd
+ * The command, the HM-18 wants no line ending.
+ *
+ * @param[in] expect
+ * The reply, or the start of it.
+ *
+ * @param[in] delay_ms
+ * Quiet time before cmd is sent, raised to BLE_AT_GAP_MS.
+ *
+ * @param[in] timeout_ms
+ * How long to wait for the reply once cmd is sent.
+ *
+ * @param[in] done_evt
+ * Posted with the BLE_AT_RESULT, unless handler is set.
+ *
+ * @param[in] handler
+ * Gets the result instead of done_evt, for commands of ble.c itself.
+ *
+ * @return
+ * false if the queue is full or cmd or expect is too long.
+ ******************************************************************************/
+static bool ble_at_push(const char *cmd, const char *expect, uint32_t delay_ms, uint32_t timeout_ms, uint32_t done_evt, BLE_AT_HANDLER handler){
+  BLE_AT_COMMAND *command;
+
+  if(((ble_at.head - ble_at.tail) == BLE_AT_QUEUE_SIZE) ||
+     (strlen(cmd) >= BLE_AT_MAX_CMD) || (strlen(expect) >= BLE_AT_MAX_REPLY)){
+      return false;
+  }
+  command = &ble_at.queue[ble_at.head & BLE_AT_QUEUE_MASK];
+  strcpy(command->cmd, cmd);
+  strcpy(command->expect, expect);
+  command->delay_ms = (delay_ms > BLE_AT_GAP_MS) ? delay_ms : BLE_AT_GAP_MS;
+  command->timeout_ms = timeout_ms;
+  command->done_evt = done_evt;
+  command->handler = handler;
+  command->baudrate = 0;
+  ble_at.head++;
+
+  ble_at_next();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Tells whether the link is busy with the module
+ *
+ * @details
+ * Anything written while AT commands are queued would run into them on the
+ * line, and the module would take it all for one bad command.
+ *
+ * @return
+ * true while AT commands are queued or ble_set_baud is running.
+ ******************************************************************************/
+static bool ble_at_busy(void){
+  return (ble_at.tail != ble_at.head) || (ble_baud.state != ble_baud_idle);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Looks up the AT+BAUD parameter for a rate
+ *
+ * @param[in] baudrate
+ * The rate.
+ *
+ * @return
+ * The parameter, or -1 if the module cannot be set to baudrate.
+ ******************************************************************************/
+static int32_t ble_baud_index(uint32_t baudrate){
+  for(int32_t i = 0; i < BLE_BAUD_RATES; i++){
+      if(baudrate && (ble_baud_table[i] == baudrate)){
+          return i;
+      }
+  }
+  return -1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues a ble_set_baud step, sent with LEUART0 at link_rate
+ *
+ * @details
+ * The LEUART is moved to link_rate by ble_at_timeout_cb at the end of the
+ * command's delay, once the transmitter is idle.
+ *
+ * @param[in] cmd
+ * The command.
+ *
+ * @param[in] expect
+ * The reply, or the start of it.
+ *
+ * @param[in] delay_ms
+ * Quiet time before cmd is sent.
+ *
+ * @param[in] link_rate
+ * LEUART0 rate cmd goes out at.
+ *
+ * @return
+ * false if the AT queue is full.
+ ******************************************************************************/
+static bool ble_baud_push(const char *cmd, const char *expect, uint32_t delay_ms, uint32_t link_rate){
+  if(!ble_at_push(cmd, expect, delay_ms, BLE_AT_TIMEOUT_MS, 0, ble_baud_step)){
+      return false;
+  }
+  ble_at.queue[(ble_at.head - 1) & BLE_AT_QUEUE_MASK].baudrate = link_rate;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues AT+BAUD for baudrate, expecting OK+Set: with the same parameter
+ *
+ * @param[in] baudrate
+ * A rate in ble_baud_table.
+ *
+ * @param[in] link_rate
+ * LEUART0 rate the command goes out at.
+ *
+ * @return
+ * false if the AT queue is full.
+ ******************************************************************************/
+static bool ble_baud_command(uint32_t baudrate, uint32_t link_rate){
+  char cmd[BLE_AT_MAX_CMD] = "AT+BAUD";
+  char expect[BLE_AT_MAX_REPLY] = "OK+Set:";
+  char param[2];
+  int32_t index = ble_baud_index(baudrate);
+
+  EFM_ASSERT(index >= 0);
+  param[0] = (char)('0' + index);
+  param[1] = 0;
+  strcat(cmd, param);
+  strcat(expect, param);
+  return ble_baud_push(cmd, expect, 0, link_rate);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends ble_set_baud and posts its done event
+ *
+ * @param[in] failed
+ * The module did not answer at the rate LEUART0 is left at.
+ ******************************************************************************/
+static void ble_baud_finish(bool failed){
+  ble_baud.state = ble_baud_idle;
+  ble_baud.failed = failed;
+  add_scheduled_event(ble_baud.done_evt);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Advances ble_set_baud with the result of the last command
+ *
+ * @details
+ * OK+Set: is only stored by the module, it changes rate when it restarts,
+ * so AT+RESET follows. A missing OK+RESET does not mean the module kept its
+ * rate, so either way the LEUART moves to the new rate and AT is sent after
+ * BLE_AT_RESET_MS to check the link.
+ *
+ * If the module is not at the new rate after that, the old rate is written
+ * back to it. AT+BAUD and AT+RESET go out at the new rate first, the rate
+ * the module is at if it restarted, and only then the LEUART goes back to the
+ * old rate to check the link again. If the module does not answer at the
+ * new rate at all it never restarted, so AT+BAUD with the old rate is sent at
+ * the old rate to undo the stored one. When nothing answers the change
+ * ends failed, with LEUART0 at the old rate.
+ *
+ * @note
+ * Handler of the commands ble_set_baud queues. Nothing else is queued while
+ * ble_set_baud runs, so the command just finished left a slot.
+ *
+ * @param[in] result
+ * The result of the last command.
+ ******************************************************************************/
+static void ble_baud_step(BLE_AT_RESULT result){
+  bool queued = true;
+
+  switch(ble_baud.state){
+    case ble_baud_set:
+      if(result == BLE_AT_OK){
+          ble_baud.state = ble_baud_reset;
+          queued = ble_baud_push("AT+RESET", "OK+RESET", 0, ble_baud.old_rate);
+      }
+      else{
+          ble_baud_finish(false);
+      }
+      break;
+    case ble_baud_reset:
+      ble_baud.state = ble_baud_verify;
+      queued = ble_baud_push("AT", "OK", BLE_AT_RESET_MS, ble_baud.new_rate);
+      break;
+    case ble_baud_verify:
+      if(result == BLE_AT_OK){
+          ble_baud_finish(false);
+      }
+      else{
+          ble_baud.state = ble_baud_revert_set;
+          queued = ble_baud_command(ble_baud.old_rate, ble_baud.new_rate);
+      }
+      break;
+    case ble_baud_revert_set:
+      if(result == BLE_AT_OK){
+          ble_baud.state = ble_baud_revert_reset;
+          queued = ble_baud_push("AT+RESET", "OK+RESET", 0, ble_baud.new_rate);
+      }
+      else{
+          ble_baud.state = ble_baud_restore;
+          queued = ble_baud_command(ble_baud.old_rate, ble_baud.old_rate);
+      }
+      break;
+    case ble_baud_revert_reset:
+      ble_baud.state = ble_baud_revert_verify;
+      queued = ble_baud_push("AT", "OK", BLE_AT_RESET_MS, ble_baud.old_rate);
+      break;
+    case ble_baud_revert_verify:
+    case ble_baud_restore:
+      ble_baud_finish(result != BLE_AT_OK);
+      break;
+    default:
+      EFM_ASSERT(false);
+      break;
+  }
+  EFM_ASSERT(queued);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Finishes the command at the tail of the queue and starts the next one
+ *
+ * @details
+ * The command is taken off the queue before its result is handed on, so a
+ * ble_set_baud step or the handler of done_evt can queue the next command.
+ * Once the queue is empty link_evt is posted to send what was kept back.
+ *
+ * @param[in] result
+ * The result of the command.
+ ******************************************************************************/
+static void ble_at_complete(BLE_AT_RESULT result){
+  BLE_AT_COMMAND *command = &ble_at.queue[ble_at.tail & BLE_AT_QUEUE_MASK];
+  uint32_t done_evt = command->done_evt;
+  BLE_AT_HANDLER handler = command->handler;
+
+  ble_at.state = ble_at_idle;
+  ble_at.tail++;
+  if(handler){
+      handler(result);
+  }
+  else if(done_evt){
+      scheduler_post(done_evt, result);
+  }
+  ble_at_next();
+  if(!ble_at_busy()){
+      add_scheduled_event(ble_link.link_evt);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Handles the reply to an AT command
+ *
+ * @note
+ * Queued handler of at_evt
+ *
+ * @param[in] result
+ * A BLE_AT_RESULT.
+ ******************************************************************************/
+static void ble_at_cb(uint32_t result){
+  if(ble_at.state != ble_at_wait){
+      return;
+  }
+  sw_timer_stop(&ble_at.timer);
+  ble_at_complete((BLE_AT_RESULT)result);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Handles the AT timer
+ *
+ * @details
+ * A timer that was started again since it expired is stale. At the end of
+ * the delay LEUART0 is moved to the command's rate if it has one, and the
+ * command is sent. The delay starts over by BLE_AT_GAP_MS if the transmitter
+ * is still busy with earlier messages, since neither can be done then. While waiting, a
+ * reply that came in first is already on its way to ble_at_cb and nothing is
+ * done, otherwise the command timed out.
+ *
+ * @note
+ * Handler of at_timeout_evt
+ ******************************************************************************/
+static void ble_at_timeout_cb(void){
+  bool timed_out;
+  bool ready;
+  uint32_t rate;
+
+  if(sw_timer_active(&ble_at.timer)){
+      return;
+  }
+  if(ble_at.state == ble_at_delay){
+      rate = ble_at.queue[ble_at.tail & BLE_AT_QUEUE_MASK].baudrate;
+      if(rate && (rate != leuart_baud_get(HM10_LEUART0))){
+          ready = leuart_baud_set(HM10_LEUART0, rate);
+      }
+      else{
+          ready = !leuart_tx_busy(HM10_LEUART0);
+      }
+      if(ready){
+          ble_at_send();
+      }
+      else{
+          sw_timer_start(&ble_at.timer, BLE_AT_GAP_MS, 0, ble_at.at_timeout_evt);
+      }
+      return;
+  }
+  if(ble_at.state != ble_at_wait){
+      return;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  timed_out = ble_at.waiting;
+  ble_at.waiting = false;
+  CORE_EXIT_CRITICAL();
+
+  if(timed_out){
+      ble_at_complete(BLE_AT_TIMEOUT);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts the byte at index of the backlog
+ *
+ * @param[in] index
+ * Free running index.
+ *
+ * @param[in] byte
+ * The byte.
+ ******************************************************************************/
+static void ble_backlog_write(uint32_t index, uint8_t byte){
+  ble_link.backlog[index & BLE_BACKLOG_MASK] = byte;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the length of the oldest message in the backlog
+ *
+ * @return
+ * Bytes in the message, not counting its length.
+ ******************************************************************************/
+static uint32_t ble_backlog_len(void){
+  return ble_link.backlog[ble_link.tail & BLE_BACKLOG_MASK] |
+         ((uint32_t)ble_link.backlog[(ble_link.tail + 1) & BLE_BACKLOG_MASK] << 8);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Keeps a message back until it can be sent
+ *
+ * @details
+ * The message goes in with its length in front. The oldest messages are
+ * dropped to make room, the newest telemetry is worth the most. Binary frames
+ * keep their sequence number so the host still sees the gap.
+ *
+ * @param[in] data
+ * The message.
+ *
+ * @param[in] len
+ * Bytes in data.
+ *
+ * @return
+ * false if the message is longer than BLE_BACKLOG_MAX_MSG and was dropped.
+ ******************************************************************************/
+static bool ble_backlog_put(const uint8_t *data, uint32_t len){
+  if((len > BLE_BACKLOG_MAX_MSG) || (len + BLE_BACKLOG_LEN > BLE_BACKLOG_SIZE)){
+      ble_link.dropped++;
+      return false;
+  }
+  while((BLE_BACKLOG_SIZE - (ble_link.head - ble_link.tail)) < (len + BLE_BACKLOG_LEN)){
+      ble_link.tail += BLE_BACKLOG_LEN + ble_backlog_len();
+      ble_link.dropped++;
+  }
+  ble_backlog_write(ble_link.head, (uint8_t)len);
+  ble_backlog_write(ble_link.head + 1, (uint8_t)(len >> 8));
+  for(uint32_t i = 0; i < len; i++){
+      ble_backlog_write(ble_link.head + BLE_BACKLOG_LEN + i, data[i]);
+  }
+  ble_link.head += BLE_BACKLOG_LEN + len;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends what was kept back, oldest first
+ *
+ * @details
+ * Each message is copied out of the backlog into the transmit ring. When the
+ * ring is full the rest is tried again after BLE_BACKLOG_RETRY_MS.
+ *
+ * @note
+ * Only called while connected and no AT commands are queued.
+ ******************************************************************************/
+static void ble_backlog_flush(void){
+  uint32_t len;
+
+  while(ble_link.tail != ble_link.head){
+      len = ble_backlog_len();
+      for(uint32_t i = 0; i < len; i++){
+          ble_flush_msg[i] = (char)ble_link.backlog[(ble_link.tail + BLE_BACKLOG_LEN + i) & BLE_BACKLOG_MASK];
+      }
+      if(!leuart_start(HM10_LEUART0, ble_flush_msg, len)){
+          sw_timer_start(&ble_link.timer, BLE_BACKLOG_RETRY_MS, 0, ble_link.link_evt);
+          return;
+      }
+      ble_link.tail += BLE_BACKLOG_LEN + len;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Tells whether a message can go straight to the LEUART
+ *
+ * @return
+ * true while connected, no AT commands are queued and nothing is kept back,
+ * so messages stay in order.
+ ******************************************************************************/
+static bool ble_link_open(void){
+  return ble_link.connected && !ble_at_busy() && (ble_link.tail == ble_link.head);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the backlog once the link is open again
+ *
+ * @note
+ * Handler of link_evt, posted on BLE_NOTI_CONN and BLE_NOTI_LOST, when the AT
+ * queue empties and by the backlog retry timer
+ ******************************************************************************/
+static void ble_link_cb(void){
+  if(ble_link.connected && !ble_at_busy()){
+      ble_backlog_flush();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Takes the module's answer to the AT sent by ble_open
+ *
+ * @details
+ * AT from the LEUART breaks a connection. The module answers OK, or OK+LOST
+ * if a central was connected, and takes AT commands after either. So
+ * AT+NOTI1 goes out only once the module is known to be disconnected, and
+ * never reaches a central as data. Without a reply the module is not
+ * answering and nothing more is sent.
+ *
+ * @param[in] result
+ * The result of AT.
+ ******************************************************************************/
+static void ble_noti_step(BLE_AT_RESULT result){
+  bool queued;
+
+  if(result != BLE_AT_OK){
+      return;
+  }
+  queued = ble_at_push("AT+NOTI1", "OK+Set:1", 0, BLE_AT_TIMEOUT_MS, 0, NULL);
+  EFM_ASSERT(queued);     //the AT just finished left a slot
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
 /***************************************************************************//**
  * @brief
  * This is the open function for ble
@@ -45,23 +732,47 @@
  *
  *  @details
  *  This function initializes a local open struct for the leuart. It initializes the
- *  members of the struct to the values. It then calls LEUART with the local struct we initialized.
+ *  members of the struct to the values. The receiver is set up to start a frame on
+ *  BLE_RX_STARTFRAME and to post rx_event on BLE_RX_SIGFRAME. It then calls LEUART
+ *  with the local struct we initialized. The receiver is unblocked for the
+ *  receive monitor, which gets the module's AT replies and connection
+ *  notifications, see ble_rx_monitor. AT is queued to find the module
+ *  disconnected, breaking a connection made before the board started, then
+ *  AT+NOTI1 to turn the notifications on. The link starts out disconnected.
+ *  The AT and link events are registered here, ble.c handles them itself.
  *
  * @note
- * called in app peripheral setup
- *
- * @param[in] tx_event
- * This is the callback event for tx_event
- *
- * @param[in] rx_event
- * This is the callback event for rx_event
+ * called in app peripheral setup, after sw_timer_open
  *
+ * @param[in] ble_settings
+ * The events and the format, text with ble_write or binary frames with
+ * ble_write_frame, see ble_get_format.
  *
  ******************************************************************************/
 
-void ble_open(uint32_t tx_event, uint32_t rx_event){
+void ble_open(BLE_OPEN_STRUCT *ble_settings){
   LEUART_OPEN_STRUCT leuart_struct_open;
 
+    ble_format = ble_settings->format;
+    ble_sequence = 0;
+    ble_baud.state = ble_baud_idle;
+    ble_at.head = 0;
+    ble_at.tail = 0;
+    ble_at.state = ble_at_idle;
+    ble_at.waiting = false;
+    ble_at.at_evt = ble_settings->at_evt;
+    ble_at.at_timeout_evt = ble_settings->at_timeout_evt;
+    scheduler_register_queued(ble_settings->at_evt, ble_at_cb, ble_settings->at_prio);
+    scheduler_register(ble_settings->at_timeout_evt, ble_at_timeout_cb, ble_settings->at_timeout_prio);
+    ble_link.head = 0;
+    ble_link.tail = 0;
+    ble_link.dropped = 0;
+    ble_link.connected = false;        //the AT below breaks any connection, OK+CONN says when it is back
+    ble_link.conn_matched = 0;
+    ble_link.lost_matched = 0;
+    ble_link.link_evt = ble_settings->link_evt;
+    scheduler_register(ble_settings->link_evt, ble_link_cb, ble_settings->link_prio);
+
     timer_delay(25); //delays 25 milliseconds for start up of si1133
 
     leuart_struct_open.baudrate = HM10_BAUDRATE;
@@ -69,22 +780,26 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
     leuart_struct_open.enable = HM10_ENABLE;
     leuart_struct_open.parity = HM10_PARITY;
     leuart_struct_open.refFreq = HM10_REFFREQ;
-    leuart_struct_open.rx_done_evt = rx_event;
+    leuart_struct_open.rx_done_evt = ble_settings->rx_evt;
     leuart_struct_open.rx_en = LEUART_RX_DEFAULT;
     leuart_struct_open.rx_loc = LEUART_RX_ROUTE_LOC;
     leuart_struct_open.rx_pin_en = LEUART_DEFAULT;
-    //leuart_struct_open.rxblocken = XX;
-    //leuart_struct_open.sfubrx = XX;
-    //leuart_struct_open.sigframe = XX;
-    //leuart_struct_open.sigframe_en = XX;
-    //leuart_struct_open.startframe = XX;
+    leuart_struct_open.rxblocken = true;
+    leuart_struct_open.sfubrx = true;
+    leuart_struct_open.sigframe = BLE_RX_SIGFRAME;
+    leuart_struct_open.sigframe_en = true;
+    leuart_struct_open.startframe = BLE_RX_STARTFRAME;
+    leuart_struct_open.startframe_en = true;
     leuart_struct_open.stopbits = HM10_STOPBITS;
-    leuart_struct_open.tx_done_evt = tx_event;
+    leuart_struct_open.tx_done_evt = ble_settings->tx_evt;
     leuart_struct_open.tx_en = LEUART_TX_DEFAULT;
+    leuart_struct_open.tx_dma_en = BLE_TX_DMA;
     leuart_struct_open.tx_loc = LEUART_TX_ROUTE_LOC;
     leuart_struct_open.tx_pin_en = LEUART_TX_DEFAULT;
 
     leuart_open(HM10_LEUART0,&leuart_struct_open);
+    leuart_rx_monitor(HM10_LEUART0, ble_rx_monitor, NULL);
+    ble_at_push("AT", "OK", 0, BLE_AT_TIMEOUT_MS, 0, ble_noti_step);
 
 
 }
@@ -97,223 +812,351 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
  *
  *
  *  @details
- *  Takes the lengths of the string, then calls leuart_start.
+ *  Takes the lengths of the string, then calls leuart_start which queues it in
+ *  the LEUART transmit ring. This never waits for an earlier message to finish.
+ *  While no central is connected, or AT commands are queued, the string goes
+ *  to the backlog instead and is sent once the link is open again.
  *
  * @note
  * N/A
  *
  * @param[in] string
  * This is the string we want to transmit to the device.
+ *
+ * @return
+ * true if the string was queued or kept back, false if the transmit ring
+ * would overflow and the string was dropped.
  ******************************************************************************/
 
-void ble_write(char* string){
+bool ble_write(char* string){
   size_t len = strlen(string);
-  leuart_start(LEUART0, string, len);
+  if(!ble_link_open()){
+      return ble_backlog_put((uint8_t *)string, len);
+  }
+  return leuart_start(LEUART0, string, len);
 
 }
 
 /***************************************************************************//**
  * @brief
- *   BLE Test performs two functions.  First, it is a Test Driven Development
- *   routine to verify that the LEUART is correctly configured to communicate
- *   with the BLE HM-18 module.  Second, the input argument passed to this
- *   function will be written into the BLE module and become the new name
- *   advertised by the module while it is looking to pair.
+ * Writes to the ble straight out of the caller's buffer
+ *
+ *
+ *  @details
+ *  Calls leuart_start_owned which queues the buffer without copying it. The
+ *  buffer is in the same order as strings from ble_write. When the link is
+ *  not open the buffer is copied to the backlog and released right away,
+ *  release_evt is posted even if the backlog could not keep it.
+ *
+ * @note
+ * The caller must not change data until release_evt is posted.
+ *
+ * @param[in] data
+ * The bytes we want to transmit to the device.
+ *
+ * @param[in] len
+ * Number of bytes in data.
+ *
+ * @param[in] release_evt
+ * Scheduler event posted when data can be reused.
+ *
+ * @return
+ * true if the buffer was queued or kept back, false if the transmit queue
+ * was full or it is longer than BLE_BACKLOG_MAX_MSG with the link not open.
+ ******************************************************************************/
+
+bool ble_write_owned(const uint8_t *data, uint32_t len, uint32_t release_evt){
+  bool kept;
+
+  if(!ble_link_open()){
+      kept = ble_backlog_put(data, len);
+      add_scheduled_event(release_evt);
+      return kept;
+  }
+  return leuart_start_owned(LEUART0, data, len, release_evt);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the format passed to ble_open
+ *
  *
  * @details
- * 	 This global function will use polling functions provided by the LEUART
- * 	 driver for both transmit and receive to validate communications with
- * 	 the HM-18 BLE module.  For the assignment, the communication with the
- * 	 BLE module must use low energy design principles of being an interrupt
- * 	 driven state machine.
+ * The application uses this to decide between ble_write and ble_write_frame,
+ * the two should not be mixed on the same link.
+ *
+ * @return
+ * The format the link was opened with.
+ ******************************************************************************/
+
+BLE_FORMAT ble_get_format(void){
+  return ble_format;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes a binary telemetry frame to the ble
+ *
+ *
+ *  @details
+ *  Builds BLE_FRAME_SYNC, type, sequence number, payload length, the values
+ *  as zigzag varints, and a CRC-8 over everything after the sync byte, then
+ *  queues it with leuart_start, or keeps it back like ble_write. A reading
+ *  that takes ~25 characters as text is 6 or 7 bytes as a frame. The
+ *  sequence number goes up by one per frame queued so the host can count
+ *  dropped frames.
  *
  * @note
- *   For this test to run to completion, the phone most not be paired with
- *   the BLE module.  In addition for the name to be stored into the module
- *   a breakpoint must be placed at the end of the test routine and stopped
- *   at this breakpoint while in the debugger for a minimum of 5 seconds.
+ * Only used when the link was opened with BLE_FORMAT_BINARY.
+ *
+ * @param[in] type
+ * Application defined frame type.
+ *
+ * @param[in] values
+ * The values to send.
+ *
+ * @param[in] count
+ * Number of values, at most BLE_FRAME_MAX_VALUES.
+ *
+ * @return
+ * true if the frame was queued or kept back, false if the transmit ring would
+ * overflow.
+ ******************************************************************************/
+
+bool ble_write_frame(uint8_t type, const int32_t *values, uint32_t count){
+  uint8_t frame[BLE_FRAME_MAX];
+  uint32_t len = BLE_FRAME_HEADER;
+
+  EFM_ASSERT(count <= BLE_FRAME_MAX_VALUES);
+  for(uint32_t i = 0; i < count; i++){
+      len += ble_put_varint(&frame[len], values[i]);
+  }
+  frame[0] = BLE_FRAME_SYNC;
+  frame[1] = type;
+  frame[2] = ble_sequence;
+  frame[3] = (uint8_t)(len - BLE_FRAME_HEADER);
+  frame[len] = ble_crc8(&frame[1], len - 1);
+  len++;
+
+  if(ble_link_open()){
+      if(!leuart_start(LEUART0, (char *)frame, len)){
+          return false;
+      }
+  }
+  else{
+      ble_backlog_put(frame, len);
+  }
+  ble_sequence++;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads a frame received from the BLE module
+ *
+ *
+ *  @details
+ *  Copies the oldest received frame, including the start and signal frame
+ *  characters, out of the LEUART receive ring.
+ *
+ * @note
+ * Called after the rx_event passed to ble_open has been posted.
+ *
+ * @param[out] string
+ * The buffer the frame is copied into, always null terminated.
+ *
+ * @param[in] max_len
+ * Size of string in bytes.
+ *
+ * @return
+ * Length of the frame copied.
+ ******************************************************************************/
+
+uint32_t ble_read(char *string, uint32_t max_len){
+  return leuart_receive(LEUART0, string, max_len);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues an AT command for the HM-18
+ *
+ *
+ *  @details
+ *  Commands run one at a time in the order they were queued, each after
+ *  BLE_AT_GAP_MS of quiet line. The reply is matched as it comes in on the
+ *  LEUART interrupt, nothing waits for it. done_evt is posted with
+ *  BLE_AT_OK once expect has been seen, or BLE_AT_TIMEOUT if it has not after
+ *  timeout_ms. Since expect only has to show up, OK also matches OK+LOST and
+ *  OK+Set: matches OK+Set: with any value.
+ *
+ * @note
+ * Register done_evt with scheduler_register_queued to get the result. Writes
+ * are kept back until the queue is empty.
+ *
+ * @param[in] cmd
+ * The command, with no line ending.
+ *
+ * @param[in] expect
+ * The reply, or the start of it.
+ *
+ * @param[in] timeout_ms
+ * How long to wait for the reply, BLE_AT_TIMEOUT_MS unless the command is slow.
+ *
+ * @param[in] done_evt
+ * Scheduler event posted with the BLE_AT_RESULT, 0 for none.
+ *
+ * @return
+ * false if the queue is full, cmd or expect is too long, or ble_set_baud is
+ * running.
+ ******************************************************************************/
+
+bool ble_at_queue(const char *cmd, const char *expect, uint32_t timeout_ms, uint32_t done_evt){
+  if(ble_baud.state != ble_baud_idle){
+      return false;
+  }
+  return ble_at_push(cmd, expect, 0, timeout_ms, done_evt, NULL);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Changes the baud rate of the link to the HM-18
+ *
+ *
+ *  @details
+ *  Starts the steps in ble_baud_step: AT+BAUD, AT+RESET, LEUART0 to the new
+ *  rate, then AT to check the link, each one a command of the AT queue.
+ *  Rates above LEUART_LFXO_MAX_BAUD put LFB on HFCLKLE, which keeps the
+ *  board out of EM2 while the link runs at them. If any step fails the link
+ *  goes back to the rate it had. done_evt is posted at the end either way,
+ *  ble_get_baud tells which rate won and ble_baud_failed whether the module
+ *  still answers at it. Writes are kept back until then.
+ *
+ * @note
+ * The module has to be disconnected, it only answers AT commands then. It
+ * keeps the new rate through power cycles, so HM10_BAUDRATE has to match it
+ * for the next boot.
+ *
+ * @param[in] baudrate
+ * One of the rates AT+BAUD takes, except 1200.
+ *
+ * @param[in] done_evt
+ * Scheduler event posted when the link is up again.
+ *
+ * @return
+ * false if baudrate is not supported, a change is already running or the AT
+ * queue is full.
+ ******************************************************************************/
+
+bool ble_set_baud(uint32_t baudrate, uint32_t done_evt){
+  if((ble_baud_index(baudrate) < 0) || (ble_baud.state != ble_baud_idle) ||
+     ((ble_at.head - ble_at.tail) == BLE_AT_QUEUE_SIZE)){
+      return false;
+  }
+  ble_baud.old_rate = leuart_baud_get(HM10_LEUART0);
+  ble_baud.new_rate = baudrate;
+  ble_baud.done_evt = done_evt;
+  ble_baud.failed = false;
+  if(baudrate == ble_baud.old_rate){
+      add_scheduled_event(done_evt);
+      return true;
+  }
+  ble_baud.state = ble_baud_set;
+  if(!ble_baud_command(baudrate, ble_baud.old_rate)){
+      ble_baud.state = ble_baud_idle;
+      return false;
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the baud rate of the link to the HM-18
+ *
+ * @return
+ * HM10_BAUDRATE until ble_set_baud changes it.
+ ******************************************************************************/
+
+uint32_t ble_get_baud(void){
+  return leuart_baud_get(HM10_LEUART0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Tells whether the last ble_set_baud lost the module
+ *
+ * @details
+ * The module did not answer at the new rate, and could not be brought back
+ * to the old one. LEUART0 is left at the old rate, ble_get_baud, which is
+ * where the module is unless it restarted without saying so.
+ *
+ * @return
+ * true if the link is down after the last ble_set_baud.
+ ******************************************************************************/
+
+bool ble_baud_failed(void){
+  return ble_baud.failed;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Tells whether a central is connected to the HM-18
+ *
+ *
+ * @details
+ * Follows BLE_NOTI_CONN and BLE_NOTI_LOST, false until the first
+ * BLE_NOTI_CONN. A central that was connected before the board started is
+ * dropped by the AT that ble_open sends and connects again.
+ *
+ * @return
+ * true while connected.
+ ******************************************************************************/
+
+bool ble_connected(void){
+  return ble_link.connected;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   BLE Test checks that the LEUART talks to the HM-18 and programs the name
+ *   the module advertises while it is looking to pair.
+ *
+ * @details
+ *   Queues AT, AT+NAME with mod_name, AT+RESET so the name is stored, and
+ *   then AT once the module is back up. Each command posts its BLE_AT_RESULT
+ *   to done_evt, BLE_TEST_COMMANDS of them in order. AT is answered with OK
+ *   if there was no connection and OK+LOST if it broke one, both pass.
+ *
+ * @note
+ *   The module only takes the name while no phone is connected, a connection
+ *   that AT broke can come back before AT+NAME is sent.
  *
  * @param[in] *mod_name
  *   The name that will be written to the HM-18 BLE module to identify it
- *   while it is advertising over Bluetooth Low Energy.
+ *   while it is advertising over Bluetooth Low Energy, at most
+ *   BLE_AT_MAX_NAME characters.
+ *
+ * @param[in] done_evt
+ *   Scheduler event posted with the result of each command.
  *
  * @return
- *   Returns bool true if successfully passed through the tests in this
- *   function.
- ******************************************************************************/
-
-bool ble_test(char *mod_name){
-	int	str_len;
-
-	CORE_DECLARE_IRQ_STATE;
-	CORE_ENTER_CRITICAL();
-
-	// This test will limit the test to the proper setup of the LEUART
-	// peripheral, routing of the signals to the proper pins, pin
-	// configuration, and transmit/reception verification.  The test
-	// will communicate with the BLE module using polling routines
-	// instead of interrupts.
-	// How is polling different than using interrupts?
-	// ANSWER: Polling is always running looking for things to be handled.
-	// where interrupts tell the system there is something that needs to be handled
-
-	// How does interrupts benefit the system for low energy operation?
-	// ANSWER: The CPU can be put into lower energy modes because it is not
-	//constantly polling.
-	// How does interrupts benefit the system that has multiple tasks?
-	// ANSWER: You can specify how and when they are handled.
-
-	// First, you will need to review the DSD HM10 datasheet to determine
-	// what the default strings to write data to the BLE module and the
-	// expected return statement from the BLE module to test / verify the
-	// correct response
-
-	// The test_str is used to tell the BLE module to end a Bluetooth connection
-	// such as with your phone.  The ok_str is the result sent from the BLE module
-	// to the micro-controller if there was not active BLE connection at the time
-	// the break command was sent to the BLE module.
-	// Replace the test_str "" with the command to break or end a BLE connection
-	// Replace the ok_str "" with the result that will be returned from the BLE
-	//   module if there was no BLE connection
-	char		test_str[80] = "AT";
-	char		ok_str[80] = "OK";
-
-
-	// output_str will be the string that will program a name to the BLE module.
-	// From the DSD HM10 datasheet, what is the command to program a name into
-	// the BLE module?
-	// The  output_str will be a string concatenation of the DSD HM10 command
-	// and the input argument sent to the ble_test() function
-	// Replace the output_str "" with the command to change the program name
-	// Replace the result_str "" with the first part of the expected result
-	// The HM-10 datasheet has an error. This response starts with "OK+Set:"
-	//  the backend of the expected response will be concatenated with the
-	//  input argument
-	char		output_str[80] = "AT+NAME";
-	char		result_str[80] = "OK+Set:";
-
-
-	// To program the name into your module, you must reset the module after you
-	// have sent the command to update the modules name.  What is the DSD HM10
-	// name to reset the module?
-	// Replace the reset_str "" with the command to reset the module
-	// Replace the reset_result_str "" with the expected BLE module response to
-	//  to the reset command
-	char		reset_str[80] = "AT+RESET";
-	char		reset_result_str[80] = "OK+RESET";
-	char		return_str[80];
-
-	bool		success;
-	bool		rx_disabled, rx_en, tx_en;
-	uint32_t	status;
-
-	// These are the routines that will build up the entire command and response
-	// of programming the name into the BLE module.  Concatenating the command or
-	// response with the input argument name
-	strcat(output_str, mod_name);
-	strcat(result_str, mod_name);
-
-	// The test routine must not alter the function of the configuration of the
-	// LEUART driver, but requires certain functionality to insure the logical test
-	// of writing and reading to the DSD HM10 module. The following c-lines of code
-	// save the current state of the LEUART driver that will be used later to
-	// re-instate the LEUART configuration
-
-	status = leuart_status(HM10_LEUART0);
-	if (status & LEUART_STATUS_RXBLOCK) {
-		rx_disabled = true;
-		// Enabling, unblocking, the receiving of data from the LEUART RX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKDIS);
-	}
-	else rx_disabled = false;
-	if (status & LEUART_STATUS_RXENS) {
-		rx_en = true;
-	} else {
-		rx_en = false;
-		// Enabling the receiving of data from the RX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXEN);
-	// Why could you be stuck in the below while loop after a write to CMD register?
-	// Answer: That would mean the reciever is not enabled.
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_RXENS));
-	}
-
-	if (status & LEUART_STATUS_TXENS){
-		tx_en = true;
-	} else {
-		// Enabling the transmission of data to the TX port
-		leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXEN);
-		while (!(leuart_status(HM10_LEUART0) & LEUART_STATUS_TXENS));
-		tx_en = false;
-	}
-	leuart_cmd_write(HM10_LEUART0, (LEUART_CMD_CLEARRX | LEUART_CMD_CLEARTX));
-
-	// This sequence of instructions is sending the break ble connection
-	// to the DSD HM10 module.
-	// Why is this command required if you want to change the name of the
-	// DSD HM10 module?
-	// ANSWER:We have to reset the HM10 for the name to change.
-	str_len = strlen(test_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, test_str[i]);
-	}
-
-	// What will the ble module response back to this command if there is
-	// a current ble connection?
-	// ANSWER: OK+LOST
-	str_len = strlen(ok_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (ok_str[i] != return_str[i]) {
-				EFM_ASSERT(false);;
-		}
-	}
-
-	// This sequence of code will be writing or programming the name of
-	// the module to the DSD HM10
-	str_len = strlen(output_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, output_str[i]);
-	}
-
-	// Here will be the check on the response back from the DSD HM10 on the
-	// programming of its name
-	str_len = strlen(result_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (result_str[i] != return_str[i]) {
-				EFM_ASSERT(false);;
-		}
-	}
-
-	// It is now time to send the command to RESET the DSD HM10 module
-	str_len = strlen(reset_str);
-	for (int i = 0; i < str_len; i++){
-		leuart_app_transmit_byte(HM10_LEUART0, reset_str[i]);
-	}
-
-	// After sending the command to RESET, the DSD HM10 will send a response
-	// back to the micro-controller
-	str_len = strlen(reset_result_str);
-	for (int i = 0; i < str_len; i++){
-		return_str[i] = leuart_app_receive_byte(HM10_LEUART0);
-		if (reset_result_str[i] != return_str[i]) {
-				EFM_ASSERT(false);;
-		}
-	}
-
-	// After the test and programming have been completed, the original
-	// state of the LEUART must be restored
-	if (!rx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXDIS);
-	if (rx_disabled) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKEN);
-	if (!tx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXDIS);
-	leuart_if_reset(HM10_LEUART0);
-
-	success = true;
-
-
-	CORE_EXIT_CRITICAL();
-	return success;
-}
+ *   false if nothing was queued, because the name is too long or the AT
+ *   queue does not have room for all the commands.
+ ******************************************************************************/
 
+bool ble_test(char *mod_name, uint32_t done_evt){
+  char name_str[BLE_AT_MAX_CMD] = "AT+NAME";
+  char result_str[BLE_AT_MAX_REPLY] = "OK+Set:";
 
+  if((strlen(mod_name) > BLE_AT_MAX_NAME) || (ble_baud.state != ble_baud_idle) ||
+     ((BLE_AT_QUEUE_SIZE - (ble_at.head - ble_at.tail)) < BLE_TEST_COMMANDS)){
+      return false;
+  }
+  strcat(name_str, mod_name);
+  strcat(result_str, mod_name);
 
+  ble_at_push("AT", "OK", 0, BLE_AT_TIMEOUT_MS, done_evt, NULL);
+  ble_at_push(name_str, result_str, 0, BLE_AT_TIMEOUT_MS, done_evt, NULL);
+  ble_at_push("AT+RESET", "OK+RESET", 0, BLE_AT_TIMEOUT_MS, done_evt, NULL);
+  ble_at_push("AT", "OK", BLE_AT_RESET_MS, BLE_AT_TIMEOUT_MS, done_evt, NULL);
+  return true;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file
+ * format.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Builds text messages in a caller's buffer without printf
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "format.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define FORMAT_UINT_DIGITS    10    // 4294967295
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const uint32_t format_pow10[FORMAT_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static const char format_hex_digits[] = "0123456789ABCDEF";
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Writes the decimal digits of value, padded with zeros to at least
+ * min_digits.
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] value
+ * The number to write.
+ *
+ * @param[in] min_digits
+ * Smallest number of digits to write, 1 for no padding.
+ *
+ ******************************************************************************/
+static void format_digits(FORMAT_BUFFER *fmt, uint32_t value, uint32_t min_digits){
+  char digits[FORMAT_UINT_DIGITS];
+  uint32_t count = 0;
+
+  do{
+      digits[count++] = (char)('0' + (value % 10));
+      value /= 10;
+  }while(value || (count < min_digits));
+
+  while(count){
+      format_char(fmt, digits[--count]);
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Starts a new message in buf
+ *
+ *
+ * @details
+ * Every format_ function appends to the message and keeps it null terminated,
+ * so buf can be handed to ble_write() at any point. Anything that does not
+ * fit is dropped and the overflow flag is set instead of writing past size.
+ *
+ *
+ * @note
+ * buf must be at least one byte so the null terminator always fits.
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] buf
+ * Caller's storage for the message.
+ *
+ * @param[in] size
+ * Size of buf in bytes.
+ *
+ ******************************************************************************/
+void format_open(FORMAT_BUFFER *fmt, char *buf, uint32_t size){
+  EFM_ASSERT(size > 0);
+  fmt->buf = buf;
+  fmt->size = size;
+  fmt->len = 0;
+  fmt->overflow = false;
+  buf[0] = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends one character
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] c
+ * The character to append.
+ *
+ ******************************************************************************/
+void format_char(FORMAT_BUFFER *fmt, char c){
+  if(fmt->len + 1 >= fmt->size){
+      fmt->overflow = true;
+      return;
+  }
+  fmt->buf[fmt->len++] = c;
+  fmt->buf[fmt->len] = 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a null terminated string
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] string
+ * The string to append.
+ *
+ ******************************************************************************/
+void format_string(FORMAT_BUFFER *fmt, const char *string){
+  while(*string){
+      format_char(fmt, *string++);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends an unsigned number in decimal
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] value
+ * The number to append.
+ *
+ ******************************************************************************/
+void format_uint(FORMAT_BUFFER *fmt, uint32_t value){
+  format_digits(fmt, value, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a signed number in decimal, the same as printf's %d
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] value
+ * The number to append.
+ *
+ ******************************************************************************/
+void format_int(FORMAT_BUFFER *fmt, int32_t value){
+  uint32_t magnitude = (uint32_t)value;
+
+  if(value < 0){
+      format_char(fmt, '-');
+      magnitude = 0u - magnitude;     //Also right for INT32_MIN
+  }
+  format_digits(fmt, magnitude, 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a fixed point number
+ *
+ *
+ * @details
+ * value is the number scaled by 10^decimals, so 123 with 1 decimal is written
+ * as "12.3" and -5 with 2 decimals as "-0.05". This replaces printf's %.Nf for
+ * values the caller already keeps in fixed point, without pulling in the float
+ * printf.
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] value
+ * The number scaled by 10^decimals.
+ *
+ * @param[in] decimals
+ * Digits after the decimal point, at most FORMAT_MAX_DECIMALS.
+ *
+ ******************************************************************************/
+void format_fixed(FORMAT_BUFFER *fmt, int32_t value, uint32_t decimals){
+  uint32_t magnitude = (uint32_t)value;
+
+  EFM_ASSERT(decimals <= FORMAT_MAX_DECIMALS);
+  if(value < 0){
+      format_char(fmt, '-');
+      magnitude = 0u - magnitude;
+  }
+  format_digits(fmt, magnitude / format_pow10[decimals], 1);
+  if(decimals){
+      format_char(fmt, '.');
+      format_digits(fmt, magnitude % format_pow10[decimals], decimals);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a number in upper case hex
+ *
+ *
+ * @param[in] fmt
+ * The buffer being built.
+ *
+ * @param[in] value
+ * The number to append.
+ *
+ * @param[in] digits
+ * Number of hex digits to write, from 1 to 8. Higher digits are cut off.
+ *
+ ******************************************************************************/
+void format_hex(FORMAT_BUFFER *fmt, uint32_t value, uint32_t digits){
+  EFM_ASSERT((digits > 0) && (digits <= 8));
+  while(digits){
+      digits--;
+      format_char(fmt, format_hex_digits[(value >> (digits * 4)) & 0xF]);
+  }
+}
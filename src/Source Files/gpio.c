@@ -23,12 +23,12 @@
 //***********************************************************************************
 // global variables
 //***********************************************************************************
-
+static uint32_t gpio_int_event[GPIO_INT_COUNT];     //posted by each external interrupt line
 
 //***********************************************************************************
 // function prototypes
 //***********************************************************************************
-
+static void gpio_int_dispatch(uint32_t lines);
 
 //***********************************************************************************
 // functions
@@ -88,3 +88,94 @@ void gpio_open(void){
 
   GPIO_DriveStrengthSet(LEUART_TX_PORT, LEUART_TX_DRIVE_STRENGTH);
 }
+
+/***************************************************************************//**
+ * @brief
+ * Posts a scheduler event on an edge of an input pin
+ *
+ *
+ * @details
+ * The pin is set as an input with a pull up and filter, for the open drain
+ * interrupt outputs of sensors, and uses the external interrupt line of its
+ * pin number. Edge interrupts are asynchronous, so they wake the CPU from
+ * EM2 and EM3 too.
+ *
+ *
+ * @note
+ * Called by drivers that use a device's interrupt pin, after gpio_open. Each
+ * pin number can only have one port, the ports share the lines.
+ *
+ * @param[in] port
+ * Port of the pin.
+ *
+ * @param[in] pin
+ * Pin number, also the external interrupt line.
+ *
+ * @param[in] rising
+ * Interrupt on a rising edge.
+ *
+ * @param[in] falling
+ * Interrupt on a falling edge.
+ *
+ * @param[in] event
+ * Scheduler event posted from the interrupt.
+ *
+ ******************************************************************************/
+void gpio_int_open(GPIO_Port_TypeDef port, uint32_t pin, bool rising, bool falling, uint32_t event){
+  EFM_ASSERT(pin < GPIO_INT_COUNT);
+  EFM_ASSERT(!gpio_int_event[pin]);
+
+  gpio_int_event[pin] = event;
+  GPIO_PinModeSet(port, pin, gpioModeInputPullFilter, 1);
+  GPIO_ExtIntConfig(port, pin, pin, rising, falling, true);
+
+  if(pin & 1){
+      NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+      NVIC_EnableIRQ(GPIO_ODD_IRQn);
+  }
+  else{
+      NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+      NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Clears the interrupt lines that fired and posts their events
+ *
+ * @param[in] lines
+ * GPIO_EVEN_INTS or GPIO_ODD_INTS.
+ *
+ ******************************************************************************/
+static void gpio_int_dispatch(uint32_t lines){
+  uint32_t int_flag = GPIO_IntGetEnabled() & lines;
+  GPIO_IntClear(int_flag);
+
+  for(uint32_t line = 0; line < GPIO_INT_COUNT; line++){
+      if(int_flag & (1u << line)){
+          add_scheduled_event(gpio_int_event[line]);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * The IRQ handler for the even numbered external interrupt lines
+ *
+ ******************************************************************************/
+void GPIO_EVEN_IRQHandler(void){
+  PROFILE_ENTER(PROF_GPIO_IRQ);
+  gpio_int_dispatch(GPIO_EVEN_INTS);
+  PROFILE_EXIT(PROF_GPIO_IRQ);
+}
+
+/***************************************************************************//**
+ * @brief
+ * The IRQ handler for the odd numbered external interrupt lines
+ *
+ ******************************************************************************/
+void GPIO_ODD_IRQHandler(void){
+  PROFILE_ENTER(PROF_GPIO_IRQ);
+  gpio_int_dispatch(GPIO_ODD_INTS);
+  PROFILE_EXIT(PROF_GPIO_IRQ);
+}
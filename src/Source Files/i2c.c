@@ -26,6 +26,330 @@ static I2C_STATE_MACHINE i2c1_state;
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Returns the state machine of a bus
+ *
+ *
+ * @param[in]
+ * I2C_TypeDef *i2c
+ * This typedef is specific to I2C0 or I2C1
+ *
+ * @return
+ * The bus's state machine, NULL for anything else.
+ ******************************************************************************/
+static I2C_STATE_MACHINE *i2c_state(I2C_TypeDef *i2c){
+  if(i2c == I2C0){
+      return &i2c0_state;
+  }
+  if(i2c == I2C1){
+      return &i2c1_state;
+  }
+  EFM_ASSERT(false);
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Hands a read to the LDMA before the address + read goes out
+ *
+ *
+ * @details
+ * For reads of I2C_DMA_MIN_RX bytes or more on a bus opened with rx_dma_en,
+ * AUTOACK is turned on and the LDMA moves the first rx_len - 1 bytes from
+ * RXDATA into the rx buffer with no interrupt per byte. RXDATAV interrupts are
+ * off meanwhile so the CPU does not steal bytes from the LDMA. The second
+ * descriptor is linked straight after the bytes and writes CTRL with AUTOACK
+ * off, so the LDMA itself turns it off before the last byte can be acked,
+ * however late its interrupt runs. i2c_dma_done then takes the last byte back
+ * so it can be NACKed.
+ *
+ *
+ * @note
+ * Called from i2c_begin and i2c_tx_next
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_rx_arm(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TRANSFER *transfer = i2c_sm->transfer;
+
+  if(!i2c_sm->rx_dma || (transfer->rx_len < I2C_DMA_MIN_RX)){
+      return;
+  }
+  i2c_sm->dma_desc[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&i2c_sm->i2cx->RXDATA, transfer->rx, transfer->rx_len - 1, 1);
+  i2c_sm->dma_desc[0].xfer.doneIfs = 0;       //only the AUTOACK write interrupts
+  i2c_sm->dma_desc[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_WRITE(i2c_sm->i2cx->CTRL & ~I2C_CTRL_AUTOACK, &i2c_sm->i2cx->CTRL);
+  i2c_sm->dma_armed = true;
+  i2c_sm->i2cx->IEN &= ~I2C_IEN_RXDATAV;
+  i2c_sm->i2cx->CTRL |= I2C_CTRL_AUTOACK;
+  LDMA_StartTransfer(i2c_sm->dma_ch, &i2c_sm->dma_cfg, &i2c_sm->dma_desc[0]);
+}
+
+/***************************************************************************//**
+ * @brief
+ * LDMA callback for when all but the last byte of a read are in
+ *
+ *
+ * @details
+ * AUTOACK was already turned off by the LDMA, so the I2C holds SCL after the
+ * last byte until it is NACKed, and this can run any time after. Turns
+ * RXDATAV back on so rxdatav_func reads the last byte, NACKs it, and sends
+ * the stop. A read that i2c_rx_disarm took back first is left alone.
+ *
+ *
+ * @note
+ * Registered with ldma_register in i2c_open, runs in the LDMA interrupt
+ *
+ *
+ * @param[in] context
+ * The I2C_STATE_MACHINE of the bus
+ ******************************************************************************/
+static void i2c_dma_done(void *context){
+  I2C_STATE_MACHINE *i2c_sm = context;
+
+  if(!i2c_sm->dma_armed){
+      return;
+  }
+  i2c_sm->dma_armed = false;
+  i2c_sm->rx_count = i2c_sm->transfer->rx_len - 1;
+  i2c_sm->i2cx->IEN |= I2C_IEN_RXDATAV;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Takes a read back from the LDMA when its transfer fails
+ *
+ *
+ * @details
+ * dma_armed is only set between i2c_rx_arm and i2c_dma_done, so it tells
+ * whether the LDMA still has the read. AUTOACK may already be off.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_rx_disarm(I2C_STATE_MACHINE *i2c_sm){
+  if(!i2c_sm->dma_armed){
+      return;
+  }
+  i2c_sm->dma_armed = false;
+  LDMA_StopTransfer(i2c_sm->dma_ch);
+  i2c_sm->i2cx->CTRL &= ~I2C_CTRL_AUTOACK;
+  i2c_sm->i2cx->IEN |= I2C_IEN_RXDATAV;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Time a transfer needs on the bus
+ *
+ *
+ * @details
+ * Counts the address bytes, tx bytes and rx bytes at I2C_BYTE_BITS each,
+ * plus the START, repeated START and STOP, at the rate the bus was opened
+ * with. Rounded up to a whole ms.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ *
+ * @param[in] transfer
+ * The transfer to time.
+ *
+ * @return
+ * ms the transfer takes with no clock stretching.
+ ******************************************************************************/
+static uint32_t i2c_transfer_ms(I2C_STATE_MACHINE *i2c_sm, I2C_TRANSFER *transfer){
+  uint64_t bytes = 1 + (uint64_t)transfer->tx_len;   //address + write, then the tx bytes
+  uint64_t bits;
+
+  if(transfer->rx_len){
+      bytes += 1 + (uint64_t)transfer->rx_len;       //address + read, then the rx bytes
+  }
+  bits = bytes*I2C_BYTE_BITS + I2C_FRAME_BITS;
+  return (uint32_t)((bits*1000 + i2c_sm->freq - 1)/i2c_sm->freq);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the transfer at the tail of the queue
+ *
+ *
+ * @details
+ * Sends a start command and the device address. The address goes out with a
+ * write if there are tx bytes (normally the register address), or straight
+ * out with a read if there are not. The transfer times out I2C_TIMEOUT_MS
+ * after the time its bytes take on the bus, so long ones are not cut short.
+ *
+ *
+ * @note
+ * Called by i2c_queue when the bus is idle, by i2c_run when the last
+ * transfer finishes and more are queued, and by i2c_supervise for a retry.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_begin(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TRANSFER *transfer = &i2c_sm->queue[i2c_sm->queue_tail & I2C_QUEUE_MASK];
+
+  EFM_ASSERT((i2c_sm->i2cx->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE);
+
+  i2c_sm->transfer = transfer;
+  i2c_sm->tx_count = 0;
+  i2c_sm->rx_count = 0;
+  i2c_sm->error = I2C_ERR_NONE;
+  i2c_sm->deadline = sw_timer_now() + SW_TIMER_MS_TO_TICKS(i2c_transfer_ms(i2c_sm, transfer) + I2C_TIMEOUT_MS);
+
+  i2c_sm->i2cx->CMD = I2C_CMD_START;
+  if(transfer->tx_len){
+      i2c_sm->current_state = initialize_write;
+      i2c_sm->i2cx->TXDATA = (transfer->device_address << 1 | 0);
+  }
+  else{
+      i2c_rx_arm(i2c_sm);
+      i2c_sm->current_state = initialize_read;
+      i2c_sm->i2cx->TXDATA = (transfer->device_address << 1 | 1);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the next queued transfer, or lets the bus go idle
+ *
+ *
+ * @details
+ * When the queue is empty sleep is unblocked, the bus is set available, and
+ * the state goes back to initialize_write.
+ *
+ *
+ * @note
+ * Called once the transfer on the bus is done or has failed for good and has
+ * been dropped from the queue, and once the bus reset is done.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_run(I2C_STATE_MACHINE *i2c_sm){
+  i2c_sm->retries = 0;
+  if(i2c_sm->queue_tail != i2c_sm->queue_head){
+      i2c_begin(i2c_sm);      //Next transfer goes right out, no trip through the main loop
+      return;
+  }
+  sleep_unblock_mode(I2C_EM_BLOCK, i2c_sm->sleep_tag);
+  i2c_sm->i2c_available = true;
+  i2c_sm->current_state = initialize_write;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Backs off before trying the failed transfer again, or gives up on it
+ *
+ *
+ * @details
+ * The back off doubles with each retry so a busy or resetting device gets
+ * time to come back. i2c_supervise starts the retry once it is over. After
+ * I2C_RETRIES retries the transfer is dropped, its error is kept for
+ * i2c_last_error, and error_evt is posted instead of its call_back.
+ *
+ *
+ * @note
+ * Called with the bus stopped or aborted
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_retry(I2C_STATE_MACHINE *i2c_sm){
+  i2c_rx_disarm(i2c_sm);
+  if(i2c_sm->retries < I2C_RETRIES){
+      i2c_sm->deadline = sw_timer_now() + SW_TIMER_MS_TO_TICKS(I2C_BACKOFF_MS << i2c_sm->retries);
+      i2c_sm->retries++;
+      i2c_sm->current_state = backoff;
+      return;
+  }
+  i2c_sm->last_error = i2c_sm->error;
+  if(i2c_sm->error_evt){
+      add_scheduled_event(i2c_sm->error_evt);
+  }
+  i2c_sm->queue_tail++;
+  i2c_run(i2c_sm);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Aborts the transfer on the bus after a bus fault
+ *
+ *
+ * @details
+ * Unlike a NACK the bus may be left stuck, so the SCL recovery is run before
+ * the retry.
+ *
+ *
+ * @note
+ * Called from i2c_irq for ARBLOST and BUSERR, and from i2c_supervise when a
+ * transfer times out.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ *
+ * @param[in] error
+ * What went wrong.
+ ******************************************************************************/
+static void i2c_fault(I2C_STATE_MACHINE *i2c_sm, I2C_ERROR error){
+  i2c_sm->i2cx->CMD = I2C_CMD_ABORT;
+  i2c_sm->i2cx->IFC = i2c_sm->i2cx->IF;
+  i2c_sm->error = error;
+  i2c_sm->recover = true;
+  i2c_retry(i2c_sm);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the next tx byte, or turns the bus around once they are all sent
+ *
+ *
+ * @details
+ * STOP is queued with the last tx byte when there is nothing to read. When
+ * there is, the last tx byte is acked first and then a repeated start and the
+ * device address with a read are sent.
+ *
+ *
+ * @note
+ * Called from ack_func
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_tx_next(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TRANSFER *transfer = i2c_sm->transfer;
+
+  if(i2c_sm->tx_count < transfer->tx_len){
+      i2c_sm->i2cx->TXDATA = transfer->tx[i2c_sm->tx_count++];
+      if((i2c_sm->tx_count == transfer->tx_len) && !transfer->rx_len){
+          i2c_sm->i2cx->CMD = I2C_CMD_STOP;
+          i2c_sm->current_state = verify_stop;
+      }
+      return;
+  }
+  i2c_rx_arm(i2c_sm);
+  i2c_sm->i2cx->CMD = I2C_CMD_START;
+  i2c_sm->i2cx->TXDATA = (transfer->device_address << 1 | 1);
+  i2c_sm->current_state = initialize_read;
+}
+
 /***************************************************************************//**
  * @brief
  * This is the function handler for when an ack interrupt is received
@@ -33,11 +357,12 @@ static I2C_STATE_MACHINE i2c1_state;
  *
  * @details
  * this is a state machine that handles the ack interrupt. If we are in the state
- * initialize_write of our state machine, then we are going to send the register address
- * and set to the next state communicate state.
+ * initialize_write the device acked its address, so we move to write_data and
+ * send the first tx byte. In write_data each ack sends the next byte until
+ * they are all out, see i2c_tx_next.
  *
- * If in communicate state, then we are going to send a start command, send a write command
- * with the device_address. Then we are going to increment the state to initialize read.
+ * In initialize_read the device acked its address for the read, so we move to
+ * receive_data and wait for the rx bytes.
  *
  *
  *
@@ -53,60 +378,80 @@ static void ack_func(I2C_STATE_MACHINE *i2c_sm){
   switch(i2c_sm->current_state){
 //--------------------------------
     case initialize_write:
-      //send register address
-      i2c_sm->i2cx->TXDATA = i2c_sm->register_address;
-      if(i2c_sm->mode == 0){
-          i2c_sm->current_state = write_data;
-      }
-      else if(i2c_sm->mode == 1){
-          i2c_sm->current_state = communicate_register;
-      }
+      i2c_sm->current_state = write_data;
+      i2c_tx_next(i2c_sm);
       break;
 //---------------------------------
-    case communicate_register:
-      i2c_sm->i2cx->CMD = I2C_CMD_START;
-      i2c_sm->i2cx->TXDATA = (i2c_sm->device_address << 1 | i2c_sm->mode);
-      i2c_sm->current_state = initialize_read;
+    case write_data:
+      i2c_tx_next(i2c_sm);
       break;
 //---------------------------------
     case initialize_read:
-      break;
-//---------------------------------
-      //code here to write data
-    case write_data:
-      i2c_sm->bytes_expected--;
-      //*(i2c_sm->data) &= ~(0xFF<<(8*i2c_sm->bytes_expected));
-      i2c_sm->i2cx->TXDATA = ((*(i2c_sm->data) >> (8*i2c_sm->bytes_expected)) & 0xFF);
-
-      if (i2c_sm->bytes_expected == 0){
-          i2c_sm->i2cx->CMD = I2C_CMD_STOP;
-          i2c_sm->current_state = receive_data;
-          break;
-      }
+      i2c_sm->current_state = receive_data;
       break;
 //---------------------------------
     case receive_data:
+      EFM_ASSERT(false);
       break;
 //---------------------------------
     case verify_stop:
+      break;        //ack of the last tx byte, STOP is already queued
+//---------------------------------
     default:
       EFM_ASSERT(false);
       break;
   }
 }
 
+/***************************************************************************//**
+ * @brief
+ * This is the function handler for when a nack interrupt is received
+ *
+ *
+ * @details
+ * The device did not ack its address or a tx byte, it is busy or not there.
+ * A stop is sent and the transfer is retried once MSTOP comes in. If the stop
+ * was already queued with the last tx byte it is just marked failed.
+ *
+ *
+ * @note
+ * called when nack interrupts
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void nack_func(I2C_STATE_MACHINE *i2c_sm){
+  switch(i2c_sm->current_state){
+//--------------------------------
+    case initialize_write:
+    case write_data:
+    case initialize_read:
+      i2c_sm->i2cx->CMD = I2C_CMD_STOP;
+      i2c_sm->current_state = verify_stop;
+      i2c_sm->error = I2C_ERR_NACK;
+      break;
+//---------------------------------
+    case verify_stop:
+      i2c_sm->error = I2C_ERR_NACK;
+      break;
+//---------------------------------
+    default:
+      break;        //the master nacks the last rx byte itself
+  }
+}
+
 /***************************************************************************//**
  * @brief
  * This is the function handler for when an rxdatav interrupt is received
  *
  *
  * @details
- * this is a state machine that handles the rxdatav interrupt. If we are in the state
- * initialize_read, then we are going to decrement the bytes expected, clear the
- * data variable which is a member of the i2c sm input into the function. We then
- * set the data member equal to the data in the RXdata. If the bytes expected is
- * not equal to 0 then we send an ack to the device and dont change states. If we got all the bytes expected,
- * then we send a nack, stop command, then move to the reveive data state.
+ * this is a state machine that handles the rxdatav interrupt. In receive_data
+ * the byte is stored in the rx buffer. If more bytes are expected then we send
+ * an ack to the device and dont change states. If we got all the bytes expected,
+ * then we send a nack, stop command, then move to the verify_stop state.
  *
  *
  *
@@ -122,6 +467,8 @@ static void ack_func(I2C_STATE_MACHINE *i2c_sm){
  ******************************************************************************/
 
 static void rxdatav_func(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TRANSFER *transfer = i2c_sm->transfer;
+
   switch(i2c_sm->current_state){
 
 //-------------------------------------
@@ -129,26 +476,22 @@ static void rxdatav_func(I2C_STATE_MACHINE *i2c_sm){
       EFM_ASSERT(false);
       break;
 //---------------------------------------
-    case communicate_register:
+    case write_data:
       EFM_ASSERT(false);
       break;
 //-------------------------------------
     case initialize_read:
-      i2c_sm->bytes_expected--;
-      *(i2c_sm->data) &= ~(0xFF<<(8*i2c_sm->bytes_expected));
-      *(i2c_sm->data) |= (i2c_sm->i2cx->RXDATA <<(8*i2c_sm->bytes_expected));
+    case receive_data:
+      transfer->rx[i2c_sm->rx_count++] = i2c_sm->i2cx->RXDATA;
 
-      if (i2c_sm->bytes_expected != 0){
+      if (i2c_sm->rx_count != transfer->rx_len){
           i2c_sm->i2cx->CMD = I2C_CMD_ACK;    //Send ack
           break;
       }
       i2c_sm->i2cx->CMD = I2C_CMD_NACK;
       i2c_sm->i2cx->CMD = I2C_CMD_STOP;
-      i2c_sm->current_state = receive_data;
+      i2c_sm->current_state = verify_stop;
       break;
-//--------------------------------------
-
-    case receive_data:
 //-------------------------------------
     case verify_stop:
     default:
@@ -164,8 +507,11 @@ static void rxdatav_func(I2C_STATE_MACHINE *i2c_sm){
  *
  * @details
  * this is a state machine that handles the stop interrupt. When this is recieved
- * we unblock sleep, set the gecko to available, set the state back to initialize_write,
- * then finally add the i2c_callback.
+ * a read of up to 4 bytes is packed big endian, stored for i2c_start and
+ * posted as the i2c_callback's payload, then we drop the transfer from the queue. If another transfer is queued it is started
+ * straight away, otherwise we unblock sleep, set the gecko to available, and set
+ * the state back to initialize_write. A transfer that was nacked goes to
+ * i2c_retry instead, and the stop of the bus reset lets the queue start.
  *
  *
  *
@@ -181,48 +527,183 @@ static void rxdatav_func(I2C_STATE_MACHINE *i2c_sm){
  ******************************************************************************/
 
 static void stop_func(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TRANSFER *transfer = i2c_sm->transfer;
+  uint32_t value;
+
   switch(i2c_sm->current_state){
 
 //-------------------------------------
     case initialize_write:
-      EFM_ASSERT(false);
-      break;
-//---------------------------------------
-    case communicate_register:
-      EFM_ASSERT(false);
-      break;
-//-------------------------------------
+    case write_data:
     case initialize_read:
+    case receive_data:
       EFM_ASSERT(false);
       break;
-//--------------------------------------
-    case receive_data:
-          sleep_unblock_mode(I2C_EM_BLOCK);
-          i2c_sm->i2c_available = true;
-          i2c_sm->current_state = initialize_write;
-          add_scheduled_event(i2c_sm->i2c_call_back);
-     break;
 //-------------------------------------
     case verify_stop:
-      EFM_ASSERT(false);
+          if(i2c_sm->error != I2C_ERR_NONE){
+              i2c_retry(i2c_sm);
+              break;
+          }
+          value = 0;
+          if(transfer->rx_len <= sizeof(value)){
+              for(uint32_t i = 0; i < transfer->rx_len; i++){
+                  value = (value << 8) | transfer->rx[i];
+              }
+          }
+          if(transfer->packed){
+              *transfer->packed = value;
+          }
+          scheduler_post(transfer->call_back, value);
+          i2c_sm->queue_tail++;
+          i2c_run(i2c_sm);
+     break;
+//-------------------------------------
+    case bus_reset:
+      i2c_sm->i2cx->CMD = I2C_CMD_ABORT; //reset the micro-controller I2C peripheral state machine
+      i2c_run(i2c_sm);
       break;
-
+//-------------------------------------
     default:
       EFM_ASSERT(false);
       break;
 }
 }
+
 /***************************************************************************//**
  * @brief
- * This resets the i2c bus
+ * Puts a transfer in a bus's queue and starts it if the bus is idle
+ *
+ *
+ * @details
+ * tx is copied into the queue if it fits in I2C_TX_INLINE bytes. If the bus
+ * is idle we block sleep mode, set availability to false, and start the
+ * transfer. Otherwise the stop interrupt of the transfer before it starts it.
+ * The supervise timer is started if it is not already running.
+ *
+ *
+ * @note
+ * Called by i2c_start and i2c_transfer
+ *
+ *
+ * @param[in] i2cx
+ * I2C0 or I2C1
+ *
+ * @param[in] transfer
+ * The transfer to queue, copied. If rx is NULL the read goes to rx_inline.
+ *
+ * @return
+ * true if the transfer was queued, false if the queue is full.
+ ******************************************************************************/
+static bool i2c_queue(I2C_TypeDef *i2cx, const I2C_TRANSFER *transfer){
+  I2C_STATE_MACHINE *i2c_local_sm = i2c_state(i2cx);
+  I2C_TRANSFER *slot;
+
+  if(!i2c_local_sm){
+      return false;
+  }
+
+  EFM_ASSERT(transfer->tx_len || transfer->rx_len);
+  if((i2c_local_sm->queue_head - i2c_local_sm->queue_tail) == I2C_QUEUE_SIZE){
+      return false;
+  }
+
+  slot = &i2c_local_sm->queue[i2c_local_sm->queue_head & I2C_QUEUE_MASK];
+  *slot = *transfer;
+  if(transfer->tx_len <= I2C_TX_INLINE){
+      for(uint32_t i = 0; i < transfer->tx_len; i++){
+          slot->tx_inline[i] = transfer->tx[i];
+      }
+      slot->tx = slot->tx_inline;
+  }
+  if(!transfer->rx){
+      EFM_ASSERT(transfer->rx_len <= sizeof(slot->rx_inline));
+      slot->rx = slot->rx_inline;
+  }
+  i2c_local_sm->queue_head++;     //Publish the transfer to the ISR
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(i2c_local_sm->i2c_available){
+      sleep_block_mode(I2C_EM_BLOCK, i2c_local_sm->sleep_tag);
+      i2c_local_sm->i2c_available = false;
+      i2c_local_sm->retries = 0;
+      i2c_begin(i2c_local_sm);
+  }
+  CORE_EXIT_CRITICAL();
+  if(!sw_timer_active(&i2c_local_sm->supervise)){
+      sw_timer_start(&i2c_local_sm->supervise, I2C_SUPERVISE_MS, I2C_SUPERVISE_MS, i2c_local_sm->supervise_evt);
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Frees a bus a slave is holding
  *
  *
  * @details
- * resets the i2c peripheral state machine, saves the state of interrupts then
- * clears the flags and buffers. It then sends a stat and stop command in accordance to the data sheet.
+ * A slave that was reset or lost clocks part way through a byte can hold SDA
+ * low forever, which the I2C peripheral can't get out of. The pins are taken
+ * back from the I2C, SCL is pulsed until the slave lets SDA go or
+ * I2C_RECOVERY_CLOCKS pulses have gone out, then a STOP is made by hand. The
+ * I2C is then given the pins back and aborted.
  *
  *
+ * @note
+ * Takes about 20 half SCL periods, so it runs with interrupts on and the bus
+ * in the bus_recover state, where i2c_irq drops any flags. Called by
+ * i2c_supervise before a retry after a bus fault, and when the bus reset
+ * times out.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_bus_recover(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TypeDef *i2c = i2c_sm->i2cx;
+  uint32_t route = i2c->ROUTEPEN;
+
+  i2c->ROUTEPEN = 0;        //SCL and SDA go back to their GPIO wired and outputs
+  GPIO_PinOutSet(i2c_sm->sda_port, i2c_sm->sda_pin);
+  GPIO_PinOutSet(i2c_sm->scl_port, i2c_sm->scl_pin);
+  for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+
+  for(uint32_t i = 0; (i < I2C_RECOVERY_CLOCKS) && !GPIO_PinInGet(i2c_sm->sda_port, i2c_sm->sda_pin); i++){
+      GPIO_PinOutClear(i2c_sm->scl_port, i2c_sm->scl_pin);
+      for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+      GPIO_PinOutSet(i2c_sm->scl_port, i2c_sm->scl_pin);
+      for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+  }
+
+  //STOP, SDA goes high while SCL is high
+  GPIO_PinOutClear(i2c_sm->scl_port, i2c_sm->scl_pin);
+  for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+  GPIO_PinOutClear(i2c_sm->sda_port, i2c_sm->sda_pin);
+  for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+  GPIO_PinOutSet(i2c_sm->scl_port, i2c_sm->scl_pin);
+  for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+  GPIO_PinOutSet(i2c_sm->sda_port, i2c_sm->sda_pin);
+  for(volatile uint32_t d = I2C_RECOVERY_DELAY; d; d--);
+
+  i2c->ROUTEPEN = route;
+  i2c->CMD = I2C_CMD_ABORT;
+  i2c->IFC = i2c->IF;
+  i2c_sm->recover = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * This resets the i2c bus
+ *
  *
+ * @details
+ * resets the i2c peripheral state machine, then clears the flags and buffers.
+ * It then sends a start and stop command in accordance to the data sheet. It
+ * does not wait for the stop, the bus stays busy in the bus_reset state until
+ * stop_func sees MSTOP or i2c_supervise times it out, and transfers queued
+ * meanwhile start after it.
  *
  *
  * @note
@@ -230,26 +711,177 @@ static void stop_func(I2C_STATE_MACHINE *i2c_sm){
  *
  *
  * @param[in]
- * I2C_TypeDef *i2c
- * This typedef is specific to I2C0 or I2C1
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
  *
  ******************************************************************************/
-static void i2c_bus_reset(I2C_TypeDef *i2c){
-  uint32_t save_state;    //variable to save the state of interrupt
+static void i2c_bus_reset(I2C_STATE_MACHINE *i2c_sm){
+  I2C_TypeDef *i2c = i2c_sm->i2cx;
+
+  sleep_block_mode(I2C_EM_BLOCK, i2c_sm->sleep_tag);
+  i2c_sm->i2c_available = false;
+  i2c_sm->current_state = bus_reset;
+  i2c_sm->deadline = sw_timer_now() + SW_TIMER_MS_TO_TICKS(I2C_TIMEOUT_MS);
 
   i2c->CMD = I2C_CMD_ABORT; //reset the micro-controller I2C peripheral state machine
-  save_state = i2c->IEN;   //Saves the state of the IEN register
-  i2c->IEN = 0;            //Clears the interrupts in the IEN
   i2c->IFC = i2c->IF;      //Clear the interrupt flags
   i2c->CMD = I2C_CMD_CLEARTX;   //clears the buffer
   i2c->CMD = (I2C_CMD_START |  I2C_CMD_STOP); //Starts then stops in accordance to datasheet
+}
 
-  while(!(i2c->IF & I2C_IF_MSTOP)); //Hold until the STOP has been completed by checking the MSTOP bit
+/***************************************************************************//**
+ * @brief
+ * Checks a busy bus for a timeout or the end of a back off
+ *
+ *
+ * @details
+ * A transfer that is past its deadline has timed out, I2C_ERR_BUSHOLD if the
+ * I2C is holding the bus, like when a slave stretches SCL forever, and
+ * I2C_ERR_TIMEOUT otherwise, like when a slave drops a byte. Either way it is
+ * aborted and retried. A back off that is over starts the retry, with the SCL
+ * recovery first if the bus faulted. A bus reset that times out runs the
+ * recovery and lets the queue start. The supervise timer is stopped once the
+ * bus is idle.
+ *
+ * Only the checks and the state change are done with interrupts off. The SCL
+ * recovery runs after them with interrupts on, in the bus_recover state, and
+ * the transfer is started in a second critical section once it is done.
+ *
+ *
+ * @note
+ * Runs from the bus's supervise event, every I2C_SUPERVISE_MS while it is
+ * busy, and from i2c_wait.
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_supervise(I2C_STATE_MACHINE *i2c_sm){
+  DEFINED_STATES recovered_from = bus_recover;
 
-  i2c->IFC = i2c->IF;      //Clear the interrupt flags that may have been caused by start stop
-  i2c->CMD = I2C_CMD_ABORT; //reset the micro-controller I2C peripheral state machine
-  i2c->IEN = save_state;   //Saves the state of the IEN register
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(i2c_sm->i2c_available){
+      sw_timer_stop(&i2c_sm->supervise);
+  }
+  else if((int32_t)(sw_timer_now() - i2c_sm->deadline) >= 0){
+      switch(i2c_sm->current_state){
+//-------------------------------------
+        case backoff:
+          if(!i2c_sm->recover){
+              i2c_begin(i2c_sm);
+              break;
+          }
+          recovered_from = backoff;
+          i2c_sm->current_state = bus_recover;
+          break;
+//-------------------------------------
+        case bus_reset:
+          recovered_from = bus_reset;
+          i2c_sm->current_state = bus_recover;
+          break;
+//-------------------------------------
+        case bus_recover:
+          break;
+//-------------------------------------
+        default:
+          if(i2c_sm->i2cx->STATE & I2C_STATE_BUSHOLD){
+              i2c_fault(i2c_sm, I2C_ERR_BUSHOLD);
+          }
+          else{
+              i2c_fault(i2c_sm, I2C_ERR_TIMEOUT);
+          }
+          break;
+      }
+  }
+  CORE_EXIT_CRITICAL();
 
+  if(recovered_from == bus_recover){
+      return;
+  }
+  i2c_bus_recover(i2c_sm);
+
+  CORE_ENTER_CRITICAL();
+  if(recovered_from == backoff){
+      i2c_begin(i2c_sm);          //the retry, the transfer is still at the tail
+  }
+  else{
+      i2c_run(i2c_sm);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Scheduler handler of the I2C0 supervise event
+ *
+ ******************************************************************************/
+static void i2c0_supervise_cb(void){
+  i2c_supervise(&i2c0_state);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Scheduler handler of the I2C1 supervise event
+ *
+ ******************************************************************************/
+static void i2c1_supervise_cb(void){
+  i2c_supervise(&i2c1_state);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Handles the interrupts of a bus
+ *
+ *
+ * @details
+ * This checks whether a bus fault, nack, ack, rxdatav, or stop interrupt was
+ * triggered, then sends us to the function handler. ARBLOST and BUSERR abort
+ * the transfer. Flags left over from an aborted transfer are dropped.
+ *
+ *
+ * @note
+ * Called by I2C0_IRQHandler and I2C1_IRQHandler
+ *
+ *
+ * @param[in]
+ * I2C_STATE_MACHINE *i2c_sm
+ * Holds information needed for the state machine
+ ******************************************************************************/
+static void i2c_irq(I2C_STATE_MACHINE *i2c_sm){
+  uint32_t int_flag = i2c_sm->i2cx->IF & i2c_sm->i2cx->IEN;
+  i2c_sm->i2cx->IFC = int_flag;
+
+  if(i2c_sm->i2c_available || (i2c_sm->current_state == backoff) || (i2c_sm->current_state == bus_recover)){
+      return;
+  }
+  if(i2c_sm->current_state == bus_reset){
+      if(int_flag & I2C_IF_MSTOP){
+          stop_func(i2c_sm);
+      }
+      return;
+  }
+  if(int_flag & I2C_IF_ARBLOST){
+      i2c_fault(i2c_sm, I2C_ERR_ARBLOST);
+      return;
+  }
+  if(int_flag & I2C_IF_BUSERR){
+      i2c_fault(i2c_sm, I2C_ERR_BUSERR);
+      return;
+  }
+  if(int_flag & I2C_IF_NACK){
+      nack_func(i2c_sm);
+  }
+  if(int_flag & I2C_IF_ACK){
+      ack_func(i2c_sm);
+  }
+  if(int_flag & I2C_IF_RXDATAV){
+      rxdatav_func(i2c_sm);
+  }
+  if(int_flag & I2C_IF_MSTOP){
+      stop_func(i2c_sm);
+  }
 }
 
 
@@ -266,12 +898,16 @@ static void i2c_bus_reset(I2C_TypeDef *i2c){
  * @details
  * Checks for the i2c input and sets the i2c accordingly. we then set the local type def to
  * the values input to the function. We then set the route locations and enable
- * interrupts int IEN and the NVIC.
+ * interrupts int IEN and the NVIC. With rx_dma_en, longer reads are moved by
+ * the bus's LDMA channel from ldma.h, which needs ldma_open first. The nack
+ * and bus fault interrupts are always on, and the supervise handler is
+ * registered for supervise_evt. The bus reset is started but not waited on,
+ * transfers can be queued straight away.
  *
  *
  *
  * @note
- * Called in si1133_i2c_open
+ * Called in si1133_i2c_open, after sw_timer_open
  *
  *
  * @param[in]
@@ -286,18 +922,51 @@ static void i2c_bus_reset(I2C_TypeDef *i2c){
  ******************************************************************************/
 void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init){
   I2C_Init_TypeDef i2c_values;
+  I2C_STATE_MACHINE *i2c_sm;
 
 
   if(i2c == I2C0){          //Enables I2C0 if input
       CMU_ClockEnable(cmuClock_I2C0, true);
-      i2c0_state.i2c_available = true;
+      i2c_sm = &i2c0_state;
+      i2c_sm->sleep_tag = SLEEP_TAG_I2C0;
+      i2c_sm->dma_ch = I2C0_RX_DMA_CH;
+      i2c_sm->dma_cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C0_RXDATAV);
+      scheduler_register(i2c_init->supervise_evt, i2c0_supervise_cb, i2c_init->supervise_prio);
   }
 
   else if(i2c == I2C1){         //Enables I2C1 if input
       CMU_ClockEnable(cmuClock_I2C1, true);
-      i2c1_state.i2c_available = true;
+      i2c_sm = &i2c1_state;
+      i2c_sm->sleep_tag = SLEEP_TAG_I2C1;
+      i2c_sm->dma_ch = I2C1_RX_DMA_CH;
+      i2c_sm->dma_cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_I2C1_RXDATAV);
+      scheduler_register(i2c_init->supervise_evt, i2c1_supervise_cb, i2c_init->supervise_prio);
+  }
+  else{
+      EFM_ASSERT(false);
+      return;
   }
 
+  i2c_sm->i2c_available = true;
+  i2c_sm->i2cx = i2c;
+  i2c_sm->queue_head = 0;
+  i2c_sm->queue_tail = 0;
+  i2c_sm->rx_dma = i2c_init->rx_dma_en;
+  i2c_sm->dma_armed = false;
+  if(i2c_sm->rx_dma){
+      ldma_register(i2c_sm->dma_ch, i2c_dma_done, i2c_sm);
+  }
+  i2c_sm->scl_port = i2c_init->scl_port;
+  i2c_sm->scl_pin = i2c_init->scl_pin;
+  i2c_sm->sda_port = i2c_init->sda_port;
+  i2c_sm->sda_pin = i2c_init->sda_pin;
+  i2c_sm->supervise_evt = i2c_init->supervise_evt;
+  i2c_sm->error_evt = i2c_init->error_evt;
+  i2c_sm->last_error = I2C_ERR_NONE;
+  i2c_sm->recover = false;
+  EFM_ASSERT(i2c_init->freq);
+  i2c_sm->freq = i2c_init->freq;
+
   //Checks for proper clock operation
   if ((i2c->IF & 0x01) == 0) {
       i2c->IFS = 0x01;
@@ -328,6 +997,7 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init){
   i2c->IEN |= (I2C_IEN_ACK * i2c_init->ack_irq_enable);
   i2c->IEN |= (I2C_IEN_RXDATAV * i2c_init->rxdatav_irq_enable);
   i2c->IEN |= (I2C_IEN_MSTOP * i2c_init->stop_irq_enable);
+  i2c->IEN |= I2C_IEN_NACK | I2C_IEN_ARBLOST | I2C_IEN_BUSERR;
 
   if(i2c == I2C0){
      NVIC_EnableIRQ(I2C0_IRQn);
@@ -337,26 +1007,27 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init){
      NVIC_EnableIRQ(I2C1_IRQn);
   }
 
-  i2c_bus_reset(i2c);
+  i2c_bus_reset(i2c_sm);
+  sw_timer_start(&i2c_sm->supervise, I2C_SUPERVISE_MS, I2C_SUPERVISE_MS, i2c_sm->supervise_evt);
 }
 /***************************************************************************//**
  * @brief
- * sets up the i2c for the device needed
+ * Queues a register read or write of up to 4 bytes for the device needed
  *
  *
  * @details
- * Checks what I2C was input into the function then sets a local pointer equal to that.
- * We then block sleep mode and set availability to false.After, we set up the local
- * I2C_STATE_MACHINE variable to the input values and set values for the i2c.
- * We then set the current state to initialize write. Finally we send a start command to the i2c
- * and then send the device address and then send a write command since the i2c
- * always starts out writing.
+ * Builds a transfer that writes the register address, then either writes the
+ * value packed big endian in *data, or reads the bytes back with a repeated
+ * start and packs them big endian into *data. The write value is copied when
+ * the transfer is queued, so the caller can reuse data as soon as this
+ * returns for a write. Back to back transfers never wait on the main loop.
  *
  *
  *
  *
  * @note
- * Called in Si1133_read
+ * Called in Si1133_read and Si1133_write. Must only be called from the main
+ * loop, never from an interrupt. i2c_transfer takes byte buffers of any length.
  *
  *
  * @param[in]
@@ -366,7 +1037,9 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init){
  *
  * @param[in]
  * uint32_t *data
- * This is the variable used to hold the data.
+ * The value to write, or where the read is stored. A read destination must
+ * stay valid until call_back. May be NULL for a read when call_back is a
+ * queued event, its handler gets the value as the payload.
  *
  * @param[in]
  * uint32_t bytes_expected
@@ -386,42 +1059,152 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_init){
  *
  * @param[in]
  * uint32_t call_back
- * This is the call back function we are using.
+ * This is the call back event posted when the transfer is done, with the
+ * value read as the payload.
+ *
+ * @return
+ * true if the transfer was queued, false if the queue is full.
  ******************************************************************************/
-//Check to see if we need two different structs according to which i2c we are using
-void i2c_start(bool mode, uint32_t *data, uint32_t bytes_expected, uint32_t device_address, uint32_t register_address, I2C_TypeDef *i2cx, uint32_t call_back){
-  I2C_STATE_MACHINE *i2c_local_sm;
+bool i2c_start(bool mode, uint32_t *data, uint32_t bytes_expected, uint32_t device_address, uint32_t register_address, I2C_TypeDef *i2cx, uint32_t call_back){
+  I2C_TRANSFER transfer;
+  uint8_t tx[1 + sizeof(uint32_t)];
 
-  if(i2cx == I2C0){
-      i2c_local_sm = &i2c0_state;
-  }
-  else if(i2cx == I2C1){
-      i2c_local_sm = &i2c1_state;
+  EFM_ASSERT((bytes_expected > 0) && (bytes_expected <= sizeof(uint32_t)));
+
+  tx[0] = (uint8_t)register_address;
+  transfer.device_address = device_address;
+  transfer.tx = tx;
+  transfer.rx = 0;
+  transfer.call_back = call_back;
+  if(mode){
+      transfer.tx_len = 1;
+      transfer.rx_len = bytes_expected;
+      transfer.packed = data;
   }
   else{
-      EFM_ASSERT(false);
+      for(uint32_t i = 0; i < bytes_expected; i++){
+          tx[1 + i] = (uint8_t)(*data >> (8*(bytes_expected - 1 - i)));
+      }
+      transfer.tx_len = 1 + bytes_expected;
+      transfer.rx_len = 0;
+      transfer.packed = 0;
   }
+  return i2c_queue(i2cx, &transfer);
+}
 
-  while(!i2c_local_sm->i2c_available);
-  EFM_ASSERT((i2cx->STATE & _I2C_STATE_STATE_MASK) == I2C_STATE_STATE_IDLE);
-
-  sleep_block_mode(I2C_EM_BLOCK);
-  i2c_local_sm->i2c_available = false;
-
-  i2c_local_sm->mode = mode;
-  i2c_local_sm->data = data;
-  i2c_local_sm->bytes_expected = bytes_expected;
-  i2c_local_sm->device_address = device_address;
-  i2c_local_sm->register_address = register_address;
-  i2c_local_sm->i2cx = i2cx;
-  i2c_local_sm->i2c_call_back = call_back;
+/***************************************************************************//**
+ * @brief
+ * Queues a write then read transfer with byte buffers of any length
+ *
+ *
+ * @details
+ * Writes tx, then if rx_len is not 0 sends a repeated start and reads rx_len
+ * bytes into rx, all as one transfer. The usual use is a register address in
+ * tx and a burst of registers read into rx. Either length can be 0, but not
+ * both.
+ *
+ *
+ * @note
+ * tx is copied if it is at most I2C_TX_INLINE bytes, otherwise it must stay
+ * valid until call_back, and rx always must. Must only be called from the
+ * main loop, never from an interrupt.
+ *
+ *
+ * @param[in] i2c
+ * I2C0 or I2C1
+ *
+ * @param[in] device_address
+ * 7 bit address of the device.
+ *
+ * @param[in] tx
+ * Bytes to write.
+ *
+ * @param[in] tx_len
+ * Number of bytes in tx.
+ *
+ * @param[out] rx
+ * Where the bytes read are stored.
+ *
+ * @param[in] rx_len
+ * Number of bytes to read.
+ *
+ * @param[in] call_back
+ * Scheduler event posted when the transfer is done.
+ *
+ * @return
+ * true if the transfer was queued, false if the queue is full.
+ ******************************************************************************/
+bool i2c_transfer(I2C_TypeDef *i2c, uint32_t device_address, const uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len, uint32_t call_back){
+  I2C_TRANSFER transfer;
 
+  EFM_ASSERT(!rx_len || rx);
+  transfer.device_address = device_address;
+  transfer.tx = tx;
+  transfer.tx_len = tx_len;
+  transfer.rx = rx;
+  transfer.rx_len = rx_len;
+  transfer.packed = 0;
+  transfer.call_back = call_back;
+  return i2c_queue(i2c, &transfer);
+}
 
+/***************************************************************************//**
+ * @brief
+ * Sleeps until every transfer queued on a bus is done
+ *
+ *
+ * @details
+ * For start up code that has to have a result before it can go on. The CPU
+ * sleeps in the lowest energy mode allowed, EM1 while the bus is busy, and
+ * the I2C interrupts wake it. Timeouts and retries are handled here too,
+ * since the main loop is not running, so this always returns.
+ *
+ *
+ * @note
+ * Normal code should use the call back event instead.
+ *
+ *
+ * @param[in]
+ * I2C_TypeDef *i2c
+ * This typedef is specific to I2C0 or I2C1
+ ******************************************************************************/
+void i2c_wait(I2C_TypeDef *i2c){
+  I2C_STATE_MACHINE *i2c_sm = i2c_state(i2c);
 
-  i2c_local_sm->current_state = initialize_write;    //Sets the current state to 0
+  while(!i2c_sm->i2c_available){
+      CORE_DECLARE_IRQ_STATE;
+      CORE_ENTER_CRITICAL();
+      if(!i2c_sm->i2c_available && !sw_timer_due() && !(get_scheduled_events() & i2c_sm->supervise_evt)){
+          enter_sleep();      //the I2C interrupt still wakes us, it runs once we leave the critical section
+      }
+      CORE_EXIT_CRITICAL();
+      sw_timer_poll();
+      if(get_scheduled_events() & i2c_sm->supervise_evt){
+          remove_scheduled_event(i2c_sm->supervise_evt);
+          i2c_supervise(i2c_sm);
+      }
+  }
+}
 
-  i2cx->CMD = I2C_CMD_START;
-  i2cx->TXDATA = (i2c_local_sm->device_address << 1 | 0);
+/***************************************************************************//**
+ * @brief
+ * Returns why the last transfer that failed for good failed
+ *
+ *
+ * @details
+ * For the handler of error_evt. Not cleared by later transfers that work,
+ * only by i2c_open.
+ *
+ *
+ * @param[in]
+ * I2C_TypeDef *i2c
+ * This typedef is specific to I2C0 or I2C1
+ *
+ * @return
+ * The error, I2C_ERR_NONE if no transfer has failed.
+ ******************************************************************************/
+I2C_ERROR i2c_last_error(I2C_TypeDef *i2c){
+  return i2c_state(i2c)->last_error;
 }
 
 /***************************************************************************//**
@@ -430,30 +1213,23 @@ void i2c_start(bool mode, uint32_t *data, uint32_t bytes_expected, uint32_t devi
  *
  * @details
  * takes in which i2c used, returns the whether or not the i2c is available.
+ * The i2c is available once its queue is empty.
  *
  *
  * @note
- * used multiple times in si1133_config.
+ * For code that has to know whether the bus is busy.
  *
  ******************************************************************************/
 bool is_available(I2C_TypeDef *i2c){
-  if(i2c == I2C0){
-      return(i2c0_state.i2c_available);
-  }
-  if(i2c == I2C1){         //Enables I2C1 if input
-      return(i2c1_state.i2c_available);
-  }
-      EFM_ASSERT(false);
-      return(false);
-  }
+  return(i2c_state(i2c)->i2c_available);
+}
 /***************************************************************************//**
  * @brief
  * The IRQ handler for i2c0
  *
  *
  * @details
- * This checks whether an ack, rxdatav, or stop interrupt wasa triggered, then
- * sends us to the function handler.
+ * Hands the interrupt to i2c_irq with the bus's state machine.
  *
  *
  *
@@ -464,19 +1240,9 @@ bool is_available(I2C_TypeDef *i2c){
  *
  ******************************************************************************/
 void I2C0_IRQHandler(){
-  uint32_t int_flag = I2C0->IF & I2C0->IEN;
-  I2C0->IFC = int_flag;
-
-  if(int_flag & I2C_IF_ACK){
-      ack_func(&i2c0_state);
-  }
-
-  if(int_flag & I2C_IF_RXDATAV){
-      rxdatav_func(&i2c0_state);
-  }
-  if(int_flag & I2C_IF_MSTOP){
-      stop_func(&i2c0_state);
-  }
+  PROFILE_ENTER(PROF_I2C0_IRQ);
+  i2c_irq(&i2c0_state);
+  PROFILE_EXIT(PROF_I2C0_IRQ);
 }
 /***************************************************************************//**
  * @brief
@@ -484,8 +1250,7 @@ void I2C0_IRQHandler(){
  *
  *
  * @details
- * This checks whether an ack, rxdatav, or stop interrupt wasa triggered, then
- * sends us to the function handler.
+ * Hands the interrupt to i2c_irq with the bus's state machine.
  *
  *
  *
@@ -496,18 +1261,7 @@ void I2C0_IRQHandler(){
  *
  ******************************************************************************/
 void I2C1_IRQHandler(){
-  uint32_t int_flag = I2C1->IF & I2C1->IEN;
-   I2C1->IFC = int_flag;
-
-   if(int_flag & I2C_IF_ACK){
-       ack_func(&i2c1_state);
-   }
-
-   if(int_flag & I2C_IF_RXDATAV){
-       rxdatav_func(&i2c1_state);
-   }
-
-   if(int_flag & I2C_IF_MSTOP){
-       stop_func(&i2c1_state);
-   }
- }
+  PROFILE_ENTER(PROF_I2C1_IRQ);
+  i2c_irq(&i2c1_state);
+  PROFILE_EXIT(PROF_I2C1_IRQ);
+}
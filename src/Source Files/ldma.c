@@ -0,0 +1,116 @@
+/**
+ * @file
+ * ldma.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Opens the LDMA controller that is shared by the peripheral drivers and
+ * hands channel done interrupts to the driver that owns the channel
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "ldma.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static LDMA_CALLBACK ldma_callback[LDMA_CALLBACK_CHANNELS];
+static void *ldma_context[LDMA_CALLBACK_CHANNELS];
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Enables the clock to the LDMA and initializes the controller
+ *
+ *
+ * @details
+ * The LDMA is shared between drivers, so it is initialized once here instead of
+ * in each driver. Each driver owns the channel assigned to it in ldma.h and
+ * starts its own transfers.
+ *
+ *
+ * @note
+ * Called in app_peripheral_setup before any driver that uses a DMA channel is
+ * opened.
+ *
+ ******************************************************************************/
+void ldma_open(void){
+  LDMA_Init_t ldma_values = LDMA_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_Init(&ldma_values);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the function called when a channel's transfer is done
+ *
+ *
+ * @details
+ * Only transfers whose descriptor has doneIfs set raise the interrupt. The
+ * callback runs in the LDMA interrupt with context as its argument.
+ *
+ *
+ * @note
+ * Called by a driver's open function for the channel it owns in ldma.h
+ *
+ * @param[in] channel
+ * The LDMA channel.
+ *
+ * @param[in] callback
+ * The function to call.
+ *
+ * @param[in] context
+ * Passed to callback, normally the driver's state machine.
+ *
+ ******************************************************************************/
+void ldma_register(uint32_t channel, LDMA_CALLBACK callback, void *context){
+  EFM_ASSERT(channel < LDMA_CALLBACK_CHANNELS);
+  ldma_callback[channel] = callback;
+  ldma_context[channel] = context;
+}
+
+/***************************************************************************//**
+ * @brief
+ * The IRQ handler for the LDMA
+ *
+ *
+ * @details
+ * Clears each channel done flag and calls the callback registered for that
+ * channel. An LDMA error means a descriptor is wrong, which is a bug.
+ *
+ *
+ ******************************************************************************/
+void LDMA_IRQHandler(void){
+  PROFILE_ENTER(PROF_LDMA_IRQ);
+  uint32_t pending = LDMA_IntGetEnabled();
+
+  EFM_ASSERT(!(pending & LDMA_IF_ERROR));
+
+  for(uint32_t ch = 0; ch < LDMA_CALLBACK_CHANNELS; ch++){
+      if(pending & (1u << ch)){
+          LDMA_IntClear(1u << ch);
+          EFM_ASSERT(ldma_callback[ch]);
+          ldma_callback[ch](ldma_context[ch]);
+      }
+  }
+  PROFILE_EXIT(PROF_LDMA_IRQ);
+}
@@ -6,7 +6,8 @@
  * @date
  *  9/8/21
  * @brief
- *  Driver to open an set an LETIMER peripheral in PWM mode
+ *  Driver to open an set an LETIMER peripheral in PWM mode, or as a free
+ *  running counter for software timers
  *
  */
 
@@ -27,6 +28,7 @@
 static uint32_t scheduled_comp0_cb;
 static uint32_t scheduled_comp1_cb;
 static uint32_t scheduled_uf_cb;
+static volatile uint32_t letimer0_wraps;    //Counter mode only, times CNT has wrapped
 
 //***********************************************************************************
 // Private functions
@@ -178,7 +180,7 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
    //If running, establish the energy mode we cannot enter
    bool LETIMERRunning = (letimer->STATUS & LETIMER_STATUS_RUNNING);             //True if timer is running, false otherwise, used for check at end
    if(LETIMERRunning){
-     sleep_block_mode(LETIMER_EM);
+     sleep_block_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
    }
 
 
@@ -203,6 +205,58 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 }
 
 
+/***************************************************************************//**
+ * @brief
+ *   Driver to open an LETIMER peripheral as a free running counter
+ *
+ * @details
+ *   The counter counts down from LETIMER_TOP and wraps without reloading, so
+ *   together with the wrap count kept by the IRQ handler it is a 32 bit clock
+ *   of LETIMER_HZ ticks, see letimer_count. COMP1 is used as a one shot alarm
+ *   at any count in the next wrap, see letimer_compare_arm. No pins are driven.
+ *
+ * @note
+ *   Used instead of letimer_pwm_open, not with it. The counter is started with
+ *   letimer_start.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral being opened
+ *
+ * @param[in] app_letimer_struct
+ *   Is the STRUCT that the calling routine will use to set the events
+ *
+ ******************************************************************************/
+
+void letimer_counter_open(LETIMER_TypeDef *letimer, APP_LETIMER_COUNTER_TypeDef *app_letimer_struct){
+  LETIMER_Init_TypeDef letimer_counter_values = LETIMER_INIT_DEFAULT;
+
+  EFM_ASSERT(letimer == LETIMER0);      //Only LETIMER0 keeps a wrap count
+  CMU_ClockEnable(cmuClock_LETIMER0,true);
+
+  letimer_start(letimer,false);             //Disables the LETIMER in case this had been called twice
+
+  letimer_counter_values.enable = false;
+  letimer_counter_values.debugRun = app_letimer_struct->debugRun;
+  letimer_counter_values.comp0Top = false;       // wrap from 0 to LETIMER_TOP
+  letimer_counter_values.repMode = letimerRepeatFree;
+
+  scheduled_comp0_cb = 0;
+  scheduled_comp1_cb = app_letimer_struct->comp1_cb;
+  scheduled_uf_cb = app_letimer_struct->uf_cb;
+
+  LETIMER_Init(letimer, &letimer_counter_values);
+  while(letimer->SYNCBUSY);
+
+  letimer->CNT = LETIMER_TOP;
+  while(letimer->SYNCBUSY);
+  letimer0_wraps = 0;
+
+  letimer->IFC = LETIMER_IFC_COMP0 | LETIMER_IFC_COMP1 | LETIMER_IFC_UF;
+  letimer->IEN = LETIMER_IEN_UF;       //COMP1 is turned on by letimer_compare_arm
+
+  NVIC_EnableIRQ(LETIMER0_IRQn);
+}
+
 /***************************************************************************//**
  * @brief
  *   Function to enable/turn-on or disable/turn-off the LETIMER specified
@@ -227,17 +281,93 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
 void letimer_start(LETIMER_TypeDef *letimer, bool enable){
   bool LETIMERRunning = (letimer->STATUS & LETIMER_STATUS_RUNNING);             //True if timer is running, false otherwise
   if(!LETIMERRunning && enable){        //If the timer is not running and has been set to enable
-      sleep_block_mode(LETIMER_EM);
+      sleep_block_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
       while(letimer->SYNCBUSY);
   }
 
   if(LETIMERRunning && !enable){       //If the timer is running and has been set to disable
-      sleep_unblock_mode(LETIMER_EM);
+      sleep_unblock_mode(LETIMER_EM, SLEEP_TAG_LETIMER);
       while(letimer->SYNCBUSY);
   }
   LETIMER_Enable(letimer,enable);
 }
 
+/***************************************************************************//**
+ * @brief
+ *   Reads the counter mode clock
+ *
+ * @details
+ *   Combines the wrap count with the 16 bit counter into a count that goes up
+ *   by one every LETIMER_HZ tick. If the counter has wrapped but the IRQ
+ *   handler has not run yet, the pending UF flag is counted here. The count
+ *   itself wraps after 2^32 ticks, so compare counts by their difference.
+ *
+ * @note
+ *   Only valid after letimer_counter_open
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral
+ *
+ * @return
+ *   Ticks since the counter was opened
+ ******************************************************************************/
+
+uint32_t letimer_count(LETIMER_TypeDef *letimer){
+  uint32_t wraps;
+  uint32_t up_count;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  up_count = LETIMER_TOP - LETIMER_CounterGet(letimer);
+  wraps = letimer0_wraps;
+  if((letimer->IF & LETIMER_IF_UF) && (up_count < (LETIMER_TOP/2))){
+      wraps++;      //Wrapped after the IRQ was disabled, the handler has not counted it yet
+  }
+  CORE_EXIT_CRITICAL();
+
+  return (wraps << 16) + up_count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Posts the comp1 event once the counter mode clock reaches count
+ *
+ * @details
+ *   COMP1 matches on the low 16 bits, so count must be within one wrap of
+ *   now. The write has to sync into the low frequency domain, which takes a
+ *   few ticks, so the caller should check the clock again afterwards in case
+ *   count went by in the meantime.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral
+ *
+ * @param[in] count
+ *   The letimer_count value to post the event at
+ *
+ ******************************************************************************/
+
+void letimer_compare_arm(LETIMER_TypeDef *letimer, uint32_t count){
+  letimer->IEN &= ~LETIMER_IEN_COMP1;
+  LETIMER_CompareSet(letimer, 1, LETIMER_TOP - (count & LETIMER_TOP));
+  while(letimer->SYNCBUSY);
+  letimer->IFC = LETIMER_IFC_COMP1;
+  letimer->IEN |= LETIMER_IEN_COMP1;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops the comp1 event armed by letimer_compare_arm
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral
+ *
+ ******************************************************************************/
+
+void letimer_compare_disarm(LETIMER_TypeDef *letimer){
+  letimer->IEN &= ~LETIMER_IEN_COMP1;
+  letimer->IFC = LETIMER_IFC_COMP1;
+}
+
 /***************************************************************************//**
  * @brief
  * Interrupt handler for the program
@@ -245,7 +375,8 @@ void letimer_start(LETIMER_TypeDef *letimer, bool enable){
  *
  * @details
  *  This IRQ handler is a simple one. If an interrupt is triggered we simply add
- *  the interrupt that was triggered to our scheduler.
+ *  the interrupt that was triggered to our scheduler. Underflows are also
+ *  counted for letimer_count.
  *
  *
  *
@@ -256,6 +387,7 @@ void letimer_start(LETIMER_TypeDef *letimer, bool enable){
  *
  ******************************************************************************/
 void LETIMER0_IRQHandler(void){
+  PROFILE_ENTER(PROF_LETIMER0_IRQ);
   uint32_t int_flag;
 
   int_flag = LETIMER0->IF & LETIMER0->IEN;
@@ -274,7 +406,9 @@ void LETIMER0_IRQHandler(void){
 
   if(int_flag & LETIMER_IF_UF){
       EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_UF));
+      letimer0_wraps++;
       add_scheduled_event(scheduled_uf_cb);
   }
+  PROFILE_EXIT(PROF_LETIMER0_IRQ);
 }
 
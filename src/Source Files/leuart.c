@@ -10,9 +10,6 @@
 // Include files
 //***********************************************************************************
 
-//** Standard Library includes
-#include <string.h>
-
 //** Silicon Labs include files
 #include "em_gpio.h"
 #include "em_cmu.h"
@@ -29,11 +26,9 @@
 //***********************************************************************************
 // private variables
 //***********************************************************************************
-uint32_t	rx_done_evt;
-uint32_t	tx_done_evt;
-bool		leuart0_tx_busy;
-
 static LEUART_STATE_MACHINE leuart0_state;
+static LDMA_TransferCfg_t   leuart0_tx_dma_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_LEUART0_TXBL);
+static LDMA_Descriptor_t    leuart0_tx_dma_desc;
 
 /***************************************************************************//**
  * @brief LEUART driver
@@ -52,15 +47,170 @@ static LEUART_STATE_MACHINE leuart0_state;
 // Private functions
 //***********************************************************************************
 
+/***************************************************************************//**
+ * @brief
+ * Finishes the segment at the tail of the transmit queue.
+ *
+ * @details
+ * Moves the queue tail past the segment and, if the segment came from the
+ * caller's storage, posts its release event so the caller can reuse it.
+ *
+ * @param[in] leuart_sm
+ * This is the state machine struct initialized as a private static variable above.
+ *
+ ******************************************************************************/
+static void leuart_tx_segment_done(LEUART_STATE_MACHINE *leuart_sm){
+  LEUART_TX_SEGMENT *segment = &leuart_sm->tx_queue[leuart_sm->tx_q_tail & LEUART_TX_QUEUE_MASK];
+
+  leuart_sm->tx_sent = 0;
+  leuart_sm->tx_q_tail++;
+  if(segment->data){
+      add_scheduled_event(segment->release_evt);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts sending the segment at the tail of the transmit queue.
+ *
+ * @details
+ * In interrupt mode this just turns on TXBL and lets write_data_func() drain
+ * the queue. In DMA mode the LDMA is started on the rest of the segment, read
+ * straight from the caller's storage for owned segments, or from the transmit
+ * ring up to its end for copied ones. Only TXC is turned on.
+ *
+ * @note
+ * Called from leuart_queue() inside a critical section, and from stop_func()
+ * when more data was queued while the last run was going out.
+ *
+ * @param[in] leuart_sm
+ * This is the state machine struct initialized as a private static variable above.
+ *
+ ******************************************************************************/
+static void leuart_tx_next(LEUART_STATE_MACHINE *leuart_sm){
+  LEUART_TX_SEGMENT *segment;
+  const uint8_t *source;
+  uint32_t count;
+
+  if(!leuart_sm->tx_dma){
+      leuart_sm->current_state = write_data_uart;
+      leuart_sm->leuart->IEN |= LEUART_IEN_TXBL;
+      return;
+  }
+
+  segment = &leuart_sm->tx_queue[leuart_sm->tx_q_tail & LEUART_TX_QUEUE_MASK];
+  count = segment->length - leuart_sm->tx_sent;
+  if(segment->data){
+      source = &segment->data[leuart_sm->tx_sent];
+  }
+  else{
+      source = &leuart_sm->tx_buffer[leuart_sm->tx_tail & LEUART_TX_BUFFER_MASK];
+      if(count > LEUART_TX_BUFFER_SIZE - (leuart_sm->tx_tail & LEUART_TX_BUFFER_MASK)){
+          count = LEUART_TX_BUFFER_SIZE - (leuart_sm->tx_tail & LEUART_TX_BUFFER_MASK);    //Stop at the end of the ring, the rest goes in the next run
+      }
+  }
+  if(count > LEUART_TX_DMA_MAX){
+      count = LEUART_TX_DMA_MAX;
+  }
+  leuart_sm->dma_count = count;
+  leuart_sm->current_state = stop;
+
+  leuart0_tx_dma_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(source, &leuart_sm->leuart->TXDATA, count);
+  leuart0_tx_dma_desc.xfer.doneIfs = false;     //No LDMA interrupt, TXC tells us the run is out
+  leuart_sm->leuart->IFC = LEUART_IFC_TXC;
+  LDMA_StartTransfer(LEUART0_TX_DMA_CH, &leuart0_tx_dma_cfg, &leuart0_tx_dma_desc);
+  leuart_sm->leuart->IEN |= LEUART_IEN_TXC;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts a segment in the transmit queue and starts the state machine if it is
+ * idle.
+ *
+ * @details
+ * The queue is single producer / single consumer like the ring, so the
+ * segment is published by moving tx_q_head. Only the check for an idle state
+ * machine is atomic: if it is idle, sleep mode is blocked and the transmit is
+ * started.
+ *
+ * @param[in] leuart
+ * This is the type of LEUART we are using.
+ *
+ * @param[in] data
+ * Caller's storage, or NULL when the bytes were copied into the transmit ring.
+ *
+ * @param[in] length
+ * Number of bytes in the segment.
+ *
+ * @param[in] release_evt
+ * Event posted when data can be reused, ignored when data is NULL.
+ *
+ ******************************************************************************/
+static void leuart_queue(LEUART_TypeDef *leuart, const uint8_t *data, uint32_t length, uint32_t release_evt){
+  LEUART_TX_SEGMENT *segment = &leuart0_state.tx_queue[leuart0_state.tx_q_head & LEUART_TX_QUEUE_MASK];
+
+  segment->data = data;
+  segment->length = length;
+  segment->release_evt = release_evt;
+  leuart0_state.tx_q_head++;     //Publish the segment to the ISR
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(leuart0_state.available){
+      sleep_block_mode(LEUART_TX_EM, SLEEP_TAG_LEUART_TX);
+      leuart0_state.available = false;
+      leuart0_state.leuart = leuart;
+      leuart_tx_next(&leuart0_state);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts LFB on the clock that can produce baudrate.
+ *
+ * @details
+ * Rates up to LEUART_LFXO_MAX_BAUD run from the LFXO. Faster rates need
+ * HFCLKLE, which stops in EM2, so LEUART_HF_EM is blocked for as long as LFB
+ * stays on it. Nothing is done when LFB is already on the right clock.
+ *
+ * @note
+ * The LEUART must be disabled, LFB only feeds LEUART0 on this board.
+ *
+ * @param[in] leuart_sm
+ * This is the state machine struct initialized as a private static variable above.
+ *
+ * @param[in] baudrate
+ * The rate the LEUART is about to be set to.
+ *
+ ******************************************************************************/
+static void leuart_clock_select(LEUART_STATE_MACHINE *leuart_sm, uint32_t baudrate){
+  bool hf_clock = (baudrate > LEUART_LFXO_MAX_BAUD);
+
+  if(hf_clock == leuart_sm->hf_clock){
+      return;
+  }
+  if(hf_clock){
+      CMU_ClockSelectSet(cmuClock_LFB, cmuSelect_HFCLKLE);
+      sleep_block_mode(LEUART_HF_EM, SLEEP_TAG_LEUART_CLK);
+  }
+  else{
+      CMU_ClockSelectSet(cmuClock_LFB, cmuSelect_LFXO);
+      sleep_unblock_mode(LEUART_HF_EM, SLEEP_TAG_LEUART_CLK);
+  }
+  leuart_sm->hf_clock = hf_clock;
+}
+
 /***************************************************************************//**
  *@brief
  * This is the state machine function for writing data when the TXBL interrupt is triggered.
  *
  *
  * @details
- * This is the write data function. It transmits one byte at a time and will trigger
- * until the count is equal to the length. Then it turns off the TBXL interrupt,
- * switches states to stop, and then turns on TXC interrupts.
+ * This is the write data function. It transmits one byte at a time from the
+ * segment at the tail of the transmit queue, out of the caller's storage or
+ * the transmit ring, until the queue is empty. Then it turns off the TBXL
+ * interrupt, switches states to stop, and then turns on TXC interrupts.
  *
  *@note
  * called when TXBL is triggered
@@ -70,12 +220,26 @@ static LEUART_STATE_MACHINE leuart0_state;
  *
  ******************************************************************************/
 static void write_data_func(LEUART_STATE_MACHINE *leuart_sm){
+  LEUART_TX_SEGMENT *segment;
+  uint8_t byte;
+
   switch(leuart_sm->current_state){
 //--------------------------------
     case write_data_uart:
-      if(leuart_sm->count != leuart_sm->length){
-          leuart_app_transmit_byte(leuart_sm->leuart, leuart_sm->data[leuart_sm->count]); //Send data, either char or byte
-          leuart_sm->count++;
+      if(leuart_sm->tx_q_tail != leuart_sm->tx_q_head){
+          segment = &leuart_sm->tx_queue[leuart_sm->tx_q_tail & LEUART_TX_QUEUE_MASK];
+          if(segment->data){
+              byte = segment->data[leuart_sm->tx_sent];
+          }
+          else{
+              byte = leuart_sm->tx_buffer[leuart_sm->tx_tail & LEUART_TX_BUFFER_MASK];
+              leuart_sm->tx_tail++;
+          }
+          leuart_app_transmit_byte(leuart_sm->leuart, byte); //Send data, either char or byte
+          leuart_sm->tx_sent++;
+          if(leuart_sm->tx_sent == segment->length){
+              leuart_tx_segment_done(leuart_sm);    //Last byte is in TXDATA, the source is free
+          }
           break;
       }
     else{
@@ -98,8 +262,12 @@ static void write_data_func(LEUART_STATE_MACHINE *leuart_sm){
  * This is the stop function for the state machine.
  *
  * @details
- * This turns off the TXC interrupt, switches the state back to write data,
- * changes the device to available, then finally unblocks sleep mode.
+ * In DMA mode a TXC that arrives before the LDMA channel is done is ignored,
+ * otherwise the finished run is accounted to its segment, releasing the
+ * segment once all of it is out. If more data is queued the next run is
+ * started right away. When the queue is empty this turns off the TXC
+ * interrupt, switches the state back to write data, changes the device to
+ * available, then finally unblocks sleep mode.
  *
  *@note
  * called when TXC is triggered
@@ -109,16 +277,35 @@ static void write_data_func(LEUART_STATE_MACHINE *leuart_sm){
  *
  ******************************************************************************/
 static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
+  LEUART_TX_SEGMENT *segment;
+
   switch(leuart_sm->current_state){
 //--------------------------------
     case write_data_uart:
       EFM_ASSERT(false);
       break;
     case stop:
+      if(leuart_sm->tx_dma){
+          if(!LDMA_TransferDone(LEUART0_TX_DMA_CH)){
+              break;      //line went idle between two DMA writes, the run is not done yet
+          }
+          segment = &leuart_sm->tx_queue[leuart_sm->tx_q_tail & LEUART_TX_QUEUE_MASK];
+          if(!segment->data){
+              leuart_sm->tx_tail += leuart_sm->dma_count;
+          }
+          leuart_sm->tx_sent += leuart_sm->dma_count;
+          if(leuart_sm->tx_sent == segment->length){
+              leuart_tx_segment_done(leuart_sm);
+          }
+      }
       leuart_sm->leuart->IEN &= ~LEUART_IEN_TXC;
+      if(leuart_sm->tx_q_tail != leuart_sm->tx_q_head){
+          leuart_tx_next(leuart_sm);     //More was queued while this run went out
+          break;
+      }
       leuart_sm->current_state = write_data_uart;
-      leuart0_state.available = true;
-      sleep_unblock_mode(LEUART_TX_EM);
+      leuart_sm->available = true;
+      sleep_unblock_mode(LEUART_TX_EM, SLEEP_TAG_LEUART_TX);
       break;
 //--------------------------------
     default:
@@ -127,6 +314,87 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
   }
 }
 
+/***************************************************************************//**
+ * @brief
+ * This is the state machine function for receiving data when the RXDATAV
+ * interrupt is triggered.
+ *
+ * @details
+ * Empties the LEUART receive buffer into the receive ring. If the ring is full
+ * the byte is dropped and counted in rx_overflow. When signal frames are not
+ * used every byte is its own frame, so the receive done event is posted here.
+ * With start frames, bytes outside a frame only get here while the receiver
+ * is unblocked for leuart_rx_monitor(), they go to the monitor and never
+ * into the ring. A monitor that returns false has the receiver blocked
+ * again, so the bytes after it are dropped without an interrupt until the
+ * next start frame.
+ *
+ * @note
+ * called when RXDATAV is triggered
+ *
+ * @param[in] leuart_sm
+ * This is the state machine struct initialized as a private static variable above.
+ *
+ ******************************************************************************/
+static void rxdatav_func(LEUART_STATE_MACHINE *leuart_sm){
+  uint32_t head = leuart_sm->rx_head;
+
+  while(leuart_sm->leuart->STATUS & LEUART_STATUS_RXDATAV){
+      char byte = leuart_sm->leuart->RXDATA;
+      if(leuart_sm->startframe_en && !leuart_sm->rx_in_frame){
+          if(byte != leuart_sm->startframe){
+              if(leuart_sm->rx_monitor && !leuart_sm->rx_monitor(leuart_sm->rx_context, byte) &&
+                 leuart_sm->rxblocken){
+                  leuart_sm->leuart->CMD = LEUART_CMD_RXBLOCKEN;   //Synchronizes in the background, like sigf_func()
+              }
+              continue;
+          }
+          leuart_sm->rx_in_frame = true;
+      }
+      if(leuart_sm->sigframe_en && (byte == leuart_sm->sigframe)){
+          leuart_sm->rx_in_frame = false;
+      }
+      if((head - leuart_sm->rx_tail) == LEUART_RX_BUFFER_SIZE){
+          leuart_sm->rx_overflow++;
+          continue;
+      }
+      leuart_sm->rx_buffer[head & LEUART_RX_BUFFER_MASK] = byte;
+      head++;
+  }
+  leuart_sm->rx_head = head;
+
+  if(!leuart_sm->sigframe_en){
+      add_scheduled_event(leuart_sm->rx_done_evt);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * This is the function for the end of a received frame, called when the
+ * SIGF interrupt is triggered.
+ *
+ * @details
+ * The signal frame has already been put in the receive ring by rxdatav_func(),
+ * so the frame is complete and the receive done event is posted. If RX blocking
+ * is used, the receiver is blocked again so anything on the line until the next
+ * start frame is thrown away by the hardware without waking the CPU, unless a
+ * receive monitor wants those bytes.
+ *
+ * @note
+ * called when SIGF is triggered
+ *
+ * @param[in] leuart_sm
+ * This is the state machine struct initialized as a private static variable above.
+ *
+ ******************************************************************************/
+static void sigf_func(LEUART_STATE_MACHINE *leuart_sm){
+  if(leuart_sm->rxblocken && !leuart_sm->rx_monitor){
+      leuart_sm->leuart->CMD = LEUART_CMD_RXBLOCKEN;   //Synchronizes in the background, nothing else is written here
+  }
+  leuart_sm->rx_frames_in++;
+  add_scheduled_event(leuart_sm->rx_done_evt);
+}
+
 
 //***********************************************************************************
 // Global functions
@@ -140,8 +408,12 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
  *
  * @details
  * Starts by enabling the clock to LEUART, then sets values of the local init typedef.
- * It then initializes the LEUART, then routes the pins for the LEUART. Finally it enables
- * the LEUART and enables the NVIC.
+ * LFB is moved off the LFXO if the baud rate needs it, see leuart_clock_select().
+ * It then initializes the LEUART, then routes the pins for the LEUART. If DMA transmit
+ * is requested, TX DMA wake-up is turned on so the LDMA can be served from EM2.
+ * The start frame, signal frame and RX block settings are loaded for the receive
+ * engine. Finally it enables the LEUART, turns on the receive interrupts if the
+ * receiver is used, and enables the NVIC.
  *
  * @note
  * called by ble open.
@@ -176,6 +448,15 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
   leuart_values.enable   =      disableLEUART;
   leuart_values.stopbits =      leuart_settings->stopbits;
   leuart0_state.available = true;
+  leuart0_state.tx_head = 0;
+  leuart0_state.tx_tail = 0;
+  leuart0_state.tx_q_head = 0;
+  leuart0_state.tx_q_tail = 0;
+  leuart0_state.tx_sent = 0;
+  leuart0_state.current_state = write_data_uart;
+  leuart0_state.baudrate = leuart_settings->baudrate;
+  leuart0_state.enable = leuart_settings->enable;
+  leuart_clock_select(&leuart0_state, leuart_settings->baudrate);
 
   //Initializes the struct
   LEUART_Init(leuart, &leuart_values);
@@ -185,12 +466,48 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
 
   leuart->ROUTELOC0 = leuart_settings->tx_loc | leuart_settings->rx_loc;
 
+  leuart0_state.tx_dma = leuart_settings->tx_dma_en;
+  if(leuart0_state.tx_dma){
+      leuart->CTRL |= LEUART_CTRL_TXDMAWU;    //Lets TXBL wake the LDMA while we sit in EM2
+      while(leuart->SYNCBUSY);
+  }
+
 
   leuart->ROUTEPEN |= (LEUART_ROUTEPEN_TXPEN * leuart_settings->tx_pin_en);
   leuart->ROUTEPEN |= (LEUART_ROUTEPEN_RXPEN * leuart_settings->rx_pin_en);
 
   leuart->STARTFRAME = LEUART_RXDATA_RXDATA_DEFAULT;      //Will clear the RxRegister because the start frame sends its contents there
   while(leuart->SYNCBUSY);
+
+  //Receive framing, the start frame unblocks the receiver and the signal frame ends a frame
+  leuart0_state.leuart = leuart;
+  leuart0_state.rx_done_evt = leuart_settings->rx_done_evt;
+  leuart0_state.rx_en = leuart_settings->rx_en;
+  leuart0_state.rxblocken = leuart_settings->rxblocken;
+  leuart0_state.startframe_en = leuart_settings->startframe_en;
+  leuart0_state.startframe = leuart_settings->startframe;
+  leuart0_state.sigframe_en = leuart_settings->sigframe_en;
+  leuart0_state.sigframe = leuart_settings->sigframe;
+  leuart0_state.rx_in_frame = false;
+  leuart0_state.rx_monitor = NULL;
+  leuart0_state.rx_context = NULL;
+  leuart0_state.rx_head = 0;
+  leuart0_state.rx_tail = 0;
+  leuart0_state.rx_overflow = 0;
+  leuart0_state.rx_frames_in = 0;
+  leuart0_state.rx_frames_out = 0;
+  if(leuart_settings->startframe_en){
+      leuart->STARTFRAME = leuart_settings->startframe;
+      while(leuart->SYNCBUSY);
+  }
+  if(leuart_settings->sfubrx){
+      leuart->CTRL |= LEUART_CTRL_SFUBRX;
+      while(leuart->SYNCBUSY);
+  }
+  if(leuart_settings->sigframe_en){
+      leuart->SIGFRAME = leuart_settings->sigframe;
+      while(leuart->SYNCBUSY);
+  }
   leuart->TXDATA = LEUART_TXDATA_TXDATA_DEFAULT;         //Clears the register
 
   while(leuart->SYNCBUSY);
@@ -203,23 +520,35 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
 
 
   leuart->IFC = _LEUART_IFC_MASK;
+
+  if(leuart0_state.rx_en){
+      if(leuart0_state.rxblocken){
+          leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);   //Ignore the line until a start frame
+      }
+      leuart->IEN |= LEUART_IEN_RXDATAV;
+      leuart->IEN |= (LEUART_IEN_SIGF * leuart0_state.sigframe_en);
+      sleep_block_mode(LEUART_RX_EM, SLEEP_TAG_LEUART_RX);       //The receiver needs the LFB clock
+  }
   NVIC_EnableIRQ(LEUART0_IRQn);
 
 }
 
 /***************************************************************************//**
  * @brief
- * This is the start function for the leuart. This sets values of the private
- * struct for the state machine.
+ * This is the start function for the leuart. It copies a message into the
+ * transmit ring and queues it.
  *
  *
  * @details
- * This starts by making the function atomic. Then it blocks the sleep mode, and then sets the
- * values of the struct and sets the state to the write state. Finally it copies the input string to our data variable
- * and then turns on the TXBL interrupt.
+ * The ring is single producer / single consumer. This function is the only
+ * writer of tx_head and the LEUART interrupt is the only writer of tx_tail, so
+ * the message is copied in without turning interrupts off. If the message does
+ * not fit in the ring, or the transmit queue is full, nothing is queued and
+ * false is returned instead of waiting for the transmit to drain.
  *
  * @note
- * called by ble start.
+ * called by ble write. Must only be called from the main loop, never from an
+ * interrupt.
  *
  * @param[in] LEUART_TypeDef *leuart
  * This is the type of LEUART we are using.
@@ -229,38 +558,263 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
  *
  * @param[in] uint32_t string_len
  * length of the input string.
+ *
+ * @return
+ * true if the message was queued, false if it would overflow.
  ******************************************************************************/
 
-void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
-  while(!(leuart0_state.available));
+bool leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
+  uint32_t head = leuart0_state.tx_head;
 
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
+  if(string_len == 0){
+      return true;
+  }
+  if((string_len > LEUART_TX_BUFFER_SIZE - (head - leuart0_state.tx_tail)) ||
+     ((leuart0_state.tx_q_head - leuart0_state.tx_q_tail) == LEUART_TX_QUEUE_SIZE)){
+      return false;
+  }
 
+  for(uint32_t i = 0; i < string_len; i++){
+      leuart0_state.tx_buffer[(head + i) & LEUART_TX_BUFFER_MASK] = string[i];
+  }
+  leuart0_state.tx_head = head + string_len;
 
-  sleep_block_mode(LEUART_TX_EM);
+  leuart_queue(leuart, NULL, string_len, 0);
+  return true;
+}
 
+/***************************************************************************//**
+ * @brief
+ * Queues a message that is sent straight out of the caller's storage.
+ *
+ *
+ * @details
+ * Nothing is copied. The caller keeps ownership of data but must not change
+ * it until release_evt is posted, which happens as soon as the last byte has
+ * been handed to the LEUART. Messages from leuart_start() and this function
+ * go out in the order they were queued.
+ *
+ * @note
+ * called by ble write owned. Must only be called from the main loop, never
+ * from an interrupt.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @param[in] const uint8_t *data
+ * The message, which must stay valid until release_evt.
+ *
+ * @param[in] uint32_t length
+ * length of the message.
+ *
+ * @param[in] uint32_t release_evt
+ * Scheduler event posted when data can be reused.
+ *
+ * @return
+ * true if the message was queued, false if the transmit queue is full.
+ ******************************************************************************/
 
-  leuart0_state.available = false;
-  leuart0_state.length = string_len;
-  leuart0_state.count = 0;
-  leuart0_state.leuart = leuart;
-  leuart0_state.current_state = write_data_uart;
+bool leuart_start_owned(LEUART_TypeDef *leuart, const uint8_t *data, uint32_t length, uint32_t release_evt){
+  if(length == 0){
+      add_scheduled_event(release_evt);
+      return true;
+  }
+  if((leuart0_state.tx_q_head - leuart0_state.tx_q_tail) == LEUART_TX_QUEUE_SIZE){
+      return false;
+  }
 
-  strcpy(leuart0_state.data, string);
+  leuart_queue(leuart, data, length, release_evt);
+  return true;
+}
 
-  leuart->IEN |= LEUART_IEN_TXBL;
-  CORE_EXIT_CRITICAL();
+/***************************************************************************//**
+ * @brief
+ * Reads one received frame out of the receive ring.
+ *
+ * @details
+ * Copies bytes from the receive ring up to and including the signal frame.
+ * Nothing is returned until a whole frame has been received, and a frame that
+ * is longer than string is cut short but still removed from the ring. If
+ * signal frames are not used, everything received so far is copied. The
+ * string is always null terminated. Only the main loop reads the ring, so
+ * no critical section is needed.
+ *
+ * @note
+ * Called by ble read after the receive done event is posted.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @param[out] char *string
+ * The buffer the frame is copied into.
+ *
+ * @param[in] uint32_t max_len
+ * Size of string in bytes, including the null terminator.
+ *
+ * @return
+ * Number of bytes copied, not counting the null terminator.
+ ******************************************************************************/
+
+uint32_t leuart_receive(LEUART_TypeDef *leuart, char *string, uint32_t max_len){
+  uint32_t tail = leuart0_state.rx_tail;
+  uint32_t len = 0;
+  char byte;
+
+  (void)leuart;
+  EFM_ASSERT(max_len > 0);
+
+  if(leuart0_state.sigframe_en && (leuart0_state.rx_frames_in == leuart0_state.rx_frames_out)){
+      string[0] = 0;
+      return 0;           //Nothing but a partial frame in the ring
+  }
+
+  while(tail != leuart0_state.rx_head){
+      byte = leuart0_state.rx_buffer[tail & LEUART_RX_BUFFER_MASK];
+      tail++;
+      if(len < (max_len - 1)){
+          string[len++] = byte;       //A frame too long for string is cut short
+      }
+      if(leuart0_state.sigframe_en && (byte == leuart0_state.sigframe)){
+          break;
+      }
+  }
+  if(leuart0_state.sigframe_en){
+      leuart0_state.rx_frames_out++;    //Also when the signal frame itself was lost to an overflow
+  }
+  leuart0_state.rx_tail = tail;
+  string[len] = 0;
+
+  return len;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Tells whether anything is still queued or going out.
+ *
+ * @details
+ * The state machine is available again once the last byte of the transmit
+ * queue has left the shift register.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @return
+ * true until the transmit queue is empty and the line is idle.
+ ******************************************************************************/
+
+bool leuart_tx_busy(LEUART_TypeDef *leuart){
+  (void)leuart;
+  return !leuart0_state.available;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Changes the baud rate of a LEUART that is already open.
+ *
+ *
+ * @details
+ * The LEUART is disabled while LFB is moved to the clock the new rate needs
+ * and CLKDIV is rewritten, then enabled again the way leuart_open() left it.
+ * The receiver is blocked again if RX blocking is used and nothing is being
+ * monitored, since a disabled receiver forgets where it was in a frame.
+ *
+ * @note
+ * Nothing is changed while a transmit is going out, the caller tries again
+ * later. Transmits are only started from the main loop, so the transmitter
+ * stays idle once this has checked it. A byte arriving while the rate
+ * changes is lost.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @param[in] uint32_t baudrate
+ * The new rate.
+ *
+ * @return
+ * false if the transmitter was busy and the rate was left alone.
+ ******************************************************************************/
+
+bool leuart_baud_set(LEUART_TypeDef *leuart, uint32_t baudrate){
+  if(!leuart0_state.available){
+      return false;
+  }
+
+  LEUART_Enable(leuart, leuartDisable);
+  while(leuart->SYNCBUSY);
+  leuart_clock_select(&leuart0_state, baudrate);
+  LEUART_BaudrateSet(leuart, 0, baudrate);      //0 reads the LEUART0 clock that was just selected
+  while(leuart->SYNCBUSY);
+  leuart0_state.baudrate = baudrate;
+  leuart0_state.rx_in_frame = false;
+
+  LEUART_Enable(leuart, leuart0_state.enable);
+  while(leuart->SYNCBUSY);
+  if(leuart0_state.rx_en && leuart0_state.rxblocken && !leuart0_state.rx_monitor){
+      leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);
+  }
+  return true;
+}
 
+/***************************************************************************//**
+ * @brief
+ * Returns the baud rate the LEUART is running at.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @return
+ * The rate from leuart_open() or the last leuart_baud_set().
+ ******************************************************************************/
+
+uint32_t leuart_baud_get(LEUART_TypeDef *leuart){
+  (void)leuart;
+  return leuart0_state.baudrate;
 }
 
 /***************************************************************************//**
  * @brief
+ * Hands the bytes received outside frames to callback.
+ *
+ *
+ * @details
+ * Replies from the module that are not framed, like the HM-18's AT responses,
+ * are thrown away by the blocked receiver. Setting a callback, or setting the
+ * same one again, unblocks the receiver, and every byte outside a frame is
+ * passed to it from the LEUART interrupt, framed bytes still go to the
+ * receive ring. Each of those bytes costs an interrupt, so when the callback
+ * returns false the receiver is blocked again until the next start frame or
+ * the next call of this. Setting callback to NULL blocks the receiver again,
+ * at the end of the frame if one is coming in.
+ *
+ * @note
+ * callback runs in the LEUART interrupt and must be short.
+ *
+ * @param[in] LEUART_TypeDef *leuart
+ * This is the type of LEUART we are using.
+ *
+ * @param[in] callback
+ * The function to call, NULL to stop monitoring.
+ *
+ * @param[in] context
+ * Passed to callback.
  *
  ******************************************************************************/
 
-//bool leuart_tx_busy(LEUART_TypeDef *leuart){
-//}
+void leuart_rx_monitor(LEUART_TypeDef *leuart, LEUART_RX_CALLBACK callback, void *context){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  leuart0_state.rx_monitor = callback;
+  leuart0_state.rx_context = context;
+  if(leuart0_state.rx_en && leuart0_state.rxblocken){
+      if(callback){
+          leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKDIS);
+      }
+      else if(!leuart0_state.rx_in_frame){
+          leuart_cmd_write(leuart, LEUART_CMD_RXBLOCKEN);   //Otherwise sigf_func() blocks it
+      }
+  }
+  CORE_EXIT_CRITICAL();
+}
 
 /***************************************************************************//**
  * @brief
@@ -308,6 +862,7 @@ uint32_t leuart_status(LEUART_TypeDef *leuart){
 
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update){
 
+	while(leuart->SYNCBUSY);		//A CMD written from the ISR may still be synchronizing
 	leuart->CMD = cmd_update;
 	while(leuart->SYNCBUSY);
 }
@@ -397,7 +952,8 @@ uint8_t leuart_app_receive_byte(LEUART_TypeDef *leuart){
  * @details
  * This saves the flags that are raised then clears the flags. It then checks the flags,
  * if the TXBL is raised we call the handler function for write. If the TXC interrupt is
- * raised, we call the stop function.
+ * raised, we call the stop function. Received bytes are handled before the signal frame
+ * so the frame is complete in the ring when the receive done event is posted.
  *
  * @note
  * N/A
@@ -405,6 +961,7 @@ uint8_t leuart_app_receive_byte(LEUART_TypeDef *leuart){
  ******************************************************************************/
 
 void LEUART0_IRQHandler(void){
+  PROFILE_ENTER(PROF_LEUART0_IRQ);
   uint32_t int_flag = LEUART0->IF & LEUART0->IEN;
   LEUART0->IFC = int_flag;
 
@@ -416,6 +973,14 @@ void LEUART0_IRQHandler(void){
       stop_func(&leuart0_state);
   }
 
+  if(int_flag & LEUART_IF_RXDATAV){
+      rxdatav_func(&leuart0_state);
+  }
+
+  if(int_flag & LEUART_IF_SIGF){
+      sigf_func(&leuart0_state);
+  }
+  PROFILE_EXIT(PROF_LEUART0_IRQ);
 }
 
 
@@ -0,0 +1,150 @@
+/**
+ * @file
+ * profile.c
+ * @author
+ * agent
+ * @date
+ * 10/16/26
+ * @brief
+ * Keeps the count, min, max and total run time of the regions marked with
+ * PROFILE_ENTER and PROFILE_EXIT. Empty unless PROFILE_ENABLED, profile.h
+ * has no-op stand-ins then.
+ *
+ */
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "profile.h"
+
+#if PROFILE_ENABLED
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static PROFILE_STATS profile_stats[PROFILE_REGIONS];
+
+static const char *profile_names[PROFILE_REGIONS] = {
+    [PROF_LEUART0_IRQ]      = "leuart0",
+    [PROF_I2C0_IRQ]         = "i2c0",
+    [PROF_I2C1_IRQ]         = "i2c1",
+    [PROF_LETIMER0_IRQ]     = "letimer0",
+    [PROF_GPIO_IRQ]         = "gpio",
+    [PROF_LDMA_IRQ]         = "ldma",
+    [PROF_SI1133_READ_CB]   = "si1133_read",
+    [PROF_REPORT_TIMER_CB]  = "report",
+    [PROF_BATCH_TIMER_CB]   = "batch",
+};
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Starts the cycle counter and zeroes every region
+ *
+ *
+ * @note
+ * Called in app_peripheral_setup, before any interrupt is enabled
+ *
+ ******************************************************************************/
+void profile_open(void){
+  PROFILE_CYCLES_INIT();
+  profile_reset();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Zeroes every region
+ *
+ ******************************************************************************/
+void profile_reset(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(int i = 0; i < PROFILE_REGIONS; i++){
+      profile_stats[i] = (PROFILE_STATS){ .min = UINT32_MAX };
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds one run of a region
+ *
+ *
+ * @details
+ * Regions in interrupts can nest, so the update takes a critical section.
+ *
+ *
+ * @note
+ * Called by PROFILE_EXIT, from interrupts and the main loop
+ *
+ * @param[in] region
+ * The region that ran.
+ *
+ * @param[in] cycles
+ * How long it ran.
+ *
+ ******************************************************************************/
+void profile_record(PROFILE_REGION region, uint32_t cycles){
+  PROFILE_STATS *stats = &profile_stats[region];
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  stats->count++;
+  stats->total += cycles;
+  if(cycles < stats->min){
+      stats->min = cycles;
+  }
+  if(cycles > stats->max){
+      stats->max = cycles;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies the stats of one region
+ *
+ *
+ * @param[in] region
+ * The region.
+ *
+ * @param[out] stats
+ * Filled in, all zeros if the region never ran.
+ *
+ ******************************************************************************/
+void profile_get(PROFILE_REGION region, PROFILE_STATS *stats){
+  EFM_ASSERT(region < PROFILE_REGIONS);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *stats = profile_stats[region];
+  CORE_EXIT_CRITICAL();
+  if(!stats->count){
+      stats->min = 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the name of a region for the report
+ *
+ ******************************************************************************/
+const char *profile_name(PROFILE_REGION region){
+  EFM_ASSERT(region < PROFILE_REGIONS);
+  return profile_names[region];
+}
+
+#endif
@@ -25,6 +25,155 @@
 
 static unsigned int event_scheduled;
 
+// Pending registered events by priority, priority p is bit 31 - p so __CLZ
+// returns the highest priority (lowest number) pending
+static uint32_t priority_scheduled;
+
+static SCHEDULER_HANDLER scheduler_handler[SCHEDULER_MAX_EVENTS];    //by priority
+static uint32_t scheduler_event[SCHEDULER_MAX_EVENTS];                //by priority
+static uint8_t event_priority[SCHEDULER_MAX_EVENTS];                  //by event bit number
+static uint32_t event_registered;
+
+// Queued events, every post is a record and runs its handler once. The records
+// come from one pool and each event keeps its own list, oldest first, so an
+// event's posts run in order and its priority bit is set while it has any.
+static SCHEDULER_PAYLOAD_HANDLER scheduler_payload_handler[SCHEDULER_MAX_EVENTS];   //by priority
+static uint32_t event_queued;
+static SCHEDULER_RECORD scheduler_pool[SCHEDULER_QUEUE_SIZE];
+static uint8_t pool_free;                                     //first unused record
+static uint8_t queue_first[SCHEDULER_MAX_EVENTS];             //oldest record, by event bit number
+static uint8_t queue_last[SCHEDULER_MAX_EVENTS];              //newest record, by event bit number
+
+#if SCHEDULER_STATS
+static SCHEDULER_EVENT_STATS event_stats[SCHEDULER_MAX_EVENTS];     //by event bit number
+#endif
+
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Converts a mask of events to the same events in priority order
+ *
+ *
+ * @details
+ * Only registered events are converted. Normally one bit is set, so the loop
+ * runs once.
+ *
+ * @note
+ * Called with interrupts disabled
+ *
+ * @param[in] event
+ * The events to convert.
+ *
+ * @return
+ * The events as a priority_scheduled mask.
+ ******************************************************************************/
+static uint32_t scheduler_priority_mask(uint32_t event){
+  uint32_t mask = 0;
+  uint32_t bit;
+
+  event &= event_registered;
+  while(event){
+      bit = 31 - __CLZ(event);
+      event &= ~(1u << bit);
+      mask |= 0x80000000u >> event_priority[bit];
+  }
+  return mask;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a record to the end of a queued event's list
+ *
+ *
+ * @details
+ * The record is taken from the free list. The event stays in
+ * event_scheduled, and its priority bit stays set, while its list is not
+ * empty.
+ *
+ * @note
+ * Called with interrupts disabled
+ *
+ * @param[in] bit
+ * Bit number of the queued event.
+ *
+ * @param[in] payload
+ * Handed to the event's handler.
+ *
+ * @return
+ * false if every record was in use and the post was dropped.
+ ******************************************************************************/
+static bool scheduler_queue_push(uint32_t bit, uint32_t payload){
+  SCHEDULER_RECORD *record;
+  uint8_t index;
+
+  if(pool_free == SCHEDULER_NO_RECORD){
+#if SCHEDULER_STATS
+      event_stats[bit].posts++;
+      event_stats[bit].overruns++;
+#endif
+      return false;
+  }
+  index = pool_free;
+  record = &scheduler_pool[index];
+  pool_free = record->next;
+  record->payload = payload;
+  record->next = SCHEDULER_NO_RECORD;
+#if SCHEDULER_STATS
+  record->posted = SCHEDULER_CYCLES();
+  event_stats[bit].posts++;
+  event_stats[bit].last_post = record->posted;
+#endif
+  if(queue_first[bit] == SCHEDULER_NO_RECORD){
+      queue_first[bit] = index;
+      event_scheduled |= 1u << bit;
+      priority_scheduled |= scheduler_priority_mask(1u << bit);
+  }
+  else{
+      scheduler_pool[queue_last[bit]].next = index;
+  }
+  queue_last[bit] = index;
+  return true;
+}
+
+#if SCHEDULER_STATS
+/***************************************************************************//**
+ * @brief
+ * Counts a post of every event in a mask
+ *
+ *
+ * @details
+ * A post to an event that is already pending is an overrun, the bitmask
+ * merges it with the one before and its handler only runs once. Otherwise the
+ * post time is kept for the latency.
+ *
+ * @note
+ * Called with interrupts disabled, before event_scheduled is updated
+ *
+ * @param[in] event
+ * The events being posted.
+ ******************************************************************************/
+static void scheduler_stats_post(uint32_t event){
+  uint32_t now = SCHEDULER_CYCLES();
+  uint32_t bit;
+
+  while(event){
+      bit = 31 - __CLZ(event);
+      event &= ~(1u << bit);
+      event_stats[bit].posts++;
+      if(event_scheduled & (1u << bit)){
+          event_stats[bit].overruns++;
+      }
+      else{
+          event_stats[bit].last_post = now;
+      }
+  }
+}
+#endif
+
 
 //***********************************************************************************
 // Global functions
@@ -37,7 +186,7 @@ static unsigned int event_scheduled;
  *
  *
  * @details
- * Sets the static variable event_scheduled to 0
+ * Sets the static variable event_scheduled to 0 and empties the handler table
  *
  *
  *
@@ -48,7 +197,23 @@ static unsigned int event_scheduled;
  ******************************************************************************/
 void scheduler_open(void){
   event_scheduled = 0;
-
+  priority_scheduled = 0;
+  event_registered = 0;
+  event_queued = 0;
+  for(int i = 0; i < SCHEDULER_MAX_EVENTS; i++){
+      scheduler_handler[i] = 0;
+      scheduler_payload_handler[i] = 0;
+      scheduler_event[i] = 0;
+      queue_first[i] = SCHEDULER_NO_RECORD;
+  }
+  for(int i = 0; i < SCHEDULER_QUEUE_SIZE; i++){
+      scheduler_pool[i].next = (i + 1 < SCHEDULER_QUEUE_SIZE) ? (uint8_t)(i + 1) : SCHEDULER_NO_RECORD;
+  }
+  pool_free = 0;
+#if SCHEDULER_STATS
+  SCHEDULER_CYCLES_INIT();
+  scheduler_stats_reset();
+#endif
 }
 
 /***************************************************************************//**
@@ -57,7 +222,7 @@ void scheduler_open(void){
  *
  *
  * @details
- * Disables interrupts then adds the event to the event scheduled.
+ * Posts the event with a payload of 0, see scheduler_post.
  *
  *
  *
@@ -74,10 +239,59 @@ void scheduler_open(void){
  ******************************************************************************/
 
 void add_scheduled_event(uint32_t event){
-    CORE_DECLARE_IRQ_STATE;
-    CORE_ENTER_CRITICAL();
-    event_scheduled |= event;
-    CORE_EXIT_CRITICAL();
+  scheduler_post(event, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Posts events, with a payload for the queued ones
+ *
+ *
+ * @details
+ * Disables interrupts then adds the events to the event scheduled. A plain
+ * event that is already pending is merged with the post before it and the
+ * payload is not kept. Each post of an event registered with
+ * scheduler_register_queued is a record in the event's list instead, so its
+ * handler runs once a post with that post's payload. Every post is counted, see
+ * scheduler_stats_get.
+ *
+ *
+ * @note
+ * Safe from interrupts at any priority and from the main loop. Every
+ * producer takes the same short critical section as the plain events, which
+ * is what keeps nested interrupts from claiming the same slot. The main loop
+ * is the only consumer.
+ *
+ *
+ * @param[in] event
+ * The events to post.
+ *
+ * @param[in] payload
+ * Handed to the handler of a queued event.
+ *
+ * @return
+ * false if every record was in use and a queued post was dropped.
+ ******************************************************************************/
+bool scheduler_post(uint32_t event, uint32_t payload){
+  uint32_t queued = event & event_queued;
+  uint32_t bit;
+  bool posted = true;
+
+  event &= ~queued;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+#if SCHEDULER_STATS
+  scheduler_stats_post(event);
+#endif
+  event_scheduled |= event;
+  priority_scheduled |= scheduler_priority_mask(event);
+  while(queued){
+      bit = 31 - __CLZ(queued);
+      queued &= ~(1u << bit);
+      posted &= scheduler_queue_push(bit, payload);
+  }
+  CORE_EXIT_CRITICAL();
+  return posted;
 }
 
 /***************************************************************************//**
@@ -87,7 +301,8 @@ void add_scheduled_event(uint32_t event){
  *
  *
  * @details
- * Disables interrupts then removes the event to the event scheduled.
+ * Disables interrupts then removes the event to the event scheduled. Not for
+ * queued events.
  *
  *
  *
@@ -102,9 +317,12 @@ void add_scheduled_event(uint32_t event){
  *
  ******************************************************************************/
 void remove_scheduled_event(uint32_t event){
+  EFM_ASSERT(!(event & event_queued));                 //records are only taken by scheduler_dispatch
+
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
   event_scheduled &= ~event;
+  priority_scheduled &= ~scheduler_priority_mask(event);
   CORE_EXIT_CRITICAL();
 }
 
@@ -114,7 +332,8 @@ void remove_scheduled_event(uint32_t event){
  *
  *
  * @details
- * Simply returns the event_scheduled static variable
+ * Simply returns the event_scheduled static variable. A queued event is set
+ * while it has a record in its list.
  *
  *
  *
@@ -129,5 +348,237 @@ uint32_t get_scheduled_events(void){
   return(event_scheduled);
 }
 
+/***************************************************************************//**
+ * @brief
+ * Registers the handler for an event
+ *
+ *
+ * @details
+ * scheduler_dispatch calls handler whenever event has been scheduled. When
+ * several events are pending the one with the lowest priority number runs
+ * first. Each priority can only be used by one event.
+ *
+ *
+ * @note
+ * Called in the peripheral setup, after scheduler_open
+ *
+ *
+ * @param[in] event
+ * The event, exactly one bit.
+ *
+ * @param[in] handler
+ * The function that handles the event.
+ *
+ * @param[in] priority
+ * 0 is the highest priority, SCHEDULER_MAX_EVENTS - 1 the lowest.
+ *
+ ******************************************************************************/
+void scheduler_register(uint32_t event, SCHEDULER_HANDLER handler, uint32_t priority){
+  uint32_t bit;
+
+  EFM_ASSERT(event && !(event & (event - 1)));          //exactly one event
+  EFM_ASSERT(priority < SCHEDULER_MAX_EVENTS);
+  EFM_ASSERT(handler);
+  EFM_ASSERT(!scheduler_handler[priority] && !scheduler_payload_handler[priority]);   //priority already taken
+  EFM_ASSERT(!(event_registered & event));
+
+  bit = 31 - __CLZ(event);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  scheduler_handler[priority] = handler;
+  scheduler_event[priority] = event;
+  event_priority[bit] = (uint8_t)priority;
+  event_registered |= event;
+  priority_scheduled |= scheduler_priority_mask(event_scheduled & event);  //already posted before registering
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Registers the handler for an event that is counted instead of merged
+ *
+ *
+ * @details
+ * Every post of the event is kept as a record, with its payload, and the
+ * handler runs once a record. For events that must not be lost when they come
+ * faster than the main loop, or that carry a value, like the result of an I2C
+ * read. The posts of one event run in the order they were posted. Between
+ * events priority decides as for plain events, a queued event is pending
+ * while it has a record. The queued events share SCHEDULER_QUEUE_SIZE
+ * records.
+ *
+ *
+ * @note
+ * Called in the peripheral setup, before the event is first posted
+ *
+ *
+ * @param[in] event
+ * The event, exactly one bit.
+ *
+ * @param[in] handler
+ * The function that handles each post, with the post's payload.
+ *
+ * @param[in] priority
+ * 0 is the highest priority, SCHEDULER_MAX_EVENTS - 1 the lowest.
+ *
+ ******************************************************************************/
+void scheduler_register_queued(uint32_t event, SCHEDULER_PAYLOAD_HANDLER handler, uint32_t priority){
+  uint32_t bit;
+
+  EFM_ASSERT(event && !(event & (event - 1)));          //exactly one event
+  EFM_ASSERT(priority < SCHEDULER_MAX_EVENTS);
+  EFM_ASSERT(handler);
+  EFM_ASSERT(!scheduler_handler[priority] && !scheduler_payload_handler[priority]);   //priority already taken
+  EFM_ASSERT(!(event_registered & event));
+  EFM_ASSERT(!(event_scheduled & event));               //a post before this was not queued
 
+  bit = 31 - __CLZ(event);
 
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  scheduler_payload_handler[priority] = handler;
+  scheduler_event[priority] = event;
+  event_priority[bit] = (uint8_t)priority;
+  event_registered |= event;
+  event_queued |= event;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the handler of the highest priority pending event
+ *
+ *
+ * @details
+ * The highest priority pending event is found with one count leading zeros,
+ * and is removed from the scheduler in the same critical section so an
+ * interrupt posting it again is never lost. A queued event takes the oldest
+ * record off its list and stays pending if there is another one. The
+ * handler runs with interrupts enabled. The time since the post and the
+ * handler's run time go into the event's stats.
+ *
+ *
+ * @note
+ * Called in the main loop, once per pass so a higher priority event posted by
+ * a handler runs next.
+ *
+ * @return
+ * true if a handler was run, false if no registered event was pending.
+ ******************************************************************************/
+bool scheduler_dispatch(void){
+  uint32_t priority;
+  uint32_t bit;
+  SCHEDULER_HANDLER handler;
+  SCHEDULER_PAYLOAD_HANDLER payload_handler;
+  SCHEDULER_RECORD record;
+  uint8_t index;
+#if SCHEDULER_STATS
+  SCHEDULER_EVENT_STATS *stats;
+  uint32_t start;
+#endif
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(!priority_scheduled){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  priority = __CLZ(priority_scheduled);
+  priority_scheduled &= ~(0x80000000u >> priority);
+  bit = 31 - __CLZ(scheduler_event[priority]);
+  handler = scheduler_handler[priority];
+  payload_handler = scheduler_payload_handler[priority];
+  if(payload_handler){
+      index = queue_first[bit];
+      EFM_ASSERT(index != SCHEDULER_NO_RECORD);
+      record = scheduler_pool[index];
+      queue_first[bit] = record.next;
+      scheduler_pool[index].next = pool_free;
+      pool_free = index;
+      if(queue_first[bit] == SCHEDULER_NO_RECORD){
+          event_scheduled &= ~scheduler_event[priority];
+      }
+      else{
+          priority_scheduled |= 0x80000000u >> priority;
+      }
+  }
+  else{
+      event_scheduled &= ~scheduler_event[priority];
+  }
+#if SCHEDULER_STATS
+  start = SCHEDULER_CYCLES();
+  stats = &event_stats[bit];
+  stats->runs++;
+  stats->last_dispatch = start;
+  stats->latency_last = start - (payload_handler ? record.posted : stats->last_post);
+  if(stats->latency_last > stats->latency_max){
+      stats->latency_max = stats->latency_last;
+  }
+#endif
+  CORE_EXIT_CRITICAL();
+
+  if(payload_handler){
+      payload_handler(record.payload);
+  }
+  else{
+      handler();
+  }
+#if SCHEDULER_STATS
+  stats->run_last = SCHEDULER_CYCLES() - start;
+  if(stats->run_last > stats->run_max){
+      stats->run_max = stats->run_last;
+  }
+#endif
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Zeroes the stats of every event
+ *
+ *
+ * @note
+ * Called in scheduler_open, and to start a new measurement
+ *
+ ******************************************************************************/
+void scheduler_stats_reset(void){
+#if SCHEDULER_STATS
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(int i = 0; i < SCHEDULER_MAX_EVENTS; i++){
+      event_stats[i] = (SCHEDULER_EVENT_STATS){0};
+  }
+  CORE_EXIT_CRITICAL();
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies the stats of one event
+ *
+ *
+ * @details
+ * The copy is taken with interrupts disabled, so the counts and times agree
+ * with each other. Events do not have to be registered, posts to an event
+ * that is only polled with get_scheduled_events are counted too.
+ *
+ *
+ * @param[in] event
+ * The event, exactly one bit.
+ *
+ * @param[out] stats
+ * Filled in, all zeros if SCHEDULER_STATS is 0.
+ *
+ ******************************************************************************/
+void scheduler_stats_get(uint32_t event, SCHEDULER_EVENT_STATS *stats){
+  EFM_ASSERT(event && !(event & (event - 1)));
+#if SCHEDULER_STATS
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *stats = event_stats[31 - __CLZ(event)];
+  CORE_EXIT_CRITICAL();
+#else
+  *stats = (SCHEDULER_EVENT_STATS){0};
+#endif
+}
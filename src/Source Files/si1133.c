@@ -22,100 +22,261 @@
 // Private variables
 //***********************************************************************************
 static uint32_t data;     //This is the read data, poor naming convention
-static uint32_t si1133_write_data;
+static uint8_t si1133_burst[SI1133_BURST_MAX];    //IRQ_STATUS then HOSTOUT0 onwards, read as one burst
+static uint32_t si1133_burst_len;
+static const SI1133_CHANNEL *si1133_channels;
+static uint32_t si1133_channel_count;
+static uint32_t si1133_write_data;      //copied by i2c_start, so it can be reused right away
+static SI1133_CONFIG_STATE_MACHINE si1133_config_sm;
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
 
 /***************************************************************************//**
  * @brief
- * Configures the si1133 to read from the light sensor and sets channel 0 as the
- * active channel
+ * Queues a one byte register write for the configuration
  *
  * @details
- * We first reset the reset cmd ctr to prevent any unwanted bugs. Then we read the
- * response0 register which is what holds the cmd ctr. We then store that value
- * for a check later. After, we then write the color of the white light sensor
- * to the input0 register. We then write the address we wish to send the input0 to,
- * This register is the ADC config register.Then we read the cmd counter again,
- * if it has incremented we move on. If not we fail an assert. After, we then write
- * Send the value of channel0 to input0. We then send chan list to the command register
- * to tell the board where to send input0. Finally we read response0 again and ensure
- * that cmd ctr has incremented again.
+ * The value is copied when it is queued. A step never has more than four
+ * transfers in the queue, so there is always room.
  *
  *
+ ******************************************************************************/
+static void si1133_config_write(uint32_t register_address, uint32_t value){
+  EFM_ASSERT(i2c_start(0, &value, 1, SI1133_ADDRESS, register_address, I2C1, NULL_CB));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues the RESPONSE0 read that ends every configuration step
  *
+ * @details
+ * Posts config_evt once it is in, so si1133_config_cb runs from the main loop
+ * with RESPONSE0 as the payload.
  *
- * @note
- * Called in Si1133_i2c_open
  *
  ******************************************************************************/
+static void si1133_config_poll(void){
+  EFM_ASSERT(i2c_start(1, NULL, 1, SI1133_ADDRESS, RESPONSE0, I2C1, si1133_config_sm.config_evt));
+}
 
-static void si1133_config(){
-  uint32_t cmd_ctr;
-  //resets the counter, avoids issue where counter is at 14 or 15
-  si1133_write_data = RESET_CMD_CTR;
-  Si1133_write(1,COMMAND_REG,NULL_CB);
-  while(!(is_available(I2C1)));
-
-  //read response0
-  Si1133_read(1, RESPONSE0, NULL_CB);
-
-  //wait
-  while(!(is_available(I2C1)));
-
-  //store value of cmd_ctr (used later)
-  cmd_ctr = data & 0x0F;      //Gets the lower 4 bits of respponse0 aka CMD_CTR
-
-
-
-  //All of this is in the first example on page 14
-  //Here we write the value to input zero
-  si1133_write_data = WHITE;
-  Si1133_write(1,INPUT0,NULL_CB);
-
-  //Wait until we finish
-  while(!(is_available(I2C1)));
-
-  //Write the param_set and the address of ADC_CONFIG to the command register
-  si1133_write_data = PARAM_SET | ADC_CONFIG0;
-  Si1133_write(1,COMMAND_REG,NULL_CB);
-
-  //Wait until we finish
-  while(!(is_available(I2C1)));
+/***************************************************************************//**
+ * @brief
+ * Queues the transfers of the current configuration state
+ *
+ * @details
+ * RESET_CMD_CTR in the reset state. Otherwise a parameter set is INPUT0 then
+ * PARAM_SET with the parameter address, and the START step enables the last
+ * channel's interrupt, reads IRQ_STATUS so a result left over from before does
+ * not hold INT low, then sends START. Every one ends with a RESPONSE0 read.
+ *
+ *
+ ******************************************************************************/
+static void si1133_config_send(void){
+  const SI1133_STEP *step = &si1133_config_sm.steps[si1133_config_sm.step];
 
-  //read response0, then we check to to see if cmd_ctl has incremented
-  Si1133_read(1, RESPONSE0, NULL_CB);
-  while(!(is_available(I2C1)));
+  si1133_config_sm.step_failed = false;
+  si1133_config_sm.polls = 0;
+  if(si1133_config_sm.state == si1133_config_reset){
+      si1133_config_write(COMMAND_REG, RESET_CMD_CTR);
+  }
+  else if(step->param == SI1133_STEP_START){
+      si1133_config_write(IRQ_ENABLE, 1u << (si1133_channel_count - 1));
+      EFM_ASSERT(i2c_start(1, &si1133_config_sm.irq_status, 1, SI1133_ADDRESS, IRQ_STATUS, I2C1, NULL_CB));
+      si1133_config_write(COMMAND_REG, START);
+  }
+  else{
+      si1133_config_write(INPUT0, step->value);
+      si1133_config_write(COMMAND_REG, PARAM_SET | step->param);
+  }
+  si1133_config_poll();
+}
 
-  if((data & 0x0F) != (cmd_ctr + 1)){
-      EFM_ASSERT(false);
+/***************************************************************************//**
+ * @brief
+ * Tries the current step again, or gives up on the configuration
+ *
+ * @details
+ * A failed command leaves CMD_ERR set and the si1133 ignores commands until
+ * RESET_CMD_CTR, so every retry starts with the reset. Parameters that already
+ * went through keep their values. After SI1133_CONFIG_RETRIES the error event
+ * is posted and ready_evt never is.
+ *
+ *
+ ******************************************************************************/
+static void si1133_config_retry(void){
+  if(++si1133_config_sm.retries > SI1133_CONFIG_RETRIES){
+      si1133_config_sm.state = si1133_config_failed;
+      add_scheduled_event(si1133_config_sm.error_evt);
+      return;
   }
+  si1133_config_sm.state = si1133_config_reset;
+  si1133_config_send();
+}
 
-  //Preps channel 0 to be active
-  si1133_write_data = CHAN0_PREP;
-  Si1133_write(1,INPUT0,NULL_CB);
+/***************************************************************************//**
+ * @brief
+ * Finishes the configuration
+ *
+ * @details
+ * In autonomous mode the INT pin interrupt is opened here. The first result
+ * takes a whole period after START, but if one came in already its falling
+ * edge was missed, so result_evt is posted for it.
+ *
+ *
+ ******************************************************************************/
+static void si1133_config_finish(void){
+  si1133_config_sm.state = si1133_config_done;
+  if(si1133_config_sm.period_ms){
+      gpio_int_open(SI1133_INT_PORT, SI1133_INT_PIN, false, true, si1133_config_sm.result_evt);
+      if(Si1133_int_pending()){
+          add_scheduled_event(si1133_config_sm.result_evt);
+      }
+  }
+  add_scheduled_event(si1133_config_sm.ready_evt);
+}
 
-  while(!(is_available(I2C1)));
+/***************************************************************************//**
+ * @brief
+ * Advances the configuration from a RESPONSE0 read
+ *
+ * @details
+ * The reset state is done once CMD_CTR reads 0 and a step once CMD_CTR is one
+ * past what it was before the step. A counter that has not moved yet means
+ * the command is still running, so RESPONSE0 is read again, up to
+ * SI1133_CMD_POLLS times. CMD_ERR, a lost command or a transfer of the step
+ * that failed for good retries the step.
+ *
+ *
+ * @note
+ * Queued handler of config_evt, also called by si1133_i2c_error_cb when the
+ * RESPONSE0 read itself failed and config_evt will never come
+ *
+ * @param[in] response
+ * RESPONSE0, not used when a transfer of the step failed.
+ *
+ ******************************************************************************/
+static void si1133_config_cb(uint32_t response){
+  uint32_t expected;
 
-  //This is what we are writing to the command register
-  si1133_write_data = PARAM_SET | CHAN_LIST;
-  Si1133_write(1,COMMAND_REG,NULL_CB);
+  if((si1133_config_sm.state != si1133_config_reset) && (si1133_config_sm.state != si1133_config_step)){
+      return;
+  }
+  if(si1133_config_sm.step_failed || (response & RESPONSE0_CMD_ERR)){
+      si1133_config_retry();
+      return;
+  }
 
-  //wait
-  while(!(is_available(I2C1)));
+  if(si1133_config_sm.state == si1133_config_reset){
+      expected = 0;
+  }
+  else{
+      expected = (si1133_config_sm.cmd_ctr + 1) & RESPONSE0_CMD_CTR;
+  }
+  if((response & RESPONSE0_CMD_CTR) != expected){
+      if(si1133_config_sm.polls++ < SI1133_CMD_POLLS){
+          si1133_config_poll();
+      }
+      else{
+          si1133_config_retry();
+      }
+      return;
+  }
 
-  //Read then check if the cmd_ctr has incremented
-  Si1133_read(1, RESPONSE0, NULL_CB);
+  si1133_config_sm.cmd_ctr = expected;
+  if(si1133_config_sm.state == si1133_config_reset){
+      si1133_config_sm.state = si1133_config_step;
+  }
+  else{
+      si1133_config_sm.step++;
+      si1133_config_sm.retries = 0;
+  }
+  if(si1133_config_sm.step == si1133_config_sm.step_count){
+      si1133_config_finish();
+  }
+  else{
+      si1133_config_send();
+  }
+}
 
-  while(!(is_available(I2C1)));
+/***************************************************************************//**
+ * @brief
+ * Handles a transfer to the si1133 that failed for good
+ *
+ * @details
+ * While configuring, the step is marked failed. i2c_error_evt is a higher
+ * priority than config_evt, so the step's RESPONSE0 read is never taken as
+ * good when a transfer before it failed. If the bus is already idle and
+ * config_evt is not pending it was the read that failed, so the step is
+ * retried now. The error is always passed on to the app's error event.
+ *
+ *
+ ******************************************************************************/
+static void si1133_i2c_error_cb(void){
+  if((si1133_config_sm.state == si1133_config_reset) || (si1133_config_sm.state == si1133_config_step)){
+      si1133_config_sm.step_failed = true;
+      if(is_available(I2C1) && !(get_scheduled_events() & si1133_config_sm.config_evt)){
+          si1133_config_cb(0);
+      }
+  }
+  add_scheduled_event(si1133_config_sm.error_evt);
+}
 
-  //Problem occurs here, cmd ctr doesn't increment again for some reason
-  if((data & 0x0F) != (cmd_ctr + 2)){
-      EFM_ASSERT(false);
+/***************************************************************************//**
+ * @brief
+ * Works out the configuration steps from the channel table
+ *
+ * @details
+ * CHAN_LIST and the parameters of every channel, then in autonomous mode
+ * MEAS_RATE, MEAS_COUNT0 and START. Every channel is measured on MEAS_COUNT0,
+ * so they all come back in the same period. The burst length of a result read
+ * is set from the result sizes.
+ *
+ *
+ * @note
+ * Called in Si1133_i2c_open
+ *
+ ******************************************************************************/
+static void si1133_config(void){
+  SI1133_STEP *steps = si1133_config_sm.steps;
+  uint32_t count = 0;
+  uint32_t chan_list = 0;
+  uint32_t meas_rate;
+  const SI1133_CHANNEL *channel;
+
+  si1133_burst_len = 1;         //IRQ_STATUS
+  for(uint32_t n = 0; n < si1133_channel_count; n++){
+      channel = &si1133_channels[n];
+      EFM_ASSERT((channel->decim_rate <= 3) && (channel->hw_gain <= 11) && (channel->sw_gain <= 7));
+
+      chan_list |= 1u << n;
+      steps[count].param = ADCCONFIG0 + SI1133_CHAN_PARAMS*n;
+      steps[count++].value = (channel->decim_rate << ADCCONFIG_DECIM_SHIFT) | channel->adcmux;
+      steps[count].param = ADCSENS0 + SI1133_CHAN_PARAMS*n;
+      steps[count++].value = (channel->hsig ? ADCSENS_HSIG : 0) | (channel->sw_gain << ADCSENS_SW_GAIN_SHIFT) | channel->hw_gain;
+      steps[count].param = ADCPOST0 + SI1133_CHAN_PARAMS*n;
+      steps[count++].value = channel->out24 ? ADCPOST_24BIT : 0;
+      steps[count].param = MEASCONFIG0 + SI1133_CHAN_PARAMS*n;
+      steps[count++].value = MEAS_COUNTER_INDEX0;
+      si1133_burst_len += channel->out24 ? 3 : 2;
   }
-  return;
+  steps[count].param = CHAN_LIST;
+  steps[count++].value = chan_list;
+
+  if(si1133_config_sm.period_ms){
+      meas_rate = (si1133_config_sm.period_ms*1000 + SI1133_MEAS_RATE_US/2) / SI1133_MEAS_RATE_US;
+      EFM_ASSERT((meas_rate > 0) && (meas_rate <= 0xFFFF));
+      steps[count].param = MEAS_RATE_H;
+      steps[count++].value = meas_rate >> 8;
+      steps[count].param = MEAS_RATE_L;
+      steps[count++].value = meas_rate & 0xFF;
+      steps[count].param = MEAS_COUNT0;
+      steps[count++].value = 1;
+      steps[count++].param = SI1133_STEP_START;
+  }
+  si1133_config_sm.step_count = count;
 }
+
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
@@ -126,7 +287,10 @@ static void si1133_config(){
  *
  * @details
  * creates a local struct for the I2C_OPEN_STRUCT then sets the values of the
- * struct accordingly. Calls I2C open with I2C1 and our local struct as an input
+ * struct accordingly. Calls I2C open with I2C1 and our local struct as an input,
+ * then starts uploading the channel table. The upload runs from I2C
+ * completion events, see si1133_config_cb, and ready_evt is posted once it
+ * is done, so this returns right away.
  *
  *
  *
@@ -134,10 +298,12 @@ static void si1133_config(){
  * @note
  * Used to set up the I2C for the SI1133,called in app.c
  *
+ * @param[in] si1133_open
+ * The channel table, the measurement period and the events to post.
  *
  ******************************************************************************/
 
-void Si1133_i2c_open(){
+void Si1133_i2c_open(SI1133_OPEN_STRUCT *si1133_open){
   I2C_OPEN_STRUCT si1133_struct_open;
 
   timer_delay(25); //delays 25 milliseconds for start up of si1133
@@ -154,9 +320,34 @@ void Si1133_i2c_open(){
   si1133_struct_open.ack_irq_enable = true;
   si1133_struct_open.rxdatav_irq_enable = true;
   si1133_struct_open.stop_irq_enable = true;
+  si1133_struct_open.rx_dma_en = true;
+  si1133_struct_open.scl_port = SI1133_SCL_PORT;
+  si1133_struct_open.scl_pin = SI1133_SCL_PIN;
+  si1133_struct_open.sda_port = SI1133_SDA_PORT;
+  si1133_struct_open.sda_pin = SI1133_SDA_PIN;
+  si1133_struct_open.supervise_evt = si1133_open->supervise_evt;
+  si1133_struct_open.supervise_prio = si1133_open->supervise_prio;
+  si1133_struct_open.error_evt = si1133_open->i2c_error_evt;
+
+  EFM_ASSERT((si1133_open->channel_count > 0) && (si1133_open->channel_count <= SI1133_MAX_CHANNELS));
+  si1133_channels = si1133_open->channels;
+  si1133_channel_count = si1133_open->channel_count;
+
+  si1133_config_sm.period_ms = si1133_open->period_ms;
+  si1133_config_sm.result_evt = si1133_open->result_evt;
+  si1133_config_sm.ready_evt = si1133_open->ready_evt;
+  si1133_config_sm.error_evt = si1133_open->error_evt;
+  si1133_config_sm.config_evt = si1133_open->config_evt;
+  scheduler_register_queued(si1133_open->config_evt, si1133_config_cb, si1133_open->config_prio);
+  scheduler_register(si1133_open->i2c_error_evt, si1133_i2c_error_cb, si1133_open->i2c_error_prio);
+  si1133_config();
 
   i2c_open(I2C1,&si1133_struct_open);
-  si1133_config();
+
+  si1133_config_sm.step = 0;
+  si1133_config_sm.retries = 0;
+  si1133_config_sm.state = si1133_config_reset;   //resets the counter, avoids issue where counter is at 14 or 15
+  si1133_config_send();
 }
 
 /***************************************************************************//**
@@ -188,9 +379,8 @@ void Si1133_i2c_open(){
  ******************************************************************************/
 void Si1133_read(uint32_t bytes_expected,uint32_t register_address, uint32_t call_back){
   bool mode = 1;
-  uint32_t device_address = 0x55;
 
-  i2c_start(mode, &data, bytes_expected, device_address, register_address, I2C1, call_back);
+  EFM_ASSERT(i2c_start(mode, &data, bytes_expected, SI1133_ADDRESS, register_address, I2C1, call_back));
 
 }
 /***************************************************************************//**
@@ -223,9 +413,8 @@ void Si1133_read(uint32_t bytes_expected,uint32_t register_address, uint32_t cal
 
 void Si1133_write(uint32_t bytes_expected,uint32_t register_address, uint32_t call_back){
   bool mode = 0;
-  uint32_t device_address = 0x55;
 
-  i2c_start(mode, &si1133_write_data, bytes_expected, device_address, register_address, I2C1, call_back);
+  EFM_ASSERT(i2c_start(mode, &si1133_write_data, bytes_expected, SI1133_ADDRESS, register_address, I2C1, call_back));
 
 }
 /***************************************************************************//**
@@ -234,7 +423,8 @@ void Si1133_write(uint32_t bytes_expected,uint32_t register_address, uint32_t ca
  *
  *
  * @details
- * reads data collected
+ * Returns the first channel of the table from the burst read by
+ * Si1133_request_result, see Si1133_result for all of them
  *
  *
  *
@@ -246,7 +436,99 @@ void Si1133_write(uint32_t bytes_expected,uint32_t register_address, uint32_t ca
  ******************************************************************************/
 
 uint32_t result_read(){
-  return(data);
+  SI1133_RESULT result;
+
+  Si1133_result(&result);
+  return (uint32_t)result.value[0];
+}
+
+/***************************************************************************//**
+ * @brief
+ * Decodes the last burst read into one value a channel
+ *
+ * @details
+ * The results follow IRQ_STATUS in channel table order, big endian, 2 bytes
+ * for a 16 bit channel and 3 bytes for a signed 24 bit one.
+ *
+ *
+ * @note
+ * Called in the handler of the Si1133_request_result call back
+ *
+ * @param[out] result
+ * Filled in with IRQ_STATUS and every channel.
+ *
+ ******************************************************************************/
+void Si1133_result(SI1133_RESULT *result){
+  const uint8_t *byte = &si1133_burst[1];
+  uint32_t raw;
+
+  result->irq_status = si1133_burst[0];
+  result->count = si1133_channel_count;
+  for(uint32_t n = 0; n < si1133_channel_count; n++){
+      if(si1133_channels[n].out24){
+          raw = ((uint32_t)byte[0] << 16) | (byte[1] << 8) | byte[2];
+          result->value[n] = (int32_t)(raw << 8) >> 8;     //sign extends bit 23
+          byte += 3;
+      }
+      else{
+          result->value[n] = (byte[0] << 8) | byte[1];
+          byte += 2;
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Converts a UV channel count to the UV index, in thousandths
+ *
+ * @details
+ * Uses the Silabs approximation UVI = 0.0187*(uv + 0.00391*uv^2) in 64 bit
+ * integer math, no floats. It holds for the UV photodiode at HW_GAIN 9 and
+ * DECIM_RATE 3, the setting in the app channel table.
+ *
+ *
+ * @param[in] uv
+ * The UV channel result.
+ *
+ * @return
+ * UV index times 1000, 0 for a negative count.
+ ******************************************************************************/
+uint32_t Si1133_uvi_milli(int32_t uv){
+  int64_t count = uv;
+
+  if(count <= 0){
+      return 0;
+  }
+  return (uint32_t)((count*SI1133_UVI_K1)/10 + (count*count*SI1133_UVI_K2)/10000);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Converts a white and an IR channel count to lux
+ *
+ * @details
+ * The white photodiode also sees IR, so a share of the IR count is taken off
+ * before scaling. Both factors are Q16 and depend on the channel settings and
+ * the window over the sensor, so SI1133_LUX_WHITE_Q16 and SI1133_LUX_IR_Q16
+ * are calibrated against a lux meter.
+ *
+ *
+ * @param[in] white
+ * The white channel result.
+ *
+ * @param[in] ir
+ * The IR channel result, measured in the same period.
+ *
+ * @return
+ * Lux, 0 if the IR correction takes it below 0.
+ ******************************************************************************/
+uint32_t Si1133_lux(int32_t white, int32_t ir){
+  int64_t lux = ((int64_t)white*SI1133_LUX_WHITE_Q16 - (int64_t)ir*SI1133_LUX_IR_Q16) >> 16;
+
+  if(lux < 0){
+      return 0;
+  }
+  return (uint32_t)lux;
 }
 
 
@@ -261,7 +543,7 @@ uint32_t result_read(){
  *
  *
  * @note
- * Called in comp1 cb
+ * Only for forced measurements, open with period_ms 0
  *
  ******************************************************************************/
 void Si1133_force_sense(){
@@ -277,14 +559,51 @@ void Si1133_force_sense(){
  * requests read from the si1133
  *
  * @details
- * Reads 2 bytes from the HOSTOUT0 register
+ * Writes the IRQ_STATUS register address then reads IRQ_STATUS and the
+ * results of every channel from HOSTOUT0 on in one transfer. Reading
+ * IRQ_STATUS lets the INT pin go back high in autonomous mode, so the read
+ * costs no extra transfer.
  *
  *
  *
  * @note
- * Called in the ub cb
+ * Called when the si1133 interrupt pin says a result is ready
  *
  ******************************************************************************/
 void Si1133_request_result(uint32_t callback){
-  Si1133_read(2,HOSTOUT0,callback);
+  static const uint8_t irq_status_reg = IRQ_STATUS;
+
+  EFM_ASSERT(i2c_transfer(I2C1, SI1133_ADDRESS, &irq_status_reg, 1, si1133_burst, si1133_burst_len, callback));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns whether the si1133 INT pin is asking for a result to be read
+ *
+ * @details
+ * The pin stays low until IRQ_STATUS is read, so if that read failed no new
+ * falling edge comes. The error handler uses this to read it again. Always
+ * false until the configuration is done.
+ *
+ *
+ ******************************************************************************/
+bool Si1133_int_pending(void){
+  if(si1133_config_sm.state != si1133_config_done || !si1133_config_sm.period_ms){
+      return false;
+  }
+  return !GPIO_PinInGet(SI1133_INT_PORT, SI1133_INT_PIN);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns why the last failed transfer to the si1133 failed
+ *
+ * @details
+ * For the handler of the error event passed to Si1133_i2c_open. I2C_ERR_NONE
+ * if the configuration gave up because the si1133 kept failing a command.
+ *
+ *
+ ******************************************************************************/
+I2C_ERROR Si1133_last_error(void){
+  return i2c_last_error(I2C1);
 }
@@ -35,7 +35,7 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-
+#define SLEEP_TICKS_TO_MS(ticks)    ((uint32_t)(((uint64_t)(ticks) * 1000) / sleep_clock_hz))
 
 
 //***********************************************************************************
@@ -43,6 +43,61 @@
 //***********************************************************************************
 static int lowest_energy_mode[MAX_ENERGY_MODES];
 
+// Residency and block accounting, timestamps are sleep_clock ticks. Off until
+// sleep_stats_reset with a clock set by sleep_clock_set.
+static SLEEP_CLOCK sleep_clock;
+static uint32_t sleep_clock_hz;
+static bool sleep_stats_on;
+static uint32_t sleep_stats_start;
+static uint64_t sleep_residency[MAX_ENERGY_MODES];
+static uint64_t sleep_held[SLEEP_TAGS];
+static uint32_t sleep_held_since[SLEEP_TAGS];
+static uint32_t sleep_held_count[SLEEP_TAGS];     //blocks the tag holds right now
+static uint32_t sleep_blocks[SLEEP_TAGS];
+static uint32_t sleep_tag_em[SLEEP_TAGS];
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Returns the time for the stats, 0 while they are off
+ *
+ ******************************************************************************/
+static uint32_t sleep_stats_now(void){
+  if(!sleep_stats_on){
+      return 0;
+  }
+  return sleep_clock();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds the time since start to the residency of an energy mode
+ *
+ *
+ * @details
+ * Runs right after waking, in or out of a critical section, so it takes its
+ * own for the 64 bit total.
+ *
+ *
+ * @param[in] EM
+ * The mode that was slept in.
+ *
+ * @param[in] start
+ * sleep_stats_now before the mode was entered.
+ *
+ ******************************************************************************/
+static void sleep_residency_add(uint32_t EM, uint32_t start){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(sleep_stats_on){
+      sleep_residency[EM] += sleep_clock() - start;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
@@ -68,6 +123,11 @@ void sleep_open(void){
       lowest_energy_mode[i] = 0;
 
   }
+  for(int i = 0; i < SLEEP_TAGS; i++){
+      sleep_held_count[i] = 0;
+  }
+  sleep_clock = 0;
+  sleep_stats_on = false;
 }
 
 /***************************************************************************//**
@@ -80,6 +140,7 @@ void sleep_open(void){
  *: Utilized by a peripheral to prevent the
  *: board from going into that sleep mode while the peripheral is active.
  *: It will increment the associated array element in lowest_energy_mode[] by one.
+ *: The tag's held time starts with its first block.
  *
  *
  * @note
@@ -90,14 +151,22 @@ void sleep_open(void){
  * @param[in] EM
  * This is the energy mode that we wish to block
  *
+ * @param[in] tag
+ * Who is blocking, the same tag is passed to sleep_unblock_mode
  *
  ******************************************************************************/
 
-void sleep_block_mode(uint32_t EM){
+void sleep_block_mode(uint32_t EM, SLEEP_TAG tag){
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
   lowest_energy_mode[EM]++;
   EFM_ASSERT(lowest_energy_mode[EM] < 5);
+  EFM_ASSERT(tag < SLEEP_TAGS);
+  if(sleep_held_count[tag]++ == 0){
+      sleep_held_since[tag] = sleep_stats_now();
+  }
+  sleep_blocks[tag]++;
+  sleep_tag_em[tag] = EM;
   CORE_EXIT_CRITICAL();
 }
 
@@ -110,7 +179,8 @@ void sleep_block_mode(uint32_t EM){
  * @details
  * Utilized to release the processor from going into a sleep mode with
  * a peripheral that is no longer active. It will decrement the associated
- * array element in lowest_energy_mode[] by one.
+ * array element in lowest_energy_mode[] by one. The tag's held time stops
+ * with its last unblock.
  *
  *
  *
@@ -121,15 +191,20 @@ void sleep_block_mode(uint32_t EM){
  * @param[in] EM
  * This is the energy mode that we wish to unblock
  *
- *
+ * @param[in] tag
+ * The tag passed to sleep_block_mode
  *
  *
  ******************************************************************************/
-void sleep_unblock_mode(uint32_t EM){
+void sleep_unblock_mode(uint32_t EM, SLEEP_TAG tag){
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
   lowest_energy_mode[EM]--;
   EFM_ASSERT (lowest_energy_mode[EM] >= 0);
+  EFM_ASSERT((tag < SLEEP_TAGS) && (sleep_held_count[tag] > 0));
+  if(--sleep_held_count[tag] == 0 && sleep_stats_on){
+      sleep_held[tag] += sleep_clock() - sleep_held_since[tag];
+  }
   CORE_EXIT_CRITICAL();
 }
 /***************************************************************************//**
@@ -138,7 +213,8 @@ void sleep_unblock_mode(uint32_t EM){
  *
  * @details
  * Function that will enter the appropriate sleep Energy Mode based on the
- * first non-zero array element in lowest_energy_mode[].
+ * first non-zero array element in lowest_energy_mode[]. The time from going
+ * in to waking up is added to that mode's residency.
  *
  *
  *
@@ -151,9 +227,11 @@ void sleep_unblock_mode(uint32_t EM){
  *
  ******************************************************************************/
 void enter_sleep(void){
+  uint32_t start;
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
 
+  start = sleep_stats_now();
   if(lowest_energy_mode[EM0] > 0){
       CORE_EXIT_CRITICAL();
       return;
@@ -165,15 +243,18 @@ void enter_sleep(void){
   else if(lowest_energy_mode[EM2] > 0){
       CORE_EXIT_CRITICAL();
       EMU_EnterEM1();
+      sleep_residency_add(EM1, start);
       return;
   }
   else if(lowest_energy_mode[EM3] > 0){
       EMU_EnterEM2(true);
+      sleep_residency_add(EM2, start);
       CORE_EXIT_CRITICAL();
       return;
   }
   else{
       EMU_EnterEM3(true);
+      sleep_residency_add(EM3, start);
       CORE_EXIT_CRITICAL();
       return;
   }
@@ -205,3 +286,104 @@ uint32_t current_block_energy_mode(void){
   return MAX_ENERGY_MODES-1;
 }
 
+
+/***************************************************************************//**
+ * @brief
+ * Sets the time source of the residency and block stats
+ *
+ *
+ * @details
+ * The stats stay off until sleep_stats_reset is called with a clock set.
+ *
+ *
+ * @note
+ * Called by sw_timer_open once the LETIMER is counting, so this module does
+ * not depend on the timer layer above it
+ *
+ *
+ * @param[in] clock
+ * Returns a free running count that wraps at 2^32.
+ *
+ * @param[in] hz
+ * Counts a second.
+ ******************************************************************************/
+void sleep_clock_set(SLEEP_CLOCK clock, uint32_t hz){
+  EFM_ASSERT(clock && hz);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  sleep_clock = clock;
+  sleep_clock_hz = hz;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Zeroes the residency and block totals and starts counting
+ *
+ *
+ * @details
+ * Tags that hold a block right now count from here.
+ *
+ *
+ * @note
+ * Called in app_peripheral_setup after sw_timer_open, and to start a new
+ * measurement
+ ******************************************************************************/
+void sleep_stats_reset(void){
+  CORE_DECLARE_IRQ_STATE;
+  EFM_ASSERT(sleep_clock);
+  CORE_ENTER_CRITICAL();
+  sleep_stats_on = true;
+  sleep_stats_start = sleep_clock();
+  for(int i = 0; i < MAX_ENERGY_MODES; i++){
+      sleep_residency[i] = 0;
+  }
+  for(int i = 0; i < SLEEP_TAGS; i++){
+      sleep_held[i] = 0;
+      sleep_held_since[i] = sleep_stats_start;
+      sleep_blocks[i] = 0;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies the totals since sleep_stats_reset
+ *
+ *
+ * @details
+ * A block that is still held counts up to now. EM0 is whatever of the
+ * elapsed time was not slept. Each sleep is counted to one tick of the
+ * clock set by sleep_clock_set. With the LETIMER on the 1 kHz ULFRCO a sleep
+ * shorter than a ms counts as 0 or 1 ms, but the count runs free, so the
+ * totals of many short sleeps come out right on average.
+ *
+ *
+ * @param[out] stats
+ * Filled in, all zeros if sleep_stats_reset was never called.
+ *
+ ******************************************************************************/
+void sleep_stats_get(SLEEP_STATS *stats){
+  uint64_t slept = 0;
+  uint64_t held;
+  uint32_t now;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  now = sleep_stats_now();
+  stats->elapsed_ms = SLEEP_TICKS_TO_MS(now - sleep_stats_start);
+  for(int i = EM1; i < MAX_ENERGY_MODES; i++){
+      stats->residency_ms[i] = SLEEP_TICKS_TO_MS(sleep_residency[i]);
+      slept += sleep_residency[i];
+  }
+  stats->residency_ms[EM0] = SLEEP_TICKS_TO_MS((now - sleep_stats_start) - slept);
+  for(int i = 0; i < SLEEP_TAGS; i++){
+      held = sleep_held[i];
+      if(sleep_held_count[i] && sleep_stats_on){
+          held += now - sleep_held_since[i];
+      }
+      stats->held_ms[i] = SLEEP_TICKS_TO_MS(held);
+      stats->blocks[i] = sleep_blocks[i];
+      stats->em[i] = sleep_tag_em[i];
+  }
+  CORE_EXIT_CRITICAL();
+}
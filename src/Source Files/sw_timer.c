@@ -0,0 +1,335 @@
+/**
+ * @file
+ *  sw_timer.c
+ * @author
+ *  agent
+ * @date
+ *  10/16/26
+ * @brief
+ *  One shot and periodic software timers that share LETIMER0
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "sw_timer.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static SW_TIMER *sw_timer_head;         //Started timers, soonest deadline first
+static uint32_t sw_timer_service_evt;
+static bool sw_timer_opened;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Puts a timer into the started list in deadline order
+ *
+ * @details
+ *   Timers with the same deadline expire in the order they were started.
+ *
+ * @param[in] timer
+ *   The timer, with its deadline set.
+ *
+ ******************************************************************************/
+static void sw_timer_insert(SW_TIMER *timer){
+  SW_TIMER **link = &sw_timer_head;
+
+  while(*link && ((int32_t)(timer->deadline - (*link)->deadline) >= 0)){
+      link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+  timer->active = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Takes a timer out of the started list
+ *
+ * @param[in] timer
+ *   The timer, which must be started.
+ *
+ ******************************************************************************/
+static void sw_timer_remove(SW_TIMER *timer){
+  SW_TIMER **link = &sw_timer_head;
+
+  while(*link != timer){
+      EFM_ASSERT(*link);
+      link = &(*link)->next;
+  }
+  *link = timer->next;
+  timer->next = 0;
+  timer->active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets the LETIMER alarm for the soonest deadline
+ *
+ * @details
+ *   The alarm can only be set within one counter wrap, a deadline further out
+ *   is picked up by one of the service passes the wrap itself causes. If the
+ *   deadline went by while the alarm was being set, the service event is
+ *   posted right away instead.
+ *
+ ******************************************************************************/
+static void sw_timer_arm(void){
+  int32_t remaining;
+
+  if(!sw_timer_head){
+      letimer_compare_disarm(SW_TIMER_LETIMER);
+      return;
+  }
+  remaining = (int32_t)(sw_timer_head->deadline - sw_timer_now());
+  if(remaining <= 0){
+      add_scheduled_event(sw_timer_service_evt);
+      return;
+  }
+  if(remaining > LETIMER_TOP){
+      letimer_compare_disarm(SW_TIMER_LETIMER);
+      return;
+  }
+  letimer_compare_arm(SW_TIMER_LETIMER, sw_timer_head->deadline);
+  if((int32_t)(sw_timer_now() - sw_timer_head->deadline) >= 0){
+      add_scheduled_event(sw_timer_service_evt);
+  }
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ *   Opens the software timers
+ *
+ * @details
+ *   Starts LETIMER0 as a free running counter and registers sw_timer_service
+ *   for service_evt, which the LETIMER posts when the soonest deadline is
+ *   reached and every time the counter wraps. Any number of timers share the
+ *   one LETIMER, and the CPU only wakes for the soonest deadline. The count
+ *   is also set as the clock of the sleep stats.
+ *
+ * @note
+ *   Called in app peripheral setup after scheduler_open. LETIMER0 can't be
+ *   used for PWM at the same time.
+ *
+ * @param[in] service_evt
+ *   The scheduler event used by the timers themselves.
+ *
+ * @param[in] priority
+ *   Scheduler priority of service_evt, normally the highest.
+ *
+ ******************************************************************************/
+void sw_timer_open(uint32_t service_evt, uint32_t priority){
+  APP_LETIMER_COUNTER_TypeDef letimer_counter_struct;
+
+  sw_timer_head = 0;
+  sw_timer_service_evt = service_evt;
+  sw_timer_opened = true;
+  scheduler_register(service_evt, sw_timer_service, priority);
+
+  letimer_counter_struct.debugRun = false;
+  letimer_counter_struct.comp1_cb = service_evt;
+  letimer_counter_struct.uf_cb = service_evt;
+  letimer_counter_open(SW_TIMER_LETIMER, &letimer_counter_struct);
+  letimer_start(SW_TIMER_LETIMER, true);
+  sleep_clock_set(sw_timer_now, LETIMER_HZ);      //the raw LETIMER count times the sleep stats
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Starts a timer
+ *
+ * @details
+ *   event is posted delay_ms from now, then every period_ms after that if
+ *   period_ms is not 0. Starting a timer that is already started restarts it.
+ *
+ * @note
+ *   Only called from the main loop, never from an interrupt.
+ *
+ * @param[in] timer
+ *   Caller owned timer, must stay valid until it expires or is stopped.
+ *
+ * @param[in] delay_ms
+ *   Time to the first expiry.
+ *
+ * @param[in] period_ms
+ *   Time between expiries after that, 0 for a one shot timer.
+ *
+ * @param[in] event
+ *   Scheduler event posted on each expiry.
+ *
+ ******************************************************************************/
+void sw_timer_start(SW_TIMER *timer, uint32_t delay_ms, uint32_t period_ms, uint32_t event){
+  uint32_t delay = SW_TIMER_MS_TO_TICKS(delay_ms);
+
+  EFM_ASSERT(sw_timer_opened);
+  EFM_ASSERT(delay <= SW_TIMER_MAX_TICKS);
+  EFM_ASSERT(SW_TIMER_MS_TO_TICKS(period_ms) <= SW_TIMER_MAX_TICKS);
+  if(timer->active){
+      sw_timer_remove(timer);
+  }
+  timer->deadline = sw_timer_now() + delay;
+  timer->period = SW_TIMER_MS_TO_TICKS(period_ms);
+  if(period_ms && !timer->period){
+      timer->period = 1;
+  }
+  timer->event = event;
+  sw_timer_insert(timer);
+  if(sw_timer_head == timer){
+      sw_timer_arm();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Stops a timer
+ *
+ * @details
+ *   Does nothing if the timer is not started. An event that was already
+ *   posted is not taken back.
+ *
+ * @param[in] timer
+ *   The timer to stop.
+ *
+ ******************************************************************************/
+void sw_timer_stop(SW_TIMER *timer){
+  bool was_head = (sw_timer_head == timer);
+
+  if(!timer->active){
+      return;
+  }
+  sw_timer_remove(timer);
+  if(was_head){
+      sw_timer_arm();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sleeps until a timer expires
+ *
+ * @details
+ *   For code that has to wait in place, such as during start up, instead of
+ *   returning to the main loop. The CPU sleeps in the lowest energy mode
+ *   allowed and services the timers itself each time the LETIMER wakes it, so
+ *   it works from inside a scheduled callback too. Other timers that expire
+ *   meanwhile post their events as usual, they run once the main loop does.
+ *
+ * @param[in] timer
+ *   A started one shot timer.
+ *
+ ******************************************************************************/
+void sw_timer_wait(SW_TIMER *timer){
+  EFM_ASSERT(!timer->period);
+  while(timer->active){
+      CORE_DECLARE_IRQ_STATE;
+      CORE_ENTER_CRITICAL();
+      if(!sw_timer_due()){
+          enter_sleep();      //the LETIMER interrupt still wakes us, it runs once we leave the critical section
+      }
+      CORE_EXIT_CRITICAL();
+      sw_timer_poll();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns whether the LETIMER has asked for the timers to be serviced
+ *
+ * @details
+ *   A wait loop checks this in a critical section before it sleeps, so a
+ *   request that came in just before is not slept through.
+ *
+ * @return
+ *   true if the service event is posted.
+ ******************************************************************************/
+bool sw_timer_due(void){
+  return (get_scheduled_events() & sw_timer_service_evt) != 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Services the timers if the LETIMER has asked for it
+ *
+ * @details
+ *   For wait loops that can't go back to the main loop, like sw_timer_wait.
+ *   Expired timers post their events as usual.
+ *
+ ******************************************************************************/
+void sw_timer_poll(void){
+  if(sw_timer_due()){
+      remove_scheduled_event(sw_timer_service_evt);
+      sw_timer_service();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns whether a timer is started
+ *
+ * @param[in] timer
+ *   The timer.
+ *
+ * @return
+ *   true until a one shot timer expires or any timer is stopped.
+ ******************************************************************************/
+bool sw_timer_active(SW_TIMER *timer){
+  return timer->active;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the current time in LETIMER ticks
+ *
+ * @return
+ *   The free running count, compare values by their signed difference.
+ ******************************************************************************/
+uint32_t sw_timer_now(void){
+  return letimer_count(SW_TIMER_LETIMER);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Expires every timer whose deadline has passed
+ *
+ * @details
+ *   Posts the event of each expired timer. A periodic timer is put back for
+ *   its next period, if the main loop was held up for more than a period the
+ *   missed expiries are skipped rather than posted all at once. Then the alarm
+ *   is set for the new soonest deadline.
+ *
+ * @note
+ *   Registered with the scheduler by sw_timer_open
+ *
+ ******************************************************************************/
+void sw_timer_service(void){
+  uint32_t now = sw_timer_now();
+  SW_TIMER *timer;
+
+  while(sw_timer_head && ((int32_t)(now - sw_timer_head->deadline) >= 0)){
+      timer = sw_timer_head;
+      sw_timer_remove(timer);
+      add_scheduled_event(timer->event);
+      if(timer->period){
+          timer->deadline += timer->period;
+          if((int32_t)(now - timer->deadline) >= 0){
+              timer->deadline = now + timer->period;
+          }
+          sw_timer_insert(timer);
+      }
+  }
+  sw_timer_arm();
+}
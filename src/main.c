@@ -58,31 +58,7 @@ int main(void)
               CORE_EXIT_CRITICAL();
           }
 
-          if(LETIMER0_COMP1_CB & get_scheduled_events()){
-              remove_scheduled_event(LETIMER0_COMP1_CB);
-              scheduled_letimer0_comp1_cb();
-          }
-
-          if(LETIMER0_UF_CB & get_scheduled_events()){
-              remove_scheduled_event(LETIMER0_UF_CB);
-              scheduled_letimer0_uf_cb();
-          }
-
-          if(SI1133_REG_READ_CB & get_scheduled_events()){
-              remove_scheduled_event(SI1133_REG_READ_CB);
-              scheduled_si1133_read_cb();
-             }
-
-          if(BOOT_UP_CB & get_scheduled_events()){
-              remove_scheduled_event(BOOT_UP_CB);
-              scheduled_boot_up_cb();
-             }
-
-          if(BLE_TX_DONE_CB & get_scheduled_events()){
-              remove_scheduled_event(BLE_TX_DONE_CB);
-              scheduled_ble_tx_done_cb();
-             }
-
+          scheduler_dispatch();    //handlers are registered in app_peripheral_setup
 
   }
 }
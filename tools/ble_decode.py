@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decodes the binary telemetry frames sent by ble_write_frame().
+
+Frame layout (see ble.h):
+    0xA5 | type | sequence | payload length | payload | CRC-8
+
+The payload is a list of zigzag varints. The CRC-8 uses polynomial 0x07 and an
+initial value of 0, and covers every byte after the sync byte.
+
+Usage:
+    ble_decode.py capture.bin          decode a raw capture
+    ble_decode.py -p COM5 [-b 9600]    decode live from a serial port (pyserial)
+"""
+
+import argparse
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER = 4
+FRAME_TYPES = {
+    0x01: "boot",
+    0x02: "z",        # tenths
+    0x03: "light",    # min, max, mean, UVI milli, lux, then the raw readings
+    0x04: "error",    # I2C_ERROR of a failed Si1133 transfer
+    0x05: "sleep",    # ms: elapsed, EM0-EM3 residency, held by sys, tx, rx, i2c0, i2c1, letimer, leclk
+    0x06: "profile",  # region, count, min, max, mean cycles
+}
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def decode_varints(payload):
+    values = []
+    value = 0
+    shift = 0
+    for byte in payload:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            values.append((value >> 1) ^ -(value & 1))
+            value = 0
+            shift = 0
+    if shift:
+        raise ValueError("payload ends inside a varint")
+    return values
+
+
+class FrameDecoder:
+    """Finds frames in a byte stream, resynchronising on bad CRCs."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.last_seq = None
+        self.crc_errors = 0
+        self.dropped = 0
+
+    def feed(self, data):
+        self.buf.extend(data)
+        frames = []
+        while True:
+            start = self.buf.find(FRAME_SYNC)
+            if start < 0:
+                self.buf.clear()
+                return frames
+            del self.buf[:start]
+            if len(self.buf) < FRAME_HEADER:
+                return frames
+            end = FRAME_HEADER + self.buf[3] + 1
+            if len(self.buf) < end:
+                return frames
+            frame = bytes(self.buf[:end])
+            if crc8(frame[1:-1]) != frame[-1]:
+                self.crc_errors += 1
+                del self.buf[:1]        # the sync byte was data, look again
+                continue
+            del self.buf[:end]
+            seq = frame[2]
+            if self.last_seq is not None:
+                self.dropped += (seq - self.last_seq - 1) & 0xFF
+            self.last_seq = seq
+            frames.append((frame[1], seq, decode_varints(frame[FRAME_HEADER:-1])))
+
+
+def print_frame(frame_type, seq, values):
+    name = FRAME_TYPES.get(frame_type, "type 0x%02X" % frame_type)
+    if name == "z" and values:
+        shown = ["%.1f" % (v / 10) for v in values]
+    else:
+        shown = [str(v) for v in values]
+    print("%3d %-6s %s" % (seq, name, " ".join(shown)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="raw capture file, default stdin")
+    parser.add_argument("-p", "--port", help="serial port to read from")
+    parser.add_argument("-b", "--baud", type=int, default=9600)
+    args = parser.parse_args()
+
+    decoder = FrameDecoder()
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud, timeout=1)
+    elif args.capture:
+        stream = open(args.capture, "rb")
+    else:
+        stream = sys.stdin.buffer
+
+    try:
+        while True:
+            data = stream.read(64)
+            if not data:
+                if args.port:
+                    continue
+                break
+            for frame in decoder.feed(data):
+                print_frame(*frame)
+    except KeyboardInterrupt:
+        pass
+    print("crc errors %d, dropped frames %d" % (decoder.crc_errors, decoder.dropped),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Reports flash taken by sections and objects in a GNU ld map file.
+
+Only the input sections placed in the "Linker script and memory map" part
+count, discarded sections are skipped. A section is named by its symbol, so
+_printf_float covers .text._printf_float and .rodata._printf_float.*. The
+objects those sections came from are totalled as well, since pulling in one
+symbol links the whole object.
+
+Usage:
+    map_size.py                                 _printf_float in the default build
+    map_size.py Tl_UART_Lab6.map sprintf _dtoa_r
+    map_size.py -o "vfprintf_float|dtoa|mprec"  objects matching a regex
+    map_size.py -t 20                           the 20 largest objects
+"""
+
+import argparse
+import os
+import re
+import sys
+
+DEFAULT_MAP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                           "GNU ARM v10.2.1 - Default", "Tl_UART_Lab6.map")
+MEMORY_MAP = "Linker script and memory map"
+FLASH_END = 0x20000000      # below is flash, the rest is RAM
+NOT_LOADED = (".debug", ".comment", ".ARM.attributes", ".stab")
+
+SECTION = re.compile(r"^ (\.[\w.$]+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$")
+PLACEMENT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+
+
+def short_object(path):
+    """libc_nano.a(lib_a-dtoa.o) for an archive member, the file name otherwise."""
+    path = path.replace("\\", "/")
+    return path.rsplit("/", 1)[-1]
+
+
+def read_sections(map_path):
+    """(section, address, size, object) of every input section placed in flash."""
+    sections = []
+    with open(map_path, errors="replace") as stream:
+        for line in stream:
+            if line.startswith(MEMORY_MAP):
+                break
+        else:
+            raise ValueError("%s has no memory map" % map_path)
+        pending = None
+        for line in stream:
+            line = line.rstrip("\n")
+            if pending:
+                match = PLACEMENT.match(line)
+                pending_name, pending = pending, None
+                if match:
+                    sections.append((pending_name, int(match.group(1), 16),
+                                     int(match.group(2), 16), short_object(match.group(3))))
+                    continue
+            match = SECTION.match(line)
+            if not match:
+                continue
+            if match.group(2) is None:
+                pending = match.group(1)        # long names put the placement on the next line
+            else:
+                sections.append((match.group(1), int(match.group(2), 16),
+                                  int(match.group(3), 16), short_object(match.group(4))))
+    return [s for s in sections
+            if s[2] and s[1] < FLASH_END and not s[0].startswith(NOT_LOADED)]
+
+
+def symbol_sections(sections, symbol):
+    pattern = re.compile(r"^\.(?:text|rodata)\.%s(?:\..*)?$" % re.escape(symbol))
+    return [s for s in sections if pattern.match(s[0])]
+
+
+def object_sizes(sections):
+    sizes = {}
+    for _, _, size, obj in sections:
+        sizes[obj] = sizes.get(obj, 0) + size
+    return sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", nargs="?", default=DEFAULT_MAP, help="map file, default the Simplicity Studio build")
+    parser.add_argument("symbols", nargs="*", help="symbols to report, default _printf_float")
+    parser.add_argument("-o", "--objects", help="also total the objects matching this regex")
+    parser.add_argument("-t", "--top", type=int, default=0, help="list the largest objects")
+    args = parser.parse_args()
+
+    if args.map.endswith(".map") or os.path.exists(args.map):
+        map_path, symbols = args.map, args.symbols
+    else:
+        map_path, symbols = DEFAULT_MAP, [args.map] + args.symbols
+    if not symbols and not args.objects and not args.top:
+        symbols = ["_printf_float"]
+
+    try:
+        sections = read_sections(map_path)
+    except (OSError, ValueError) as error:
+        print(error, file=sys.stderr)
+        sys.exit(1)
+    sizes = object_sizes(sections)
+    print("%s: %d bytes of flash in %d sections" % (os.path.basename(map_path),
+          sum(s[2] for s in sections), len(sections)))
+
+    for symbol in symbols:
+        found = symbol_sections(sections, symbol)
+        if not found:
+            print("%s: not linked" % symbol)
+            continue
+        for name, address, size, obj in found:
+            print("  %-32s 0x%08x %6d  %s" % (name, address, size, obj))
+        objects = sorted(set(s[3] for s in found))
+        print("%s: %d bytes, %d with the rest of %s" % (symbol, sum(s[2] for s in found),
+              sum(sizes[o] for o in objects), ", ".join(objects)))
+
+    if args.objects:
+        pattern = re.compile(args.objects)
+        matched = sorted((o for o in sizes if pattern.search(o)), key=lambda o: -sizes[o])
+        for obj in matched:
+            print("  %6d  %s" % (sizes[obj], obj))
+        print("%s: %d bytes in %d objects" % (args.objects, sum(sizes[o] for o in matched), len(matched)))
+
+    for obj in sorted(sizes, key=lambda o: -sizes[o])[:args.top]:
+        print("  %6d  %s" % (sizes[obj], obj))
+
+
+if __name__ == "__main__":
+    main()